@@ -0,0 +1,90 @@
+#ifndef CPPKAFKA_BENCHMARK_RUNNER_H
+#define CPPKAFKA_BENCHMARK_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cppkafka {
+namespace benchmarks {
+
+// Minimal Google-Benchmark-style harness. Each benchmark is a callable invoked
+// with the per-thread iteration count; the runner times it across 1..N threads
+// and reports ns/op and ops/sec so CI can diff runs.
+class BenchmarkRunner {
+public:
+    using BenchmarkFunction = std::function<void(size_t iterations)>;
+
+    void add(std::string name, size_t iterations, BenchmarkFunction function) {
+        benchmarks_.push_back({ std::move(name), iterations, std::move(function), { 1 } });
+    }
+
+    void add_threaded(std::string name, size_t iterations, std::vector<size_t> thread_counts,
+                      BenchmarkFunction function, std::function<void()> teardown = nullptr) {
+        benchmarks_.push_back({ std::move(name), iterations, std::move(function),
+                                std::move(thread_counts), std::move(teardown) });
+    }
+
+    void run_all() {
+        std::printf("%-55s %12s %15s %15s\n", "benchmark", "threads", "ns/op", "ops/sec");
+        for (const Benchmark& benchmark : benchmarks_) {
+            for (const size_t threads : benchmark.thread_counts) {
+                run_one(benchmark, threads);
+            }
+        }
+    }
+private:
+    struct Benchmark {
+        std::string name;
+        size_t iterations;
+        BenchmarkFunction function;
+        std::vector<size_t> thread_counts;
+        // Run untimed after each thread-count pass, e.g. to drain accumulated state
+        std::function<void()> teardown;
+    };
+
+    void run_one(const Benchmark& benchmark, size_t thread_count) {
+        using std::chrono::duration_cast;
+        using std::chrono::nanoseconds;
+        using std::chrono::steady_clock;
+
+        const size_t iterations_per_thread = benchmark.iterations / thread_count;
+        std::atomic<bool> start_flag{false};
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for (size_t i = 0; i != thread_count; ++i) {
+            threads.emplace_back([&]() {
+                while (!start_flag) {
+                    std::this_thread::yield();
+                }
+                benchmark.function(iterations_per_thread);
+            });
+        }
+        const auto start = steady_clock::now();
+        start_flag = true;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+        const size_t total_operations = iterations_per_thread * thread_count;
+        const double ns_per_op = static_cast<double>(elapsed.count()) / total_operations;
+        const double ops_per_sec = total_operations / (elapsed.count() / 1e9);
+        std::printf("%-55s %12zu %15.1f %15.0f\n", benchmark.name.c_str(), thread_count,
+                    ns_per_op, ops_per_sec);
+        if (benchmark.teardown) {
+            benchmark.teardown();
+        }
+    }
+
+    std::vector<Benchmark> benchmarks_;
+};
+
+} // benchmarks
+} // cppkafka
+
+#endif // CPPKAFKA_BENCHMARK_RUNNER_H
@@ -0,0 +1,347 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "cppkafka/consumer.h"
+#include "cppkafka/message_builder.h"
+#include "cppkafka/mock_cluster.h"
+#include "cppkafka/producer.h"
+#include "cppkafka/utils/buffered_producer.h"
+#include "cppkafka/utils/latency_histogram.h"
+#include "cppkafka/utils/roundrobin_poll_strategy.h"
+
+// End-to-end pipeline benchmark: stands up an in-process mock cluster, pushes
+// messages from N producer threads through BufferedProducer and consumes them
+// back across M partitions through a poll strategy, measuring throughput and
+// produce-to-consume latency percentiles. Unlike the microbenchmarks next
+// door, the whole stack is exercised - wrapper, librdkafka and (mock) broker -
+// so a run before and after a library upgrade shows what the upgrade really
+// costs. Results are emitted as JSON; pass a previous run via --baseline to
+// get a comparison and a nonzero exit status on regression, suitable for CI.
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::thread;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+using namespace cppkafka;
+
+namespace {
+
+struct Options {
+    size_t producers = 2;
+    size_t partitions = 4;
+    size_t messages = 100000;
+    size_t payload_size = 512;
+    size_t max_buffer_size = 10000;
+    size_t linger_ms = 5;
+    size_t brokers = 1;
+    double tolerance_percent = 10.0;
+    string output_file;
+    string baseline_file;
+};
+
+struct Results {
+    double produce_throughput_msgs = 0;
+    double consume_throughput_msgs = 0;
+    double consume_throughput_mb = 0;
+    size_t messages_consumed = 0;
+    LatencyHistogram::Snapshot latency;
+};
+
+void print_usage(const char* program) {
+    cout << "Usage: " << program << " [options]\n"
+         << "  --producers N        producer threads (default 2)\n"
+         << "  --partitions N       topic partitions (default 4)\n"
+         << "  --messages N         total messages to push through (default 100000)\n"
+         << "  --payload-size N     payload bytes per message (default 512)\n"
+         << "  --max-buffer-size N  BufferedProducer flush threshold (default 10000)\n"
+         << "  --linger-ms N        librdkafka linger.ms (default 5)\n"
+         << "  --brokers N          mock brokers to spin up (default 1)\n"
+         << "  --output FILE        write the JSON report to FILE instead of stdout\n"
+         << "  --baseline FILE      compare against a previous JSON report\n"
+         << "  --tolerance PCT      regression tolerance in percent (default 10)\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const string argument = argv[i];
+        if (argument == "--help") {
+            print_usage(argv[0]);
+            return false;
+        }
+        if (i + 1 == argc) {
+            cerr << "Missing value for " << argument << endl;
+            return false;
+        }
+        const string value = argv[++i];
+        if (argument == "--producers") options.producers = std::stoul(value);
+        else if (argument == "--partitions") options.partitions = std::stoul(value);
+        else if (argument == "--messages") options.messages = std::stoul(value);
+        else if (argument == "--payload-size") options.payload_size = std::stoul(value);
+        else if (argument == "--max-buffer-size") options.max_buffer_size = std::stoul(value);
+        else if (argument == "--linger-ms") options.linger_ms = std::stoul(value);
+        else if (argument == "--brokers") options.brokers = std::stoul(value);
+        else if (argument == "--tolerance") options.tolerance_percent = std::stod(value);
+        else if (argument == "--output") options.output_file = value;
+        else if (argument == "--baseline") options.baseline_file = value;
+        else {
+            cerr << "Unknown option " << argument << endl;
+            return false;
+        }
+    }
+    if (options.payload_size < sizeof(int64_t)) {
+        cerr << "--payload-size must be at least " << sizeof(int64_t)
+             << " to carry the produce timestamp" << endl;
+        return false;
+    }
+    return true;
+}
+
+void write_report(std::ostream& output, const Options& options, const Results& results) {
+    output << "{\n"
+           << "  \"config\": {\n"
+           << "    \"producers\": " << options.producers << ",\n"
+           << "    \"partitions\": " << options.partitions << ",\n"
+           << "    \"messages\": " << options.messages << ",\n"
+           << "    \"payload_size\": " << options.payload_size << ",\n"
+           << "    \"max_buffer_size\": " << options.max_buffer_size << ",\n"
+           << "    \"linger_ms\": " << options.linger_ms << ",\n"
+           << "    \"brokers\": " << options.brokers << "\n"
+           << "  },\n"
+           << "  \"results\": {\n"
+           << "    \"messages_consumed\": " << results.messages_consumed << ",\n"
+           << "    \"produce_throughput_msgs_per_sec\": " << results.produce_throughput_msgs << ",\n"
+           << "    \"consume_throughput_msgs_per_sec\": " << results.consume_throughput_msgs << ",\n"
+           << "    \"consume_throughput_mb_per_sec\": " << results.consume_throughput_mb << ",\n"
+           << "    \"latency_min_us\": " << results.latency.minimum << ",\n"
+           << "    \"latency_avg_us\": " << results.latency.average << ",\n"
+           << "    \"latency_p50_us\": " << results.latency.p50 << ",\n"
+           << "    \"latency_p95_us\": " << results.latency.p95 << ",\n"
+           << "    \"latency_p99_us\": " << results.latency.p99 << ",\n"
+           << "    \"latency_p999_us\": " << results.latency.p999 << ",\n"
+           << "    \"latency_max_us\": " << results.latency.maximum << "\n"
+           << "  }\n"
+           << "}\n";
+}
+
+// Pulls the number following "key": out of a report. The reports are flat and
+// generated by write_report above, so a full JSON parser isn't warranted.
+bool find_number(const string& report, const string& key, double& value) {
+    const string quoted = "\"" + key + "\"";
+    const size_t key_position = report.find(quoted);
+    if (key_position == string::npos) {
+        return false;
+    }
+    const size_t colon = report.find(':', key_position + quoted.size());
+    if (colon == string::npos) {
+        return false;
+    }
+    value = std::strtod(report.c_str() + colon + 1, nullptr);
+    return true;
+}
+
+// Returns true if the metric regressed past the tolerance. higher_is_better
+// selects the direction: throughput regresses downwards, latency upwards.
+bool compare_metric(const string& report, const string& key, double current,
+                    bool higher_is_better, double tolerance_percent) {
+    double baseline = 0;
+    if (!find_number(report, key, baseline) || baseline == 0) {
+        return false;
+    }
+    const double change_percent = (current - baseline) / baseline * 100.0;
+    const bool regressed = higher_is_better ? (change_percent < -tolerance_percent)
+                                            : (change_percent > tolerance_percent);
+    std::printf("%-38s %15.1f %15.1f %+9.1f%% %s\n", key.c_str(), baseline, current,
+                change_percent, regressed ? "REGRESSED" : "ok");
+    return regressed;
+}
+
+bool compare_to_baseline(const string& baseline_file, const Results& results,
+                         double tolerance_percent) {
+    std::ifstream input(baseline_file);
+    if (!input) {
+        cerr << "Cannot read baseline file " << baseline_file << endl;
+        return false;
+    }
+    std::ostringstream contents;
+    contents << input.rdbuf();
+    const string report = contents.str();
+
+    std::printf("%-38s %15s %15s %10s\n", "metric", "baseline", "current", "change");
+    bool regressed = false;
+    regressed |= compare_metric(report, "produce_throughput_msgs_per_sec",
+                                results.produce_throughput_msgs, true, tolerance_percent);
+    regressed |= compare_metric(report, "consume_throughput_msgs_per_sec",
+                                results.consume_throughput_msgs, true, tolerance_percent);
+    regressed |= compare_metric(report, "latency_p50_us",
+                                static_cast<double>(results.latency.p50), false,
+                                tolerance_percent);
+    regressed |= compare_metric(report, "latency_p99_us",
+                                static_cast<double>(results.latency.p99), false,
+                                tolerance_percent);
+    regressed |= compare_metric(report, "latency_p999_us",
+                                static_cast<double>(results.latency.p999), false,
+                                tolerance_percent);
+    return regressed;
+}
+
+} // namespace
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+
+namespace {
+
+const string TOPIC = "cppkafka_pipeline_benchmark";
+
+Results run_scenario(MockCluster& cluster, const Options& options) {
+    Results results;
+    LatencyHistogram histogram;
+
+    Consumer consumer(cluster.make_configuration()
+                             .set("group.id", "cppkafka_pipeline_benchmark")
+                             .set("enable.auto.commit", false)
+                             .set("enable.partition.eof", false)
+                             .set("auto.offset.reset", "earliest"));
+    consumer.subscribe({ TOPIC });
+    RoundRobinPollStrategy poll_strategy(consumer);
+
+    std::atomic<size_t> consumed{0};
+    std::atomic<int64_t> consume_elapsed_us{0};
+    thread consumer_thread([&]() {
+        const auto deadline = steady_clock::now() + seconds(120);
+        const auto start = steady_clock::now();
+        while (consumed < options.messages && steady_clock::now() < deadline) {
+            Message message = poll_strategy.poll(milliseconds(100));
+            if (!message || message.get_error()) {
+                continue;
+            }
+            const Buffer& payload = message.get_payload();
+            if (payload.get_size() >= sizeof(int64_t)) {
+                int64_t produced_at;
+                std::memcpy(&produced_at, payload.get_data(), sizeof(produced_at));
+                const int64_t elapsed = LatencyHistogram::now_us() - produced_at;
+                histogram.record(elapsed > 0 ? elapsed : 0);
+            }
+            ++consumed;
+        }
+        consume_elapsed_us =
+            duration_cast<std::chrono::microseconds>(steady_clock::now() - start).count();
+    });
+
+    BufferedProducer<string> producer(cluster.make_configuration()
+                                             .set("linger.ms", static_cast<int>(options.linger_ms)));
+    producer.set_max_buffer_size(options.max_buffer_size);
+
+    const string payload_template(options.payload_size, 'x');
+    const size_t messages_per_producer = options.messages / options.producers;
+    const size_t remainder = options.messages % options.producers;
+
+    const auto produce_start = steady_clock::now();
+    vector<thread> producer_threads;
+    producer_threads.reserve(options.producers);
+    for (size_t producer_index = 0; producer_index != options.producers; ++producer_index) {
+        const size_t count = messages_per_producer + (producer_index < remainder ? 1 : 0);
+        producer_threads.emplace_back([&, producer_index, count]() {
+            using Builder = BufferedProducer<string>::Builder;
+            for (size_t i = 0; i != count; ++i) {
+                string payload = payload_template;
+                const int64_t now = LatencyHistogram::now_us();
+                std::memcpy(&payload[0], &now, sizeof(now));
+                Builder builder(TOPIC);
+                builder.partition(static_cast<int>((producer_index + i) % options.partitions))
+                       .payload(std::move(payload));
+                producer.add_message(std::move(builder));
+            }
+        });
+    }
+    for (thread& producer_thread : producer_threads) {
+        producer_thread.join();
+    }
+    producer.flush();
+    producer.wait_for_acks(seconds(60));
+    const auto produce_elapsed =
+        duration_cast<std::chrono::microseconds>(steady_clock::now() - produce_start);
+
+    consumer_thread.join();
+
+    results.messages_consumed = consumed;
+    results.produce_throughput_msgs = options.messages / (produce_elapsed.count() / 1e6);
+    if (consume_elapsed_us > 0) {
+        const double consume_seconds = consume_elapsed_us / 1e6;
+        results.consume_throughput_msgs = consumed / consume_seconds;
+        results.consume_throughput_mb = (consumed * options.payload_size) /
+                                        (consume_seconds * 1024 * 1024);
+    }
+    results.latency = histogram.get_snapshot();
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+
+    cout << "Running pipeline: " << options.producers << " producers -> "
+         << options.partitions << " partitions, " << options.messages << " messages of "
+         << options.payload_size << " bytes" << endl;
+
+    MockCluster cluster(options.brokers);
+    cluster.create_topic(TOPIC, options.partitions);
+    const Results results = run_scenario(cluster, options);
+
+    if (results.messages_consumed != options.messages) {
+        cerr << "Only consumed " << results.messages_consumed << " of " << options.messages
+             << " messages before the deadline" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!options.output_file.empty()) {
+        std::ofstream output(options.output_file);
+        if (!output) {
+            cerr << "Cannot write to " << options.output_file << endl;
+            return EXIT_FAILURE;
+        }
+        write_report(output, options, results);
+        cout << "Report written to " << options.output_file << endl;
+    }
+    else {
+        write_report(cout, options, results);
+    }
+
+    if (!options.baseline_file.empty() &&
+        compare_to_baseline(options.baseline_file, results, options.tolerance_percent)) {
+        cerr << "Performance regressed beyond " << options.tolerance_percent
+             << "% tolerance" << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+#else // RD_KAFKA_VERSION < RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION
+
+int main() {
+    cerr << "The pipeline benchmark needs the mock cluster, which requires "
+            "librdkafka >= 1.4.0" << endl;
+    return EXIT_FAILURE;
+}
+
+#endif // RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION
@@ -0,0 +1,133 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cppkafka/producer.h"
+#include "cppkafka/configuration.h"
+#include "cppkafka/message_builder.h"
+#include "cppkafka/utils/buffered_producer.h"
+#include "cppkafka/utils/mpsc_ring_buffer.h"
+#include "cppkafka/utils/sharded_queue.h"
+#include "cppkafka/utils/partition_affine_queue.h"
+#include "benchmark_runner.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+using namespace cppkafka;
+using cppkafka::benchmarks::BenchmarkRunner;
+
+// Producer-side microbenchmarks. No broker needs to be reachable: messages are
+// enqueued locally inside librdkafka and expire after message.timeout.ms, which
+// makes librdkafka itself generate the delivery reports (all failed) that
+// exercise the ack bookkeeping, so these numbers are comparable across runs.
+
+static const vector<size_t> THREAD_COUNTS = { 1, 2, 4, 8, 16, 32 };
+static const string PAYLOAD(100, 'a');
+static const string KEY = "benchmark_key";
+static const string TOPIC = "cppkafka_benchmark";
+
+Configuration make_config(const string& brokers) {
+    return {
+        { "metadata.broker.list", brokers },
+        // Expire messages quickly so delivery reports are produced locally
+        { "message.timeout.ms", 100 },
+        { "queue.buffering.max.messages", 10000000 }
+    };
+}
+
+void benchmark_message_builder(BenchmarkRunner& runner) {
+    runner.add("MessageBuilder construction", 2000000, [](size_t iterations) {
+        for (size_t i = 0; i != iterations; ++i) {
+            MessageBuilder builder(TOPIC);
+            builder.partition(static_cast<int>(i % 16)).key(KEY).payload(PAYLOAD);
+            // Keep the optimizer from discarding the builder
+            volatile int partition = builder.partition();
+            (void)partition;
+        }
+    });
+}
+
+void benchmark_producer_produce(BenchmarkRunner& runner, const string& brokers) {
+    auto producer = std::make_shared<Producer>(make_config(brokers));
+    runner.add_threaded("Producer::produce (local enqueue)", 512000, THREAD_COUNTS,
+        [producer](size_t iterations) {
+            MessageBuilder builder(TOPIC);
+            builder.key(KEY).payload(PAYLOAD);
+            for (size_t i = 0; i != iterations; ++i) {
+                producer->produce(builder);
+                if ((i & 0xfff) == 0) {
+                    // Serve expired-message delivery reports along the way
+                    producer->poll(std::chrono::milliseconds(0));
+                }
+            }
+        },
+        [producer]() {
+            // Drain all pending delivery reports before the next pass
+            producer->flush(std::chrono::milliseconds(5000));
+        });
+}
+
+template <typename QueueType>
+void benchmark_add_message(BenchmarkRunner& runner, const string& brokers, const string& name) {
+    using Producer = BufferedProducer<string, std::allocator<ConcreteMessageBuilder<string>>,
+                                      QueueType>;
+    auto producer = std::make_shared<Producer>(make_config(brokers));
+    // Stay under the MpscRingBuffer default capacity since nothing consumes
+    // while the benchmark is running
+    runner.add_threaded("BufferedProducer::add_message [" + name + "]", 32000, THREAD_COUNTS,
+        [producer](size_t iterations) {
+            MessageBuilder builder(TOPIC);
+            builder.key(KEY).payload(PAYLOAD);
+            for (size_t i = 0; i != iterations; ++i) {
+                builder.partition(static_cast<int>(i % 16));
+                producer->add_message(builder);
+            }
+        },
+        [producer]() {
+            producer->clear();
+        });
+}
+
+void benchmark_flush(BenchmarkRunner& runner, const string& brokers) {
+    auto producer = std::make_shared<BufferedProducer<string>>(make_config(brokers));
+    runner.add("BufferedProducer::async_flush (8k message batches)", 256000,
+        [producer](size_t iterations) {
+            MessageBuilder builder(TOPIC);
+            builder.key(KEY).payload(PAYLOAD);
+            size_t produced = 0;
+            while (produced != iterations) {
+                const size_t batch_size = std::min<size_t>(8192, iterations - produced);
+                for (size_t i = 0; i != batch_size; ++i) {
+                    producer->add_message(builder);
+                }
+                producer->async_flush();
+                produced += batch_size;
+            }
+        });
+}
+
+int main(int argc, char* argv[]) {
+    const string brokers = (argc > 1) ? argv[1] : "localhost:9092";
+    cout << "Using broker list: " << brokers << " (does not need to be reachable)" << endl;
+
+    BenchmarkRunner runner;
+    benchmark_message_builder(runner);
+    benchmark_producer_produce(runner, brokers);
+
+    using Builder = ConcreteMessageBuilder<string>;
+    benchmark_add_message<std::deque<Builder, std::allocator<Builder>>>(runner, brokers,
+                                                                        "std::deque");
+    benchmark_add_message<MpscRingBuffer<Builder>>(runner, brokers, "MpscRingBuffer");
+    benchmark_add_message<ShardedQueue<Builder>>(runner, brokers, "ShardedQueue");
+    benchmark_add_message<PartitionAffineQueue<Builder>>(runner, brokers,
+                                                         "PartitionAffineQueue");
+    benchmark_flush(runner, brokers);
+
+    runner.run_all();
+    return EXIT_SUCCESS;
+}
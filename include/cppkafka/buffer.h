@@ -32,6 +32,7 @@
 
 #include <cstddef>
 #include <array>
+#include <string_view>
 #include <vector>
 #include <iosfwd>
 #include <algorithm>
@@ -147,12 +148,22 @@ public:
      * Note that you *can't use temporaries* here as they would be destructed after
      * the constructor finishes.
      */
-    Buffer(const std::string& data); 
+    Buffer(const std::string& data);
 
     /**
      * Don't allow construction from temporary strings
      */
     Buffer(std::string&&) = delete;
+
+    /**
+     * \brief Construct a buffer from a string view
+     *
+     * Like every other constructor this takes no ownership: the viewed
+     * characters must outlive the buffer.
+     */
+    Buffer(std::string_view data)
+    : Buffer(data.data(), data.size()) {
+    }
     
     Buffer(const Buffer&) = delete;
     Buffer(Buffer&&) = default;
@@ -189,6 +200,15 @@ public:
      */
     operator std::string() const;
 
+    /**
+     * \brief Converts this buffer into a string view, without copying
+     *
+     * The view is only valid while the pointed-to data is.
+     */
+    operator std::string_view() const {
+        return std::string_view(reinterpret_cast<const char*>(data_), size_);
+    }
+
     /**
      * \brief Converts the contents of the buffer into a vector.
      *
@@ -210,7 +230,59 @@ private:
 };
 
 /**
- * Compares Buffer objects for equality 
+ * \brief Hex-encodes the buffer contents into a caller-provided buffer
+ *
+ * Writes two lowercase hex characters per input byte, without any allocation
+ * or null terminator. If the output buffer is too small, the encoding is
+ * truncated at a whole byte boundary.
+ *
+ * \param input The buffer to encode
+ * \param output Where the encoded characters are written
+ * \param output_size The capacity of the output buffer
+ * \return The amount of characters written
+ */
+CPPKAFKA_API size_t to_hex(const Buffer& input, char* output, size_t output_size);
+
+/**
+ * Hex-encodes the buffer contents into a string
+ */
+CPPKAFKA_API std::string to_hex(const Buffer& input);
+
+/**
+ * \brief Formats the buffer contents into a caller-provided buffer
+ *
+ * Printable characters are copied verbatim and any other byte is written as a
+ * \\xHH escape, i.e. the same format the output operator produces, without any
+ * allocation or null terminator. If the output buffer is too small, the
+ * formatting is truncated at a whole byte boundary.
+ *
+ * \param input The buffer to format
+ * \param output Where the formatted characters are written
+ * \param output_size The capacity of the output buffer
+ * \return The amount of characters written
+ */
+CPPKAFKA_API size_t to_printable(const Buffer& input, char* output, size_t output_size);
+
+/**
+ * Formats the buffer contents into a string
+ */
+CPPKAFKA_API std::string to_printable(const Buffer& input);
+
+/**
+ * \brief Three-way lexicographical comparison of Buffer objects
+ *
+ * Returns a negative value if lhs compares less than rhs, zero if both are
+ * equal and a positive value otherwise. Prefer this over chaining the
+ * relational operators when ordering buffers (e.g. inside comparators),
+ * since it scans the data only once.
+ *
+ * On x86-64 the comparison kernels are vectorized (SSE2 with an AVX2
+ * variant selected at runtime); other platforms fall back to memcmp.
+ */
+CPPKAFKA_API int compare(const Buffer& lhs, const Buffer& rhs);
+
+/**
+ * Compares Buffer objects for equality
  */
 CPPKAFKA_API bool operator==(const Buffer& lhs, const Buffer& rhs);
 
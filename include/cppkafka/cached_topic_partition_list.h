@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_CACHED_TOPIC_PARTITION_LIST_H
+#define CPPKAFKA_CACHED_TOPIC_PARTITION_LIST_H
+
+#include <cstdint>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+#include "topic_partition_list.h"
+
+namespace cppkafka {
+
+/**
+ * \brief A reusable rd_kafka_topic_partition_list_t wrapper
+ *
+ * convert() builds a fresh native list - including one topic name copy per
+ * entry - on every call, which adds up on paths that pass the same partitions
+ * over and over (e.g. committing offsets after every batch). This class keeps
+ * the native handle alive across calls: as long as the topic/partition layout
+ * doesn't change, update() only patches the offsets in place and performs no
+ * allocation at all.
+ *
+ * Typical usage on a commit path:
+ *
+ * \code
+ * CachedTopicPartitionList cached;
+ * while (running) {
+ *     // consume, process, track offsets in a TopicPartitionList...
+ *     cached.update(offsets);
+ *     consumer.commit(cached);
+ * }
+ * \endcode
+ */
+class CPPKAFKA_API CachedTopicPartitionList {
+public:
+    /**
+     * Constructs an empty cached list
+     */
+    CachedTopicPartitionList();
+
+    /**
+     * \brief Constructs a cached list from the given topic/partitions
+     *
+     * \param topic_partitions The topic/partition list to be converted
+     */
+    explicit CachedTopicPartitionList(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Brings the native list in sync with the given topic/partitions
+     *
+     * If the given list contains the same topics and partitions in the same
+     * order as the cached one, only the offsets are patched in place.
+     * Otherwise the native list is rebuilt from scratch.
+     *
+     * \param topic_partitions The topic/partition list to sync with
+     */
+    void update(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Sets the offset of a single entry in place
+     *
+     * \param index The entry's position within the list
+     * \param offset The offset to be set
+     */
+    void set_offset(size_t index, int64_t offset);
+
+    /**
+     * Gets the amount of entries in the list
+     */
+    size_t get_size() const;
+
+    /**
+     * \brief Gets the native list handle
+     *
+     * The handle stays owned by this object and remains valid until the next
+     * update() that rebuilds the list.
+     */
+    rd_kafka_topic_partition_list_t* get_handle() const;
+
+    /**
+     * Converts the native list back into a TopicPartitionList
+     */
+    TopicPartitionList get_topic_partitions() const;
+
+    /**
+     * Indicates whether this cached list holds a native handle
+     */
+    explicit operator bool() const;
+private:
+    bool matches(const TopicPartitionList& topic_partitions) const;
+
+    TopicPartitionsListPtr handle_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_CACHED_TOPIC_PARTITION_LIST_H
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_CLUSTER_TOPOLOGY_H
+#define CPPKAFKA_CLUSTER_TOPOLOGY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+#include "metadata.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Compact cluster topology snapshot for hot routing lookups
+ *
+ * Metadata::get_topics materializes every topic and partition into nested
+ * vectors of owning objects, which on a cluster with thousands of partitions
+ * means tens of thousands of allocations per refresh — wasteful when all a
+ * partitioner needs is "how many partitions does this topic have" and "who
+ * leads this partition".
+ *
+ * This class parses the raw rd_kafka_metadata_t once into flat arrays: one
+ * topic table plus a single contiguous leader array that all topics share, so
+ * a refresh performs a handful of allocations regardless of partition count.
+ * When update() is called with metadata whose shape matches the current
+ * snapshot (same topics, same partition counts — by far the common case), the
+ * leader array is patched in place without allocating at all; topology
+ * changes fall back to a full rebuild.
+ *
+ * Lookup-heavy callers should resolve the topic index once and use the
+ * index-based accessors in their inner loop:
+ *
+ * \code
+ * ClusterTopology topology(producer.get_metadata());
+ *
+ * const size_t topic = topology.find_topic("events");
+ * for (const auto& record : records) {
+ *     const int32_t partition = hash(record.key) % topology.get_partition_count(topic);
+ *     // topology.get_leader(topic, partition) for broker-affine batching
+ * }
+ * \endcode
+ *
+ * \warning This class performs no synchronization of its own; guard update()
+ * against concurrent lookups externally (or update a copy and swap).
+ */
+class CPPKAFKA_API ClusterTopology {
+public:
+    /**
+     * Represents a broker in this snapshot
+     */
+    struct Broker {
+        int32_t id;
+        int port;
+        std::string host;
+    };
+
+    /**
+     * The index returned by find_topic when the topic is unknown
+     */
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * The leader id returned for partitions without a known leader
+     */
+    static const int32_t UNKNOWN_LEADER = -1;
+
+    /**
+     * Constructs an empty topology snapshot
+     */
+    ClusterTopology();
+
+    /**
+     * Constructs a snapshot from the given metadata
+     *
+     * \param metadata The metadata to be parsed
+     */
+    ClusterTopology(const Metadata& metadata);
+
+    /**
+     * Constructs a snapshot from a raw metadata handle
+     *
+     * \param handle The handle to be parsed. Not owned; only read during
+     *               construction
+     */
+    ClusterTopology(const rd_kafka_metadata_t* handle);
+
+    /**
+     * \brief Refreshes this snapshot against newer metadata
+     *
+     * If the topology's shape is unchanged only the leader array is updated,
+     * in place and allocation free. Otherwise the snapshot is rebuilt.
+     *
+     * \param metadata The metadata to refresh from
+     */
+    void update(const Metadata& metadata);
+
+    /**
+     * \sa ClusterTopology::update
+     */
+    void update(const rd_kafka_metadata_t* handle);
+
+    /**
+     * \brief Finds the index of the given topic
+     *
+     * The index stays valid until an update changes the topology's shape;
+     * compare get_version between lookups to detect that.
+     *
+     * \param topic The topic name to be looked up
+     *
+     * \return The topic's index, or npos if the topic is unknown
+     */
+    size_t find_topic(const std::string& topic) const;
+
+    /**
+     * Gets the partition count for the topic at the given index
+     *
+     * \param topic_index The index obtained from find_topic
+     */
+    size_t get_partition_count(size_t topic_index) const;
+
+    /**
+     * \brief Gets the partition count for the given topic
+     *
+     * \param topic The topic name to be looked up
+     *
+     * \throws ElementNotFound if the topic is unknown
+     */
+    size_t get_partition_count(const std::string& topic) const;
+
+    /**
+     * Gets the leader broker id for a partition of the topic at the given index
+     *
+     * \param topic_index The index obtained from find_topic
+     * \param partition The partition to be looked up
+     *
+     * \return The leader's broker id, or UNKNOWN_LEADER if the partition has
+     *         none (or doesn't exist)
+     */
+    int32_t get_leader(size_t topic_index, int partition) const;
+
+    /**
+     * \brief Gets the leader broker id for a partition of the given topic
+     *
+     * \param topic The topic name to be looked up
+     * \param partition The partition to be looked up
+     *
+     * \throws ElementNotFound if the topic is unknown
+     */
+    int32_t get_leader(const std::string& topic, int partition) const;
+
+    /**
+     * Gets the brokers in this snapshot
+     */
+    const std::vector<Broker>& get_brokers() const;
+
+    /**
+     * Finds the broker with the given id
+     *
+     * \param broker_id The broker id to be looked up
+     *
+     * \return A pointer to the broker, or null if it's unknown
+     */
+    const Broker* find_broker(int32_t broker_id) const;
+
+    /**
+     * Gets the amount of topics in this snapshot
+     */
+    size_t get_topic_count() const;
+
+    /**
+     * \brief Gets this snapshot's version
+     *
+     * Starts at 0 (empty) and increments on every update, so cached indexes
+     * and derived routing tables can detect refreshes cheaply.
+     */
+    uint64_t get_version() const;
+
+    /**
+     * Indicates whether this snapshot contains any topics
+     */
+    bool empty() const;
+private:
+    struct TopicEntry {
+        // Offset of this topic's slice in leaders_
+        uint32_t first_partition;
+        uint32_t partition_count;
+    };
+
+    bool try_patch(const rd_kafka_metadata_t* handle);
+    void rebuild(const rd_kafka_metadata_t* handle);
+
+    std::unordered_map<std::string, size_t> topic_index_;
+    std::vector<TopicEntry> topics_;
+    // Leader ids for all topics, indexed by partition id within each slice
+    std::vector<int32_t> leaders_;
+    std::vector<Broker> brokers_;
+    uint64_t version_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_CLUSTER_TOPOLOGY_H
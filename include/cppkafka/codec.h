@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_CODEC_H
+#define CPPKAFKA_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "buffer.h"
+#include "detail/endianness.h"
+#include "exceptions.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Describes how a struct is laid out on the wire.
+ *
+ * Specialize this for your type with a fields() function returning a tuple of
+ * member pointers, in wire order:
+ *
+ * \code
+ * struct Order {
+ *     uint64_t id;
+ *     int32_t quantity;
+ *     double price;
+ * };
+ *
+ * template <>
+ * struct cppkafka::CodecTraits<Order> {
+ *     static constexpr auto fields() {
+ *         return std::make_tuple(&Order::id, &Order::quantity, &Order::price);
+ *     }
+ * };
+ * \endcode
+ *
+ * Described types can then be passed to encode_to()/decode(). Fields may be
+ * arithmetic types, enums or other described types; everything is packed
+ * big-endian with no padding, so the wire layout doesn't depend on the host's
+ * endianness or the struct's alignment.
+ */
+template <typename T>
+struct CodecTraits;
+
+namespace detail {
+
+template <typename T, typename = void>
+struct is_codec_described : std::false_type {
+
+};
+
+template <typename T>
+struct is_codec_described<T, decltype(void(CodecTraits<T>::fields()))> : std::true_type {
+
+};
+
+template <typename T>
+struct member_pointer_type;
+
+template <typename C, typename M>
+struct member_pointer_type<M C::*> {
+    using type = M;
+};
+
+// Byte-order helpers dispatched on width; 1-byte values pass through
+inline uint8_t host_to_wire(uint8_t value) { return value; }
+inline uint16_t host_to_wire(uint16_t value) { return htobe16(value); }
+inline uint32_t host_to_wire(uint32_t value) { return htobe32(value); }
+inline uint64_t host_to_wire(uint64_t value) { return htobe64(value); }
+inline uint8_t wire_to_host(uint8_t value) { return value; }
+inline uint16_t wire_to_host(uint16_t value) { return be16toh(value); }
+inline uint32_t wire_to_host(uint32_t value) { return be32toh(value); }
+inline uint64_t wire_to_host(uint64_t value) { return be64toh(value); }
+
+template <size_t Size>
+struct uint_of_size;
+
+template <> struct uint_of_size<1> { using type = uint8_t; };
+template <> struct uint_of_size<2> { using type = uint16_t; };
+template <> struct uint_of_size<4> { using type = uint32_t; };
+template <> struct uint_of_size<8> { using type = uint64_t; };
+
+template <typename T>
+constexpr size_t codec_size() {
+    if constexpr (is_codec_described<T>::value) {
+        return std::apply([](auto... members) {
+            return (codec_size<typename member_pointer_type<decltype(members)>::type>()
+                    + ... + size_t(0));
+        }, CodecTraits<T>::fields());
+    }
+    else {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "Type must be arithmetic, enum or CodecTraits-described");
+        return sizeof(T);
+    }
+}
+
+template <typename T>
+uint8_t* codec_encode(uint8_t* output, const T& value) {
+    if constexpr (is_codec_described<T>::value) {
+        std::apply([&](auto... members) {
+            ((output = codec_encode(output, value.*members)), ...);
+        }, CodecTraits<T>::fields());
+        return output;
+    }
+    else {
+        using WireType = typename uint_of_size<sizeof(T)>::type;
+        WireType raw;
+        std::memcpy(&raw, &value, sizeof(T));
+        raw = host_to_wire(raw);
+        std::memcpy(output, &raw, sizeof(T));
+        return output + sizeof(T);
+    }
+}
+
+template <typename T>
+const uint8_t* codec_decode(const uint8_t* input, T& value) {
+    if constexpr (is_codec_described<T>::value) {
+        std::apply([&](auto... members) {
+            ((input = codec_decode(input, value.*members)), ...);
+        }, CodecTraits<T>::fields());
+        return input;
+    }
+    else {
+        using WireType = typename uint_of_size<sizeof(T)>::type;
+        WireType raw;
+        std::memcpy(&raw, input, sizeof(T));
+        raw = wire_to_host(raw);
+        std::memcpy(&value, &raw, sizeof(T));
+        return input + sizeof(T);
+    }
+}
+
+} // detail
+
+/**
+ * \brief The amount of bytes a type occupies on the wire
+ *
+ * This is a compile-time constant: the sum of the field sizes for described
+ * types, sizeof otherwise.
+ */
+template <typename T>
+constexpr size_t encoded_size() {
+    return detail::codec_size<T>();
+}
+
+/**
+ * \brief Encodes a value into a caller-provided buffer
+ *
+ * \param output Where the encoded bytes are written
+ * \param capacity The capacity of the output buffer
+ * \param value The value to encode
+ * \return The amount of bytes written (always encoded_size<T>())
+ * \throws Exception if the output buffer is too small
+ */
+template <typename T>
+size_t encode_to(void* output, size_t capacity, const T& value) {
+    if (capacity < encoded_size<T>()) {
+        throw Exception("Output buffer is too small");
+    }
+    detail::codec_encode(static_cast<uint8_t*>(output), value);
+    return encoded_size<T>();
+}
+
+/**
+ * \brief Appends the encoding of a value to a payload container
+ *
+ * The container must be contiguous and hold some type of size 1, e.g.
+ * std::string or std::vector<uint8_t>, so it can be handed to a message
+ * builder as-is after encoding.
+ *
+ * \param output The container to append to
+ * \param value The value to encode
+ */
+template <typename Container, typename T>
+void encode_to(Container& output, const T& value) {
+    static_assert(sizeof(typename Container::value_type) == 1,
+                  "Container must hold some type of size 1");
+    const size_t offset = output.size();
+    output.resize(offset + encoded_size<T>());
+    detail::codec_encode(reinterpret_cast<uint8_t*>(&output[offset]), value);
+}
+
+/**
+ * \brief Decodes a value from a buffer
+ *
+ * \param input The buffer to decode from
+ * \param offset The offset at which the value starts
+ * \return The decoded value
+ * \throws Exception if the buffer doesn't contain enough bytes
+ */
+template <typename T>
+T decode(const Buffer& input, size_t offset = 0) {
+    if (input.get_size() < offset || input.get_size() - offset < encoded_size<T>()) {
+        throw Exception("Input buffer is too small");
+    }
+    T value{};
+    detail::codec_decode(input.get_data() + offset, value);
+    return value;
+}
+
+} // cppkafka
+
+#endif // CPPKAFKA_CODEC_H
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_COMPACT_TOPIC_PARTITION_LIST_H
+#define CPPKAFKA_COMPACT_TOPIC_PARTITION_LIST_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include "detail/small_vector.h"
+#include "macros.h"
+#include "topic_partition.h"
+#include "topic_partition_list.h"
+
+namespace cppkafka {
+
+/**
+ * \brief A structure-of-arrays topic/partition list with interned topic names
+ *
+ * TopicPartitionList stores one heap allocated std::string per entry even
+ * though most lists span only one or two distinct topics, so scanning and
+ * patching them touches scattered string data. This container keeps a small
+ * interned topic table and parallel partition/offset arrays instead; lists of
+ * up to 8 entries live entirely inside the object without any heap
+ * allocation, and offset updates and lookups walk dense integer arrays.
+ *
+ * It converts to and from TopicPartitionList so it can be fed to any of the
+ * existing APIs, and mirrors the operations rebalance handling typically
+ * performs on lists (lookup, offset patching, filtering by topic/partition).
+ */
+class CPPKAFKA_API CompactTopicPartitionList {
+public:
+    /**
+     * Indicates an entry that could not be found
+     */
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * Constructs an empty list
+     */
+    CompactTopicPartitionList() = default;
+
+    /**
+     * \brief Constructs a compact list from a TopicPartitionList
+     *
+     * \param topic_partitions The topic/partition list to be converted
+     */
+    CompactTopicPartitionList(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Appends an entry to the list
+     *
+     * \param topic The topic name; interned, so repeated names share storage
+     * \param partition The partition
+     * \param offset The offset; defaults to TopicPartition::OFFSET_INVALID
+     */
+    void add(const std::string& topic, int partition,
+             int64_t offset = TopicPartition::OFFSET_INVALID);
+
+    /**
+     * \brief Appends an entry to the list
+     *
+     * \param topic_partition The topic/partition to be appended
+     */
+    void add(const TopicPartition& topic_partition);
+
+    /**
+     * \brief Finds the position of the given topic/partition
+     *
+     * \param topic The topic name
+     * \param partition The partition
+     *
+     * \return The entry's position, or npos if it's not in the list
+     */
+    size_t find(const std::string& topic, int partition) const;
+
+    /**
+     * Gets the topic name of the entry at the given position
+     */
+    const std::string& get_topic(size_t index) const;
+
+    /**
+     * Gets the partition of the entry at the given position
+     */
+    int get_partition(size_t index) const;
+
+    /**
+     * Gets the offset of the entry at the given position
+     */
+    int64_t get_offset(size_t index) const;
+
+    /**
+     * Sets the offset of the entry at the given position
+     */
+    void set_offset(size_t index, int64_t offset);
+
+    /**
+     * Gets the amount of entries in the list
+     */
+    size_t get_size() const;
+
+    /**
+     * Indicates whether the list is empty
+     */
+    bool empty() const;
+
+    /**
+     * Gets the amount of distinct topics in the list
+     */
+    size_t get_topic_count() const;
+
+    /**
+     * \brief Extracts the subset of entries belonging to the given topics
+     *
+     * Topic names are matched case-insensitively, like the free function
+     * find_matches over TopicPartitionList. The topic table is consulted
+     * once per distinct topic rather than once per entry.
+     *
+     * \param topics The topic names to be looked up
+     */
+    CompactTopicPartitionList find_matches(const std::set<std::string>& topics) const;
+
+    /**
+     * \brief Extracts the subset of entries with the given partition ids
+     *
+     * \param ids The partition ids to be looked up
+     */
+    CompactTopicPartitionList find_matches(const std::set<int>& ids) const;
+
+    /**
+     * Converts this list into a TopicPartitionList
+     */
+    TopicPartitionList get_topic_partitions() const;
+private:
+    // Inline capacity of the per-entry arrays; lists at or below this size
+    // perform no heap allocation for them
+    static constexpr size_t INLINE_ENTRIES = 8;
+
+    uint16_t intern_topic(const std::string& topic);
+
+    std::vector<std::string> topics_;
+    detail::SmallVector<uint16_t, INLINE_ENTRIES> topic_ids_;
+    detail::SmallVector<int32_t, INLINE_ENTRIES> partitions_;
+    detail::SmallVector<int64_t, INLINE_ENTRIES> offsets_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_COMPACT_TOPIC_PARTITION_LIST_H
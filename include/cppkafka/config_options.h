@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_CONFIG_OPTIONS_H
+#define CPPKAFKA_CONFIG_OPTIONS_H
+
+#include <string>
+#include <type_traits>
+
+namespace cppkafka {
+
+/**
+ * The configuration level a statically described option applies to
+ */
+enum class ConfigScope {
+    GLOBAL,
+    TOPIC,
+    ANY
+};
+
+/**
+ * \brief Compile-time catalog of well known rdkafka configuration options
+ *
+ * Each type in this namespace describes one option: its rdkafka name, the
+ * C++ type of its value and whether it belongs to the global or the topic
+ * configuration. They're meant to be used with the typed
+ * ConfigurationBase::set overload:
+ *
+ * \code
+ * Configuration config;
+ * config.set<option::GroupId>("my-group")
+ *       .set<option::LingerMs>(5)
+ *       .set<option::EnableAutoCommit>(false);
+ * \endcode
+ *
+ * Misspelled names can't happen (an unknown catalog entry fails to compile),
+ * mismatched value types are rejected at compile time and applying a topic
+ * level option to a global configuration (or vice versa) is a compile error
+ * as well.
+ */
+namespace option {
+
+#define CPPKAFKA_CONFIG_OPTION(type_name, option_name, option_type, option_scope) \
+struct type_name {                                                                \
+    static constexpr const char* name = option_name;                              \
+    using ValueType = option_type;                                                \
+    static constexpr ConfigScope scope = ConfigScope::option_scope;               \
+};
+
+// Broker and client identity
+CPPKAFKA_CONFIG_OPTION(BootstrapServers, "bootstrap.servers", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(MetadataBrokerList, "metadata.broker.list", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(ClientId, "client.id", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(GroupId, "group.id", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(GroupInstanceId, "group.instance.id", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(Debug, "debug", std::string, GLOBAL)
+
+// Message sizing and protocol limits
+CPPKAFKA_CONFIG_OPTION(MessageMaxBytes, "message.max.bytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(ReceiveMessageMaxBytes, "receive.message.max.bytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(MaxInFlight, "max.in.flight", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(ApiVersionRequest, "api.version.request", bool, GLOBAL)
+
+// Timeouts, retries and backoff
+CPPKAFKA_CONFIG_OPTION(SocketTimeoutMs, "socket.timeout.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SocketKeepaliveEnable, "socket.keepalive.enable", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(ReconnectBackoffMs, "reconnect.backoff.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(ReconnectBackoffMaxMs, "reconnect.backoff.max.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(RetryBackoffMs, "retry.backoff.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(MessageSendMaxRetries, "message.send.max.retries", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(StatisticsIntervalMs, "statistics.interval.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(LogConnectionClose, "log.connection.close", bool, GLOBAL)
+
+// Consumer group / fetcher behavior
+CPPKAFKA_CONFIG_OPTION(SessionTimeoutMs, "session.timeout.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(HeartbeatIntervalMs, "heartbeat.interval.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(MaxPollIntervalMs, "max.poll.interval.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(PartitionAssignmentStrategy, "partition.assignment.strategy", std::string,
+                       GLOBAL)
+CPPKAFKA_CONFIG_OPTION(EnableAutoCommit, "enable.auto.commit", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(AutoCommitIntervalMs, "auto.commit.interval.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(EnableAutoOffsetStore, "enable.auto.offset.store", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(EnablePartitionEof, "enable.partition.eof", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(AllowAutoCreateTopics, "allow.auto.create.topics", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(FetchMinBytes, "fetch.min.bytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(FetchMaxBytes, "fetch.max.bytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(FetchWaitMaxMs, "fetch.wait.max.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(FetchMessageMaxBytes, "fetch.message.max.bytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(QueuedMinMessages, "queued.min.messages", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(QueuedMaxMessagesKbytes, "queued.max.messages.kbytes", int, GLOBAL)
+
+// Producer batching and reliability
+CPPKAFKA_CONFIG_OPTION(LingerMs, "linger.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(BatchNumMessages, "batch.num.messages", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(BatchSize, "batch.size", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(QueueBufferingMaxMessages, "queue.buffering.max.messages", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(QueueBufferingMaxKbytes, "queue.buffering.max.kbytes", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(EnableIdempotence, "enable.idempotence", bool, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(TransactionalId, "transactional.id", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(TransactionTimeoutMs, "transaction.timeout.ms", int, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(CompressionCodec, "compression.codec", std::string, ANY)
+CPPKAFKA_CONFIG_OPTION(CompressionLevel, "compression.level", int, ANY)
+
+// Security
+CPPKAFKA_CONFIG_OPTION(SecurityProtocol, "security.protocol", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SaslMechanism, "sasl.mechanism", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SaslUsername, "sasl.username", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SaslPassword, "sasl.password", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SslCaLocation, "ssl.ca.location", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SslCertificateLocation, "ssl.certificate.location", std::string, GLOBAL)
+CPPKAFKA_CONFIG_OPTION(SslKeyLocation, "ssl.key.location", std::string, GLOBAL)
+
+// Topic level options
+CPPKAFKA_CONFIG_OPTION(RequestRequiredAcks, "request.required.acks", int, TOPIC)
+CPPKAFKA_CONFIG_OPTION(Acks, "acks", int, TOPIC)
+CPPKAFKA_CONFIG_OPTION(RequestTimeoutMs, "request.timeout.ms", int, TOPIC)
+CPPKAFKA_CONFIG_OPTION(MessageTimeoutMs, "message.timeout.ms", int, TOPIC)
+CPPKAFKA_CONFIG_OPTION(Partitioner, "partitioner", std::string, TOPIC)
+CPPKAFKA_CONFIG_OPTION(AutoOffsetReset, "auto.offset.reset", std::string, TOPIC)
+
+#undef CPPKAFKA_CONFIG_OPTION
+
+} // option
+
+namespace detail {
+
+// Detects whether a type describes a catalog option
+template <typename T, typename = void>
+struct is_config_option : std::false_type {
+
+};
+
+template <typename T>
+struct is_config_option<T, typename std::enable_if<
+        std::is_same<decltype(T::name), const char* const>::value &&
+        std::is_same<decltype(T::scope), const ConfigScope>::value>::type>
+: std::true_type {
+
+};
+
+} // detail
+
+} // cppkafka
+
+#endif // CPPKAFKA_CONFIG_OPTIONS_H
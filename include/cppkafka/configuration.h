@@ -40,6 +40,8 @@
 #include "topic_configuration.h"
 #include "clonable_ptr.h"
 #include "configuration_base.h"
+#include "kafka_statistics.h"
+#include "thread_configuration.h"
 #include "macros.h"
 #include "event.h"
 
@@ -61,6 +63,11 @@ class KafkaHandleBase;
  */
 class CPPKAFKA_API Configuration : public ConfigurationBase<Configuration> {
 public:
+    /**
+     * The configuration level typed catalog options are validated against
+     */
+    static constexpr ConfigScope OPTION_SCOPE = ConfigScope::GLOBAL;
+
     using DeliveryReportCallback = std::function<void(Producer& producer, const Message&)>;
     using OffsetCommitCallback = std::function<void(Consumer& consumer,
                                                     Error error,
@@ -77,6 +84,8 @@ public:
                                            const std::string& facility,
                                            const std::string& message)>;
     using StatsCallback = std::function<void(KafkaHandleBase& handle, const std::string& json)>;
+    using ParsedStatsCallback = std::function<void(KafkaHandleBase& handle,
+                                                   const KafkaStatistics& statistics)>;
     using SocketCallback = std::function<int(int domain, int type, int protocol)>;
     using BackgroundEventCallback = std::function<void(KafkaHandleBase& handle, Event)>;
 
@@ -138,7 +147,18 @@ public:
      */
     Configuration& set_stats_callback(StatsCallback callback);
 
-    /** 
+    /**
+     * \brief Sets the typed stats callback (invokes rd_kafka_conf_set_stats_cb)
+     *
+     * Instead of receiving the raw statistics JSON, the callback receives a
+     * KafkaStatistics struct parsed in a single allocation-free pass, which
+     * avoids the cost of running a DOM parser on every statistics interval.
+     * Both this and the raw string overload may be set at the same time; each
+     * is invoked with its respective representation.
+     */
+    Configuration& set_stats_callback(ParsedStatsCallback callback);
+
+    /**
      * Sets the socket callback (invokes rd_kafka_conf_set_socket_cb)
      */
     Configuration& set_socket_callback(SocketCallback callback);
@@ -155,7 +175,24 @@ public:
     Configuration& set_events(int events);
 #endif
 
-    /** 
+#if RD_KAFKA_VERSION >= RD_KAFKA_INTERCEPTOR_SUPPORT_VERSION
+    /**
+     * \brief Sets the configuration applied to librdkafka's internal threads
+     *
+     * A copy of the given ThreadConfiguration is attached to the rdkafka handle
+     * via conf interceptors and applied to each of its threads (main, background
+     * and broker) as the thread starts. The copy follows the handle's lifetime,
+     * including across Configuration copies.
+     *
+     * \remark This should be set at most once per configuration; rdkafka rejects
+     * duplicate interceptor registrations
+     *
+     * \sa ThreadConfiguration
+     */
+    Configuration& set_thread_configuration(ThreadConfiguration config);
+#endif
+
+    /**
      * Sets the default topic configuration
      */
     Configuration& set_default_topic_configuration(TopicConfiguration config);
@@ -212,6 +249,11 @@ public:
      */
     const StatsCallback& get_stats_callback() const;
 
+    /**
+     * Gets the typed stats callback
+     */
+    const ParsedStatsCallback& get_parsed_stats_callback() const;
+
     /**
      * Gets the socket callback
      */
@@ -222,6 +264,11 @@ public:
      */
     const BackgroundEventCallback& get_background_event_callback() const;
 
+    /**
+     * Gets the thread configuration, if any was set
+     */
+    const std::optional<ThreadConfiguration>& get_thread_configuration() const;
+
     /**
      * Gets the default topic configuration
      */
@@ -240,12 +287,14 @@ private:
 
     HandlePtr handle_;
     std::optional<TopicConfiguration> default_topic_config_;
+    std::optional<ThreadConfiguration> thread_configuration_;
     DeliveryReportCallback delivery_report_callback_;
     OffsetCommitCallback offset_commit_callback_;
     ErrorCallback error_callback_;
     ThrottleCallback throttle_callback_;
     LogCallback log_callback_;
     StatsCallback stats_callback_;
+    ParsedStatsCallback parsed_stats_callback_;
     SocketCallback socket_callback_;
     BackgroundEventCallback background_event_callback_;
 };
@@ -31,8 +31,10 @@
 #define CPPKAFKA_CONFIGURATION_BASE_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
+#include "config_options.h"
 #include "exceptions.h"
 #include "configuration_option.h"
 
@@ -67,6 +69,42 @@ public:
         return proxy_set(name, value);
     }
 
+    /**
+     * Sets a string_view value
+     */
+    Concrete& set(const std::string& name, std::string_view value) {
+        return proxy_set(name, std::string(value));
+    }
+
+    /**
+     * \brief Sets an option described by the compile-time catalog
+     *
+     * The option's rdkafka name and value type come from the catalog entry
+     * (see the option namespace in config_options.h), so typos and value
+     * type mismatches are rejected at compile time, as is applying an
+     * option to the wrong configuration level:
+     *
+     * \code
+     * config.set<option::LingerMs>(5);
+     * \endcode
+     *
+     * \param value The value to be set, of the option's declared type
+     */
+    template <typename Option>
+    Concrete& set(const typename Option::ValueType& value) {
+        static_assert(detail::is_config_option<Option>::value,
+                      "Option must be a config_options.h catalog entry");
+        static_assert(Option::scope == ConfigScope::ANY ||
+                      Option::scope == Concrete::OPTION_SCOPE,
+                      "Option does not apply to this configuration level");
+        if constexpr (std::is_same<typename Option::ValueType, std::string>::value) {
+            return proxy_set(Option::name, value);
+        }
+        else {
+            return set(std::string(Option::name), value);
+        }
+    }
+
     /**
      * Sets a list of options
      */
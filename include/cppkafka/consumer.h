@@ -34,14 +34,18 @@
 #include <string>
 #include <chrono>
 #include <functional>
+#include <type_traits>
 #include "kafka_handle_base.h"
 #include "queue.h"
 #include "macros.h"
 #include "error.h"
+#include "message_batch.h"
+#include "partition_offset_result.h"
 #include "detail/callback_invoker.h"
 
 namespace cppkafka {
 
+class CachedTopicPartitionList;
 class TopicConfiguration;
 
 /**
@@ -113,6 +117,18 @@ public:
      * \param config The configuration to be used
      */
     Consumer(Configuration config);
+
+    /**
+     * \brief Constructs a consumer sharing a frozen configuration
+     *
+     * The frozen configuration is shared by reference count rather than
+     * duplicated; only the rd_kafka_conf_t duplicate consumed by rd_kafka_new
+     * is created. Prefer this when creating many consumers from the same
+     * options.
+     *
+     * \param config The frozen configuration to be used
+     */
+    Consumer(FrozenConfiguration config);
     Consumer(const Consumer&) = delete;
     Consumer(Consumer&&) = delete;
     Consumer& operator=(const Consumer&) = delete;
@@ -135,6 +151,11 @@ public:
      * \note You *do not need* to call Consumer::assign with the provided topic parttitions. This
      * will be handled automatically by cppkafka.
      *
+     * \remark When the group uses the cooperative rebalance protocol (e.g.
+     * partition.assignment.strategy=cooperative-sticky), the callback receives only the
+     * partitions added by each rebalance rather than the full assignment, and cppkafka
+     * applies them via Consumer::incremental_assign.
+     *
      * \param callback The topic/partition assignment callback
      */
     void set_assignment_callback(AssignmentCallback callback);
@@ -150,6 +171,11 @@ public:
      * anything like that. That's handled automatically by cppkafka. This is just a notifitation
      * so your application code can react to revocations
      *
+     * \remark When the group uses the cooperative rebalance protocol, the callback receives
+     * only the partitions being revoked rather than the full assignment, and cppkafka
+     * applies the removal via Consumer::incremental_unassign; unrevoked partitions keep
+     * consuming throughout the rebalance.
+     *
      * \param callback The topic/partition revocation callback
      */
     void set_revocation_callback(RevocationCallback callback);
@@ -195,7 +221,73 @@ public:
      * parameter
      */
     void unassign();
-    
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_INCREMENTAL_REBALANCE_SUPPORT_VERSION)
+    /**
+     * \brief Incrementally adds partitions to the current assignment
+     *
+     * This translates into a call to rd_kafka_incremental_assign. Unlike
+     * Consumer::assign, the current assignment (and all per-partition state,
+     * fetch positions included) is left untouched; only the given partitions
+     * are added. Valid regardless of the rebalance protocol in use, but
+     * mandatory when handling assignments under the cooperative protocol -
+     * which cppkafka's own rebalance handling does automatically.
+     *
+     * \param topic_partitions The partitions to add to the assignment
+     */
+    void incremental_assign(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Incrementally removes partitions from the current assignment
+     *
+     * This translates into a call to rd_kafka_incremental_unassign. The
+     * remaining partitions keep consuming without interruption.
+     *
+     * \param topic_partitions The partitions to remove from the assignment
+     */
+    void incremental_unassign(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Gets the rebalance protocol currently in effect
+     *
+     * This translates into a call to rd_kafka_rebalance_protocol.
+     *
+     * \return "NONE", "EAGER" or "COOPERATIVE"
+     */
+    std::string get_rebalance_protocol() const;
+#endif
+
+    /**
+     * \brief Resolves timestamps to offsets and assigns the partitions in one pass
+     *
+     * Replaying N partitions from timestamps via get_offsets_for_times plus
+     * assign builds three native lists and pays two conversions per call.
+     * This combines both: the queried timestamps are loaded into a single
+     * native list, rd_kafka_offsets_for_times patches the offsets in place,
+     * and the very same list is handed to rd_kafka_assign. One broker round
+     * trip, one list, no intermediate conversions.
+     *
+     * \param queries A map from topic/partition to the timestamp to seek to
+     *
+     * \return The assigned partitions with their resolved offsets
+     */
+    TopicPartitionList seek_to_timestamps(const TopicPartitionsTimestampsMap& queries);
+
+    /**
+     * \brief Resolves timestamps to offsets and assigns the partitions in one pass
+     *
+     * Same as the other overload of Consumer::seek_to_timestamps but the
+     * provided timeout will be used instead of the one configured on this
+     * Consumer.
+     *
+     * \param queries A map from topic/partition to the timestamp to seek to
+     * \param timeout The timeout for the offset lookup
+     *
+     * \return The assigned partitions with their resolved offsets
+     */
+    TopicPartitionList seek_to_timestamps(const TopicPartitionsTimestampsMap& queries,
+                                          std::chrono::milliseconds timeout);
+
     /**
      * \brief Pauses all consumption
      */
@@ -260,6 +352,26 @@ public:
      */
     void async_commit(const TopicPartitionList& topic_partitions);
 
+    /**
+     * \brief Commits the offsets on the given cached topic/partitions synchronously
+     *
+     * This translates into a call to rd_kafka_commit using the cached native
+     * list directly, so no per-call list conversion takes place.
+     *
+     * \param topic_partitions The cached topic/partition list to be committed
+     */
+    void commit(const CachedTopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Commits the offsets on the given cached topic/partitions asynchronously
+     *
+     * This translates into a call to rd_kafka_commit using the cached native
+     * list directly, so no per-call list conversion takes place.
+     *
+     * \param topic_partitions The cached topic/partition list to be committed
+     */
+    void async_commit(const CachedTopicPartitionList& topic_partitions);
+
     /**
      * \brief Gets the minimum and maximum offsets for the given topic/partition
      *
@@ -296,6 +408,45 @@ public:
     TopicPartitionList get_offsets_committed(const TopicPartitionList& topic_partitions,
                                              std::chrono::milliseconds timeout) const;
 
+    /**
+     * \brief Gets the committed offsets without allocating
+     *
+     * Unlike the TopicPartitionList overloads, this queries rd_kafka_committed
+     * through a reusable cached list and writes the outcome into a
+     * caller-provided array of trivially copyable results, so polling committed
+     * offsets in a loop - or under broker flapping, where every retry would
+     * otherwise rebuild a whole list - never touches the heap. Results are
+     * positional: results[i] refers to entry i of the cached list.
+     *
+     * \remark Per-partition errors are reported in the results instead of being
+     * thrown, so one flapping partition doesn't hide the others' offsets; only
+     * call-level failures raise HandleException.
+     *
+     * \param topic_partitions The cached topic/partition list to be queried
+     * \param results The caller-provided results array
+     * \param capacity The results array's capacity; must cover the list
+     *
+     * \return The amount of results written
+     */
+    size_t get_offsets_committed(const CachedTopicPartitionList& topic_partitions,
+                                 PartitionOffsetResult* results, size_t capacity) const;
+
+    /**
+     * \brief Gets the committed offsets without allocating, with a timeout
+     *
+     * \sa get_offsets_committed(const CachedTopicPartitionList&, PartitionOffsetResult*, size_t)
+     *
+     * \param topic_partitions The cached topic/partition list to be queried
+     * \param results The caller-provided results array
+     * \param capacity The results array's capacity; must cover the list
+     * \param timeout The timeout for this operation. Supersedes the default consumer timeout.
+     *
+     * \return The amount of results written
+     */
+    size_t get_offsets_committed(const CachedTopicPartitionList& topic_partitions,
+                                 PartitionOffsetResult* results, size_t capacity,
+                                 std::chrono::milliseconds timeout) const;
+
     /**
      * \brief Gets the offset positions for the given topic/partition list
      *
@@ -306,6 +457,20 @@ public:
      * \return The topic partition list
      */
     TopicPartitionList get_offsets_position(const TopicPartitionList& topic_partitions) const;
+
+    /**
+     * \brief Gets the offset positions without allocating
+     *
+     * \sa get_offsets_committed(const CachedTopicPartitionList&, PartitionOffsetResult*, size_t)
+     *
+     * \param topic_partitions The cached topic/partition list to be queried
+     * \param results The caller-provided results array
+     * \param capacity The results array's capacity; must cover the list
+     *
+     * \return The amount of results written
+     */
+    size_t get_offsets_position(const CachedTopicPartitionList& topic_partitions,
+                                PartitionOffsetResult* results, size_t capacity) const;
 #if (RD_KAFKA_VERSION >= RD_KAFKA_STORE_OFFSETS_SUPPORT_VERSION)
     /**
      * \brief Stores the offsets on the currently assigned topic/partitions (legacy).
@@ -327,6 +492,20 @@ public:
      * \note When using this API it's recommended to set enable.auto.offset.store=false and enable.auto.commit=true.
      */
     void store_offsets(const TopicPartitionList& topic_partitions) const;
+
+    /**
+     * \brief Stores the offsets for a batch of messages (legacy).
+     *
+     * This finds the highest offset per partition in the batch and stores them all
+     * through a single call to rd_kafka_offsets_store, which is considerably cheaper
+     * than calling store_offset once per message when consuming via poll_batch.
+     * Like store_offset, the stored offset is the message offset plus one.
+     *
+     * \param messages The messages whose offsets will be stored.
+     *
+     * \note When using this API it's recommended to set enable.auto.offset.store=false and enable.auto.commit=true.
+     */
+    void store_offsets(const std::vector<Message>& messages) const;
 #endif
     /**
      * \brief Stores the offset for this message (legacy).
@@ -339,6 +518,30 @@ public:
      */
     void store_offset(const Message& msg) const;
 
+    /**
+     * \brief Enables or disables byte tracking of polled messages
+     *
+     * When enabled, every valid message returned by poll and the vector
+     * poll_batch overloads carries an accounting hook that raises the
+     * held-bytes gauge on this handle's HandleStatistics and lowers it again
+     * when the message is destroyed, so the gauge reports the payload bytes
+     * the application is currently holding on to (and its high water mark the
+     * worst case ever reached). Useful to catch consumers that keep messages
+     * alive too long, which pins librdkafka-owned payload memory.
+     *
+     * Disabled by default since the hook costs one small allocation per
+     * message. Messages polled through MessageBatch are not tracked; the
+     * batch reuses its message slots.
+     *
+     * \param enabled Whether to track the bytes held by polled messages
+     */
+    void set_message_byte_tracking(bool enabled);
+
+    /**
+     * \brief Gets whether byte tracking of polled messages is enabled
+     */
+    bool get_message_byte_tracking() const;
+
     /**
      * \brief Gets the current topic subscription
      *
@@ -473,7 +676,70 @@ public:
      */
     std::vector<Message> poll_batch(size_t max_batch_size,
                                     std::chrono::milliseconds timeout);
-    
+
+    /**
+     * \brief Polls for a batch of messages, reusing the given batch's storage
+     *
+     * Unlike the other poll_batch overloads this does not allocate a fresh message
+     * vector per call: the batch keeps both the raw message array handed to
+     * librdkafka and the vector of Message views alive between calls, making the
+     * steady-state consume loop allocation-free. Messages previously held by the
+     * batch are destroyed.
+     *
+     * \param batch The batch to poll messages into
+     *
+     * \return The number of messages polled
+     */
+    size_t poll_batch(MessageBatch& batch);
+
+    /**
+     * \brief Polls for a batch of messages, reusing the given batch's storage
+     *
+     * Same as the other overload of Consumer::poll_batch(MessageBatch&) but the
+     * provided timeout will be used instead of the one configured on this Consumer.
+     *
+     * \param batch The batch to poll messages into
+     * \param timeout The timeout for this operation
+     *
+     * \return The number of messages polled
+     */
+    size_t poll_batch(MessageBatch& batch, std::chrono::milliseconds timeout);
+
+    /**
+     * \brief Polls for a batch of messages into an output iterator
+     *
+     * Unlike the vector returning overloads this writes the messages straight
+     * into caller owned storage (a reused vector via std::back_inserter, an
+     * array of Message slots, etc), so tight consume loops don't construct and
+     * destroy a container per call. Batches of up to 512 messages don't touch
+     * the heap at all.
+     *
+     * \param output The iterator the messages are written to
+     * \param max_batch_size The maximum amount of messages expected
+     *
+     * \return The number of messages written
+     */
+    template <typename OutputIterator,
+              typename = typename std::enable_if<!std::is_integral<OutputIterator>::value>::type>
+    size_t poll_batch(OutputIterator output, size_t max_batch_size);
+
+    /**
+     * \brief Polls for a batch of messages into an output iterator
+     *
+     * Same as Consumer::poll_batch(OutputIterator, size_t) but the provided
+     * timeout will be used instead of the one configured on this Consumer.
+     *
+     * \param output The iterator the messages are written to
+     * \param max_batch_size The maximum amount of messages expected
+     * \param timeout The timeout for this operation
+     *
+     * \return The number of messages written
+     */
+    template <typename OutputIterator,
+              typename = typename std::enable_if<!std::is_integral<OutputIterator>::value>::type>
+    size_t poll_batch(OutputIterator output, size_t max_batch_size,
+                      std::chrono::milliseconds timeout);
+
     /**
      * \brief Get the global event queue servicing this consumer corresponding to
      *        rd_kafka_queue_get_main and which is polled via rd_kafka_poll
@@ -506,16 +772,22 @@ public:
      */
     Queue get_partition_queue(const TopicPartition& partition) const;
 private:
+    // Largest batch whose raw message array fits on the stack (4KB of pointers)
+    static constexpr size_t STACK_BATCH_SIZE = 512;
+
     static void rebalance_proxy(rd_kafka_t *handle, rd_kafka_resp_err_t error,
                                 rd_kafka_topic_partition_list_t *partitions, void *opaque);
     void close();
     void commit(const Message& msg, bool async);
     void commit(const TopicPartitionList* topic_partitions, bool async);
+    void commit(const CachedTopicPartitionList& topic_partitions, bool async);
     void handle_rebalance(rd_kafka_resp_err_t err, TopicPartitionList& topic_partitions);
+    void account_held_message(Message& message);
 
     AssignmentCallback assignment_callback_;
     RevocationCallback revocation_callback_;
     RebalanceErrorCallback rebalance_error_callback_;
+    bool message_byte_tracking_{false};
 };
 
 // Implementations
@@ -532,18 +804,79 @@ std::vector<Message, Allocator> Consumer::poll_batch(size_t max_batch_size,
     std::vector<rd_kafka_message_t*> raw_messages(max_batch_size);
     // Note that this will leak the queue when using rdkafka < 0.11.5 (see get_queue comment)
     Queue queue = Queue::make_queue(rd_kafka_queue_get_consumer(get_handle()));
+    const auto start = std::chrono::steady_clock::now();
     ssize_t result = rd_kafka_consume_batch_queue(queue.get_handle(),
                                                   timeout.count(),
                                                   raw_messages.data(),
                                                   raw_messages.size());
+    HandleStatistics& statistics = get_statistics();
+    statistics.record_poll(std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start),
+                           result > 0);
     if (result == -1) {
         check_error(rd_kafka_last_error());
         // on the off-chance that check_error() does not throw an error
         return std::vector<Message, Allocator>(alloc);
     }
-    return std::vector<Message, Allocator>(raw_messages.begin(),
-                                           raw_messages.begin() + result,
-                                           alloc);
+    for (ssize_t i = 0; i < result; ++i) {
+        if (raw_messages[i]->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+            statistics.record_consume(raw_messages[i]->len);
+        }
+    }
+    std::vector<Message, Allocator> messages(raw_messages.begin(),
+                                             raw_messages.begin() + result,
+                                             alloc);
+    if (message_byte_tracking_) {
+        for (Message& message : messages) {
+            account_held_message(message);
+        }
+    }
+    return messages;
+}
+
+template <typename OutputIterator, typename>
+size_t Consumer::poll_batch(OutputIterator output, size_t max_batch_size) {
+    return poll_batch(output, max_batch_size, get_timeout());
+}
+
+template <typename OutputIterator, typename>
+size_t Consumer::poll_batch(OutputIterator output, size_t max_batch_size,
+                            std::chrono::milliseconds timeout) {
+    // Small batches keep the raw message array on the stack
+    rd_kafka_message_t* stack_messages[STACK_BATCH_SIZE];
+    std::vector<rd_kafka_message_t*> heap_messages;
+    rd_kafka_message_t** raw_messages = stack_messages;
+    if (max_batch_size > STACK_BATCH_SIZE) {
+        heap_messages.resize(max_batch_size);
+        raw_messages = heap_messages.data();
+    }
+    // Note that this will leak the queue when using rdkafka < 0.11.5 (see get_queue comment)
+    Queue queue = Queue::make_queue(rd_kafka_queue_get_consumer(get_handle()));
+    const auto start = std::chrono::steady_clock::now();
+    const ssize_t result = rd_kafka_consume_batch_queue(queue.get_handle(),
+                                                        timeout.count(),
+                                                        raw_messages,
+                                                        max_batch_size);
+    HandleStatistics& statistics = get_statistics();
+    statistics.record_poll(std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start),
+                           result > 0);
+    if (result == -1) {
+        check_error(rd_kafka_last_error());
+        // on the off-chance that check_error() does not throw an error
+        return 0;
+    }
+    for (ssize_t i = 0; i < result; ++i) {
+        if (raw_messages[i]->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+            statistics.record_consume(raw_messages[i]->len);
+        }
+        Message message(raw_messages[i]);
+        if (message_byte_tracking_) {
+            account_held_message(message);
+        }
+        *output++ = std::move(message);
+    }
+    return static_cast<size_t>(result);
 }
 
 } // cppkafka
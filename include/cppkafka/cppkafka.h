@@ -31,7 +31,12 @@
 #define CPPKAFKA_H
 
 #include <cppkafka/buffer.h>
+#include <cppkafka/cached_topic_partition_list.h>
 #include <cppkafka/clonable_ptr.h>
+#include <cppkafka/cluster_topology.h>
+#include <cppkafka/codec.h>
+#include <cppkafka/compact_topic_partition_list.h>
+#include <cppkafka/config_options.h>
 #include <cppkafka/configuration.h>
 #include <cppkafka/configuration_base.h>
 #include <cppkafka/configuration_option.h>
@@ -39,31 +44,63 @@
 #include <cppkafka/error.h>
 #include <cppkafka/event.h>
 #include <cppkafka/exceptions.h>
+#include <cppkafka/frozen_configuration.h>
+#include <cppkafka/gathered_payload.h>
 #include <cppkafka/group_information.h>
+#include <cppkafka/handle_statistics.h>
 #include <cppkafka/header.h>
 #include <cppkafka/header_list.h>
 #include <cppkafka/header_list_iterator.h>
+#include <cppkafka/header_schema.h>
 #include <cppkafka/kafka_handle_base.h>
+#include <cppkafka/kafka_statistics.h>
 #include <cppkafka/logging.h>
 #include <cppkafka/macros.h>
 #include <cppkafka/message.h>
+#include <cppkafka/message_batch.h>
 #include <cppkafka/message_builder.h>
 #include <cppkafka/message_internal.h>
+#include <cppkafka/message_pool.h>
 #include <cppkafka/message_timestamp.h>
 #include <cppkafka/metadata.h>
+#include <cppkafka/mock_cluster.h>
+#include <cppkafka/owning_buffer.h>
+#include <cppkafka/partition_offset_result.h>
 #include <cppkafka/producer.h>
 #include <cppkafka/queue.h>
+#include <cppkafka/thread_configuration.h>
 #include <cppkafka/topic.h>
 #include <cppkafka/topic_configuration.h>
 #include <cppkafka/topic_partition.h>
 #include <cppkafka/topic_partition_list.h>
+#include <cppkafka/topic_partition_map.h>
+#include <cppkafka/wrapper_profiler.h>
+#include <cppkafka/utils/awaitable_consumer.h>
+#include <cppkafka/utils/background_event_pump.h>
+#include <cppkafka/utils/adaptive_batch_controller.h>
 #include <cppkafka/utils/backoff_committer.h>
 #include <cppkafka/utils/backoff_performer.h>
+#include <cppkafka/utils/backoff_scheduler.h>
 #include <cppkafka/utils/buffered_producer.h>
+#include <cppkafka/utils/batch_transform.h>
+#include <cppkafka/utils/commit_order_tracker.h>
 #include <cppkafka/utils/compacted_topic_processor.h>
+#include <cppkafka/utils/compacted_topic_store.h>
 #include <cppkafka/utils/consumer_dispatcher.h>
+#include <cppkafka/utils/consumer_pipeline.h>
+#include <cppkafka/utils/event_driven_poll_strategy.h>
+#include <cppkafka/utils/handle_event_loop.h>
+#include <cppkafka/utils/key_partitioner.h>
+#include <cppkafka/utils/lag_monitor.h>
+#include <cppkafka/utils/latency_histogram.h>
+#include <cppkafka/utils/parallel_consumer.h>
 #include <cppkafka/utils/poll_interface.h>
 #include <cppkafka/utils/poll_strategy_base.h>
+#include <cppkafka/utils/polling_consumer.h>
+#include <cppkafka/utils/prefetching_consumer.h>
 #include <cppkafka/utils/roundrobin_poll_strategy.h>
+#include <cppkafka/utils/sharded_consumer.h>
+#include <cppkafka/utils/topic_router.h>
+#include <cppkafka/utils/weighted_poll_strategy.h>
 
 #endif
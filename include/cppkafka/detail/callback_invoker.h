@@ -34,6 +34,7 @@
 #include <assert.h>
 #include "../logging.h"
 #include "../kafka_handle_base.h"
+#include "function_ref.h"
 
 namespace cppkafka {
 
@@ -50,8 +51,47 @@ bool error_value<bool>() { return false; }
 template<> inline
 int error_value<int>() { return -1; }
 
+// Logs an exception that escaped a callback; what is null for non-std exceptions
+inline void log_callback_exception(const char* callback_name, KafkaHandleBase* handle,
+                                   const char* what) {
+    static const char* library_name = "cppkafka";
+    if (!handle) {
+        return;
+    }
+    std::ostringstream error_msg;
+    if (what) {
+        error_msg << "Caught exception in " << callback_name << " callback: " << what;
+    }
+    else {
+        error_msg << "Caught unknown exception in " << callback_name << " callback";
+    }
+    if (handle->get_configuration().get_log_callback()) {
+        try {
+            // Log it
+            handle->get_configuration().get_log_callback()(*handle,
+                                                           static_cast<int>(LogLevel::LogErr),
+                                                           library_name,
+                                                           error_msg.str());
+        }
+        catch (...) {} // sink everything
+    }
+    else {
+        rd_kafka_log_print(handle->get_handle(),
+                           static_cast<int>(LogLevel::LogErr),
+                           library_name,
+                           error_msg.str().c_str());
+    }
+}
+
 /**
  * \brief Wraps an std::function object and runs it while preventing all exceptions from escaping
+ *
+ * Defining CPPKAFKA_NOEXCEPT_CALLBACKS removes the per-call try/catch from every
+ * invoker: exceptions thrown by callbacks then propagate (typically terminating
+ * through the librdkafka C trampoline that invoked them). Only enable it for
+ * applications whose callbacks are guaranteed not to throw; in exchange the
+ * per-message exception frame disappears from the produce and consume paths.
+ *
  * \tparam Func An std::function object
  */
 template <typename Func>
@@ -77,48 +117,83 @@ public:
     
     template <typename ...Args>
     RetType operator()(Args&&... args) const {
-        static const char* library_name = "cppkafka";
-        std::ostringstream error_msg;
+#ifndef CPPKAFKA_NOEXCEPT_CALLBACKS
         try {
+#endif
             if (callback_) {
                 return callback_(std::forward<Args>(args)...);
             }
             return error_value<RetType>();
+#ifndef CPPKAFKA_NOEXCEPT_CALLBACKS
         }
         catch (const std::exception& ex) {
-            if (handle_) {
-                error_msg << "Caught exception in " << callback_name_ << " callback: " << ex.what();
-            }
+            log_callback_exception(callback_name_, handle_, ex.what());
         }
         catch (...) {
-            if (handle_) {
-                error_msg << "Caught unknown exception in " << callback_name_ << " callback";
-            }
+            log_callback_exception(callback_name_, handle_, nullptr);
         }
-        // Log error
-        if (handle_) {
-            if (handle_->get_configuration().get_log_callback()) {
-                try {
-                    // Log it
-                    handle_->get_configuration().get_log_callback()(*handle_,
-                                                                    static_cast<int>(LogLevel::LogErr),
-                                                                    library_name,
-                                                                    error_msg.str());
-                }
-                catch (...) {} // sink everything
-            }
-            else {
-                rd_kafka_log_print(handle_->get_handle(),
-                                   static_cast<int>(LogLevel::LogErr),
-                                   library_name,
-                                   error_msg.str().c_str());
+        return error_value<RetType>();
+#endif
+    }
+private:
+    const char* callback_name_;
+    const Func& callback_;
+    KafkaHandleBase* handle_;
+};
+
+template <typename Signature>
+class CallbackRefInvoker;
+
+/**
+ * \brief CallbackInvoker variant built on a non-owning FunctionRef
+ *
+ * Same exception containment (and the same CPPKAFKA_NOEXCEPT_CALLBACKS opt-out)
+ * as CallbackInvoker, but the callback is held as a FunctionRef: the invoker is
+ * three words, trivially copyable and can be hoisted out of a message loop so
+ * hot paths pay one indirect call per message rather than an std::function
+ * dispatch. Accepts any callable - a concrete lambda skips the std::function
+ * machinery entirely - as well as std::function objects, whose emptiness is
+ * preserved.
+ *
+ * \tparam Signature The callback signature, e.g. void(Consumer&, Message)
+ */
+template <typename RetType, typename... Args>
+class CallbackRefInvoker<RetType(Args...)> {
+public:
+    CallbackRefInvoker(const char* callback_name,
+                       FunctionRef<RetType(Args...)> callback,
+                       KafkaHandleBase* handle)
+    : callback_name_(callback_name),
+      callback_(callback),
+      handle_(handle) {
+    }
+
+    explicit operator bool() const {
+        return (bool)callback_;
+    }
+
+    RetType operator()(Args... args) const {
+#ifndef CPPKAFKA_NOEXCEPT_CALLBACKS
+        try {
+#endif
+            if (callback_) {
+                return callback_(static_cast<Args&&>(args)...);
             }
+            return error_value<RetType>();
+#ifndef CPPKAFKA_NOEXCEPT_CALLBACKS
+        }
+        catch (const std::exception& ex) {
+            log_callback_exception(callback_name_, handle_, ex.what());
+        }
+        catch (...) {
+            log_callback_exception(callback_name_, handle_, nullptr);
         }
         return error_value<RetType>();
+#endif
     }
 private:
     const char* callback_name_;
-    const Func& callback_;
+    FunctionRef<RetType(Args...)> callback_;
     KafkaHandleBase* handle_;
 };
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_FUNCTION_REF_H
+#define CPPKAFKA_FUNCTION_REF_H
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace cppkafka {
+
+template <typename Signature>
+class FunctionRef;
+
+/**
+ * \brief Non-owning reference to a callable
+ *
+ * Two words - an object pointer and a trampoline - instead of std::function's
+ * owning storage: constructing one never allocates, copying is trivial and
+ * invoking is a single indirect call. Meant for handing a callback down a call
+ * chain for immediate invocation, where std::function's ownership is paid for
+ * without being needed.
+ *
+ * Constructing from an std::function of the same signature maps an empty
+ * function to a null FunctionRef, so emptiness checks keep working across the
+ * conversion.
+ *
+ * \warning A FunctionRef does not extend the referenced callable's lifetime; it
+ * must not outlive it (in particular, do not store one bound to a temporary).
+ */
+template <typename RetType, typename... Args>
+class FunctionRef<RetType(Args...)> {
+public:
+    /**
+     * Matches std::function's nested typedef so generic invokers work with both
+     */
+    using result_type = RetType;
+
+    /**
+     * Constructs a null reference
+     */
+    constexpr FunctionRef() = default;
+
+    /**
+     * \brief Constructs a reference to the given callable
+     *
+     * \param callable The callable; it is referenced, not copied
+     */
+    template <typename Callable,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<Callable>::type, FunctionRef>::value &&
+                  !std::is_same<typename std::decay<Callable>::type,
+                                std::function<RetType(Args...)>>::value>::type>
+    FunctionRef(Callable&& callable)
+    : object_(const_cast<void*>(static_cast<const void*>(&callable))),
+      trampoline_([](void* object, Args... args) -> RetType {
+          using StoredType = typename std::remove_reference<Callable>::type;
+          return (*static_cast<StoredType*>(object))(static_cast<Args&&>(args)...);
+      }) {
+    }
+
+    /**
+     * \brief Constructs a reference to the callable held by an std::function
+     *
+     * An empty function yields a null reference.
+     *
+     * \param callback The function object; it is referenced, not copied
+     */
+    FunctionRef(const std::function<RetType(Args...)>& callback) {
+        if (callback) {
+            object_ = const_cast<void*>(static_cast<const void*>(&callback));
+            trampoline_ = [](void* object, Args... args) -> RetType {
+                return (*static_cast<const std::function<RetType(Args...)>*>(object))
+                    (static_cast<Args&&>(args)...);
+            };
+        }
+    }
+
+    /**
+     * \brief Constructs a reference to a free function
+     *
+     * \param function The function pointer; may be null
+     */
+    FunctionRef(RetType (*function)(Args...)) {
+        if (function) {
+            object_ = reinterpret_cast<void*>(function);
+            trampoline_ = [](void* object, Args... args) -> RetType {
+                return reinterpret_cast<RetType (*)(Args...)>(object)
+                    (static_cast<Args&&>(args)...);
+            };
+        }
+    }
+
+    /**
+     * Indicates whether this references a callable
+     */
+    explicit operator bool() const {
+        return trampoline_ != nullptr;
+    }
+
+    /**
+     * \brief Invokes the referenced callable
+     *
+     * Must not be called on a null reference.
+     */
+    RetType operator()(Args... args) const {
+        return trampoline_(object_, static_cast<Args&&>(args)...);
+    }
+private:
+    void* object_{nullptr};
+    RetType (*trampoline_)(void*, Args...){nullptr};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_FUNCTION_REF_H
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_SMALL_VECTOR_H
+#define CPPKAFKA_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace cppkafka {
+namespace detail {
+
+/**
+ * \brief A minimal vector with inline storage for small sizes
+ *
+ * Elements are stored inside the object itself until InlineCapacity is
+ * exceeded, at which point they're moved to the heap. Only trivially
+ * copyable element types are supported, which keeps copies and growth
+ * down to plain memcpys.
+ *
+ * This is an implementation detail of the structure-of-arrays containers
+ * (e.g. CompactTopicPartitionList); it intentionally supports just the
+ * operations those need.
+ */
+template <typename T, size_t InlineCapacity>
+class SmallVector {
+public:
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallVector only supports trivially copyable types");
+
+    SmallVector()
+    : data_(inline_data_), size_(0), capacity_(InlineCapacity) {
+
+    }
+
+    SmallVector(const SmallVector& other)
+    : SmallVector() {
+        assign(other);
+    }
+
+    SmallVector(SmallVector&& other)
+    : SmallVector() {
+        steal(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            assign(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    void push_back(T value) {
+        if (size_ == capacity_) {
+            grow(capacity_ * 2);
+        }
+        data_[size_++] = value;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+    T& operator[](size_t index) {
+        return data_[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+
+    T* data() {
+        return data_;
+    }
+
+    const T* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    T* begin() {
+        return data_;
+    }
+
+    T* end() {
+        return data_ + size_;
+    }
+
+    const T* begin() const {
+        return data_;
+    }
+
+    const T* end() const {
+        return data_ + size_;
+    }
+private:
+    bool is_inline() const {
+        return data_ == inline_data_;
+    }
+
+    void grow(size_t new_capacity) {
+        T* new_data = new T[new_capacity];
+        std::memcpy(new_data, data_, size_ * sizeof(T));
+        release();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    void assign(const SmallVector& other) {
+        if (other.size_ > capacity_) {
+            grow(other.size_);
+        }
+        std::memcpy(data_, other.data_, other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    void steal(SmallVector& other) {
+        if (other.is_inline()) {
+            std::memcpy(inline_data_, other.inline_data_, other.size_ * sizeof(T));
+            data_ = inline_data_;
+            capacity_ = InlineCapacity;
+        }
+        else {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data_;
+            other.capacity_ = InlineCapacity;
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    void release() {
+        if (!is_inline()) {
+            delete[] data_;
+            data_ = inline_data_;
+            capacity_ = InlineCapacity;
+        }
+    }
+
+    T inline_data_[InlineCapacity];
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+};
+
+} // detail
+} // cppkafka
+
+#endif // CPPKAFKA_SMALL_VECTOR_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_TRACEPOINTS_H
+#define CPPKAFKA_TRACEPOINTS_H
+
+/*
+ * Static tracepoint (USDT) layer for the produce/poll hot paths.
+ *
+ * Compiling with -DCPPKAFKA_ENABLE_TRACEPOINTS emits SystemTap/DTrace style
+ * probes under the "cppkafka" provider (requires <sys/sdt.h>, shipped in
+ * systemtap-sdt-dev or equivalent), which tools like bpftrace can attach to
+ * on a live binary:
+ *
+ *     bpftrace -e 'usdt:./app:cppkafka:produce_end { @[arg0] = hist(arg1); }'
+ *
+ * Probes and their arguments:
+ *     produce_start(partition, payload_size)
+ *     produce_end(partition, payload_size, error)
+ *     poll_end(message_count, latency_us)
+ *     flush_start(buffer_size)
+ *     flush_end(pending_acks)
+ *     delivery_report(error)
+ *     queue_full(partition)
+ *
+ * When not enabled (the default), every CPPKAFKA_TRACE* macro expands to
+ * nothing, so there is zero overhead and no build dependency. When enabled,
+ * a probe site is a single nop instruction until a tracer attaches to it.
+ */
+
+#if defined(CPPKAFKA_ENABLE_TRACEPOINTS) && defined(__has_include)
+    #if __has_include(<sys/sdt.h>)
+        #define CPPKAFKA_TRACEPOINTS_AVAILABLE
+    #endif
+#endif
+
+#ifdef CPPKAFKA_TRACEPOINTS_AVAILABLE
+
+#include <sys/sdt.h>
+
+#define CPPKAFKA_TRACE0(name)             DTRACE_PROBE(cppkafka, name)
+#define CPPKAFKA_TRACE1(name, a1)         DTRACE_PROBE1(cppkafka, name, a1)
+#define CPPKAFKA_TRACE2(name, a1, a2)     DTRACE_PROBE2(cppkafka, name, a1, a2)
+#define CPPKAFKA_TRACE3(name, a1, a2, a3) DTRACE_PROBE3(cppkafka, name, a1, a2, a3)
+
+#else
+
+#define CPPKAFKA_TRACE0(name)             do {} while (0)
+#define CPPKAFKA_TRACE1(name, a1)         do {} while (0)
+#define CPPKAFKA_TRACE2(name, a1, a2)     do {} while (0)
+#define CPPKAFKA_TRACE3(name, a1, a2, a3) do {} while (0)
+
+#endif
+
+#endif // CPPKAFKA_TRACEPOINTS_H
@@ -32,6 +32,7 @@
 
 #include <string>
 #include <iosfwd>
+#include <type_traits>
 #include <librdkafka/rdkafka.h>
 #include "macros.h"
 
@@ -57,7 +58,19 @@ public:
     rd_kafka_resp_err_t get_error() const;
 
     /**
-     * Gets the error string
+     * \brief Gets the error string without allocating
+     *
+     * The returned pointer comes straight from rd_kafka_err2str and refers
+     * to static storage, so this is the cheap way to render an error on hot
+     * paths (logging inside retry loops, etc).
+     */
+    const char* get_message() const;
+
+    /**
+     * \brief Gets the error string
+     *
+     * This allocates a std::string copy; prefer get_message when the error
+     * is only going to be printed.
      */
     std::string to_string() const;
 
@@ -84,6 +97,11 @@ private:
     rd_kafka_resp_err_t error_{RD_KAFKA_RESP_ERR_NO_ERROR};
 };
 
+// Error is meant to stay a plain code-only value that's free to construct
+// and copy on error-heavy paths
+static_assert(std::is_trivially_copyable<Error>::value,
+              "Error must remain trivially copyable");
+
 } // cppkafka
 
 #endif // CPPKAFKA_ERROR_H
@@ -99,36 +99,52 @@ public:
 };
 
 /**
- * A generic rdkafka handle error
+ * \brief A generic rdkafka handle error
+ *
+ * Only the error code is stored; the message is rendered lazily in what()
+ * from rdkafka's static error string table, so constructing (and swallowing)
+ * these in a tight retry loop doesn't allocate.
  */
 class CPPKAFKA_API HandleException : public Exception {
 public:
     HandleException(Error error);
 
+    const char* what() const noexcept;
+
     Error get_error() const;
 private:
     Error error_;
 };
 
 /**
- * Consumer exception
+ * \brief Consumer exception
+ *
+ * Like HandleException, this stores only the error code and renders the
+ * message lazily in what().
  */
 class CPPKAFKA_API ConsumerException : public Exception {
 public:
     ConsumerException(Error error);
 
+    const char* what() const noexcept;
+
     Error get_error() const;
 private:
     Error error_;
 };
 
 /**
- * Queue exception for rd_kafka_queue_t errors
+ * \brief Queue exception for rd_kafka_queue_t errors
+ *
+ * Like HandleException, this stores only the error code and renders the
+ * message lazily in what().
  */
 class CPPKAFKA_API QueueException : public Exception {
 public:
     QueueException(Error error);
 
+    const char* what() const noexcept;
+
     Error get_error() const;
 private:
     Error error_;
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_FROZEN_CONFIGURATION_H
+#define CPPKAFKA_FROZEN_CONFIGURATION_H
+
+#include <memory>
+#include <librdkafka/rdkafka.h>
+#include "configuration.h"
+#include "macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief An immutable, cheaply shareable Configuration
+ *
+ * Copying a Configuration duplicates the whole underlying rd_kafka_conf_t via
+ * rd_kafka_conf_dup, so creating many handles from the same options (e.g. one
+ * producer per partition) re-duplicates the option set once per copy on top of
+ * the duplicate rd_kafka_new itself needs. FrozenConfiguration is built once
+ * from a Configuration and afterwards only shares it: copies are reference
+ * counted and handle construction performs a single rd_kafka_conf_dup, the one
+ * consumed by rd_kafka_new.
+ *
+ * \code
+ * FrozenConfiguration config(Configuration{
+ *     { "metadata.broker.list", "127.0.0.1:9092" }
+ * });
+ *
+ * // Each producer shares the frozen options; only rd_kafka_new's dup is paid
+ * for (int i = 0; i < 64; ++i) {
+ *     producers.emplace_back(config);
+ * }
+ * \endcode
+ *
+ * The wrapped Configuration can't be modified after freezing; apply all
+ * options and callbacks before constructing the FrozenConfiguration.
+ */
+class CPPKAFKA_API FrozenConfiguration {
+public:
+    /**
+     * \brief Freezes the given configuration
+     *
+     * If a default topic configuration was set, it is attached to the
+     * underlying handle here, once, rather than on every handle construction.
+     *
+     * \param config The configuration to be frozen
+     */
+    explicit FrozenConfiguration(Configuration config);
+
+    /**
+     * Gets the frozen configuration
+     */
+    const Configuration& get_configuration() const;
+
+    /**
+     * \brief Creates the rd_kafka_conf_t for a new handle
+     *
+     * Duplicates the frozen handle and sets the given opaque on the duplicate,
+     * leaving the shared configuration untouched so concurrent handle creation
+     * is safe. The caller owns the returned configuration (rd_kafka_new takes
+     * it over).
+     *
+     * \param opaque The opaque pointer to be set on the new configuration
+     */
+    rd_kafka_conf_t* make_handle_configuration(void* opaque) const;
+private:
+    std::shared_ptr<const Configuration> config_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_FROZEN_CONFIGURATION_H
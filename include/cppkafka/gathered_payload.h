@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_GATHERED_PAYLOAD_H
+#define CPPKAFKA_GATHERED_PAYLOAD_H
+
+#include <cstddef>
+#include "buffer.h"
+#include "macros.h"
+#include "detail/small_vector.h"
+
+namespace cppkafka {
+
+/**
+ * \brief A payload described as a list of fragments, iovec style
+ *
+ * Producing a message whose wire format is composed of several pieces (e.g.
+ * header + body + checksum) normally means serializing them into a temporary
+ * string and then letting rdkafka copy that string into its own buffer, so
+ * every byte is copied twice. A GatheredPayload instead just records views of
+ * the pieces; Producer::produce gathers them directly into the single buffer
+ * handed over to rdkafka, removing the intermediate copy.
+ *
+ * \code
+ * GatheredPayload payload;
+ * payload.add(header_buffer)
+ *        .add(body_buffer)
+ *        .add(checksum_buffer);
+ * producer.produce(builder, payload);
+ * \endcode
+ *
+ * Fragments are not copied nor owned; the viewed data only needs to stay
+ * alive until the produce call returns.
+ */
+class CPPKAFKA_API GatheredPayload {
+public:
+    /**
+     * \brief Appends a fragment to the payload
+     *
+     * Only the fragment's data pointer and size are stored.
+     *
+     * \param fragment The fragment to be appended
+     */
+    GatheredPayload& add(const Buffer& fragment);
+
+    /**
+     * Gets the total size of all fragments
+     */
+    size_t get_size() const;
+
+    /**
+     * \brief Copies all fragments, in order, into the given buffer
+     *
+     * The output buffer must have room for at least get_size() bytes.
+     *
+     * \param output The buffer the fragments are gathered into
+     */
+    void copy_to(void* output) const;
+private:
+    struct Fragment {
+        const void* data;
+        size_t size;
+    };
+
+    detail::SmallVector<Fragment, 8> fragments_;
+    size_t total_size_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_GATHERED_PAYLOAD_H
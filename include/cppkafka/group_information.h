@@ -3,8 +3,11 @@
 
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include <string_view>
 #include "macros.h"
 #include "metadata.h"
+#include "buffer.h"
 #include "error.h"
 #include "topic_partition_list.h"
 
@@ -138,6 +141,185 @@ private:
 
 using GroupInformationList = std::vector<GroupInformation>;
 
+/**
+ * \brief Non owning view over a consumer group member entry
+ *
+ * Unlike GroupMemberInformation this does not copy anything: the accessors
+ * return views straight into the rd_kafka_group_list memory, so constructing
+ * and reading one is allocation free. The view (and anything obtained through
+ * it) is only valid while the GroupInformationSnapshot it came from is alive.
+ */
+class CPPKAFKA_API GroupMemberInformationView {
+public:
+    /**
+     * Constructs a view over the given member entry
+     *
+     * \param info The member entry to be viewed
+     */
+    GroupMemberInformationView(const rd_kafka_group_member_info& info);
+
+    /**
+     * Gets the member id
+     */
+    std::string_view get_member_id() const;
+
+    /**
+     * Gets the client id
+     */
+    std::string_view get_client_id() const;
+
+    /**
+     * Gets the client host
+     */
+    std::string_view get_client_host() const;
+
+    /**
+     * Gets the member metadata
+     */
+    Buffer get_member_metadata() const;
+
+    /**
+     * \brief Gets the member assignment
+     *
+     * The raw blob can still be decoded on demand by feeding it to
+     * MemberAssignmentInformation
+     */
+    Buffer get_member_assignment() const;
+private:
+    const rd_kafka_group_member_info* info_;
+};
+
+/**
+ * \brief Non owning view over a consumer group entry
+ *
+ * \sa GroupMemberInformationView
+ */
+class CPPKAFKA_API GroupInformationView {
+public:
+    /**
+     * Constructs a view over the given group entry
+     *
+     * \param info The group entry to be viewed
+     */
+    GroupInformationView(const rd_kafka_group_info& info);
+
+    /**
+     * \brief Gets the broker metadata
+     *
+     * \remark This is the one accessor that allocates, as BrokerMetadata
+     * copies the broker's host name
+     */
+    BrokerMetadata get_broker() const;
+
+    /**
+     * Gets the group name
+     */
+    std::string_view get_name() const;
+
+    /**
+     * Gets the broker-originated error
+     */
+    Error get_error() const;
+
+    /**
+     * Gets the group state
+     */
+    std::string_view get_state() const;
+
+    /**
+     * Gets the group protocol type
+     */
+    std::string_view get_protocol_type() const;
+
+    /**
+     * Gets the group protocol
+     */
+    std::string_view get_protocol() const;
+
+    /**
+     * Gets the amount of members in this group
+     */
+    size_t get_member_count() const;
+
+    /**
+     * Gets a view over the member at the given index
+     *
+     * \param index The index of the member to be viewed
+     */
+    GroupMemberInformationView get_member(size_t index) const;
+private:
+    const rd_kafka_group_info* info_;
+};
+
+/**
+ * \brief Owns a rd_kafka_group_list and exposes borrowed views over it
+ *
+ * This is the zero copy counterpart of GroupInformationList: instead of
+ * materializing every group/member into owned strings and vectors, the
+ * snapshot keeps the raw list alive and hands out lightweight views over it.
+ * Monitoring code that scrapes large groups periodically should prefer this
+ * over KafkaHandleBase::get_consumer_groups, which copies every field.
+ *
+ * Example:
+ *
+ * \code
+ * GroupInformationSnapshot snapshot = consumer.get_consumer_groups_snapshot();
+ * for (size_t i = 0; i < snapshot.get_size(); ++i) {
+ *     GroupInformationView group = snapshot.get_group(i);
+ *     for (size_t j = 0; j < group.get_member_count(); ++j) {
+ *         // No allocations happen while inspecting the member
+ *         report(group.get_name(), group.get_member(j).get_member_id());
+ *     }
+ * }
+ * \endcode
+ *
+ * \warning Views obtained from a snapshot must not outlive it.
+ */
+class CPPKAFKA_API GroupInformationSnapshot {
+public:
+    /**
+     * \brief Constructs an empty snapshot
+     *
+     * \remark Using any methods except GroupInformationSnapshot::get_handle on
+     * an empty snapshot is undefined behavior
+     */
+    GroupInformationSnapshot();
+
+    /**
+     * \brief Constructs a snapshot, taking ownership of the handle
+     *
+     * \param handle The handle to be used
+     */
+    GroupInformationSnapshot(const rd_kafka_group_list* handle);
+
+    /**
+     * Gets the amount of groups in this snapshot
+     */
+    size_t get_size() const;
+
+    /**
+     * Gets a view over the group at the given index
+     *
+     * \param index The index of the group to be viewed
+     */
+    GroupInformationView get_group(size_t index) const;
+
+    /**
+     * Indicates whether this snapshot is valid (not null)
+     */
+    explicit operator bool() const;
+
+    /**
+     * Returns the rdkafka handle
+     */
+    const rd_kafka_group_list* get_handle() const;
+private:
+    using HandlePtr = std::unique_ptr<const rd_kafka_group_list,
+                                      decltype(&rd_kafka_group_list_destroy)>;
+
+    HandlePtr handle_;
+};
+
 } // cppkafka
 
 #endif // CPPKAFKA_GROUP_INFORMATION_H
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_HANDLE_STATISTICS_H
+#define CPPKAFKA_HANDLE_STATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Per-handle hot path counters
+ *
+ * Every Producer/Consumer owns one of these (see
+ * KafkaHandleBase::get_statistics) and the produce/poll paths update it as
+ * they go, so production metrics come built in instead of requiring a
+ * wrapper layer around every call site.
+ *
+ * The recording methods are single relaxed atomic additions and each counter
+ * sits on its own cache line, so updating them costs a few nanoseconds and
+ * producer/consumer threads never contend on the same line. Counters are
+ * only ever incremented (monotonic); rates and deltas are derived by
+ * subtracting snapshots:
+ *
+ * \code
+ * HandleStatistics::Snapshot previous = producer.get_statistics().get_snapshot();
+ * // ... every scrape interval:
+ * HandleStatistics::Snapshot current = producer.get_statistics().get_snapshot();
+ * report_rate(current.bytes_produced - previous.bytes_produced);
+ * previous = current;
+ * \endcode
+ *
+ * The one exception to monotonicity is the held-bytes gauge, which tracks
+ * the payload bytes of consumed messages the application has not destroyed
+ * yet: it moves both ways and is read directly rather than as a delta. Its
+ * high water mark is monotonic again.
+ *
+ * \remark Snapshots are not taken atomically across counters; individual
+ * counters are exact but one snapshot may straddle an in-flight operation.
+ */
+class CPPKAFKA_API HandleStatistics {
+public:
+    /**
+     * Plain copy of all counters at one point in time
+     */
+    struct Snapshot {
+        uint64_t messages_produced;
+        uint64_t bytes_produced;
+        uint64_t queue_full_events;
+        uint64_t messages_consumed;
+        uint64_t bytes_consumed;
+        uint64_t polls;
+        uint64_t empty_polls;
+        uint64_t poll_time_us;
+        uint64_t bytes_held;
+        uint64_t bytes_held_high_water_mark;
+    };
+
+    /**
+     * Records a successfully enqueued message of the given payload size
+     */
+    void record_produce(uint64_t bytes) {
+        add(messages_produced_, 1);
+        add(bytes_produced_, bytes);
+    }
+
+    /**
+     * Records a produce rejected with RD_KAFKA_RESP_ERR__QUEUE_FULL
+     */
+    void record_queue_full() {
+        add(queue_full_events_, 1);
+    }
+
+    /**
+     * Records a consumed message of the given payload size
+     */
+    void record_consume(uint64_t bytes) {
+        add(messages_consumed_, 1);
+        add(bytes_consumed_, bytes);
+    }
+
+    /**
+     * Records a poll call, its latency, and whether it yielded anything
+     */
+    void record_poll(std::chrono::microseconds elapsed, bool got_messages) {
+        add(polls_, 1);
+        add(poll_time_us_, static_cast<uint64_t>(elapsed.count()));
+        if (!got_messages) {
+            add(empty_polls_, 1);
+        }
+    }
+
+    /**
+     * \brief Records payload bytes entering application ownership
+     *
+     * Raises the held-bytes gauge and, when the new level exceeds it, the
+     * high water mark.
+     */
+    void record_message_hold(uint64_t bytes) {
+        const uint64_t held = bytes_held_.value.fetch_add(bytes, std::memory_order_relaxed) +
+                              bytes;
+        uint64_t mark = bytes_held_high_water_mark_.value.load(std::memory_order_relaxed);
+        while (held > mark &&
+               !bytes_held_high_water_mark_.value.compare_exchange_weak(
+                   mark, held, std::memory_order_relaxed)) {
+            //mark was reloaded by the failed exchange; retry unless it passed held
+        }
+    }
+
+    /**
+     * Records payload bytes leaving application ownership
+     */
+    void record_message_release(uint64_t bytes) {
+        bytes_held_.value.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * Takes a consistent-enough copy of all counters
+     */
+    Snapshot get_snapshot() const;
+
+    /**
+     * \brief Resets all counters to zero
+     *
+     * Prefer snapshot deltas over resetting when multiple scrapers read the
+     * same handle.
+     */
+    void reset();
+private:
+    // One counter per cache line so producer and consumer side updates (and
+    // snapshot readers) never false-share
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static void add(Counter& counter, uint64_t amount) {
+        counter.value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    Counter messages_produced_;
+    Counter bytes_produced_;
+    Counter queue_full_events_;
+    Counter messages_consumed_;
+    Counter bytes_consumed_;
+    Counter polls_;
+    Counter empty_polls_;
+    Counter poll_time_us_;
+    Counter bytes_held_;
+    Counter bytes_held_high_water_mark_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_HANDLE_STATISTICS_H
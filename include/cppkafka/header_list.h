@@ -30,6 +30,10 @@
 #ifndef CPPKAFKA_HEADER_LIST_H
 #define CPPKAFKA_HEADER_LIST_H
 
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
 #include <librdkafka/rdkafka.h>
 #include "clonable_ptr.h"
 #include "header.h"
@@ -87,7 +91,15 @@ public:
 
     template <typename OtherHeaderType>
     HeaderList(HeaderList<OtherHeaderType>&& other);
-    
+
+    // Note: the name index is not copied; the copy rebuilds its own lazily.
+    // Moves are noexcept so containers of header-carrying builders grow by
+    // moving elements instead of cloning their handles
+    HeaderList(const HeaderList& other);
+    HeaderList(HeaderList&& other) noexcept;
+    HeaderList& operator=(const HeaderList& other);
+    HeaderList& operator=(HeaderList&& other) noexcept;
+
     /**
      * \brief Add a header to the list. This translates to rd_kafka_header_add().
      * \param header The header.
@@ -125,7 +137,30 @@ public:
      * \return The last header.
      */
     HeaderType back() const; //throws
-    
+
+    /**
+     * \brief Return the first header with the given name, if any.
+     *
+     * The first lookup builds a small index (header names sorted once) which is
+     * reused by subsequent lookups, so repeatedly getting a few headers out of a
+     * larger list doesn't re-scan the list each time. The index is rebuilt
+     * lazily after add() or remove().
+     *
+     * \param name The header name.
+     * \return The header, or an empty optional if no header has that name.
+     */
+    std::optional<HeaderType> get(const std::string& name) const;
+
+    /**
+     * \brief Indicates if the list contains a header with the given name.
+     *
+     * Uses the same lazily-built index as get().
+     *
+     * \param name The header name.
+     * \return True if at least one header has that name, false otherwise.
+     */
+    bool contains(const std::string& name) const;
+
     /**
      * \brief Returns the number of headers in the list. This translates to rd_kafka_header_cnt().
      * \return The number of headers.
@@ -178,10 +213,21 @@ private:
     
     using HandlePtr = ClonablePtr<rd_kafka_headers_t, decltype(&rd_kafka_headers_destroy),
                                   decltype(&rd_kafka_headers_copy)>;
-    
+
+    // One entry per header; the name pointer points into the handle's storage
+    struct IndexEntry {
+        const char* name;
+        size_t index;
+    };
+
     HeaderList(rd_kafka_headers_t* handle, NonOwningTag);
-    
+    void build_index() const;
+    typename std::vector<IndexEntry>::const_iterator index_lookup(const std::string& name) const;
+    void invalidate_index();
+
     HandlePtr handle_;
+    mutable std::vector<IndexEntry> name_index_;
+    mutable bool index_built_{false};
 };
 
 template <typename HeaderType>
@@ -246,20 +292,58 @@ HeaderList<HeaderType>::HeaderList(HeaderList<OtherHeaderType>&& other)
 
 }
 
+template <typename HeaderType>
+HeaderList<HeaderType>::HeaderList(const HeaderList& other)
+: handle_(other.handle_) {
+    // The index is rebuilt lazily: for owning lists the copy clones the handle,
+    // so the cached name pointers would point into the original's storage
+}
+
+template <typename HeaderType>
+HeaderList<HeaderType>::HeaderList(HeaderList&& other) noexcept
+: handle_(std::move(other.handle_)),
+  name_index_(std::move(other.name_index_)),
+  index_built_(other.index_built_) {
+    // Moving keeps the same handle, so the index stays valid
+    other.invalidate_index();
+}
+
+template <typename HeaderType>
+HeaderList<HeaderType>& HeaderList<HeaderType>::operator=(const HeaderList& other) {
+    if (this != &other) {
+        handle_ = other.handle_;
+        invalidate_index();
+    }
+    return *this;
+}
+
+template <typename HeaderType>
+HeaderList<HeaderType>& HeaderList<HeaderType>::operator=(HeaderList&& other) noexcept {
+    if (this != &other) {
+        handle_ = std::move(other.handle_);
+        name_index_ = std::move(other.name_index_);
+        index_built_ = other.index_built_;
+        other.invalidate_index();
+    }
+    return *this;
+}
+
 // Methods
 template <typename HeaderType>
 Error HeaderList<HeaderType>::add(const HeaderType& header) {
     assert(handle_);
+    invalidate_index();
     return rd_kafka_header_add(handle_.get(),
                                header.get_name().data(),  header.get_name().size(),
                                header.get_value().data(), header.get_value().size());
-    
+
 }
 
 template <>
 inline
 Error HeaderList<Header<Buffer>>::add(const Header<Buffer>& header) {
     assert(handle_);
+    invalidate_index();
     return rd_kafka_header_add(handle_.get(),
                                header.get_name().data(), header.get_name().size(),
                                header.get_value().get_data(), header.get_value().get_size());
@@ -268,6 +352,7 @@ Error HeaderList<Header<Buffer>>::add(const Header<Buffer>& header) {
 template <typename HeaderType>
 Error HeaderList<HeaderType>::remove(const std::string& name) {
     assert(handle_);
+    invalidate_index();
     return rd_kafka_header_remove(handle_.get(), name.data());
 }
 
@@ -293,6 +378,73 @@ HeaderType HeaderList<HeaderType>::back() const {
     return at(size()-1);
 }
 
+template <typename HeaderType>
+std::optional<HeaderType> HeaderList<HeaderType>::get(const std::string& name) const {
+    if (!handle_) {
+        return {};
+    }
+    auto iter = index_lookup(name);
+    if (iter == name_index_.end()) {
+        return {};
+    }
+    return at(iter->index);
+}
+
+template <typename HeaderType>
+bool HeaderList<HeaderType>::contains(const std::string& name) const {
+    if (!handle_) {
+        return false;
+    }
+    // The lookup may (re)build the index, so it must be sequenced before
+    // taking the end iterator
+    auto iter = index_lookup(name);
+    return iter != name_index_.end();
+}
+
+template <typename HeaderType>
+void HeaderList<HeaderType>::build_index() const {
+    name_index_.clear();
+    const size_t count = rd_kafka_header_cnt(handle_.get());
+    name_index_.reserve(count);
+    for (size_t i = 0; i != count; ++i) {
+        const char* name;
+        const void* value;
+        size_t value_size;
+        if (rd_kafka_header_get_all(handle_.get(), i, &name, &value, &value_size) ==
+            RD_KAFKA_RESP_ERR_NO_ERROR) {
+            name_index_.push_back(IndexEntry{ name, i });
+        }
+    }
+    // Stable so duplicated names keep their list order and lookups find the first
+    std::stable_sort(name_index_.begin(), name_index_.end(),
+                     [](const IndexEntry& lhs, const IndexEntry& rhs) {
+                         return std::strcmp(lhs.name, rhs.name) < 0;
+                     });
+    index_built_ = true;
+}
+
+template <typename HeaderType>
+typename std::vector<typename HeaderList<HeaderType>::IndexEntry>::const_iterator
+HeaderList<HeaderType>::index_lookup(const std::string& name) const {
+    if (!index_built_) {
+        build_index();
+    }
+    auto iter = std::lower_bound(name_index_.begin(), name_index_.end(), name.c_str(),
+                                 [](const IndexEntry& entry, const char* value) {
+                                     return std::strcmp(entry.name, value) < 0;
+                                 });
+    if (iter == name_index_.end() || std::strcmp(iter->name, name.c_str()) != 0) {
+        return name_index_.end();
+    }
+    return iter;
+}
+
+template <typename HeaderType>
+void HeaderList<HeaderType>::invalidate_index() {
+    name_index_.clear();
+    index_built_ = false;
+}
+
 template <typename HeaderType>
 size_t HeaderList<HeaderType>::size() const {
     return handle_ ? rd_kafka_header_cnt(handle_.get()) : 0;
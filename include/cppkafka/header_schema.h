@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_HEADER_SCHEMA_H
+#define CPPKAFKA_HEADER_SCHEMA_H
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "buffer.h"
+#include "exceptions.h"
+#include "header_list.h"
+#include "macros.h"
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+
+namespace cppkafka {
+
+/**
+ * \brief Pre-registered header names for building per-message header lists
+ *
+ * Producers that attach the same few headers to every message pay for a fresh
+ * set of Header objects - including a std::string name copy per header - on
+ * every produce call. A schema registers the names once; per message only the
+ * values are supplied and the header list is built in a single pass, sized
+ * exactly and fed straight from buffer views:
+ *
+ * \code
+ * HeaderSchema schema{ "source", "trace_id", "schema_version" };
+ * ...
+ * builder.header_list(schema.make_list(source, trace_id, version));
+ * producer.produce(builder);
+ * \endcode
+ *
+ * \remark librdkafka's public header API has no in-place value update, and
+ * produce() takes ownership of the handle on success, so the rd_kafka_headers_t
+ * itself cannot be recycled across messages; what the schema removes is the
+ * per-message name and Header object churn on the cppkafka side.
+ */
+class CPPKAFKA_API HeaderSchema {
+public:
+    using HeaderListType = HeaderList<Header<Buffer>>;
+
+    /**
+     * \brief Constructs a schema from a list of header names
+     *
+     * \param names The header names, in the order values will be supplied
+     */
+    HeaderSchema(std::initializer_list<std::string> names);
+
+    /**
+     * \brief Appends a header name to the schema
+     *
+     * \param name The header name
+     */
+    void add_name(std::string name);
+
+    /**
+     * Gets the amount of headers in the schema
+     */
+    size_t size() const;
+
+    /**
+     * Gets the registered header names
+     */
+    const std::vector<std::string>& get_names() const;
+
+    /**
+     * \brief Builds a header list holding the given values
+     *
+     * One value must be supplied per registered name, in registration order.
+     * Values may be anything a Buffer can view (std::string, std::vector,
+     * another Buffer, etc.); they are copied into the list by librdkafka.
+     *
+     * \param values The header values
+     * \return An owning header list
+     * \throws Exception if the amount of values doesn't match the schema
+     */
+    template <typename... Values>
+    HeaderListType make_list(const Values&... values) const {
+        if (sizeof...(Values) != names_.size()) {
+            throw Exception("Invalid amount of header values");
+        }
+        HeaderListType list(names_.size());
+        size_t index = 0;
+        (add_value(list, index++, to_view(values)), ...);
+        return list;
+    }
+private:
+    static Buffer to_view(const Buffer& value) {
+        return Buffer(value.get_data(), value.get_size());
+    }
+
+    template <typename T>
+    static Buffer to_view(const T& value) {
+        return Buffer(value);
+    }
+
+    void add_value(HeaderListType& list, size_t index, const Buffer& value) const;
+
+    std::vector<std::string> names_;
+};
+
+} // cppkafka
+
+#endif //RD_KAFKA_HEADERS_SUPPORT_VERSION
+
+#endif // CPPKAFKA_HEADER_SCHEMA_H
@@ -32,18 +32,23 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
 #include <chrono>
 #include <unordered_map>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
 #include <tuple>
 #include <chrono>
 #include <librdkafka/rdkafka.h>
 #include "group_information.h"
+#include "topic.h"
 #include "topic_partition.h"
 #include "topic_partition_list.h"
 #include "topic_configuration.h"
 #include "configuration.h"
+#include "frozen_configuration.h"
+#include "handle_statistics.h"
 #include "macros.h"
 #include "logging.h"
 #include "queue.h"
@@ -124,6 +129,39 @@ public:
      */
     void add_brokers(const std::string& brokers);
 
+    /**
+     * \brief Warms up the broker connections ahead of traffic
+     *
+     * Creating a handle does not talk to the cluster: DNS, TCP, TLS and SASL
+     * are all paid lazily by the first real request, which makes the first
+     * produce or consume after a cold start several seconds slower than
+     * steady state. This call forces the bootstrap by issuing metadata
+     * requests (librdkafka connects to the configured brokers in parallel
+     * internally to serve them) until one succeeds or the timeout expires,
+     * and then best-effort pre-fetches metadata for the topics registered on
+     * this handle so the first produce/consume doesn't pay the per-topic
+     * metadata round trip either.
+     *
+     * Typically called right after construction, before the pod/instance
+     * starts taking traffic; poll KafkaHandleBase::is_ready from a readiness
+     * probe when warming up from another thread.
+     *
+     * \param timeout The maximum time to wait for the cluster to respond
+     *
+     * \return Whether the bootstrap completed within the timeout
+     */
+    bool warmup(std::chrono::milliseconds timeout);
+
+    /**
+     * \brief Gets whether a warmup() call completed successfully
+     *
+     * A single atomic load; safe to call from any thread, e.g. a readiness
+     * probe.
+     *
+     * \return Whether this handle is warmed up
+     */
+    bool is_ready() const;
+
     /**
      * \brief Queries the offset for the given topic/partition
      *
@@ -149,6 +187,37 @@ public:
     OffsetTuple query_offsets(const TopicPartition& topic_partition,
                               std::chrono::milliseconds timeout) const;
 
+    /**
+     * \brief Queries the watermark offsets for a whole list of topic/partitions
+     *
+     * The queries are issued concurrently from a small pool of worker threads
+     * (rd_kafka_query_watermark_offsets is thread safe), so scanning hundreds
+     * of partitions costs roughly one round trip instead of one per
+     * partition. The result vector is parallel to the input list.
+     *
+     * If any partition fails, HandleException is thrown for the first failure
+     * once all workers have finished.
+     *
+     * \param topic_partitions The topic/partitions to be queried
+     *
+     * \return One {low, high} watermark pair per input topic/partition
+     */
+    std::vector<OffsetTuple> query_offsets(const TopicPartitionList& topic_partitions) const;
+
+    /**
+     * \brief Queries the watermark offsets for a whole list of topic/partitions
+     * with a given timeout
+     *
+     * \param topic_partitions The topic/partitions to be queried
+     *
+     * \param timeout The timeout applied to each query. This supersedes the
+     * default handle timeout.
+     *
+     * \return One {low, high} watermark pair per input topic/partition
+     */
+    std::vector<OffsetTuple> query_offsets(const TopicPartitionList& topic_partitions,
+                                           std::chrono::milliseconds timeout) const;
+
     /**
      * \brief Gets the rdkafka handle
      *
@@ -181,6 +250,24 @@ public:
      */
     Topic get_topic(const std::string& name, TopicConfiguration config);
 
+    /**
+     * \brief Gets a topic handle from a shared per-name cache
+     *
+     * The first lookup of each name creates the handle via get_topic and
+     * stores it; subsequent lookups take a shared lock and return a
+     * non-owning view of the stored handle, so concurrent threads resolving
+     * the same topics never serialize on a mutex nor call rd_kafka_topic_new
+     * again. rdkafka topic handles are safe to use from multiple threads.
+     *
+     * The returned topic is valid for the lifetime of this consumer/producer;
+     * cached handles are only released on destruction.
+     *
+     * \param name The name of the topic to be looked up
+     *
+     * \return A non-owning topic
+     */
+    Topic get_cached_topic(const std::string& name);
+
     /**
      * \brief Gets metadata for brokers, topics, partitions, etc
      *
@@ -233,6 +320,41 @@ public:
     TopicMetadata get_metadata(const Topic& topic,
                                std::chrono::milliseconds timeout) const;
 
+    /**
+     * \brief Sets the time to live for the topic metadata cache
+     *
+     * While the TTL is non zero, topic level metadata lookups (the
+     * get_metadata overloads taking a Topic, which pause/resume use
+     * internally to enumerate partitions) are served from an in-memory
+     * snapshot that's refreshed via a single all-topics metadata round trip
+     * whenever it's older than the TTL. This turns e.g. pausing N topics
+     * during a rebalance into at most one RPC instead of N.
+     *
+     * The cache is disabled by default and a zero TTL disables it again.
+     *
+     * \param ttl The maximum age of cached metadata
+     *
+     * \sa KafkaHandleBase::invalidate_metadata_cache
+     */
+    void set_metadata_cache_ttl(std::chrono::milliseconds ttl);
+
+    /**
+     * \brief Gets the time to live for the topic metadata cache
+     *
+     * \return The configured TTL; zero means caching is disabled
+     */
+    std::chrono::milliseconds get_metadata_cache_ttl() const;
+
+    /**
+     * \brief Drops any cached topic metadata
+     *
+     * The next topic level metadata lookup will go back to the broker. Call
+     * this whenever the cluster layout may have changed behind the cache's
+     * back, e.g. from a rebalance callback or after a partition related
+     * error.
+     */
+    void invalidate_metadata_cache();
+
     /**
      * \brief Gets the consumer group information
      *
@@ -270,6 +392,27 @@ public:
      */
     GroupInformationList get_consumer_groups(std::chrono::milliseconds timeout);
 
+    /**
+     * \brief Gets all consumer groups as a borrowed snapshot
+     *
+     * Unlike get_consumer_groups this does not copy the group list into owned
+     * objects; the returned snapshot keeps the raw rd_kafka_group_list alive
+     * and exposes allocation free views over it, which is considerably
+     * cheaper when scraping large groups periodically.
+     *
+     * \return The group snapshot
+     */
+    GroupInformationSnapshot get_consumer_groups_snapshot();
+
+    /**
+     * \brief Gets all consumer groups as a borrowed snapshot, with a timeout
+     *
+     * \param timeout The timeout for this operation. Supersedes the default handle timeout.
+     *
+     * \return The group snapshot
+     */
+    GroupInformationSnapshot get_consumer_groups_snapshot(std::chrono::milliseconds timeout);
+
     /**
      * \brief Gets topic/partition offsets based on timestamps
      *
@@ -315,9 +458,25 @@ public:
      * \brief Gets the handle's configuration
      *
      * \return A reference to the configuration object
-     */ 
+     */
     const Configuration& get_configuration() const;
 
+    /**
+     * \brief Gets this handle's hot path counters
+     *
+     * The produce and poll paths keep these up to date with relaxed atomic
+     * increments; read them from any thread via
+     * HandleStatistics::get_snapshot.
+     *
+     * \return A reference to the statistics object
+     */
+    HandleStatistics& get_statistics();
+
+    /**
+     * \sa KafkaHandleBase::get_statistics
+     */
+    const HandleStatistics& get_statistics() const;
+
 #if RD_KAFKA_VERSION >= RD_KAFKA_ADMIN_API_SUPPORT_VERSION
     /**
      * \brief Gets the background queue
@@ -360,6 +519,15 @@ public:
     void yield() const;
 protected:
     KafkaHandleBase(Configuration config);
+    KafkaHandleBase(FrozenConfiguration config);
+
+    /**
+     * \brief Gets the handle's frozen configuration
+     *
+     * When the handle was built from a plain Configuration, this is the frozen
+     * wrapper created around it during construction.
+     */
+    const FrozenConfiguration& get_frozen_configuration() const;
 
     void set_handle(rd_kafka_t* handle);
     void check_error(rd_kafka_resp_err_t error) const;
@@ -378,21 +546,36 @@ private:
 
     using HandlePtr = std::unique_ptr<rd_kafka_t, HandleDeleter>;
     using TopicConfigurationMap = std::unordered_map<std::string, TopicConfiguration>;
+    using MetadataCacheClock = std::chrono::steady_clock;
+    using TopicMetadataMap = std::unordered_map<std::string, TopicMetadata>;
+    using TopicMap = std::unordered_map<std::string, Topic>;
 
     Topic get_topic(const std::string& name, rd_kafka_topic_conf_t* conf);
     Metadata get_metadata(bool all_topics,
                           rd_kafka_topic_t* topic_ptr,
                           std::chrono::milliseconds timeout) const;
+    TopicMetadata get_cached_metadata(const Topic& topic,
+                                      std::chrono::milliseconds timeout) const;
     GroupInformationList fetch_consumer_groups(const char* name,
                                                std::chrono::milliseconds timeout);
+    GroupInformationSnapshot fetch_consumer_groups_snapshot(const char* name,
+                                                            std::chrono::milliseconds timeout);
     void save_topic_config(const std::string& topic_name, TopicConfiguration config);
 
     std::chrono::milliseconds timeout_ms_;
-    Configuration config_;
+    FrozenConfiguration config_;
     TopicConfigurationMap topic_configurations_;
     std::mutex topic_configurations_mutex_;
     HandlePtr handle_;
     int destroy_flags_;
+    std::chrono::milliseconds metadata_cache_ttl_;
+    mutable TopicMetadataMap metadata_cache_;
+    mutable MetadataCacheClock::time_point metadata_cache_expiration_;
+    mutable std::mutex metadata_cache_mutex_;
+    TopicMap topic_cache_;
+    std::shared_mutex topic_cache_mutex_;
+    HandleStatistics statistics_;
+    std::atomic<bool> ready_{false};
 };
 
 } // cppkafka
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_KAFKA_STATISTICS_H
+#define CPPKAFKA_KAFKA_STATISTICS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Typed view of librdkafka's periodic statistics payload
+ *
+ * librdkafka emits its statistics as a JSON document. This struct captures the
+ * fields that are relevant for monitoring consumer lag, broker round-trip times
+ * and queue depths without going through a DOM parser.
+ *
+ * KafkaStatistics::parse fills an instance using a single forward pass over the
+ * JSON text and performs no allocations once the instance has been sized by a
+ * previous interval: strings are re-assigned in place and the broker/topic
+ * vectors keep their capacity between intervals. Reuse the same instance across
+ * callbacks to get allocation-free steady state parsing.
+ *
+ * Fields that are missing from the payload (e.g. consumer fields on a producer
+ * handle) keep their default values.
+ *
+ * \sa Configuration::set_stats_callback
+ */
+struct CPPKAFKA_API KafkaStatistics {
+    /**
+     * Rolling window statistics as emitted by librdkafka (e.g. rtt, int_latency)
+     */
+    struct WindowStatistics {
+        int64_t min{0};
+        int64_t max{0};
+        int64_t avg{0};
+        int64_t cnt{0};
+    };
+
+    /**
+     * Per broker connection statistics
+     */
+    struct BrokerStatistics {
+        std::string name;
+        std::string state;
+        int32_t node_id{-1};
+        /**
+         * Requests awaiting transmission / in flight to this broker
+         */
+        int64_t outbuf_cnt{0};
+        int64_t outbuf_msg_cnt{0};
+        int64_t waitresp_cnt{0};
+        int64_t waitresp_msg_cnt{0};
+        int64_t tx{0};
+        int64_t tx_bytes{0};
+        int64_t rx{0};
+        int64_t rx_bytes{0};
+        /**
+         * Broker round-trip time, in microseconds
+         */
+        WindowStatistics rtt;
+        /**
+         * Internal producer queue latency, in microseconds
+         */
+        WindowStatistics int_latency;
+    };
+
+    /**
+     * Per partition statistics
+     */
+    struct PartitionStatistics {
+        int32_t partition{-1};
+        int32_t leader{-1};
+        /**
+         * Producer queue depths for this partition
+         */
+        int64_t msgq_cnt{0};
+        int64_t msgq_bytes{0};
+        int64_t xmit_msgq_cnt{0};
+        int64_t xmit_msgq_bytes{0};
+        /**
+         * Consumer fetch queue depths for this partition
+         */
+        int64_t fetchq_cnt{0};
+        int64_t fetchq_size{0};
+        int64_t lo_offset{-1};
+        int64_t hi_offset{-1};
+        int64_t app_offset{-1};
+        int64_t committed_offset{-1};
+        /**
+         * Difference between the high watermark and the committed offset,
+         * -1 if unknown
+         */
+        int64_t consumer_lag{-1};
+        int64_t txmsgs{0};
+        int64_t txbytes{0};
+        int64_t rxmsgs{0};
+        int64_t rxbytes{0};
+    };
+
+    /**
+     * Per topic statistics
+     */
+    struct TopicStatistics {
+        std::string name;
+        WindowStatistics batch_size;
+        std::vector<PartitionStatistics> partitions;
+    };
+
+    std::string name;
+    std::string client_id;
+    std::string type;
+    int64_t ts{0};
+    int64_t time{0};
+    /**
+     * Messages and bytes currently held in producer queues
+     */
+    int64_t msg_cnt{0};
+    int64_t msg_size{0};
+    int64_t replyq{0};
+    int64_t tx{0};
+    int64_t tx_bytes{0};
+    int64_t rx{0};
+    int64_t rx_bytes{0};
+    int64_t txmsgs{0};
+    int64_t txmsg_bytes{0};
+    int64_t rxmsgs{0};
+    int64_t rxmsg_bytes{0};
+    std::vector<BrokerStatistics> brokers;
+    std::vector<TopicStatistics> topics;
+
+    /**
+     * \brief Parses a statistics JSON payload into the given output struct
+     *
+     * The parse is a single pass over the input. Fields that are not part of
+     * this struct are skipped without being materialized. The output struct is
+     * reset before parsing but keeps any memory it already owns, so reusing the
+     * same instance avoids allocations entirely once broker and topic sets are
+     * stable.
+     *
+     * \param data Pointer to the JSON text (does not need to be null terminated)
+     * \param length Length of the JSON text
+     * \param output The struct to fill
+     *
+     * \return true if the payload was well formed, false otherwise. On failure
+     *         the output contents are unspecified.
+     */
+    static bool parse(const char* data, size_t length, KafkaStatistics& output);
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_KAFKA_STATISTICS_H
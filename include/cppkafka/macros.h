@@ -52,5 +52,9 @@
 #define RD_KAFKA_MESSAGE_STATUS_SUPPORT_VERSION 0x01000002 //v1.0.0.02
 #define RD_KAFKA_STORE_OFFSETS_SUPPORT_VERSION 0x00090501 //v0.9.5.01
 #define RD_KAFKA_DESTROY_FLAGS_SUPPORT_VERSION 0x000b0600 //v0.11.6
+#define RD_KAFKA_INTERCEPTOR_SUPPORT_VERSION 0x000b0600 //v0.11.6
+#define RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION 0x010400ff //v1.4.0
+#define RD_KAFKA_PURGE_SUPPORT_VERSION 0x010000ff //v1.0.0
+#define RD_KAFKA_INCREMENTAL_REBALANCE_SUPPORT_VERSION 0x010600ff //v1.6.0
 
 #endif // CPPKAFKA_MACROS_H
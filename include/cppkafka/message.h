@@ -35,6 +35,8 @@
 #include <chrono>
 #include <cassert>
 #include <optional>
+#include <string_view>
+#include <type_traits>
 #include <librdkafka/rdkafka.h>
 #include "buffer.h"
 #include "macros.h"
@@ -107,8 +109,23 @@ public:
      * \brief Gets the topic that this message belongs to
      */
     std::string get_topic() const {
+        return std::string(get_topic_view());
+    }
+
+    /**
+     * \brief Gets the topic name as a non-allocating view
+     *
+     * The underlying rd_kafka_topic_name pointer is cached on first access, so
+     * repeated calls neither allocate nor go back into librdkafka.
+     *
+     * \warning The view is only valid while this message is alive.
+     */
+    std::string_view get_topic_view() const {
         assert(handle_);
-        return handle_->rkt ? rd_kafka_topic_name(handle_->rkt) : std::string{};
+        if (!cached_topic_name_) {
+            cached_topic_name_ = handle_->rkt ? rd_kafka_topic_name(handle_->rkt) : "";
+        }
+        return cached_topic_name_;
     }
 
     /**
@@ -166,6 +183,24 @@ public:
         return key_;
     }
 
+    /**
+     * \brief Gets the message's payload as a non-allocating string view
+     *
+     * \warning The view is only valid while this message is alive.
+     */
+    std::string_view get_payload_view() const {
+        return static_cast<std::string_view>(payload_);
+    }
+
+    /**
+     * \brief Gets the message's key as a non-allocating string view
+     *
+     * \warning The view is only valid while this message is alive.
+     */
+    std::string_view get_key_view() const {
+        return static_cast<std::string_view>(key_);
+    }
+
     /**
      * \brief Gets the message offset
      */
@@ -190,6 +225,18 @@ public:
      * If calling rd_kafka_message_timestamp returns -1, then std::nullptr_t will be returned.
      */
     std::optional<MessageTimestamp> get_timestamp() const;
+
+    /**
+     * \brief Gets the raw message timestamp in milliseconds since the epoch
+     *
+     * The timestamp is fetched from librdkafka once and cached, so this is the
+     * cheapest way to read it several times per message. Returns -1 if the
+     * message has no timestamp.
+     */
+    int64_t get_raw_timestamp() const {
+        load_timestamp();
+        return raw_timestamp_;
+    }
     
 #if RD_KAFKA_VERSION >= RD_KAFKA_MESSAGE_LATENCY_SUPPORT_VERSION
     /**
@@ -224,6 +271,18 @@ public:
     rd_kafka_message_t* get_handle() const {
         return handle_.get();
     }
+
+    /**
+     * \brief Releases ownership of the rdkafka message handle
+     *
+     * The message becomes empty and the caller is responsible for calling
+     * rd_kafka_message_destroy on the returned handle. If this message didn't
+     * own its handle (e.g. it was built via make_non_owning) or was already
+     * empty, nullptr is returned and nothing is transferred.
+     *
+     * \sa MessagePool
+     */
+    rd_kafka_message_t* release_owned_handle();
     
     /**
      * \brief Internal private const data accessor (internal use only)
@@ -231,6 +290,13 @@ public:
     InternalPtr internal() const {
         return internal_;
     }
+
+    /**
+     * \brief Internal private data setter (internal use only)
+     */
+    void internal(InternalPtr internal) {
+        internal_ = std::move(internal);
+    }
 private:
     using HandlePtr = std::unique_ptr<rd_kafka_message_t, decltype(&rd_kafka_message_destroy)>;
 
@@ -239,6 +305,7 @@ private:
     Message(rd_kafka_message_t* handle, NonOwningTag);
     Message(HandlePtr handle);
     Message& load_internal();
+    void load_timestamp() const;
 
     HandlePtr handle_;
     Buffer payload_;
@@ -248,10 +315,36 @@ private:
 #endif
     void* user_data_;
     InternalPtr internal_;
+    // Lazily loaded caches for the metadata hot path
+    mutable const char* cached_topic_name_{nullptr};
+    mutable int64_t raw_timestamp_{-1};
+    mutable rd_kafka_timestamp_type_t raw_timestamp_type_{RD_KAFKA_TIMESTAMP_NOT_AVAILABLE};
+    mutable bool timestamp_loaded_{false};
 };
 
+// Messages are moved through poll_batch results and producer retry queues;
+// keep the move noexcept so those containers never fall back to copying
+static_assert(std::is_nothrow_move_constructible<Message>::value,
+              "Message must be nothrow move constructible");
+
 using MessageList = std::vector<Message>;
 
+/**
+ * \brief Extracts the raw timestamps of a whole batch of messages in one pass
+ *
+ * Fills a caller-provided array with the timestamp of each message in
+ * milliseconds since the epoch (-1 for messages without one), avoiding the
+ * per-message MessageTimestamp/optional construction of get_timestamp().
+ * Intended for time-indexed processing of poll_batch() results.
+ *
+ * \param messages The batch of messages
+ * \param timestamps Caller-provided array of at least messages.size() entries
+ * \param types Optional parallel array receiving each message's timestamp type
+ *              (the rd_kafka_timestamp_type_t value, 0 meaning not available)
+ */
+CPPKAFKA_API void extract_timestamps(const MessageList& messages, int64_t* timestamps,
+                                     uint8_t* types = nullptr);
+
 } // cppkafka
 
 #endif // CPPKAFKA_MESSAGE_H
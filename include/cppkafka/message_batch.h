@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MESSAGE_BATCH_H
+#define CPPKAFKA_MESSAGE_BATCH_H
+
+#include <cstddef>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+#include "message.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Reusable storage for batches of polled messages
+ *
+ * Consumer::poll_batch(MessageBatch&) fills this object instead of returning a fresh
+ * std::vector<Message>. Both the raw rd_kafka_message_t* array handed to librdkafka
+ * and the vector holding the Message views are kept between calls, so once the batch
+ * has been through one full poll no further allocations happen in the steady-state
+ * consume loop:
+ *
+ * \code
+ * MessageBatch batch(512);
+ * while (running) {
+ *     consumer.poll_batch(batch);
+ *     for (const Message& message : batch) {
+ *         // process message
+ *     }
+ * }
+ * \endcode
+ *
+ * \remark Polling into the batch destroys the messages it previously held.
+ */
+class CPPKAFKA_API MessageBatch {
+public:
+    using const_iterator = std::vector<Message>::const_iterator;
+    using iterator = std::vector<Message>::iterator;
+
+    /**
+     * \brief Constructs a batch able to hold up to max_batch_size messages
+     *
+     * \param max_batch_size The maximum amount of messages polled into this batch
+     */
+    explicit MessageBatch(size_t max_batch_size);
+
+    /**
+     * Gets the maximum amount of messages this batch can hold
+     */
+    size_t get_max_batch_size() const;
+
+    /**
+     * Gets the amount of messages currently in this batch
+     */
+    size_t get_size() const;
+
+    /**
+     * Indicates whether this batch holds no messages
+     */
+    bool empty() const;
+
+    /**
+     * Destroys the currently held messages, keeping the storage for reuse
+     */
+    void clear();
+
+    /**
+     * Getter for the held messages
+     */
+    const std::vector<Message>& get_messages() const;
+
+    /**
+     * Accesses the message at the given index
+     */
+    const Message& operator[](size_t index) const;
+    Message& operator[](size_t index);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * \brief Getter for the raw message array librdkafka consumes into
+     *
+     * Meant to be used by Consumer::poll_batch; the array holds
+     * get_max_batch_size() entries.
+     */
+    rd_kafka_message_t** get_buffer();
+
+    /**
+     * \brief Takes ownership of the first message_count raw messages in the buffer
+     *
+     * Meant to be used by Consumer::poll_batch after librdkafka filled the raw
+     * buffer. Previously held messages must have been cleared beforehand.
+     *
+     * \param message_count The amount of messages written into the raw buffer
+     */
+    void load(size_t message_count);
+private:
+    std::vector<rd_kafka_message_t*> buffer_;
+    std::vector<Message> messages_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_MESSAGE_BATCH_H
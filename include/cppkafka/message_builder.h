@@ -31,6 +31,8 @@
 #define CPPKAFKA_MESSAGE_BUILDER_H
 
 #include <chrono>
+#include <string_view>
+#include <type_traits>
 #include "buffer.h"
 #include "topic.h"
 #include "macros.h"
@@ -49,6 +51,12 @@ public:
     using HeaderType = Header<BufferType>;
     using HeaderListType = HeaderList<HeaderType>;
 #endif
+
+    // Builders are moved through producer queues; a throwing move would force
+    // those containers to copy on growth, so require it to be noexcept up front
+    static_assert(std::is_nothrow_move_constructible<BufferType>::value,
+                  "BufferType must be nothrow move constructible");
+
     /**
      * Construct a BasicMessageBuilder
      *
@@ -109,6 +117,23 @@ public:
      */
     Concrete& key(BufferType&& value);
 
+    /**
+     * \brief Sets the message's key from a string view
+     *
+     * For view buffer types (e.g. cppkafka::Buffer) no characters are copied,
+     * so the viewed data must outlive the builder. Restricted to actual
+     * string_view arguments so existing std::string calls keep resolving to
+     * the BufferType overloads.
+     *
+     * \param value The key to be used
+     */
+    template <typename V,
+              typename = typename std::enable_if<std::is_same<V, std::string_view>::value>::type>
+    Concrete& key(V value) {
+        key_ = BufferType(value);
+        return get_concrete();
+    }
+
 #if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
     /**
      *  Add a header(s) to the message
@@ -134,6 +159,23 @@ public:
      */
     Concrete& payload(BufferType&& value);
 
+    /**
+     * \brief Sets the message's payload from a string view
+     *
+     * For view buffer types (e.g. cppkafka::Buffer) no characters are copied,
+     * so the viewed data must outlive the builder. Restricted to actual
+     * string_view arguments so existing std::string calls keep resolving to
+     * the BufferType overloads.
+     *
+     * \param value The payload to be used
+     */
+    template <typename V,
+              typename = typename std::enable_if<std::is_same<V, std::string_view>::value>::type>
+    Concrete& payload(V value) {
+        payload_ = BufferType(value);
+        return get_concrete();
+    }
+
     /**
      * Sets the message's timestamp with a 'duration'
      *
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MESSAGE_POOL_H
+#define CPPKAFKA_MESSAGE_POOL_H
+
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+#include "message.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Defers and batches rd_kafka_message_t destruction
+ *
+ * Destroying consumed messages one at a time puts one rd_kafka_message_destroy
+ * call in the middle of every iteration of a consume loop. On high throughput
+ * consumers the destroy calls interleave poorly with the processing code; it is
+ * considerably cheaper to retire handles in batches.
+ *
+ * Instead of letting each Message destroy its handle, recycle processed
+ * messages into a pool. The pool collects the raw handles and destroys a whole
+ * batch in a tight loop whenever the flush threshold is reached (and on
+ * destruction):
+ *
+ * \code
+ * MessagePool pool;
+ * while (running) {
+ *     vector<Message> messages = consumer.poll_batch(512);
+ *     for (const Message& message : messages) {
+ *         // process message
+ *     }
+ *     pool.recycle(messages);
+ * }
+ * \endcode
+ *
+ * Non-owning and empty messages are recycled as no-ops, so an entire
+ * poll_batch / Queue::consume_batch result can be handed over unconditionally.
+ *
+ * \remark This class is not thread-safe; use one pool per consuming thread.
+ */
+class CPPKAFKA_API MessagePool {
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param flush_threshold The amount of pending handles that triggers a flush
+     */
+    MessagePool(size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+
+    MessagePool(const MessagePool&) = delete;
+    MessagePool(MessagePool&&) = delete;
+    MessagePool& operator=(const MessagePool&) = delete;
+    MessagePool& operator=(MessagePool&&) = delete;
+
+    /**
+     * Destructor. Flushes any pending handles.
+     */
+    ~MessagePool();
+
+    /**
+     * \brief Takes over the handle of a processed message
+     *
+     * The message becomes empty immediately; its handle is destroyed on the
+     * next flush.
+     *
+     * \param message The message to be recycled
+     */
+    void recycle(Message& message);
+
+    /**
+     * \brief Takes over the handles of a batch of processed messages
+     *
+     * Every message in the batch becomes empty; the vector itself is left
+     * intact so its capacity can be reused by the next poll.
+     *
+     * \param messages The messages to be recycled
+     */
+    void recycle(std::vector<Message>& messages);
+
+    /**
+     * Destroys all pending handles
+     */
+    void flush();
+
+    /**
+     * Gets the amount of handles waiting to be destroyed
+     */
+    size_t get_pending_count() const;
+private:
+    static const size_t DEFAULT_FLUSH_THRESHOLD;
+
+    void maybe_flush();
+
+    std::vector<rd_kafka_message_t*> pending_handles_;
+    size_t flush_threshold_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_MESSAGE_POOL_H
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MOCK_CLUSTER_H
+#define CPPKAFKA_MOCK_CLUSTER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+
+#include <librdkafka/rdkafka_mock.h>
+#include "configuration.h"
+
+namespace cppkafka {
+
+/**
+ * \brief An in-process mock kafka cluster
+ *
+ * Wraps rd_kafka_mock_cluster_new so producers and consumers can be exercised
+ * without a real broker: tests and benchmarks run reproducibly on any machine,
+ * and failure paths that are hard to provoke against a live cluster (request
+ * errors, broker latency, brokers going down) can be injected on demand.
+ *
+ * \code
+ * MockCluster cluster(3);
+ * cluster.create_topic("some_topic", 4);
+ *
+ * Producer producer(cluster.make_configuration());
+ * Consumer consumer(cluster.make_configuration()
+ *                          .set("group.id", "some_group"));
+ * \endcode
+ *
+ * The cluster's brokers are served by an internal librdkafka thread; handles
+ * created from make_configuration talk to them over real sockets, so the whole
+ * wrapper stack, including librdkafka itself, is measured.
+ *
+ * \remark Only available when built against librdkafka >= 1.4.0.
+ */
+class CPPKAFKA_API MockCluster {
+public:
+    /**
+     * \brief Constructs a mock cluster
+     *
+     * \param broker_count The amount of mock brokers to spin up
+     */
+    explicit MockCluster(size_t broker_count = 1);
+    MockCluster(const MockCluster&) = delete;
+    MockCluster& operator=(const MockCluster&) = delete;
+
+    /**
+     * \brief Destructor. Tears down the mock brokers.
+     *
+     * Handles created against this cluster should be destroyed first.
+     */
+    ~MockCluster();
+
+    /**
+     * \brief Gets the bootstrap servers string for this cluster
+     *
+     * Suitable as the value of metadata.broker.list.
+     */
+    const std::string& get_bootstrap_servers() const;
+
+    /**
+     * \brief Builds a configuration pointing at this cluster
+     *
+     * The returned configuration only has metadata.broker.list set; apply any
+     * further options on top of it.
+     */
+    Configuration make_configuration() const;
+
+    /**
+     * \brief Creates a topic on the mock cluster
+     *
+     * \param topic The name of the topic to be created
+     * \param partition_count The amount of partitions in the topic
+     * \param replication_factor The replication factor; defaults to the
+     *        amount of brokers when 0
+     */
+    void create_topic(const std::string& topic, size_t partition_count,
+                      size_t replication_factor = 0);
+
+    /**
+     * \brief Sets the simulated round-trip latency of a broker
+     *
+     * Every request to the broker is delayed by this amount, allowing latency
+     * distributions to be measured without a network.
+     *
+     * \param broker_id The id of the broker (brokers are numbered from 1)
+     * \param rtt The round-trip time to be injected
+     */
+    void set_broker_rtt(int32_t broker_id, std::chrono::milliseconds rtt);
+
+    /**
+     * \brief Makes a broker refuse connections
+     *
+     * \param broker_id The id of the broker (brokers are numbered from 1)
+     */
+    void set_broker_down(int32_t broker_id);
+
+    /**
+     * \brief Makes a previously downed broker accept connections again
+     *
+     * \param broker_id The id of the broker (brokers are numbered from 1)
+     */
+    void set_broker_up(int32_t broker_id);
+
+    /**
+     * \brief Pushes errors to be returned for a request type
+     *
+     * The next requests of the given type are answered with the given errors,
+     * in order, one per request; afterwards the cluster behaves normally
+     * again. This is how commit retries, produce failures and similar failure
+     * paths are provoked deterministically.
+     *
+     * \param api_key The kafka protocol api key of the request type (e.g. 0
+     *        for Produce, 8 for OffsetCommit)
+     * \param errors The errors to be returned
+     */
+    void push_request_errors(int16_t api_key,
+                             const std::vector<rd_kafka_resp_err_t>& errors);
+
+    /**
+     * Returns the rd_kafka_mock_cluster_t handle
+     */
+    rd_kafka_mock_cluster_t* get_handle() const;
+private:
+    rd_kafka_t* handle_;
+    rd_kafka_mock_cluster_t* cluster_;
+    std::string bootstrap_servers_;
+    size_t broker_count_;
+};
+
+} // cppkafka
+
+#endif // RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION
+
+#endif // CPPKAFKA_MOCK_CLUSTER_H
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_OWNING_BUFFER_H
+#define CPPKAFKA_OWNING_BUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "buffer.h"
+#include "macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief An owning buffer with a configurable inline capacity.
+ *
+ * Unlike Buffer, which is only a view, this type owns the bytes it points to.
+ * Contents of up to InlineCapacity bytes are stored inside the object itself,
+ * so typical message keys and header values never touch the heap; larger
+ * contents fall back to a heap allocation.
+ *
+ * The type converts implicitly to Buffer, so it can be used anywhere a Buffer
+ * is accepted, and it satisfies the BufferType requirements of
+ * BasicMessageBuilder, Header and BufferedProducer, e.g.:
+ *
+ * \code
+ * ConcreteMessageBuilder<OwningBuffer> builder("my_topic");
+ * builder.key(OwningBuffer(key_data)).payload(OwningBuffer(payload_data));
+ * \endcode
+ *
+ * A std::hash specialization is provided so it can also be used directly as
+ * an unordered container key (e.g. as the Key type of CompactedTopicProcessor).
+ */
+template <size_t InlineCapacity>
+class CPPKAFKA_API BasicOwningBuffer {
+public:
+    /**
+     * The type of data this buffer holds
+     */
+    using DataType = Buffer::DataType;
+
+    /**
+     * The const iterator type
+     */
+    using const_iterator = const DataType*;
+
+    /**
+     * The inline capacity, in bytes
+     */
+    static constexpr size_t inline_capacity = InlineCapacity;
+
+    /**
+     * Constructs an empty buffer
+     */
+    BasicOwningBuffer()
+    : size_(0) {
+    }
+
+    /**
+     * \brief Constructs a buffer by copying a pointer/size pair
+     *
+     * \param data A pointer to some type of size 1
+     * \param size The amount of bytes to copy
+     */
+    template <typename T>
+    BasicOwningBuffer(const T* data, size_t size)
+    : size_(0) {
+        static_assert(sizeof(T) == sizeof(DataType), "sizeof(T) != sizeof(DataType)");
+        if ((data == nullptr) && (size > 0)) {
+            throw Exception("Invalid buffer configuration");
+        }
+        assign(reinterpret_cast<const DataType*>(data), size);
+    }
+
+    /**
+     * Constructs a buffer by copying the contents of a string
+     */
+    BasicOwningBuffer(const std::string& data)
+    : BasicOwningBuffer(data.data(), data.size()) {
+    }
+
+    /**
+     * Constructs a buffer by copying the contents of a vector
+     */
+    template <typename T>
+    BasicOwningBuffer(const std::vector<T>& data)
+    : BasicOwningBuffer(data.data(), data.size()) {
+    }
+
+    /**
+     * Constructs a buffer by copying the contents of a Buffer view
+     */
+    explicit BasicOwningBuffer(const Buffer& data)
+    : BasicOwningBuffer(data.get_data(), data.get_size()) {
+    }
+
+    BasicOwningBuffer(const BasicOwningBuffer& rhs)
+    : size_(0) {
+        assign(rhs.get_data(), rhs.get_size());
+    }
+
+    // Builders containing these buffers flow through producer queues by move,
+    // which BasicMessageBuilder and BufferedProducer require to be noexcept
+    BasicOwningBuffer(BasicOwningBuffer&& rhs) noexcept
+    : size_(rhs.size_) {
+        if (is_inline()) {
+            std::memcpy(storage_.inline_data, rhs.storage_.inline_data, size_);
+        }
+        else {
+            storage_.heap_data = rhs.storage_.heap_data;
+        }
+        rhs.size_ = 0;
+    }
+
+    BasicOwningBuffer& operator=(const BasicOwningBuffer& rhs) {
+        if (this != &rhs) {
+            assign(rhs.get_data(), rhs.get_size());
+        }
+        return *this;
+    }
+
+    BasicOwningBuffer& operator=(BasicOwningBuffer&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            size_ = rhs.size_;
+            if (is_inline()) {
+                std::memcpy(storage_.inline_data, rhs.storage_.inline_data, size_);
+            }
+            else {
+                storage_.heap_data = rhs.storage_.heap_data;
+            }
+            rhs.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~BasicOwningBuffer() {
+        clear();
+    }
+
+    /**
+     * \brief Replaces the contents of this buffer
+     *
+     * \param data A pointer to the bytes to copy
+     * \param size The amount of bytes to copy
+     */
+    void assign(const DataType* data, size_t size) {
+        clear();
+        size_ = size;
+        if (is_inline()) {
+            std::memcpy(storage_.inline_data, data, size_);
+        }
+        else {
+            storage_.heap_data = new DataType[size_];
+            std::memcpy(storage_.heap_data, data, size_);
+        }
+    }
+
+    /**
+     * Empties this buffer, releasing any heap storage
+     */
+    void clear() {
+        if (!is_inline()) {
+            delete[] storage_.heap_data;
+        }
+        size_ = 0;
+    }
+
+    /**
+     * Getter for the data pointer
+     */
+    const DataType* get_data() const {
+        return is_inline() ? storage_.inline_data : storage_.heap_data;
+    }
+
+    /**
+     * Getter for the size of the buffer
+     */
+    size_t get_size() const {
+        return size_;
+    }
+
+    /**
+     * Checks whether this buffer is empty
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Gets an iterator to the beginning of this buffer
+     */
+    const_iterator begin() const {
+        return get_data();
+    }
+
+    /**
+     * Gets an iterator to the end of this buffer
+     */
+    const_iterator end() const {
+        return get_data() + size_;
+    }
+
+    /**
+     * Checks whether this is a non empty buffer
+     */
+    explicit operator bool() const {
+        return size_ != 0;
+    }
+
+    /**
+     * \brief Converts this buffer into a non-owning view
+     *
+     * The view is only valid while this object is alive and unmodified.
+     */
+    operator Buffer() const {
+        return Buffer(get_data(), size_);
+    }
+
+    /**
+     * \brief Converts the contents of the buffer into a string
+     *
+     * Explicit, both because it copies and because a second implicit
+     * conversion would make overload sets taking Buffer or std::string
+     * (e.g. Buffer's own constructors) ambiguous.
+     */
+    explicit operator std::string() const {
+        return std::string(begin(), end());
+    }
+private:
+    union Storage {
+        DataType inline_data[InlineCapacity];
+        DataType* heap_data;
+    };
+
+    bool is_inline() const {
+        return size_ <= InlineCapacity;
+    }
+
+    Storage storage_;
+    size_t size_;
+};
+
+/**
+ * An owning buffer whose inline capacity covers typical key and header sizes
+ */
+using OwningBuffer = BasicOwningBuffer<48>;
+
+// Comparison operators, routed through the Buffer comparison kernels
+
+template <size_t N>
+bool operator==(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return Buffer(lhs) == Buffer(rhs);
+}
+
+template <size_t N>
+bool operator!=(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <size_t N>
+bool operator<(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return compare(Buffer(lhs), Buffer(rhs)) < 0;
+}
+
+template <size_t N>
+bool operator>(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return compare(Buffer(lhs), Buffer(rhs)) > 0;
+}
+
+template <size_t N>
+bool operator<=(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return !(lhs > rhs);
+}
+
+template <size_t N>
+bool operator>=(const BasicOwningBuffer<N>& lhs, const BasicOwningBuffer<N>& rhs) {
+    return !(lhs < rhs);
+}
+
+} // cppkafka
+
+namespace std {
+
+// Allows using owning buffers as unordered container keys
+template <size_t N>
+struct hash<cppkafka::BasicOwningBuffer<N>> {
+    size_t operator()(const cppkafka::BasicOwningBuffer<N>& buffer) const {
+        // FNV-1a
+        size_t result = 14695981039346656037ULL;
+        for (const auto value : buffer) {
+            result = (result ^ value) * 1099511628211ULL;
+        }
+        return result;
+    }
+};
+
+} // std
+
+#endif // CPPKAFKA_OWNING_BUFFER_H
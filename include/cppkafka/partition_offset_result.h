@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_PARTITION_OFFSET_RESULT_H
+#define CPPKAFKA_PARTITION_OFFSET_RESULT_H
+
+#include <cstdint>
+#include <type_traits>
+#include <librdkafka/rdkafka.h>
+#include "macros.h"
+#include "error.h"
+
+namespace cppkafka {
+
+/**
+ * \brief The per-partition outcome of an offset query, as a plain value
+ *
+ * Consumer::get_offsets_committed and Consumer::get_offsets_position return
+ * TopicPartitionList results, which means one topic string per entry per call.
+ * That's fine for occasional queries but turns lag polling or commit
+ * verification under broker flapping into an allocator stress test. This type
+ * carries only the partition, the offset and the per-partition error, so a
+ * caller-provided array of these can be filled without touching the heap.
+ *
+ * Results are positional: entry i of a filled array refers to entry i of the
+ * queried list, so the topic is implied by the query and doesn't need to be
+ * stored.
+ *
+ * \sa Consumer::get_offsets_committed(const CachedTopicPartitionList&, PartitionOffsetResult*, size_t)
+ */
+class CPPKAFKA_API PartitionOffsetResult {
+public:
+    /**
+     * Constructs an empty result (invalid offset, no error)
+     */
+    PartitionOffsetResult() = default;
+
+    /**
+     * Constructs a result from its components
+     */
+    PartitionOffsetResult(int32_t partition, int64_t offset, Error error);
+
+    /**
+     * Gets the partition
+     */
+    int32_t get_partition() const;
+
+    /**
+     * Gets the queried offset; RD_KAFKA_OFFSET_INVALID when nothing was stored
+     */
+    int64_t get_offset() const;
+
+    /**
+     * Gets the per-partition error, if any
+     */
+    Error get_error() const;
+
+    /**
+     * Indicates whether the query succeeded for this partition
+     */
+    explicit operator bool() const;
+private:
+    int32_t partition_{RD_KAFKA_PARTITION_UA};
+    int64_t offset_{RD_KAFKA_OFFSET_INVALID};
+    Error error_;
+};
+
+// Arrays of these are meant to live on the caller's stack and be filled with
+// plain stores, so the type has to stay a trivially copyable value
+static_assert(std::is_trivially_copyable<PartitionOffsetResult>::value,
+              "PartitionOffsetResult must remain trivially copyable");
+
+} // cppkafka
+
+#endif // CPPKAFKA_PARTITION_OFFSET_RESULT_H
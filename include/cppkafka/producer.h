@@ -31,9 +31,14 @@
 #define CPPKAFKA_PRODUCER_H
 
 #include <memory>
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <vector>
 #include "kafka_handle_base.h"
 #include "configuration.h"
 #include "buffer.h"
+#include "gathered_payload.h"
 #include "topic.h"
 #include "macros.h"
 #include "message_builder.h"
@@ -92,6 +97,13 @@ public:
         BLOCK_ON_FULL_QUEUE = RD_KAFKA_MSG_F_BLOCK ///< Producer will block if the underlying queue is full
     };
 
+    /**
+     * \brief Callback invoked for each message which could not be enqueued by produce_batch
+     *
+     * The builder given to the callback is the one which failed to be produced.
+     */
+    using BatchFailureCallback = std::function<void(MessageBuilder&, Error)>;
+
     /**
      * \brief Constructs a producer using the given configuration
      *
@@ -99,6 +111,18 @@ public:
      */
     Producer(Configuration config);
 
+    /**
+     * \brief Constructs a producer sharing a frozen configuration
+     *
+     * The frozen configuration is shared by reference count rather than
+     * duplicated; only the rd_kafka_conf_t duplicate consumed by rd_kafka_new
+     * is created. Prefer this when creating many producers from the same
+     * options.
+     *
+     * \param config The frozen configuration to use
+     */
+    Producer(FrozenConfiguration config);
+
     /**
      * \brief Sets the payload policy
      *
@@ -118,7 +142,21 @@ public:
      */
     void produce(const MessageBuilder& builder);
     void produce(MessageBuilder&& builder);
-    
+
+    /**
+     * \brief Produces a message into a pre-created topic
+     *
+     * The topic handle supersedes the builder's topic name: rdkafka is handed
+     * the handle directly (RD_KAFKA_V_RKT), skipping the per-message name
+     * lookup through its internal topic table. Use this when producing to a
+     * fixed set of topics whose handles were created up front.
+     *
+     * \param topic The topic to produce into
+     * \param builder The builder class used to compose a message
+     */
+    void produce(const Topic& topic, const MessageBuilder& builder);
+    void produce(const Topic& topic, MessageBuilder&& builder);
+
     /**
      * \brief Produces a message
      *
@@ -127,6 +165,83 @@ public:
     void produce(const Message& message);
     void produce(Message&& message);
 
+    /**
+     * \brief Produces a message gathering the payload from a fragment list
+     *
+     * The fragments are copied, in order, into a single buffer which rdkafka
+     * takes ownership of (RD_KAFKA_MSG_F_FREE), so each payload byte is copied
+     * exactly once regardless of the payload policy. The builder's own payload
+     * is ignored; topic, partition, key, headers, timestamp and user data are
+     * taken from it as usual.
+     *
+     * \param builder The builder class used to compose the message
+     * \param payload The fragments the payload is gathered from
+     */
+    void produce(const MessageBuilder& builder, const GatheredPayload& payload);
+
+    /**
+     * \brief Produces a message whose payload is written in place
+     *
+     * A buffer of the declared size is allocated and the writer is invoked as
+     * writer(payload, payload_size) to fill it before rdkafka takes ownership
+     * of it (RD_KAFKA_MSG_F_FREE). This lets a serializer compose the payload
+     * directly into the buffer rdkafka will keep, without an intermediate
+     * copy. The builder's own payload is ignored.
+     *
+     * \param builder The builder class used to compose the message
+     * \param payload_size The exact size of the payload to be written
+     * \param writer Callable invoked to fill the payload buffer
+     */
+    template <typename Writer>
+    void produce(const MessageBuilder& builder, size_t payload_size, const Writer& writer) {
+        void* payload = std::malloc(payload_size);
+        if (!payload) {
+            throw std::bad_alloc();
+        }
+        try {
+            writer(payload, payload_size);
+        }
+        catch (...) {
+            std::free(payload);
+            throw;
+        }
+        produce_owned(builder, payload, payload_size);
+    }
+
+    /**
+     * \brief Produces a batch of messages
+     *
+     * The builders are grouped by topic and each group is enqueued using a single
+     * rd_kafka_produce_batch call, amortizing the handle's internal lock over the
+     * whole group instead of paying for it once per message.
+     *
+     * Messages carrying headers or an explicit timestamp are not supported by
+     * rd_kafka_produce_batch and are produced individually as if Producer::produce
+     * had been called on them.
+     *
+     * \param builders The builders for the messages to be produced
+     *
+     * \return The number of messages successfully enqueued
+     *
+     * \remark This method throws cppkafka::HandleException on the first failed message
+     */
+    size_t produce_batch(std::vector<MessageBuilder>& builders);
+
+    /**
+     * \brief Produces a batch of messages
+     *
+     * Same as the other overload of Producer::produce_batch but instead of throwing,
+     * the provided callback is invoked once for each message which failed to be
+     * enqueued, along with the error it failed with.
+     *
+     * \param builders The builders for the messages to be produced
+     * \param callback The callback invoked on each failed message
+     *
+     * \return The number of messages successfully enqueued
+     */
+    size_t produce_batch(std::vector<MessageBuilder>& builders,
+                         const BatchFailureCallback& callback);
+
     /**
      * \brief Polls on this handle
      *
@@ -165,12 +280,17 @@ public:
 private:
 #if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
     void do_produce(const MessageBuilder& builder, MessageBuilder::HeaderListType&& headers);
+    void do_produce(const Topic& topic, const MessageBuilder& builder,
+                    MessageBuilder::HeaderListType&& headers);
     void do_produce(const Message& message, MessageBuilder::HeaderListType&& headers);
 #else
     void do_produce(const MessageBuilder& builder);
+    void do_produce(const Topic& topic, const MessageBuilder& builder);
     void do_produce(const Message& message);
 #endif
-    
+    // Takes ownership of the malloc'd payload; frees it if it can't be enqueued
+    void produce_owned(const MessageBuilder& builder, void* payload, size_t payload_size);
+
     // Members
     PayloadPolicy message_payload_policy_;
 };
@@ -29,6 +29,7 @@
 
 #include <vector>
 #include <memory>
+#include <type_traits>
 #include <librdkafka/rdkafka.h>
 #include "event.h"
 #include "macros.h"
@@ -105,6 +106,27 @@ public:
      * This translates to a call to rd_kafka_queue_forward(NULL)
      */
     void disable_queue_forwarding() const;
+
+    /**
+     * \brief Registers a callback invoked when this queue becomes non-empty
+     *
+     * This translates to a call to rd_kafka_queue_cb_event_enable.
+     *
+     * \warning The callback is invoked from rdkafka's internal threads and
+     * must not call into the consume APIs; it should only signal another
+     * thread (or executor) to do the consuming.
+     *
+     * \param callback The callback to be invoked
+     * \param opaque The opaque pointer passed to the callback
+     */
+    void enable_event_callback(void (*callback)(rd_kafka_t*, void*), void* opaque) const;
+
+    /**
+     * \brief Unregisters the event callback
+     *
+     * This translates to a call to rd_kafka_queue_cb_event_enable(NULL)
+     */
+    void disable_event_callback() const;
     
     /**
      * \brief Sets the timeout for consume operations
@@ -200,6 +222,41 @@ public:
     std::vector<Message> consume_batch(size_t max_batch_size,
                                        std::chrono::milliseconds timeout) const;
 
+    /**
+     * \brief Consumes a batch of messages into an output iterator
+     *
+     * Unlike the vector returning overloads this writes the messages straight
+     * into caller owned storage (a reused vector via std::back_inserter, an
+     * array of Message slots, etc), so tight consume loops don't construct and
+     * destroy a container per call. Batches of up to 512 messages don't touch
+     * the heap at all.
+     *
+     * \param output The iterator the messages are written to
+     * \param max_batch_size The max number of messages to consume if available
+     *
+     * \return The number of messages written
+     */
+    template <typename OutputIterator,
+              typename = typename std::enable_if<!std::is_integral<OutputIterator>::value>::type>
+    size_t consume_batch(OutputIterator output, size_t max_batch_size) const;
+
+    /**
+     * \brief Consumes a batch of messages into an output iterator
+     *
+     * Same as Queue::consume_batch(OutputIterator, size_t) but the specified
+     * timeout will be used instead of the configured one
+     *
+     * \param output The iterator the messages are written to
+     * \param max_batch_size The max number of messages to consume if available
+     * \param timeout The timeout to be used on this call
+     *
+     * \return The number of messages written
+     */
+    template <typename OutputIterator,
+              typename = typename std::enable_if<!std::is_integral<OutputIterator>::value>::type>
+    size_t consume_batch(OutputIterator output, size_t max_batch_size,
+                         std::chrono::milliseconds timeout) const;
+
     /**
      * \brief Extracts the next message in this Queue
      *
@@ -225,7 +282,9 @@ public:
     
 private:
     static const std::chrono::milliseconds DEFAULT_TIMEOUT;
-    
+    // Largest batch whose raw message array fits on the stack (4KB of pointers)
+    static constexpr size_t STACK_BATCH_SIZE = 512;
+
     using HandlePtr = std::unique_ptr<rd_kafka_queue_t, decltype(&rd_kafka_queue_destroy)>;
 
     struct NonOwningTag { };
@@ -265,6 +324,39 @@ std::vector<Message, Allocator> Queue::consume_batch(size_t max_batch_size,
     return std::vector<Message, Allocator>(raw_messages.begin(), raw_messages.begin() + result, alloc);
 }
 
+template <typename OutputIterator, typename>
+size_t Queue::consume_batch(OutputIterator output, size_t max_batch_size) const {
+    return consume_batch(output, max_batch_size, timeout_ms_);
+}
+
+template <typename OutputIterator, typename>
+size_t Queue::consume_batch(OutputIterator output, size_t max_batch_size,
+                            std::chrono::milliseconds timeout) const {
+    // Small batches keep the raw message array on the stack
+    rd_kafka_message_t* stack_messages[STACK_BATCH_SIZE];
+    std::vector<rd_kafka_message_t*> heap_messages;
+    rd_kafka_message_t** raw_messages = stack_messages;
+    if (max_batch_size > STACK_BATCH_SIZE) {
+        heap_messages.resize(max_batch_size);
+        raw_messages = heap_messages.data();
+    }
+    const ssize_t result = rd_kafka_consume_batch_queue(handle_.get(),
+                                                        static_cast<int>(timeout.count()),
+                                                        raw_messages,
+                                                        max_batch_size);
+    if (result == -1) {
+        rd_kafka_resp_err_t error = rd_kafka_last_error();
+        if (error != RD_KAFKA_RESP_ERR_NO_ERROR) {
+            throw QueueException(error);
+        }
+        return 0;
+    }
+    for (ssize_t i = 0; i < result; ++i) {
+        *output++ = Message(raw_messages[i]);
+    }
+    return static_cast<size_t>(result);
+}
+
 } // cppkafka
 
 #endif //CPPKAFKA_QUEUE_H
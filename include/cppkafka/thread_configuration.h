@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_THREAD_CONFIGURATION_H
+#define CPPKAFKA_THREAD_CONFIGURATION_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Describes how librdkafka's internal threads should be configured
+ *
+ * rd_kafka_new spawns the handle's main, background and broker threads with the
+ * process defaults, so on multi-socket hosts they migrate freely across NUMA nodes.
+ * A ThreadConfiguration, installed via Configuration::set_thread_configuration, is
+ * applied to each of those threads as it starts (through librdkafka's on_thread_start
+ * interceptor): the thread can be pinned to an explicit CPU set or to the CPUs of one
+ * NUMA node, re-niced, and given a recognizable name prefix.
+ *
+ * All settings are optional; unset ones leave the thread untouched. Applying the
+ * settings is a Linux-only operation and a no-op elsewhere.
+ *
+ * Example:
+ *
+ * \code
+ * ThreadConfiguration threads;
+ * threads.set_numa_node(0);
+ * threads.set_name_prefix("orders-");
+ * config.set_thread_configuration(threads);
+ * \endcode
+ *
+ * \sa Configuration::set_thread_configuration
+ */
+class CPPKAFKA_API ThreadConfiguration {
+public:
+    /**
+     * \brief Pins the handle threads to an explicit set of CPUs
+     *
+     * Takes precedence over set_numa_node.
+     *
+     * \param cpus The CPU indexes to pin to
+     */
+    ThreadConfiguration& set_cpu_set(std::vector<int> cpus);
+
+    /**
+     * \brief Pins the handle threads to the CPUs of the given NUMA node
+     *
+     * The node's CPU list is read from sysfs when the first thread starts.
+     *
+     * \param node The NUMA node index
+     */
+    ThreadConfiguration& set_numa_node(int node);
+
+    /**
+     * \brief Sets the nice level the handle threads run at
+     *
+     * \param level The nice level (-20..19); raising priority requires privileges
+     */
+    ThreadConfiguration& set_nice_level(int level);
+
+    /**
+     * \brief Sets a prefix for the handle threads' names
+     *
+     * The prefix is prepended to librdkafka's own thread name and truncated to the
+     * 15 character limit imposed by the kernel.
+     *
+     * \param prefix The prefix to use
+     */
+    ThreadConfiguration& set_name_prefix(std::string prefix);
+
+    /**
+     * Gets the explicit CPU set, empty if unset
+     */
+    const std::vector<int>& get_cpu_set() const;
+
+    /**
+     * Gets the NUMA node, -1 if unset
+     */
+    int get_numa_node() const;
+
+    /**
+     * Gets the nice level, if set
+     */
+    const std::optional<int>& get_nice_level() const;
+
+    /**
+     * Gets the thread name prefix
+     */
+    const std::string& get_name_prefix() const;
+
+    /**
+     * \brief Applies this configuration to the calling thread
+     *
+     * Invoked from the thread-start interceptor for every handle thread; can also
+     * be called directly on application-owned worker threads to co-locate them with
+     * the handle's threads.
+     *
+     * \param thread_name The thread's base name, used with the name prefix
+     */
+    void apply_to_current_thread(const std::string& thread_name) const;
+private:
+    std::vector<int> cpus_;
+    std::string name_prefix_;
+    std::optional<int> nice_level_;
+    int numa_node_{-1};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_THREAD_CONFIGURATION_H
@@ -50,6 +50,11 @@ class Buffer;
  */
 class CPPKAFKA_API TopicConfiguration : public ConfigurationBase<TopicConfiguration> {
 public:
+    /**
+     * The configuration level typed catalog options are validated against
+     */
+    static constexpr ConfigScope OPTION_SCOPE = ConfigScope::TOPIC;
+
     /**
      * \brief Partitioner callback
      *
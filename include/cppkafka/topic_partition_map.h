@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_TOPIC_PARTITION_MAP_H
+#define CPPKAFKA_TOPIC_PARTITION_MAP_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "exceptions.h"
+#include "macros.h"
+#include "topic_partition.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Per-partition state table keyed by topic/partition
+ *
+ * Every per-partition state table - partition queues, offset trackers, lag
+ * and metrics tables - ends up as a std::map keyed by TopicPartition, which
+ * pays a string comparison per tree level on every lookup. This container
+ * interns each topic name once and stores the values in dense
+ * partition-indexed arrays, so a lookup is one hash of the topic name and an
+ * array index, and none at all on the id-based fast path:
+ *
+ * \code
+ * TopicPartitionMap<int64_t> offsets;
+ * offsets.emplace(TopicPartition("events", 0), 0);
+ * // Hot loop: resolve the topic id once, then index per message
+ * const size_t topic_id = offsets.get_topic_id("events");
+ * int64_t* offset = offsets.get(topic_id, message.get_partition());
+ * \endcode
+ *
+ * The interface mirrors std::map<TopicPartition, T> for the common
+ * operations (find/emplace/erase/clear/iteration with first/second access),
+ * so it drops into existing tables; iteration visits partitions in ascending
+ * order within each topic, topics in interning order. References and
+ * iterators to surviving entries stay valid across emplace and erase, like
+ * the node-based map they replace.
+ *
+ * Partitions act as array indexes, so only concrete partitions (>= 0) can be
+ * stored; sparse partition spaces waste one pointer per gap.
+ */
+template <typename T>
+class TopicPartitionMap {
+public:
+    using value_type = std::pair<const TopicPartition, T>;
+
+    /**
+     * The id returned by get_topic_id for topics that were never stored
+     */
+    static constexpr size_t npos = static_cast<size_t>(-1);
+private:
+    using SlotPtr = std::unique_ptr<value_type>;
+
+    struct TopicSlots {
+        std::string topic;
+        // Index == partition; empty slots are gaps in the partition space
+        std::vector<SlotPtr> slots;
+    };
+
+    template <typename MapType, typename ValueType>
+    class basic_iterator {
+        friend class TopicPartitionMap;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ValueType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+        basic_iterator() = default;
+
+        reference operator*() const {
+            return *map_->topics_[topic_index_].slots[slot_index_];
+        }
+
+        pointer operator->() const {
+            return map_->topics_[topic_index_].slots[slot_index_].get();
+        }
+
+        basic_iterator& operator++() {
+            ++slot_index_;
+            advance();
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator output = *this;
+            ++*this;
+            return output;
+        }
+
+        /**
+         * Allows converting an iterator into a const_iterator
+         */
+        operator basic_iterator<const TopicPartitionMap,
+                                const typename TopicPartitionMap::value_type>() const {
+            return { map_, topic_index_, slot_index_ };
+        }
+
+        friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) {
+            return lhs.topic_index_ == rhs.topic_index_ && lhs.slot_index_ == rhs.slot_index_;
+        }
+
+        friend bool operator!=(const basic_iterator& lhs, const basic_iterator& rhs) {
+            return !(lhs == rhs);
+        }
+    private:
+        // Lets the iterator to const_iterator conversion reach the target's
+        // private constructor
+        template <typename M, typename V>
+        friend class basic_iterator;
+
+        basic_iterator(MapType* map, size_t topic_index, size_t slot_index)
+        : map_(map), topic_index_(topic_index), slot_index_(slot_index) {
+            advance();
+        }
+
+        // Moves forward to the next occupied slot, crossing topics as needed
+        void advance() {
+            while (topic_index_ < map_->topics_.size()) {
+                const auto& slots = map_->topics_[topic_index_].slots;
+                while (slot_index_ < slots.size() && !slots[slot_index_]) {
+                    ++slot_index_;
+                }
+                if (slot_index_ < slots.size()) {
+                    return;
+                }
+                ++topic_index_;
+                slot_index_ = 0;
+            }
+            // Canonical end position so comparisons don't depend on the path taken
+            slot_index_ = 0;
+        }
+
+        MapType* map_{nullptr};
+        size_t topic_index_{0};
+        size_t slot_index_{0};
+    };
+public:
+    using iterator = basic_iterator<TopicPartitionMap, value_type>;
+    using const_iterator = basic_iterator<const TopicPartitionMap, const value_type>;
+
+    /**
+     * \brief Inserts a value for the given topic/partition
+     *
+     * \param key The topic/partition to insert the value under. Must have a
+     *            concrete partition (>= 0)
+     * \param value The value to be inserted
+     *
+     * \return An iterator to the (new or preexisting) entry and whether the
+     *         insertion took place
+     */
+    std::pair<iterator, bool> emplace(const TopicPartition& key, T value) {
+        const size_t topic_index = intern(key.get_topic());
+        const size_t slot_index = to_slot_index(key.get_partition());
+        std::vector<SlotPtr>& slots = topics_[topic_index].slots;
+        if (slots.size() <= slot_index) {
+            slots.resize(slot_index + 1);
+        }
+        if (slots[slot_index]) {
+            return { iterator(this, topic_index, slot_index), false };
+        }
+        slots[slot_index].reset(new value_type(key, std::move(value)));
+        ++size_;
+        return { iterator(this, topic_index, slot_index), true };
+    }
+
+    /**
+     * \brief Gets the value for the given topic/partition, inserting a
+     *        default constructed one if absent
+     */
+    T& operator[](const TopicPartition& key) {
+        return emplace(key, T()).first->second;
+    }
+
+    /**
+     * \brief Looks up the entry for the given topic/partition
+     *
+     * One topic name hash plus an array index.
+     *
+     * \return An iterator to the entry, or end() if not present
+     */
+    iterator find(const TopicPartition& key) {
+        const std::pair<size_t, size_t> position = find_position(key);
+        return iterator(this, position.first, position.second);
+    }
+
+    /**
+     * \sa TopicPartitionMap::find
+     */
+    const_iterator find(const TopicPartition& key) const {
+        const std::pair<size_t, size_t> position = find_position(key);
+        return const_iterator(this, position.first, position.second);
+    }
+
+    /**
+     * \brief Gets the interned id of the given topic
+     *
+     * Resolving the id once outside a hot loop removes the remaining hash
+     * from the per-message lookups; ids stay valid for the lifetime of the
+     * map (clear() included).
+     *
+     * \return The topic's id, or npos if no entry for it was ever inserted
+     */
+    size_t get_topic_id(const std::string& topic) const {
+        const auto iter = topic_ids_.find(topic);
+        return iter != topic_ids_.end() ? iter->second : npos;
+    }
+
+    /**
+     * \brief Looks up a value by interned topic id and partition
+     *
+     * The fast path: two bounds checks and an array index, no hashing and no
+     * string comparison.
+     *
+     * \param topic_id The topic's id as returned by get_topic_id
+     * \param partition The partition to look up
+     *
+     * \return A pointer to the value, or nullptr if not present
+     */
+    T* get(size_t topic_id, int partition) {
+        const std::pair<size_t, size_t> position = get_position(topic_id, partition);
+        return position.first != npos ? &topics_[position.first].slots[position.second]->second
+                                      : nullptr;
+    }
+
+    /**
+     * \sa TopicPartitionMap::get
+     */
+    const T* get(size_t topic_id, int partition) const {
+        const std::pair<size_t, size_t> position = get_position(topic_id, partition);
+        return position.first != npos ? &topics_[position.first].slots[position.second]->second
+                                      : nullptr;
+    }
+
+    /**
+     * \brief Removes the entry for the given topic/partition
+     *
+     * The topic name stays interned; only the slot is released.
+     *
+     * \return The amount of removed entries (0 or 1)
+     */
+    size_t erase(const TopicPartition& key) {
+        const std::pair<size_t, size_t> position = find_position(key);
+        if (position.first == npos) {
+            return 0;
+        }
+        topics_[position.first].slots[position.second].reset();
+        --size_;
+        return 1;
+    }
+
+    /**
+     * \brief Removes all entries
+     *
+     * Topic ids stay interned and valid.
+     */
+    void clear() {
+        for (TopicSlots& topic_slots : topics_) {
+            topic_slots.slots.clear();
+        }
+        size_ = 0;
+    }
+
+    /**
+     * Gets the amount of entries
+     */
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * Indicates whether this map is empty
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    iterator begin() {
+        return iterator(this, 0, 0);
+    }
+
+    iterator end() {
+        return iterator(this, topics_.size(), 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, topics_.size(), 0);
+    }
+private:
+    static size_t to_slot_index(int partition) {
+        if (partition < 0) {
+            throw Exception("TopicPartitionMap requires a concrete partition");
+        }
+        return static_cast<size_t>(partition);
+    }
+
+    size_t intern(const std::string& topic) {
+        const auto result = topic_ids_.emplace(topic, topics_.size());
+        if (result.second) {
+            topics_.push_back(TopicSlots{ topic, {} });
+        }
+        return result.first->second;
+    }
+
+    std::pair<size_t, size_t> get_position(size_t topic_id, int partition) const {
+        if (topic_id < topics_.size() && partition >= 0) {
+            const std::vector<SlotPtr>& slots = topics_[topic_id].slots;
+            const size_t slot_index = static_cast<size_t>(partition);
+            if (slot_index < slots.size() && slots[slot_index]) {
+                return { topic_id, slot_index };
+            }
+        }
+        return { npos, 0 };
+    }
+
+    // Returns { topics_.size(), 0 } (the end position) when not found, so the
+    // result can feed an iterator directly
+    std::pair<size_t, size_t> find_position(const TopicPartition& key) const {
+        const std::pair<size_t, size_t> position =
+            get_position(get_topic_id(key.get_topic()), key.get_partition());
+        return position.first != npos ? position
+                                      : std::pair<size_t, size_t>{ topics_.size(), 0 };
+    }
+
+    std::vector<TopicSlots> topics_;
+    std::unordered_map<std::string, size_t> topic_ids_;
+    size_t size_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_TOPIC_PARTITION_MAP_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_ADAPTIVE_BATCH_CONTROLLER_H
+#define CPPKAFKA_ADAPTIVE_BATCH_CONTROLLER_H
+
+#include <chrono>
+#include <cstddef>
+#include "../macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief AIMD feedback controller for batch sizes and flush thresholds
+ *
+ * Fixed batch sizes handed to Consumer::poll_batch (and fixed buffer limits on
+ * BufferedProducer) are tuned by hand and go stale as traffic shifts. This class
+ * closes the loop instead: after each batch the caller reports how full it came
+ * back and how long it took, and the controller adjusts its recommended size
+ * using additive-increase/multiplicative-decrease:
+ *
+ * - Batches consistently filling up to the target ratio grow additively, probing
+ *   for more throughput.
+ * - Batches coming back mostly empty shrink multiplicatively, so the size tracks
+ *   a traffic drop within a few batches instead of waiting on a full one.
+ * - Batches exceeding the optional latency budget also shrink multiplicatively,
+ *   bounding the time messages sit in a batch regardless of fill.
+ *
+ * Observations are smoothed with an exponential moving average and adjustments
+ * are applied every ADJUSTMENT_INTERVAL batches, so a single outlier poll does
+ * not swing the size around.
+ *
+ * Consumer wiring:
+ *
+ * \code
+ * AdaptiveBatchController controller(64, 4096);
+ * std::vector<Message> messages;
+ * while (running) {
+ *     const size_t batch_size = controller.get_batch_size();
+ *     const auto start = std::chrono::steady_clock::now();
+ *     messages.clear();
+ *     const size_t count = consumer.poll_batch(std::back_inserter(messages), batch_size);
+ *     controller.record_batch(batch_size, count,
+ *                             std::chrono::duration_cast<std::chrono::microseconds>(
+ *                                 std::chrono::steady_clock::now() - start));
+ *     // process messages...
+ * }
+ * \endcode
+ *
+ * Producer wiring, treating the recommendation as the flush threshold:
+ *
+ * \code
+ * const auto start = std::chrono::steady_clock::now();
+ * const size_t buffered = producer.get_buffer_size();
+ * producer.flush();
+ * controller.record_batch(producer.get_max_buffer_size(), buffered,
+ *                         std::chrono::duration_cast<std::chrono::microseconds>(
+ *                             std::chrono::steady_clock::now() - start));
+ * producer.set_max_buffer_size(controller.get_batch_size());
+ * \endcode
+ *
+ * \remark This class is not thread safe; it is meant to live next to the single
+ * threaded poll or flush loop it controls.
+ */
+class CPPKAFKA_API AdaptiveBatchController {
+public:
+    /**
+     * Default smallest batch size the controller will recommend
+     */
+    static constexpr size_t DEFAULT_MINIMUM_BATCH_SIZE = 32;
+
+    /**
+     * Default largest batch size the controller will recommend
+     */
+    static constexpr size_t DEFAULT_MAXIMUM_BATCH_SIZE = 4096;
+
+    /**
+     * Amount of recorded batches between adjustments
+     */
+    static constexpr size_t ADJUSTMENT_INTERVAL = 8;
+
+    /**
+     * Constructs a controller using the default size bounds
+     */
+    AdaptiveBatchController();
+
+    /**
+     * \brief Constructs a controller recommending sizes within the given bounds
+     *
+     * The initial recommendation is the minimum size; traffic has to earn
+     * larger batches.
+     *
+     * \param minimum_batch_size The smallest size ever recommended (at least 1)
+     * \param maximum_batch_size The largest size ever recommended
+     */
+    AdaptiveBatchController(size_t minimum_batch_size, size_t maximum_batch_size);
+
+    /**
+     * \brief Sets the fill ratio the controller steers towards
+     *
+     * Batches filling at least this much of the requested size are considered
+     * saturated and trigger additive growth; batches below half of it trigger
+     * multiplicative shrinking. Defaults to 0.8.
+     *
+     * \param ratio The target fill ratio, in the (0, 1] range
+     */
+    void set_target_fill_ratio(double ratio);
+
+    /**
+     * \brief Sets the per-batch latency budget
+     *
+     * Once the smoothed batch latency exceeds the budget the recommended size
+     * is halved, regardless of how full batches come back. A zero budget (the
+     * default) disables the latency term.
+     *
+     * \param budget The maximum acceptable smoothed batch latency
+     */
+    void set_latency_budget(std::chrono::microseconds budget);
+
+    /**
+     * \brief Records the outcome of one batch
+     *
+     * \param requested The size that was asked for
+     * \param received The amount of messages actually obtained
+     * \param latency How long the batch took to fill (or be cut off by a timeout)
+     */
+    void record_batch(size_t requested, size_t received, std::chrono::microseconds latency);
+
+    /**
+     * \brief Records the outcome of one batch without latency information
+     *
+     * Only the fill feedback term is applied for such batches.
+     */
+    void record_batch(size_t requested, size_t received);
+
+    /**
+     * Gets the currently recommended batch size
+     */
+    size_t get_batch_size() const;
+
+    /**
+     * Gets the smoothed observed fill ratio, or 0 if nothing was recorded yet
+     */
+    double get_average_fill_ratio() const;
+
+    /**
+     * Gets the smoothed observed batch latency
+     */
+    std::chrono::microseconds get_average_latency() const;
+
+    /**
+     * \brief Resets the controller to its initial state
+     *
+     * The recommendation drops back to the minimum size and the smoothed
+     * observations are cleared.
+     */
+    void reset();
+private:
+    // Weight of the newest observation in the moving averages
+    static constexpr double SMOOTHING = 0.25;
+
+    void adjust();
+
+    size_t minimum_batch_size_;
+    size_t maximum_batch_size_;
+    size_t batch_size_;
+    size_t increase_step_;
+    size_t observed_batches_{0};
+    double target_fill_ratio_{0.8};
+    double average_fill_ratio_{-1};
+    double average_latency_us_{-1};
+    std::chrono::microseconds latency_budget_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_ADAPTIVE_BATCH_CONTROLLER_H
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_AWAITABLE_CONSUMER_H
+#define CPPKAFKA_AWAITABLE_CONSUMER_H
+
+// This utility requires C++20 coroutine support; on older toolchains the
+// header is a no-op so it can stay in the umbrella include
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define CPPKAFKA_COROUTINES_ENABLED 1
+#else
+#define CPPKAFKA_COROUTINES_ENABLED 0
+#endif
+
+#if CPPKAFKA_COROUTINES_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "../message.h"
+#include "../queue.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Coroutine based consume API on top of queue event callbacks
+ *
+ * Every blocking consume entry point (Consumer::poll, Queue::consume) ties up
+ * a thread per consumer. This adapter registers a non-empty callback on the
+ * consumer's queue (rd_kafka_queue_cb_event_enable via
+ * Queue::enable_event_callback) and exposes awaitables instead: a coroutine
+ * that co_awaits async_poll suspends without blocking any thread, and is
+ * resumed through a caller supplied executor only once messages are actually
+ * ready — so many consumers can share one event loop and no thread wakeup sits
+ * on the hot path.
+ *
+ * Example:
+ *
+ * \code
+ * AwaitableConsumer awaitable(consumer, [&](std::function<void()> resume) {
+ *     // schedule resume() on your event loop / thread pool
+ *     loop.post(std::move(resume));
+ * });
+ *
+ * // From a coroutine (any task type works):
+ * while (running) {
+ *     Message msg = co_await awaitable.async_poll();
+ *     if (msg) {
+ *         // process
+ *     }
+ * }
+ * \endcode
+ *
+ * Awaits may complete with an empty message (or empty batch) spuriously, e.g.
+ * when the queue event was consumed by a rebalance notification; callers
+ * should treat that exactly like a timed out poll.
+ *
+ * \warning At most one coroutine may be awaiting on an AwaitableConsumer at
+ * any time, and the object must outlive any coroutine suspended on it.
+ *
+ * \warning The executor is invoked from rdkafka's internal threads; it must
+ * hand the resume off to another thread and never run it inline.
+ */
+class CPPKAFKA_API AwaitableConsumer {
+public:
+    /**
+     * Schedules a resume on the application's event loop
+     */
+    using Executor = std::function<void(std::function<void()>)>;
+
+    /**
+     * \brief Awaitable returned by async_poll
+     */
+    class PollAwaitable {
+    public:
+        PollAwaitable(AwaitableConsumer& parent)
+        : parent_(&parent) {
+
+        }
+
+        bool await_ready() {
+            message_ = parent_->consumer_.poll(std::chrono::milliseconds(0));
+            return static_cast<bool>(message_);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return parent_->suspend(handle);
+        }
+
+        Message await_resume() {
+            if (!message_) {
+                message_ = parent_->consumer_.poll(std::chrono::milliseconds(0));
+            }
+            return std::move(message_);
+        }
+    private:
+        AwaitableConsumer* parent_;
+        Message message_;
+    };
+
+    /**
+     * \brief Awaitable returned by async_poll_batch
+     */
+    class PollBatchAwaitable {
+    public:
+        PollBatchAwaitable(AwaitableConsumer& parent, size_t max_batch_size)
+        : parent_(&parent), max_batch_size_(max_batch_size) {
+
+        }
+
+        bool await_ready() {
+            messages_ = parent_->consumer_.poll_batch(max_batch_size_,
+                                                      std::chrono::milliseconds(0));
+            return !messages_.empty();
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return parent_->suspend(handle);
+        }
+
+        std::vector<Message> await_resume() {
+            if (messages_.empty()) {
+                messages_ = parent_->consumer_.poll_batch(max_batch_size_,
+                                                          std::chrono::milliseconds(0));
+            }
+            return std::move(messages_);
+        }
+    private:
+        AwaitableConsumer* parent_;
+        std::vector<Message> messages_;
+        size_t max_batch_size_;
+    };
+
+    /**
+     * \brief Constructor
+     *
+     * \param consumer A reference to the wrapped consumer instance
+     * \param executor The executor used to schedule coroutine resumes
+     */
+    AwaitableConsumer(Consumer& consumer, Executor executor)
+    : consumer_(consumer), queue_(consumer.get_consumer_queue()),
+      executor_(std::move(executor)) {
+        queue_.enable_event_callback(&AwaitableConsumer::on_queue_event, this);
+    }
+
+    /**
+     * \brief Destructor. Unregisters the queue callback.
+     */
+    ~AwaitableConsumer() {
+        queue_.disable_event_callback();
+    }
+
+    AwaitableConsumer(const AwaitableConsumer&) = delete;
+    AwaitableConsumer& operator=(const AwaitableConsumer&) = delete;
+
+    /**
+     * \brief Awaits the next message
+     *
+     * \return An awaitable yielding a Message (possibly empty, see above)
+     */
+    PollAwaitable async_poll() {
+        return PollAwaitable(*this);
+    }
+
+    /**
+     * \brief Awaits the next batch of messages
+     *
+     * \param max_batch_size The maximum amount of messages to be yielded
+     *
+     * \return An awaitable yielding up to max_batch_size messages
+     */
+    PollBatchAwaitable async_poll_batch(size_t max_batch_size) {
+        return PollBatchAwaitable(*this, max_batch_size);
+    }
+
+    /**
+     * Gets the underlying consumer
+     */
+    Consumer& get_consumer() {
+        return consumer_;
+    }
+private:
+    bool suspend(std::coroutine_handle<> handle) {
+        awaiting_.store(handle.address(), std::memory_order_release);
+        // A message may have raced in between the failed poll in await_ready
+        // and the handle being published; reclaim the handle and resume
+        // inline rather than waiting for a callback that already fired
+        if (queue_.get_length() > 0) {
+            // If the exchange comes back null the callback thread won the
+            // claim and a resume is already scheduled, so stay suspended
+            return awaiting_.exchange(nullptr, std::memory_order_acq_rel) == nullptr;
+        }
+        return true;
+    }
+
+    void notify() {
+        void* handle = awaiting_.exchange(nullptr, std::memory_order_acq_rel);
+        if (handle) {
+            executor_([handle]() {
+                std::coroutine_handle<>::from_address(handle).resume();
+            });
+        }
+    }
+
+    static void on_queue_event(rd_kafka_t*, void* opaque) {
+        static_cast<AwaitableConsumer*>(opaque)->notify();
+    }
+
+    Consumer& consumer_;
+    Queue queue_;
+    Executor executor_;
+    std::atomic<void*> awaiting_{nullptr};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_COROUTINES_ENABLED
+
+#endif // CPPKAFKA_AWAITABLE_CONSUMER_H
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_BACKGROUND_EVENT_PUMP_H
+#define CPPKAFKA_BACKGROUND_EVENT_PUMP_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <librdkafka/rdkafka.h>
+#include "../event.h"
+#include "../kafka_handle_base.h"
+#include "../macros.h"
+#include "../queue.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Drains a handle's event queue on a background thread, in batches
+ *
+ * Applications that use the event API typically run their own thread around
+ * rd_kafka_queue_poll with a fixed timeout, which either burns CPU waking up
+ * constantly or adds that timeout's worth of latency to every event. This
+ * utility replaces those hand rolled loops: a single pump thread blocks on the
+ * queue, drains everything that's pending in one batch once the first event
+ * arrives, and dispatches each Event to the handler registered for its type.
+ *
+ * The poll timeout adapts to the traffic: it starts at the minimum interval
+ * and doubles after each empty poll up to the maximum, snapping back to the
+ * minimum as soon as an event shows up. Since rd_kafka_queue_poll wakes up the
+ * moment an event is enqueued, the timeout only bounds how often an idle pump
+ * wakes up (and how long stop() may take), not event latency.
+ *
+ * Example:
+ *
+ * \code
+ * Producer producer(config);
+ *
+ * BackgroundEventPump pump(producer);
+ * pump.set_handler(RD_KAFKA_EVENT_STATS, [](Event event) {
+ *     // parse event.get_stats()
+ * });
+ * pump.start();
+ * // produce...
+ * pump.stop();
+ * \endcode
+ *
+ * \warning Handlers run on the pump thread; they should not block for
+ * prolonged periods of time or events will back up on the queue.
+ */
+class CPPKAFKA_API BackgroundEventPump {
+public:
+    /**
+     * Callback invoked for each drained event
+     */
+    using EventHandler = std::function<void(Event)>;
+
+    /**
+     * \brief Constructs a pump over the handle's main event queue
+     *
+     * \param handle The handle whose main queue will be drained
+     */
+    explicit BackgroundEventPump(KafkaHandleBase& handle);
+
+    /**
+     * \brief Constructs a pump over an arbitrary queue
+     *
+     * \param queue The queue to be drained
+     */
+    explicit BackgroundEventPump(Queue queue);
+
+    /**
+     * \brief Destructor. Stops the pump thread if still running.
+     */
+    ~BackgroundEventPump();
+
+    BackgroundEventPump(const BackgroundEventPump&) = delete;
+    BackgroundEventPump& operator=(const BackgroundEventPump&) = delete;
+
+    /**
+     * \brief Registers the handler for a specific event type
+     *
+     * Replaces any handler previously registered for that type. May be called
+     * while the pump is running.
+     *
+     * \param type The event type (e.g. RD_KAFKA_EVENT_LOG)
+     * \param handler The handler to be invoked for events of that type
+     */
+    void set_handler(rd_kafka_event_type_t type, EventHandler handler);
+
+    /**
+     * \brief Registers the handler for event types without a specific handler
+     *
+     * Events whose type has no handler and for which no default handler is set
+     * are destroyed silently.
+     *
+     * \param handler The fallback handler
+     */
+    void set_default_handler(EventHandler handler);
+
+    /**
+     * \brief Sets the bounds for the adaptive poll timeout
+     *
+     * Defaults to [1ms, 100ms]. The maximum also bounds how long stop() may
+     * block waiting for the pump thread to notice the shutdown.
+     *
+     * \param minimum The timeout used while events are flowing
+     * \param maximum The timeout an idle pump backs off to
+     */
+    void set_poll_interval(std::chrono::milliseconds minimum,
+                           std::chrono::milliseconds maximum);
+
+    /**
+     * \brief Starts the pump thread
+     */
+    void start();
+
+    /**
+     * \brief Stops the pump thread and waits for it to finish
+     */
+    void stop();
+private:
+    // Batches are capped so a flooded queue can't starve the shutdown check
+    static const size_t MAX_BATCH_SIZE = 64;
+
+    void pump_loop();
+    void dispatch(Event event);
+
+    Queue queue_;
+    std::map<rd_kafka_event_type_t, EventHandler> handlers_;
+    EventHandler default_handler_;
+    std::mutex handlers_mutex_;
+    std::thread pump_thread_;
+    std::chrono::milliseconds min_poll_interval_{1};
+    std::chrono::milliseconds max_poll_interval_{100};
+    std::atomic<bool> running_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_BACKGROUND_EVENT_PUMP_H
@@ -32,8 +32,10 @@
 
 #include <chrono>
 #include <functional>
+#include <map>
 #include <thread>
 #include <string>
+#include "../cached_topic_partition_list.h"
 #include "../consumer.h"
 #include "backoff_performer.h"
 #include "../detail/callback_invoker.h"
@@ -71,6 +73,25 @@ namespace cppkafka {
  * // Now commit. If there's an error, this will retry forever
  * committer.commit(some_message);
  * \endcode
+ *
+ * When committing once per message, every call is a synchronous broker round trip
+ * and the commit rate caps the consumption rate. Coalescing avoids this: once
+ * enabled via set_commit_coalescing, commit(msg) only records the offset into a
+ * per-partition high watermark table and an actual broker commit (with the usual
+ * backoff/retry handling) fires whenever enough messages were recorded or enough
+ * time elapsed:
+ *
+ * \code
+ * // Commit at most every 1000 messages or every 100 milliseconds
+ * committer.set_commit_coalescing(1000, std::chrono::milliseconds(100));
+ * while (running) {
+ *     Message msg = consumer.poll();
+ *     // ... process ...
+ *     committer.commit(msg);
+ * }
+ * // Commit whatever is left before shutting down
+ * committer.flush_commit();
+ * \endcode
  */
 class CPPKAFKA_API BackoffCommitter : public BackoffPerformer {
 public:
@@ -92,6 +113,11 @@ public:
      */
     BackoffCommitter(Consumer& consumer);
 
+    /**
+     * \brief Destructor. Flushes any coalesced offsets, swallowing errors.
+     */
+    ~BackoffCommitter();
+
     /**
      * \brief Sets the error callback
      *
@@ -114,6 +140,9 @@ public:
      * This will call Consumer::commit(msg) until either the message is successfully
      * committed or the error callback returns false (if any is set).
      *
+     * If coalescing is enabled, the message's offset is only recorded and the
+     * broker commit is deferred until one of the coalescing thresholds is hit.
+     *
      * \param msg The message to be committed
      */
     void commit(const Message& msg);
@@ -124,10 +153,53 @@ public:
      * This will call Consumer::commit(topic_partitions) until either the offsets are successfully
      * committed or the error callback returns false (if any is set).
      *
+     * If coalescing is enabled, the offsets are merged into the pending high
+     * watermark table instead and committed when a threshold is hit.
+     *
      * \param topic_partitions The topic/partition list to be committed
      */
     void commit(const TopicPartitionList& topic_partitions);
-    
+
+    /**
+     * \brief Enables offset-commit coalescing
+     *
+     * Subsequent calls to commit(msg) or commit(topic_partitions) record the
+     * highest offset seen per partition and an aggregated commit is performed
+     * every max_messages recorded messages or whenever more than max_interval has
+     * passed since the last commit, whichever happens first. A threshold of 0
+     * disables that trigger.
+     *
+     * \remark The time threshold is only checked from within commit calls; no
+     * background timer is involved. Call flush_commit before shutting down to
+     * avoid re-processing messages recorded but not yet committed.
+     *
+     * \param max_messages Amount of recorded messages triggering a commit
+     * \param max_interval Time since the last commit triggering a new one
+     */
+    void set_commit_coalescing(size_t max_messages, std::chrono::milliseconds max_interval);
+
+    /**
+     * \brief Disables offset-commit coalescing
+     *
+     * Any pending offsets are committed before disabling.
+     */
+    void disable_commit_coalescing();
+
+    /**
+     * \brief Commits all coalesced offsets now
+     *
+     * This performs a single Consumer::commit over the pending high watermark
+     * table, applying the usual backoff/retry handling. Does nothing if there are
+     * no pending offsets.
+     */
+    void flush_commit();
+
+    /**
+     * Gets the amount of messages recorded since the last aggregated commit
+     */
+    size_t get_pending_commit_count() const;
+
+
     /**
      * \brief Get the internal Consumer object
      *
@@ -161,8 +233,23 @@ private:
         return false; //continue
     }
 
+    void record_offset(const TopicPartition& topic_partition, int64_t next_offset);
+    void maybe_flush();
+    bool flush_offsets_matches() const;
+
     Consumer& consumer_;
     ErrorCallback callback_;
+    // Highest "next offset" recorded per partition while coalescing
+    std::map<TopicPartition, int64_t> pending_offsets_;
+    // Scratch list and cached native handle reused across coalesced flushes;
+    // while the partition layout is stable, flushing is allocation-free
+    TopicPartitionList flush_offsets_;
+    CachedTopicPartitionList cached_offsets_;
+    std::chrono::steady_clock::time_point last_commit_time_;
+    std::chrono::milliseconds maximum_pending_interval_{0};
+    size_t maximum_pending_messages_{0};
+    size_t pending_message_count_{0};
+    bool coalescing_enabled_{false};
 };
 
 } // cppkafka
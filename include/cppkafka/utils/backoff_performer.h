@@ -138,7 +138,7 @@ public:
         // No more retries left or we have a terminal error.
         throw ActionTerminatedException("Commit failed: no more retries.");
     }
-private:
+protected:
     TimeUnit increase_backoff(TimeUnit backoff);
 
     TimeUnit initial_backoff_;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_BACKOFF_SCHEDULER_H
+#define CPPKAFKA_BACKOFF_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+#include "backoff_performer.h"
+
+namespace cppkafka {
+
+/**
+ * \class BackoffScheduler
+ *
+ * \brief Asynchronous, deadline based counterpart to BackoffPerformer::perform
+ *
+ * BackoffPerformer::perform sleeps the calling thread between retries, so when many
+ * operations fail at once (e.g. commits during broker flapping) every worker thread
+ * ends up parked in a backoff sleep. BackoffScheduler instead keeps failed
+ * operations in a deadline ordered heap serviced by one shared timer thread:
+ * schedule() enqueues the operation and returns immediately, and every attempt runs
+ * on the timer thread at its deadline. Deadlines carry a configurable random jitter
+ * so retries of operations that failed together don't keep hammering the broker in
+ * lockstep.
+ *
+ * The backoff policy (initial/step/maximum backoff, linear or exponential, maximum
+ * retries) is inherited from BackoffPerformer and configured the same way.
+ *
+ * Example:
+ *
+ * \code
+ * BackoffScheduler scheduler;
+ * scheduler.set_maximum_retries(10);
+ *
+ * scheduler.schedule([&]() {
+ *     return try_commit(); // returns true on success
+ * });
+ * // the calling thread is free at this point
+ * \endcode
+ *
+ * \warning Operations run on the shared timer thread; a slow operation delays every
+ * other scheduled retry. Keep them short (e.g. an async commit) or hand the heavy
+ * part off to another thread.
+ */
+class CPPKAFKA_API BackoffScheduler : public BackoffPerformer {
+public:
+    /**
+     * The scheduled operation; returning true means it succeeded and won't be retried
+     */
+    using OperationCallback = std::function<bool()>;
+
+    /**
+     * Callback invoked (on the timer thread) when an operation runs out of retries
+     */
+    using ExhaustedCallback = std::function<void()>;
+
+    /**
+     * Default ratio the retry delay is jittered by (+/- 20%)
+     */
+    static constexpr double DEFAULT_JITTER_RATIO = 0.2;
+
+    /**
+     * \brief Constructor. Starts the timer thread.
+     */
+    BackoffScheduler();
+
+    /**
+     * \brief Destructor. Stops the timer thread; pending operations are dropped.
+     */
+    ~BackoffScheduler();
+
+    BackoffScheduler(const BackoffScheduler&) = delete;
+    BackoffScheduler& operator=(const BackoffScheduler&) = delete;
+
+    /**
+     * \brief Sets the ratio the retry delays are jittered by
+     *
+     * Every delay is multiplied by a number uniformly drawn from
+     * [1 - ratio, 1 + ratio]. Use 0 to disable jitter.
+     *
+     * \param ratio The jitter ratio, in the range [0, 1]
+     */
+    void set_jitter_ratio(double ratio);
+
+    /**
+     * \brief Schedules an operation for execution on the timer thread
+     *
+     * The first attempt runs as soon as the timer thread gets to it. On failure the
+     * operation is re-scheduled with the configured backoff until it either succeeds
+     * or runs out of retries, in which case it is silently dropped.
+     *
+     * \param operation The operation to be executed
+     */
+    void schedule(OperationCallback operation);
+
+    /**
+     * \brief Schedules an operation, with a callback for when retries are exhausted
+     *
+     * \param operation The operation to be executed
+     * \param on_exhausted Invoked on the timer thread if the operation never succeeds
+     */
+    void schedule(OperationCallback operation, ExhaustedCallback on_exhausted);
+
+    /**
+     * Gets the amount of operations currently waiting for execution or retry
+     */
+    size_t get_pending_count() const;
+
+    /**
+     * \brief Stops the timer thread and waits for it to finish
+     *
+     * Pending operations are dropped. Called automatically on destruction.
+     */
+    void stop();
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Operation {
+        OperationCallback callback;
+        ExhaustedCallback on_exhausted;
+        TimeUnit backoff;
+        size_t retries_left;
+        Clock::time_point deadline;
+    };
+
+    struct DeadlineGreater {
+        bool operator()(const Operation& lhs, const Operation& rhs) const {
+            return lhs.deadline > rhs.deadline;
+        }
+    };
+
+    void timer_loop();
+    TimeUnit apply_jitter(TimeUnit value);
+
+    std::priority_queue<Operation, std::vector<Operation>, DeadlineGreater> operations_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::minstd_rand jitter_generator_;
+    double jitter_ratio_{DEFAULT_JITTER_RATIO};
+    std::atomic<bool> running_{false};
+    std::thread timer_thread_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_BACKOFF_SCHEDULER_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_BATCH_TRANSFORM_H
+#define CPPKAFKA_BATCH_TRANSFORM_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../macros.h"
+#include "../message.h"
+
+namespace cppkafka {
+
+/**
+ * \class BatchTransform
+ *
+ * \brief Applies a functor over a message batch in parallel, preserving order
+ *
+ * Decompressing and decoding consumed payloads inline serializes that CPU work
+ * behind poll. BatchTransform takes the std::vector<Message> returned by
+ * Consumer::poll_batch and applies a functor to every message across a pool of
+ * worker threads, writing each result into the matching slot of a pre-sized
+ * output vector so input order is preserved without any synchronization on the
+ * results. The batch is processed synchronously: the messages (and the rdkafka
+ * handles they own) are guaranteed to stay alive for the whole parallel region,
+ * and remain available to the caller afterwards for committing.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * BatchTransform transform(8);
+ * while (running) {
+ *     std::vector<Message> messages = consumer.poll_batch(512);
+ *     std::vector<Record> records = transform.transform(messages, [](Message& message) {
+ *         return decode(decompress(message.get_payload()));
+ *     });
+ *     // records[i] corresponds to messages[i]
+ * }
+ * \endcode
+ *
+ * The workers are created once and reused across batches; each batch is split
+ * into one contiguous index range per worker, so no per-message dispatch is
+ * paid. This pairs with ConsumerPipeline but is useful standalone whenever the
+ * per-message work dominates the poll loop.
+ *
+ * \remark If the functor throws, the first exception caught is rethrown on the
+ * calling thread once the batch finishes; the output slots of failed messages
+ * keep their default-constructed value.
+ */
+class CPPKAFKA_API BatchTransform {
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param num_workers The amount of worker threads. Defaults to the number
+     *                    of hardware threads.
+     */
+    explicit BatchTransform(size_t num_workers = 0);
+    BatchTransform(const BatchTransform&) = delete;
+    BatchTransform& operator=(const BatchTransform&) = delete;
+
+    /**
+     * \brief Destructor. Joins the worker threads.
+     */
+    ~BatchTransform();
+
+    /**
+     * \brief Transforms a batch of messages, returning the results
+     *
+     * The result type must be default constructible so the output vector can
+     * be pre-sized before the workers fill it in.
+     *
+     * \param messages The messages to be transformed
+     * \param functor Callable invoked as functor(Message&) for every message
+     *
+     * \return One result per message, in input order
+     */
+    template <typename Functor>
+    auto transform(std::vector<Message>& messages, const Functor& functor)
+    -> std::vector<typename std::decay<decltype(functor(std::declval<Message&>()))>::type> {
+        std::vector<typename std::decay<decltype(functor(std::declval<Message&>()))>::type>
+            output;
+        transform(messages, functor, output);
+        return output;
+    }
+
+    /**
+     * \brief Transforms a batch of messages into the given output vector
+     *
+     * The output vector is resized to the amount of messages; result i is
+     * written into slot i. Reusing the same output vector across batches
+     * avoids re-allocating it every poll.
+     *
+     * \param messages The messages to be transformed
+     * \param functor Callable invoked as functor(Message&) for every message
+     * \param output The vector the results are written into
+     */
+    template <typename Functor, typename OutputType>
+    void transform(std::vector<Message>& messages, const Functor& functor,
+                   std::vector<OutputType>& output) {
+        output.resize(messages.size());
+        run_batch([&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                output[i] = functor(messages[i]);
+            }
+        }, messages.size());
+    }
+private:
+    using RangeJob = std::function<void(size_t, size_t)>;
+
+    void run_batch(RangeJob job, size_t item_count);
+    void worker_loop(size_t worker_index);
+
+    const size_t num_workers_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable job_available_;
+    std::condition_variable batch_done_;
+    RangeJob job_;
+    size_t item_count_{0};
+    size_t pending_workers_{0};
+    uint64_t generation_{0};
+    std::exception_ptr exception_;
+    bool running_{true};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_BATCH_TRANSFORM_H
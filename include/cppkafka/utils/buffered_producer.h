@@ -32,16 +32,27 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
 #include <algorithm>
+#include <fstream>
 #include <map>
+#include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <future>
 #include <thread>
 #include "../producer.h"
+#include "../queue.h"
 #include "../detail/callback_invoker.h"
+#include "../detail/tracepoints.h"
 #include "../message_internal.h"
+#include "latency_histogram.h"
+#include "mpsc_ring_buffer.h"
 
 namespace cppkafka {
 
@@ -81,9 +92,19 @@ namespace cppkafka {
  * shall not make any internal copies of the message and it is the application's responsibility to free
  * the messages *after* the ProduceSuccessCallback has reported a successful delivery to avoid memory
  * corruptions.
+ *
+ * \remark Queue policy: The QueuePolicy template parameter selects the container used for
+ * buffering messages. The default is a mutex protected std::deque. For high thread-count
+ * producers, MpscRingBuffer can be used instead, which makes add_message lock-free (a single
+ * CAS) at the cost of a bounded buffer (see mpsc_ring_buffer.h), or ShardedQueue, which gives
+ * each producing thread its own sub-queue so threads don't share locks nor cache lines
+ * (see sharded_queue.h). For heavily compressed topics, PartitionAffineQueue flushes
+ * messages grouped by topic/partition to maximize librdkafka's batch fill
+ * (see partition_affine_queue.h).
  */
 template <typename BufferType,
-          typename Allocator = std::allocator<ConcreteMessageBuilder<BufferType>>>
+          typename Allocator = std::allocator<ConcreteMessageBuilder<BufferType>>,
+          typename QueuePolicy = std::deque<ConcreteMessageBuilder<BufferType>, Allocator>>
 class BufferedProducer {
 public:
     enum class FlushMethod {
@@ -95,17 +116,55 @@ public:
         OncePerMessage, ///< Notify once per message.
         EachOccurence   ///< Notify on each occurence.
     };
+    enum class QueueFullWaitPolicy {
+        Poll,               ///< Poll the producer and retry immediately (default).
+        ExponentialBackoff  ///< Back off exponentially, woken up early by delivery reports.
+    };
+    /**
+     * The final outcome of a message produced via produce_async()
+     */
+    struct DeliveryResult {
+        Error error;                            ///< The delivery error. Empty on success.
+        std::string topic;                      ///< The topic the message was produced to.
+        int partition{RD_KAFKA_PARTITION_UA};   ///< The partition the message landed on.
+        int64_t offset{-1};                     ///< The offset assigned by the broker.
+    };
+    /**
+     * The outcome of a deadline-bounded shutdown()
+     */
+    struct ShutdownReport {
+        size_t delivered{0};    ///< Messages acked by the broker during shutdown.
+        size_t persisted{0};    ///< Messages persisted to the dump file.
+        size_t dropped{0};      ///< Messages dropped or with unknown fate at the deadline.
+    };
     /**
      * Concrete builder
      */
     using Builder = ConcreteMessageBuilder<BufferType>;
-    using QueueType = std::deque<Builder, Allocator>;
-    
+    using QueueType = QueuePolicy;
+
+    // Builders flow through every internal queue by move; a buffer type with a
+    // throwing move would silently downgrade queue growth to copies (and their
+    // allocations), so reject it at compile time instead of finding out in a
+    // production profile
+    static_assert(std::is_nothrow_move_constructible<BufferType>::value,
+                  "BufferType must be nothrow move constructible");
+    static_assert(std::is_nothrow_move_constructible<Builder>::value,
+                  "Builder must be nothrow move constructible");
+
     /**
      * Callback to indicate a message was delivered to the broker
      */
     using ProduceSuccessCallback = std::function<void(const Message&)>;
 
+    /**
+     * Callback to indicate a batch of messages was delivered to the broker.
+     *
+     * Invoked once per drained delivery report event by process_delivery_reports(),
+     * so the dispatch overhead is paid per chunk instead of per acknowledged message.
+     */
+    using ProduceSuccessBatchCallback = std::function<void(const std::vector<Message>&)>;
+
     /**
      * Callback to indicate a message failed to be produced by the broker.
      *
@@ -152,6 +211,16 @@ public:
      */
     using QueueFullCallback = std::function<void(const MessageBuilder&)>;
 
+    /**
+     * \brief Callback receiving messages spilled over the resident cap
+     *
+     * When a resident message cap is set (see set_max_resident_messages) and the buffer
+     * is at capacity, add_message() hands the message to this callback instead of
+     * enqueuing it, so the application can spill it somewhere bounded (e.g. a
+     * MessageSpool) instead of growing RSS during a long broker outage.
+     */
+    using OverflowCallback = std::function<void(Builder&&)>;
+
     /**
      * \brief Constructs a buffered producer using the provided configuration
      *
@@ -181,6 +250,59 @@ public:
      */
     void add_message(Builder builder);
 
+    /**
+     * \brief Adds a trivially copyable record, stored in the flat payload slab
+     *
+     * The record's bytes are copied into an internal contiguous slab with a single
+     * bump-pointer memcpy and the buffered message's payload is a view into that
+     * slab, so flushing produces straight from slab offsets: the payloads of a
+     * batch lie back to back in memory instead of scattered across per-message
+     * heap allocations. Only available when BufferType is Buffer (the one buffer
+     * type that can view external storage) and T is trivially copyable.
+     *
+     * The slab rewinds automatically once the producer is quiescent - no buffered
+     * messages, no flushes in progress, no pending acks - so steady
+     * produce/flush/wait cycles keep reusing the same memory.
+     *
+     * \param topic The topic to produce the record to
+     * \param partition The partition to produce into
+     * \param record The record whose bytes become the message payload
+     */
+    template <typename T>
+    typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                            std::is_same<BufferType, Buffer>::value>::type
+    add_flat_message(const std::string& topic, int partition, const T& record);
+
+    /**
+     * \brief Adds a keyed trivially copyable record, stored in the flat payload slab
+     *
+     * Same as the other overload; the key bytes are copied into the slab right
+     * next to the payload.
+     *
+     * \param topic The topic to produce the record to
+     * \param partition The partition to produce into
+     * \param key The message key bytes
+     * \param record The record whose bytes become the message payload
+     */
+    template <typename T>
+    typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                            std::is_same<BufferType, Buffer>::value>::type
+    add_flat_message(const std::string& topic, int partition, const Buffer& key,
+                     const T& record);
+
+    /**
+     * Gets the amount of payload bytes currently held by the flat payload slab
+     */
+    size_t get_flat_slab_size() const;
+
+    /**
+     * \brief Releases the flat payload slab's memory
+     *
+     * \warning Only call this while no flat messages are buffered or in flight;
+     * their payloads are views into the slab.
+     */
+    void reset_flat_slab();
+
     /**
      * \brief Produces a message asynchronously without buffering it
      *
@@ -229,7 +351,29 @@ public:
      * \remark This method throws cppkafka::HandleException on failure
      */
     void produce(const Message& message);
-    
+
+    /**
+     * \brief Produces a message asynchronously and returns a future for its delivery
+     *
+     * The returned future is completed exactly once with the final outcome of this
+     * message: either its successful delivery, or the error it was dropped with after
+     * all retries (if any) were exhausted. This allows tracking individual messages
+     * without correlating them through the shared ProduceSuccessCallback and
+     * user_data.
+     *
+     * \param builder The builder that contains the message to be produced
+     *
+     * \return A future holding the message's DeliveryResult
+     *
+     * \remark This method reports errors through the future instead of throwing.
+     *
+     * \remark Internally this relies on the same per-message tracking used by the
+     *         retry machinery. The first call enables that tracking for all messages,
+     *         so when mixing produce_async with the other produce methods, either
+     *         call it (or set_max_number_retries) before producing anything else.
+     */
+    std::future<DeliveryResult> produce_async(const MessageBuilder& builder);
+
     /**
      * \brief Flushes all buffered messages and returns immediately.
      *
@@ -267,6 +411,94 @@ public:
      */
     bool flush(std::chrono::milliseconds timeout, bool preserve_order = false);
 
+    /**
+     * \brief Persists all buffered (un-flushed) messages to a file
+     *
+     * The buffer is drained into a compact binary dump (a topic table followed by
+     * varint-framed records carrying partition, timestamp, key and payload), written
+     * with buffered sequential I/O. This is meant for crash-safe shutdowns: the
+     * un-flushed buffer of a producer can be persisted in milliseconds and handed to
+     * restore() on the next start instead of being lost.
+     *
+     * Retry messages are dumped first so restore() re-enqueues them ahead of newer
+     * ones, preserving the flush order they would have had.
+     *
+     * \param path The path of the dump file (overwritten if it exists)
+     *
+     * \return The number of messages dumped
+     *
+     * \warning Message headers and the user data pointer are not serialized.
+     */
+    size_t dump(const std::string& path);
+
+    /**
+     * \brief Re-enqueues the messages of a dump file into the buffer
+     *
+     * Messages are appended to the buffer in dump order without triggering an
+     * automatic flush; call flush()/async_flush() to produce them.
+     *
+     * \param path The path of a file written by dump()
+     *
+     * \return The number of messages restored
+     *
+     * \remark BufferType must own its contents (e.g. std::string) since the restored
+     *         builders outlive the file read.
+     */
+    size_t restore(const std::string& path);
+
+    /**
+     * \brief Flushes what it can before a deadline and persists the rest
+     *
+     * Graceful shutdown is usually on a clock (e.g. the time between SIGTERM
+     * and SIGKILL) while flush() can wait forever on a dead broker. shutdown()
+     * makes the procedure time bounded: it flushes the buffer and waits for
+     * acks within the deadline, fails the messages still sitting in rdkafka's
+     * send queue at the deadline so retryable ones return to the buffer, and
+     * finally dumps whatever is left buffered to the given file for restore()
+     * on the next start.
+     *
+     * Messages already in flight to a broker are left untouched: their
+     * broker-side fate is unknown, so they are counted as dropped rather than
+     * persisted (which could duplicate them).
+     *
+     * \param deadline The time budget for the whole procedure. A small slice
+     *        of it is reserved for collecting the failed messages and writing
+     *        the dump.
+     * \param dump_path The path the remaining buffer is dumped to; not
+     *        created when nothing is left to persist
+     *
+     * \return The amounts of messages delivered, persisted and dropped
+     *
+     * \remark After this call returns the buffer is empty; the producer should
+     *         be destroyed without further use.
+     */
+    ShutdownReport shutdown(std::chrono::milliseconds deadline, const std::string& dump_path);
+
+    /**
+     * \brief Serves pending delivery reports in batches
+     *
+     * This drains the producer's event queue in chunks (one delivery report event at
+     * a time, each carrying many messages) and invokes the ProduceSuccessBatchCallback
+     * once per chunk with all successfully delivered messages. Failed messages still
+     * go through the per-message retry bookkeeping, exactly as if they had been
+     * reported via Producer::poll().
+     *
+     * Call this periodically instead of relying on Producer::poll() when the
+     * per-message callback dispatch becomes a bottleneck at high ack rates.
+     *
+     * \param timeout The maximum time to wait for the first event to become available
+     *
+     * \return The number of delivery reports processed
+     *
+     * \remark The messages passed to the batch callback are only valid for the
+     *         duration of the callback.
+     *
+     * \remark Successful deliveries consumed by this call do not invoke the
+     *         per-message ProduceSuccessCallback. Reports served elsewhere (e.g. by
+     *         the flush performed while waiting for acks) take the per-message path.
+     */
+    size_t process_delivery_reports(std::chrono::milliseconds timeout);
+
     /**
      * \brief Waits for produced message's acknowledgements from the brokers
      */
@@ -325,7 +557,69 @@ public:
      * \return The max buffer size. A value of -1 indicates an unbounded buffer.
      */
     ssize_t get_max_buffer_size() const;
-    
+
+    /**
+     * \brief Sets the maximum amount of payload bytes to be enqueued in the buffer.
+     *
+     * Counterpart of set_max_buffer_size for workloads with wildly varying message
+     * sizes, where a message count caps memory poorly. After 'max_bytes' of payload
+     * is buffered, flush() (or async_flush(), depending on the flush method) is
+     * called automatically. Both limits may be set; whichever is hit first triggers
+     * the flush.
+     *
+     * \param max_bytes The max amount of buffered payload bytes. A value of -1
+     *                  disables the byte-based trigger (default value)
+     */
+    void set_max_buffer_bytes(ssize_t max_bytes);
+
+    /**
+     * \brief Return the maximum allowed amount of buffered payload bytes.
+     *
+     * \return The max buffered bytes. A value of -1 indicates no byte limit.
+     */
+    ssize_t get_max_buffer_bytes() const;
+
+    /**
+     * \brief Get the amount of payload bytes currently held in the buffer
+     *
+     * A single relaxed atomic load; safe to call from any thread at any rate.
+     * Key and header bytes are not counted.
+     *
+     * \return The buffered payload bytes
+     */
+    uint64_t get_buffered_bytes() const;
+
+    /**
+     * \brief Get the amount of payload bytes currently buffered for one topic
+     *
+     * \param topic The topic to get the buffered bytes of
+     *
+     * \return The buffered payload bytes, or 0 if no message for this topic
+     *         was ever buffered
+     */
+    uint64_t get_buffered_bytes(const std::string& topic) const;
+
+    /**
+     * \brief Get the largest amount of payload bytes ever held in the buffer
+     *
+     * The high water mark only ever rises, which makes it the number to size
+     * memory budgets against: it captures the worst backlog ever reached even
+     * if every scrape happened to run while the buffer was drained.
+     *
+     * \return The high water mark of the buffered payload bytes
+     */
+    uint64_t get_buffered_bytes_high_water_mark() const;
+
+    /**
+     * \brief Get the largest amount of payload bytes ever buffered for one topic
+     *
+     * \param topic The topic to get the high water mark of
+     *
+     * \return The topic's high water mark, or 0 if no message for this topic
+     *         was ever buffered
+     */
+    uint64_t get_buffered_bytes_high_water_mark(const std::string& topic) const;
+
     /**
      * \brief Sets the method used to flush the internal buffer when 'max_buffer_size' is reached.
      *        Default is 'Sync'
@@ -395,6 +689,34 @@ public:
      */
     size_t get_max_number_retries() const;
 
+    /**
+     * \brief Enables produce-to-ack latency tracking
+     *
+     * Sampled messages are timestamped when handed to rdkafka and the elapsed time until
+     * their delivery report is recorded into the histogram returned by get_latency_histogram(),
+     * in microseconds. With sampling_rate == 1 every message is measured; with N, one in every
+     * N produced messages is. For unsampled messages the hot path cost is a relaxed load and
+     * a branch.
+     *
+     * \remark Enabling this also enables message tracking, as the timestamp travels in the
+     *         internal message envelope alongside the user data.
+     *
+     * \param sampling_rate Measure one in every sampling_rate messages
+     */
+    void enable_latency_tracking(size_t sampling_rate = 1);
+
+    /**
+     * Disables produce-to-ack latency tracking
+     */
+    void disable_latency_tracking();
+
+    /**
+     * \brief Gets the produce-to-ack latency histogram
+     *
+     * \sa LatencyHistogram::get_snapshot
+     */
+    const LatencyHistogram& get_latency_histogram() const;
+
     /**
      * Gets the Producer object
      */
@@ -422,6 +744,45 @@ public:
      */
     QueueFullNotification get_queue_full_notification() const;
 
+    /**
+     * \brief Sets the policy used to wait when RD_KAFKA_RESP_ERR__QUEUE_FULL is received.
+     *
+     * The default QueueFullWaitPolicy::Poll retries in a tight produce/poll loop, which
+     * burns a core per producing thread when the brokers are slow for sustained periods.
+     * QueueFullWaitPolicy::ExponentialBackoff instead sleeps between attempts (starting
+     * at the initial backoff and doubling up to the maximum) and is woken up early
+     * whenever a delivery report frees space in the producer's queue.
+     */
+    void set_queue_full_wait_policy(QueueFullWaitPolicy policy);
+
+    /**
+     * Get the queue full wait policy.
+     */
+    QueueFullWaitPolicy get_queue_full_wait_policy() const;
+
+    /**
+     * \brief Sets the backoff range used by QueueFullWaitPolicy::ExponentialBackoff
+     *
+     * \param initial The delay used after the first queue full error of a message
+     * \param maximum The upper bound for the exponentially increasing delay
+     */
+    void set_queue_full_backoff(std::chrono::milliseconds initial,
+                                std::chrono::milliseconds maximum);
+
+    /**
+     * \brief Get the total time spent blocked on queue full errors
+     *
+     * \return The accumulated blocked time across all producing threads
+     */
+    std::chrono::microseconds get_total_time_blocked_on_queue_full() const;
+
+    /**
+     * \brief Get the total number of queue full errors received while producing
+     *
+     * \return The number of occurrences
+     */
+    size_t get_total_queue_full_occurrences() const;
+
     /**
      * \brief Sets the message produce failure callback
      *
@@ -457,7 +818,16 @@ public:
      * \param callback The callback to be set
      */
     void set_produce_success_callback(ProduceSuccessCallback callback);
-    
+
+    /**
+     * \brief Sets the batched successful delivery callback
+     *
+     * Only invoked from process_delivery_reports().
+     *
+     * \param callback The callback to be set
+     */
+    void set_produce_success_batch_callback(ProduceSuccessBatchCallback callback);
+
     /**
      * \brief Sets the local flush failure callback
      *
@@ -497,7 +867,35 @@ public:
      * \warning Do not call any method on the BufferedProducer while inside this callback
      */
     void set_queue_full_callback(QueueFullCallback callback);
-    
+
+    /**
+     * \brief Sets the maximum amount of messages kept resident in the buffer
+     *
+     * Once the buffer holds this many messages, further add_message() calls invoke
+     * the overflow callback instead of enqueuing. Without an overflow callback the
+     * cap has no effect. Retried messages are exempt so their delivery state is
+     * preserved.
+     *
+     * \param limit The resident cap, or -1 to disable it (default)
+     */
+    void set_max_resident_messages(ssize_t limit);
+
+    /**
+     * \brief Gets the resident message cap
+     *
+     * \return The cap, -1 meaning unbounded
+     */
+    ssize_t get_max_resident_messages() const;
+
+    /**
+     * \brief Sets the buffer overflow callback
+     *
+     * \param callback The callback receiving spilled messages
+     *
+     * \sa set_max_resident_messages
+     */
+    void set_overflow_callback(OverflowCallback callback);
+
     struct TestParameters {
         bool force_delivery_error_;
         bool force_produce_error_;
@@ -587,10 +985,53 @@ private:
                 --num_retries_;
             }
         }
+        // Returns a future tied to the final delivery outcome of this message.
+        // For produce_async() senders only.
+        std::future<DeliveryResult> get_delivery_future() {
+            wants_delivery_result_ = true;
+            return delivery_promise_.get_future();
+        }
+        // Completes the delivery future (if any) from the reported message.
+        // Called from inside on_delivery_report() once the outcome is final.
+        void complete_delivery(const Message& message) {
+            if (wants_delivery_result_) {
+                set_delivery_result(DeliveryResult{message.get_error(), message.get_topic(),
+                                                   message.get_partition(), message.get_offset()});
+            }
+        }
+        // Completes the delivery future (if any) with a local production error.
+        void complete_delivery(Error error) {
+            if (wants_delivery_result_) {
+                set_delivery_result(DeliveryResult{error, std::string(),
+                                                   RD_KAFKA_PARTITION_UA, -1});
+            }
+        }
+        // Stamps the time this message was handed to rdkafka, for latency
+        // tracking. The first stamp wins so retries don't reset the clock.
+        void mark_produced(int64_t time_us) {
+            int64_t expected = -1;
+            produce_time_us_.compare_exchange_strong(expected, time_us,
+                                                     std::memory_order_relaxed);
+        }
+        // Returns the produce timestamp, -1 if this message wasn't sampled
+        int64_t get_produce_time_us() const {
+            return produce_time_us_.load(std::memory_order_relaxed);
+        }
     private:
+        void set_delivery_result(DeliveryResult result) {
+            try {
+                delivery_promise_.set_value(std::move(result));
+            }
+            catch (const std::future_error&) {
+                //Promise has already been set once.
+            }
+        }
         SenderType sender_;
         mutable std::promise<bool> retry_promise_;
+        std::promise<DeliveryResult> delivery_promise_;
         size_t num_retries_;
+        std::atomic<int64_t> produce_time_us_{-1};
+        bool wants_delivery_result_{false};
     };
     using TrackerPtr = std::shared_ptr<Tracker>;
     
@@ -603,11 +1044,11 @@ private:
     struct AckMonitor
     {
         // Increments the number of sent acks
-        void increment_pending_acks() {
+        void increment_pending_acks(size_t count = 1) {
             while (!flag_.test_and_set()) {
                 //save the last ack number for this thread so we only
                 //wait up to this number.
-                last_ack_[std::this_thread::get_id()] = ++sent_acks_;
+                last_ack_[std::this_thread::get_id()] = (sent_acks_ += count);
                 flag_.clear();
                 break;
             }
@@ -693,28 +1134,73 @@ private:
     bool sync_produce(const MessageBuilder& builder, std::chrono::milliseconds timeout, bool throw_on_error);
     Configuration prepare_configuration(Configuration config);
     void on_delivery_report(const Message& message);
+    void handle_queue_event(const Event& event);
     template <typename BuilderType>
     void async_produce(BuilderType&& message, bool throw_on_error);
     static void swap_queues(QueueType & queue1, QueueType & queue2, std::mutex & mutex);
     bool wait_for_acks_impl(Threads threads, std::chrono::milliseconds timeout);
+    void drain_into(std::vector<Builder>& snapshot, QueueType& queue, std::mutex& mutex);
+    // Dump format helpers
+    static Buffer make_buffer_view(const Buffer& buffer) {
+        return Buffer(buffer.get_data(), buffer.get_size());
+    }
+    template <typename T>
+    static Buffer make_buffer_view(const T& container) {
+        return Buffer(container);
+    }
+    static void write_varint(std::string& buffer, uint64_t value);
+    static uint64_t read_varint(std::istream& input);
+    // Flat payload slab helpers. Both expect slab_mutex_ to be held.
+    const char* slab_copy(const void* data, size_t size);
+    void maybe_rewind_slab();
+    // One cache line per topic so hot topics don't bounce the line colder
+    // topics are read from. The map hands out stable pointers, so lookups
+    // lock but the updates themselves are relaxed atomics.
+    struct alignas(64) TopicByteCounter {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> high_water_mark{0};
+    };
+
+    // Byte accounting helpers. Every enqueue (do_add_message) accounts the
+    // builder's payload and every dequeue (flush, dump, clear) releases it,
+    // so the gauges track exactly what sits in the queues.
+    TopicByteCounter& get_topic_byte_counter(const std::string& topic);
+    static void raise_high_water_mark(std::atomic<uint64_t>& high_water_mark, uint64_t value);
+    template <typename T>
+    void account_buffered(const T& builder);
+    template <typename T>
+    void release_buffered(const T& builder);
+
+    struct SlabChunk {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+    };
 
     // Static members
     static const std::chrono::milliseconds infinite_timeout;
     static const std::chrono::milliseconds no_timeout;
+    static constexpr char DUMP_MAGIC[4] = {'C', 'P', 'K', 'D'};
+    static constexpr uint8_t DUMP_VERSION = 1;
+    static constexpr size_t SLAB_CHUNK_SIZE = 64 * 1024;
     
     // Members
     Producer producer_;
+    Queue event_queue_;
     QueueType messages_;
     QueueType retry_messages_;
     mutable std::mutex mutex_;
     mutable std::mutex retry_mutex_;
     ProduceSuccessCallback produce_success_callback_;
+    ProduceSuccessBatchCallback produce_success_batch_callback_;
     ProduceFailureCallback produce_failure_callback_;
     ProduceTerminationCallback produce_termination_callback_;
     FlushFailureCallback flush_failure_callback_;
     FlushTerminationCallback flush_termination_callback_;
     QueueFullCallback queue_full_callback_;
+    OverflowCallback overflow_callback_;
     ssize_t max_buffer_size_{-1};
+    ssize_t max_buffer_bytes_{-1};
+    ssize_t max_resident_messages_{-1};
     FlushMethod flush_method_{FlushMethod::Sync};
     AckMonitor ack_monitor_;
     std::atomic<size_t> flushes_in_progress_{0};
@@ -723,18 +1209,37 @@ private:
     int max_number_retries_{0};
     bool enable_message_retries_{false};
     QueueFullNotification queue_full_notification_{QueueFullNotification::None};
+    QueueFullWaitPolicy queue_full_wait_policy_{QueueFullWaitPolicy::Poll};
+    std::chrono::milliseconds queue_full_backoff_initial_{1};
+    std::chrono::milliseconds queue_full_backoff_maximum_{1000};
+    std::mutex queue_full_mutex_;
+    std::condition_variable queue_full_cv_;
+    std::atomic<size_t> total_time_blocked_us_{0};
+    std::atomic<size_t> total_queue_full_occurrences_{0};
+    LatencyHistogram latency_histogram_;
+    std::atomic<size_t> latency_sampling_rate_{0};
+    std::atomic<size_t> latency_sample_counter_{0};
+    std::atomic<uint64_t> total_buffered_bytes_{0};
+    std::atomic<uint64_t> buffered_bytes_high_water_mark_{0};
+    mutable std::mutex topic_bytes_mutex_;
+    std::map<std::string, std::unique_ptr<TopicByteCounter>> topic_bytes_;
+    mutable std::mutex slab_mutex_;
+    std::vector<SlabChunk> slab_chunks_;
+    size_t slab_chunk_index_{0};
+    size_t slab_chunk_used_{0};
+    size_t slab_bytes_{0};
 #ifdef KAFKA_TEST_INSTANCE
     TestParameters* test_params_;
 #endif
 };
 
 // Full blocking wait as per RdKafka
-template <typename BufferType, typename Allocator>
+template <typename BufferType, typename Allocator, typename QueuePolicy>
 const std::chrono::milliseconds
-BufferedProducer<BufferType, Allocator>::infinite_timeout = std::chrono::milliseconds(-1);
-template <typename BufferType, typename Allocator>
+BufferedProducer<BufferType, Allocator, QueuePolicy>::infinite_timeout = std::chrono::milliseconds(-1);
+template <typename BufferType, typename Allocator, typename QueuePolicy>
 const std::chrono::milliseconds
-BufferedProducer<BufferType, Allocator>::no_timeout = std::chrono::milliseconds::zero();
+BufferedProducer<BufferType, Allocator, QueuePolicy>::no_timeout = std::chrono::milliseconds::zero();
 
 template <typename BufferType>
 Producer::PayloadPolicy get_default_payload_policy() {
@@ -746,8 +1251,8 @@ Producer::PayloadPolicy get_default_payload_policy<Buffer>() {
     return Producer::PayloadPolicy::PASSTHROUGH_PAYLOAD;
 }
 
-template <typename BufferType, typename Allocator>
-BufferedProducer<BufferType, Allocator>::BufferedProducer(Configuration config,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+BufferedProducer<BufferType, Allocator, QueuePolicy>::BufferedProducer(Configuration config,
                                                           const Allocator& alloc)
 : producer_(prepare_configuration(std::move(config))),
   messages_(alloc),
@@ -758,20 +1263,116 @@ BufferedProducer<BufferType, Allocator>::BufferedProducer(Configuration config,
 #endif
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::add_message(const MessageBuilder& builder) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::add_message(const MessageBuilder& builder) {
     add_message(Builder(builder)); //make ConcreteBuilder
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::add_message(Builder builder) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::add_message(Builder builder) {
     add_tracker(SenderType::Async, builder);
     //post message unto the producer queue
-    do_add_message(move(builder), QueueKind::Produce, FlushAction::DoFlush);
+    do_add_message(std::move(builder), QueueKind::Produce, FlushAction::DoFlush);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+template <typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                        std::is_same<BufferType, Buffer>::value>::type
+BufferedProducer<BufferType, Allocator, QueuePolicy>::add_flat_message(const std::string& topic,
+                                                                       int partition,
+                                                                       const T& record) {
+    const char* payload;
+    {
+        std::lock_guard<std::mutex> lock(slab_mutex_);
+        maybe_rewind_slab();
+        payload = slab_copy(&record, sizeof(T));
+    }
+    Builder builder(topic);
+    builder.partition(partition).payload(Buffer(payload, sizeof(T)));
+    add_message(std::move(builder));
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::produce(const MessageBuilder& builder) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+template <typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                        std::is_same<BufferType, Buffer>::value>::type
+BufferedProducer<BufferType, Allocator, QueuePolicy>::add_flat_message(const std::string& topic,
+                                                                       int partition,
+                                                                       const Buffer& key,
+                                                                       const T& record) {
+    const char* key_bytes;
+    const char* payload;
+    {
+        std::lock_guard<std::mutex> lock(slab_mutex_);
+        maybe_rewind_slab();
+        key_bytes = slab_copy(key.get_data(), key.get_size());
+        payload = slab_copy(&record, sizeof(T));
+    }
+    Builder builder(topic);
+    builder.partition(partition).payload(Buffer(payload, sizeof(T)));
+    if (key_bytes) {
+        builder.key(Buffer(key_bytes, key.get_size()));
+    }
+    add_message(std::move(builder));
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_flat_slab_size() const {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    return slab_bytes_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::reset_flat_slab() {
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    slab_chunks_.clear();
+    slab_chunk_index_ = 0;
+    slab_chunk_used_ = 0;
+    slab_bytes_ = 0;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+const char* BufferedProducer<BufferType, Allocator, QueuePolicy>::slab_copy(const void* data,
+                                                                            size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    // Find a chunk with enough room, appending one once the existing ones are full.
+    // An oversized payload gets a dedicated chunk of its own size.
+    while (slab_chunk_index_ < slab_chunks_.size() &&
+           slab_chunks_[slab_chunk_index_].capacity - slab_chunk_used_ < size) {
+        ++slab_chunk_index_;
+        slab_chunk_used_ = 0;
+    }
+    if (slab_chunk_index_ == slab_chunks_.size()) {
+        const size_t capacity = (size > SLAB_CHUNK_SIZE) ? size : size_t(SLAB_CHUNK_SIZE);
+        slab_chunks_.push_back(SlabChunk{std::unique_ptr<char[]>(new char[capacity]), capacity});
+        slab_chunk_used_ = 0;
+    }
+    char* destination = slab_chunks_[slab_chunk_index_].data.get() + slab_chunk_used_;
+    std::memcpy(destination, data, size);
+    slab_chunk_used_ += size;
+    slab_bytes_ += size;
+    return destination;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::maybe_rewind_slab() {
+    if (slab_bytes_ == 0) {
+        return;
+    }
+    // Rewind only once nothing can still reference the slab: no buffered
+    // messages, no flush walking a snapshot and no message awaiting its ack
+    if (get_buffer_size() == 0 && get_flushes_in_progress() == 0 && get_pending_acks() == 0) {
+        slab_chunk_index_ = 0;
+        slab_chunk_used_ = 0;
+        slab_bytes_ = 0;
+    }
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::produce(const MessageBuilder& builder) {
     if (enable_message_retries_) {
         //Adding a retry tracker requires copying the builder since
         //we cannot modify the original instance. Cloning is a fast operation
@@ -785,19 +1386,19 @@ void BufferedProducer<BufferType, Allocator>::produce(const MessageBuilder& buil
     }
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::sync_produce(const MessageBuilder& builder) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::sync_produce(const MessageBuilder& builder) {
     sync_produce(builder, infinite_timeout, true);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::sync_produce(const MessageBuilder& builder,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::sync_produce(const MessageBuilder& builder,
                                                            std::chrono::milliseconds timeout) {
     return sync_produce(builder, infinite_timeout, true);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::sync_produce(const MessageBuilder& builder,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::sync_produce(const MessageBuilder& builder,
                                                            std::chrono::milliseconds timeout,
                                                            bool throw_on_error) {
     if (enable_message_retries_) {
@@ -827,6 +1428,8 @@ bool BufferedProducer<BufferType, Allocator>::sync_produce(const MessageBuilder&
                     }
                 }
                 ++total_messages_dropped_;
+                // The message won't be retried anymore, complete any delivery future
+                tracker->complete_delivery(ex.get_error());
                 // Call the flush termination callback
                 CallbackInvoker<FlushTerminationCallback>("flush termination", flush_termination_callback_, &producer_)
                         (builder, ex.get_error());
@@ -861,44 +1464,153 @@ bool BufferedProducer<BufferType, Allocator>::sync_produce(const MessageBuilder&
     return false;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::produce(const Message& message) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::produce(const Message& message) {
     async_produce(MessageBuilder(message), true);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::async_flush() {
-    flush(no_timeout, false);
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+std::future<typename BufferedProducer<BufferType, Allocator, QueuePolicy>::DeliveryResult>
+BufferedProducer<BufferType, Allocator, QueuePolicy>::produce_async(const MessageBuilder& builder) {
+    if (!enable_message_retries_) {
+        enable_message_retries_ = true; //enable per-message tracking once
+    }
+    //Cloning is a fast operation since the MessageBuilder class holds pointers to data only.
+    MessageBuilder builder_clone(builder.clone());
+    TrackerPtr tracker = add_tracker(SenderType::Async, builder_clone);
+    std::future<DeliveryResult> result = tracker->get_delivery_future();
+    //Errors are reported through the future, either from the local production
+    //failure path or from the delivery report.
+    async_produce(builder_clone, false);
+    return result;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::async_flush() {
+    if (enable_message_retries_) {
+        //The retry bookkeeping requires the per-message production path
+        flush(no_timeout, false);
+        return;
+    }
+    CPPKAFKA_TRACE1(flush_start, get_buffer_size());
+    CounterGuard<size_t> counter_guard(flushes_in_progress_);
+    auto batch_flusher = [this](QueueType& queue, std::mutex & mutex)->void
+    {
+        std::vector<Builder> flush_queue;
+        if constexpr (detail::is_concurrent_queue<QueueType>::value) {
+            //Only consume the messages present on entry (producers may keep pushing)
+            size_t remaining = queue.size();
+            flush_queue.reserve(remaining);
+            bool consumed = true;
+            while (remaining-- > 0 && consumed) {
+                consumed = queue.try_pop([&](Builder&& builder)->void {
+                    flush_queue.emplace_back(std::move(builder));
+                });
+            }
+        }
+        else {
+            QueueType swapped;
+            swap_queues(queue, swapped, mutex);
+            flush_queue.assign(std::make_move_iterator(swapped.begin()),
+                               std::make_move_iterator(swapped.end()));
+        }
+        if (flush_queue.empty()) {
+            return;
+        }
+        //Build non-owning builders over the concrete ones, which outlive produce_batch
+        std::vector<MessageBuilder> batch;
+        batch.reserve(flush_queue.size());
+        for (Builder& builder : flush_queue) {
+            release_buffered(builder);
+            batch.emplace_back(builder);
+        }
+        const size_t enqueued = producer_.produce_batch(batch,
+            [this](MessageBuilder& builder, Error error)->void {
+                if (error == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+                    //Same policy as produce_message: poll and retry until it fits
+                    try {
+                        produce_message(builder);
+                        return;
+                    }
+                    catch (const HandleException& ex) {
+                        error = ex.get_error();
+                    }
+                }
+                //Without message retries enabled a failed message is dropped,
+                //mirroring the async_produce error path
+                CallbackInvoker<FlushFailureCallback>("flush failure", flush_failure_callback_, &producer_)
+                    (builder, error);
+                ++total_messages_dropped_;
+                CallbackInvoker<FlushTerminationCallback>("flush termination", flush_termination_callback_, &producer_)
+                    (builder, error);
+            });
+        if (enqueued > 0) {
+            ack_monitor_.increment_pending_acks(enqueued);
+        }
+    };
+    //Produce retry queue first since these messages were produced first.
+    batch_flusher(retry_messages_, retry_mutex_);
+    //Produce recently enqueued messages
+    batch_flusher(messages_, mutex_);
+    //Flush the underlying producer without waiting for acks
+    wait_for_current_thread_acks(no_timeout);
+    CPPKAFKA_TRACE1(flush_end, get_pending_acks());
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::flush(bool preserve_order) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::flush(bool preserve_order) {
     flush(infinite_timeout, preserve_order);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::flush(std::chrono::milliseconds timeout,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::flush(std::chrono::milliseconds timeout,
                                                     bool preserve_order) {
+    CPPKAFKA_TRACE1(flush_start, get_buffer_size());
     CounterGuard<size_t> counter_guard(flushes_in_progress_);
     auto queue_flusher = [timeout, preserve_order, this]
                          (QueueType& queue, std::mutex & mutex)->void
     {
-        QueueType flush_queue; // flush from temporary queue
-        swap_queues(queue, flush_queue, mutex);
-        //Produce one message at a time and wait for acks until queue is empty
-        while (!flush_queue.empty()) {
-            if (preserve_order) {
-                //When preserving order, we must ensure that each message
-                //gets delivered before producing the next one.
-                sync_produce(flush_queue.front(), timeout, false);
+        if constexpr (detail::is_concurrent_queue<QueueType>::value) {
+            //Drain the lock-free ring in-place. Producers may keep pushing
+            //concurrently, so only consume the messages present on entry.
+            size_t remaining = queue.size();
+            bool consumed = true;
+            while (remaining-- > 0 && consumed) {
+                consumed = queue.try_pop([&](Builder&& builder)->void {
+                    release_buffered(builder);
+                    if (preserve_order) {
+                        //When preserving order, we must ensure that each message
+                        //gets delivered before producing the next one.
+                        sync_produce(builder, timeout, false);
+                    }
+                    else {
+                        //Produce as fast as possible w/o waiting. If one or more
+                        //messages fail, they will be re-enqueued for retry
+                        //on the next flush cycle, which causes re-ordering.
+                        async_produce(std::move(builder), false);
+                    }
+                });
             }
-            else {
-                //Produce as fast as possible w/o waiting. If one or more
-                //messages fail, they will be re-enqueued for retry
-                //on the next flush cycle, which causes re-ordering.
-                async_produce(flush_queue.front(), false);
+        }
+        else {
+            QueueType flush_queue; // flush from temporary queue
+            swap_queues(queue, flush_queue, mutex);
+            //Produce one message at a time and wait for acks until queue is empty
+            while (!flush_queue.empty()) {
+                release_buffered(flush_queue.front());
+                if (preserve_order) {
+                    //When preserving order, we must ensure that each message
+                    //gets delivered before producing the next one.
+                    sync_produce(flush_queue.front(), timeout, false);
+                }
+                else {
+                    //Produce as fast as possible w/o waiting. If one or more
+                    //messages fail, they will be re-enqueued for retry
+                    //on the next flush cycle, which causes re-ordering.
+                    async_produce(std::move(flush_queue.front()), false);
+                }
+                flush_queue.pop_front();
             }
-            flush_queue.pop_front();
         }
     };
     //Produce retry queue first since these messages were produced first.
@@ -909,35 +1621,313 @@ bool BufferedProducer<BufferType, Allocator>::flush(std::chrono::milliseconds ti
         //Wait for acks from the messages produced above via async_produce
         wait_for_current_thread_acks(timeout);
     }
+    CPPKAFKA_TRACE1(flush_end, get_pending_acks());
     return !ack_monitor_.has_current_thread_pending_acks();
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::wait_for_acks() {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::drain_into(std::vector<Builder>& snapshot,
+                                                                      QueueType& queue,
+                                                                      std::mutex& mutex) {
+    if constexpr (detail::is_concurrent_queue<QueueType>::value) {
+        bool consumed = true;
+        while (consumed) {
+            consumed = queue.try_pop([&](Builder&& builder)->void {
+                snapshot.emplace_back(std::move(builder));
+            });
+        }
+    }
+    else {
+        QueueType drained;
+        swap_queues(queue, drained, mutex);
+        snapshot.insert(snapshot.end(),
+                        std::make_move_iterator(drained.begin()),
+                        std::make_move_iterator(drained.end()));
+    }
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::dump(const std::string& path) {
+    static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+    // Snapshot the whole buffer, retry messages first so restore() re-enqueues
+    // them ahead of newer ones
+    std::vector<Builder> snapshot;
+    drain_into(snapshot, retry_messages_, retry_mutex_);
+    drain_into(snapshot, messages_, mutex_);
+    for (const Builder& builder : snapshot) {
+        release_buffered(builder);
+    }
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw Exception("Failed to open dump file: " + path);
+    }
+    // Topic table in first-appearance order, so records only carry an index
+    std::unordered_map<std::string, uint64_t> topic_indexes;
+    std::vector<const std::string*> topics;
+    for (const Builder& builder : snapshot) {
+        const auto result = topic_indexes.emplace(builder.topic(), topics.size());
+        if (result.second) {
+            topics.push_back(&result.first->first);
+        }
+    }
+    std::string buffer;
+    buffer.append(DUMP_MAGIC, sizeof(DUMP_MAGIC));
+    buffer.push_back(static_cast<char>(DUMP_VERSION));
+    write_varint(buffer, topics.size());
+    for (const std::string* topic : topics) {
+        write_varint(buffer, topic->size());
+        buffer.append(*topic);
+    }
+    write_varint(buffer, snapshot.size());
+    for (const Builder& builder : snapshot) {
+        const Buffer key = make_buffer_view(builder.key());
+        const Buffer payload = make_buffer_view(builder.payload());
+        write_varint(buffer, topic_indexes[builder.topic()]);
+        // Zigzag encoded so RD_KAFKA_PARTITION_UA (-1) stays a single byte
+        const int64_t partition = builder.partition();
+        write_varint(buffer, (static_cast<uint64_t>(partition) << 1) ^
+                             static_cast<uint64_t>(partition >> 63));
+        write_varint(buffer, static_cast<uint64_t>(builder.timestamp().count()));
+        write_varint(buffer, key.get_size());
+        buffer.append(reinterpret_cast<const char*>(key.get_data()), key.get_size());
+        write_varint(buffer, payload.get_size());
+        buffer.append(reinterpret_cast<const char*>(payload.get_data()), payload.get_size());
+        if (buffer.size() >= FLUSH_THRESHOLD) {
+            output.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    output.write(buffer.data(), buffer.size());
+    output.flush();
+    if (!output) {
+        throw Exception("Failed to write dump file: " + path);
+    }
+    return snapshot.size();
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::restore(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw Exception("Failed to open dump file: " + path);
+    }
+    char magic[sizeof(DUMP_MAGIC)];
+    input.read(magic, sizeof(magic));
+    const int version = input.get();
+    if (!input || !std::equal(magic, magic + sizeof(magic), DUMP_MAGIC)) {
+        throw Exception("Not a buffer dump file: " + path);
+    }
+    if (version != DUMP_VERSION) {
+        throw Exception("Unsupported dump file version: " + std::to_string(version));
+    }
+    std::vector<std::string> topics(read_varint(input));
+    for (std::string& topic : topics) {
+        topic.resize(read_varint(input));
+        input.read(&topic[0], topic.size());
+    }
+    const uint64_t record_count = read_varint(input);
+    std::string scratch;
+    for (uint64_t i = 0; i < record_count; ++i) {
+        const uint64_t topic_index = read_varint(input);
+        if (topic_index >= topics.size()) {
+            throw Exception("Corrupt dump record in: " + path);
+        }
+        Builder builder(topics[topic_index]);
+        const uint64_t partition = read_varint(input);
+        builder.partition(static_cast<int>(static_cast<int64_t>(partition >> 1) ^
+                                           -static_cast<int64_t>(partition & 1)));
+        builder.timestamp(std::chrono::milliseconds(static_cast<int64_t>(read_varint(input))));
+        const uint64_t key_size = read_varint(input);
+        if (key_size > 0) {
+            scratch.resize(key_size);
+            input.read(&scratch[0], scratch.size());
+            builder.key(BufferType(scratch.begin(), scratch.end()));
+        }
+        const uint64_t payload_size = read_varint(input);
+        if (payload_size > 0) {
+            scratch.resize(payload_size);
+            input.read(&scratch[0], scratch.size());
+            builder.payload(BufferType(scratch.begin(), scratch.end()));
+        }
+        if (!input) {
+            throw Exception("Truncated dump file: " + path);
+        }
+        add_tracker(SenderType::Async, builder);
+        do_add_message(std::move(builder), QueueKind::Produce, FlushAction::DontFlush);
+    }
+    return record_count;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::ShutdownReport
+BufferedProducer<BufferType, Allocator, QueuePolicy>::shutdown(std::chrono::milliseconds deadline,
+                                                               const std::string& dump_path) {
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    using std::chrono::steady_clock;
+    ShutdownReport report;
+    const auto deadline_point = steady_clock::now() + deadline;
+    const size_t acked_before = total_messages_produced_;
+    const size_t dropped_before = total_messages_dropped_;
+    // Reserve a slice of the budget for collecting failed messages and
+    // writing the dump
+    const milliseconds reserve = std::max(std::min(deadline / 10, milliseconds(500)),
+                                          milliseconds(50));
+    auto remaining = [&]()->milliseconds {
+        const auto left = duration_cast<milliseconds>(deadline_point - steady_clock::now());
+        return left > milliseconds(0) ? left : milliseconds(0);
+    };
+    // Produce everything buffered and wait for the acks within the budget
+    flush(deadline > reserve ? deadline - reserve : milliseconds(0), false);
+    if (get_pending_acks() > 0) {
+        const milliseconds left = remaining();
+        if (left > reserve) {
+            wait_for_acks(left - reserve);
+        }
+    }
+#if RD_KAFKA_VERSION >= RD_KAFKA_PURGE_SUPPORT_VERSION
+    if (get_pending_acks() > 0) {
+        // Fail the messages still sitting in rdkafka's send queue; their
+        // delivery reports arrive immediately and retryable ones re-enter the
+        // retry queue, which makes them part of the dump below. In-flight
+        // requests are left alone since the broker may still apply them.
+        rd_kafka_purge(producer_.get_handle(), RD_KAFKA_PURGE_F_QUEUE);
+        wait_for_acks(std::max(remaining(), milliseconds(50)));
+    }
+#endif
+    if (get_buffer_size() > 0) {
+        report.persisted = dump(dump_path);
+    }
+    report.delivered = total_messages_produced_ - acked_before;
+    report.dropped = (total_messages_dropped_ - dropped_before) + get_pending_acks();
+    return report;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::write_varint(std::string& buffer,
+                                                                        uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+uint64_t BufferedProducer<BufferType, Allocator, QueuePolicy>::read_varint(std::istream& input) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (true) {
+        const int byte = input.get();
+        if ((byte == std::char_traits<char>::eof()) || (shift > 63)) {
+            throw Exception("Corrupt varint in dump file");
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::process_delivery_reports(std::chrono::milliseconds timeout) {
+    if (!event_queue_) {
+        event_queue_ = Queue::make_queue(rd_kafka_queue_get_main(producer_.get_handle()));
+    }
+    size_t processed = 0;
+    auto remaining = timeout;
+    while (Event event = event_queue_.next_event(remaining)) {
+        // Only wait for the first event, then drain whatever is already queued
+        remaining = no_timeout;
+        if (event.get_type() != RD_KAFKA_EVENT_DR) {
+            handle_queue_event(event);
+            continue;
+        }
+        std::vector<Message> messages = event.get_messages();
+        std::vector<Message> delivered;
+        delivered.reserve(messages.size());
+        processed += messages.size();
+        for (Message& message : messages) {
+            if (message.get_error()) {
+                // Failures engage the per-message retry bookkeeping
+                on_delivery_report(message);
+                continue;
+            }
+            if (enable_message_retries_) {
+                // Restore the user data and unblock any synchronous sender
+                // waiting for this ack.
+                TrackerPtr tracker =
+                    std::static_pointer_cast<Tracker>(MessageInternal::load(message)->get_internal());
+                if (tracker) {
+                    tracker->complete_delivery(message);
+                    tracker->should_retry(false);
+                }
+            }
+            ++total_messages_produced_;
+            ack_monitor_.decrement_pending_acks();
+            delivered.emplace_back(std::move(message));
+        }
+        if (!delivered.empty()) {
+            CallbackInvoker<ProduceSuccessBatchCallback>
+                ("batch delivery success", produce_success_batch_callback_, &producer_)(delivered);
+        }
+    }
+    // Wake up any producer thread backing off on a full queue
+    if ((processed > 0) && (queue_full_wait_policy_ == QueueFullWaitPolicy::ExponentialBackoff)) {
+        queue_full_cv_.notify_all();
+    }
+    return processed;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::handle_queue_event(const Event& event) {
+    // Dispatch the callbacks rd_kafka_poll would have served for this event
+    switch (event.get_type()) {
+        case RD_KAFKA_EVENT_ERROR:
+            CallbackInvoker<Configuration::ErrorCallback>
+                ("error", producer_.get_configuration().get_error_callback(), &producer_)
+                (producer_, event.get_error().get_error(), event.get_error().to_string());
+            break;
+#if RD_KAFKA_VERSION >= RD_KAFKA_EVENT_STATS_SUPPORT_VERSION
+        case RD_KAFKA_EVENT_STATS:
+            CallbackInvoker<Configuration::StatsCallback>
+                ("statistics", producer_.get_configuration().get_stats_callback(), &producer_)
+                (producer_, event.get_stats());
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::wait_for_acks() {
     //block until all acks have been received
     wait_for_acks_impl(Threads::All, infinite_timeout);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::wait_for_current_thread_acks() {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::wait_for_current_thread_acks() {
     //block until all acks from the current thread have been received
     wait_for_acks_impl(Threads::Current, infinite_timeout);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::wait_for_acks(std::chrono::milliseconds timeout) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::wait_for_acks(std::chrono::milliseconds timeout) {
     //block until all acks have been received
     return wait_for_acks_impl(Threads::All, timeout);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::wait_for_current_thread_acks(std::chrono::milliseconds timeout) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::wait_for_current_thread_acks(std::chrono::milliseconds timeout) {
     //block until all acks from the current thread have been received
     return wait_for_acks_impl(Threads::Current, timeout);
 }
 
-template <typename BufferType, typename Allocator>
-bool BufferedProducer<BufferType, Allocator>::wait_for_acks_impl(Threads threads,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+bool BufferedProducer<BufferType, Allocator, QueuePolicy>::wait_for_acks_impl(Threads threads,
                                                                  std::chrono::milliseconds timeout) {
     auto remaining = timeout;
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -969,16 +1959,33 @@ bool BufferedProducer<BufferType, Allocator>::wait_for_acks_impl(Threads threads
     return !pending_acks;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::clear() {
-    QueueType tmp;
-    swap_queues(messages_, tmp, mutex_);
-    QueueType retry_tmp;
-    swap_queues(retry_messages_, retry_tmp, retry_mutex_);
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::clear() {
+    //Discard through try_pop/swap rather than QueueType::clear() so every
+    //dropped message passes through the byte accounting
+    const auto discard = [this](QueueType& queue, std::mutex& mutex)->void {
+        if constexpr (detail::is_concurrent_queue<QueueType>::value) {
+            bool consumed = true;
+            while (consumed) {
+                consumed = queue.try_pop([&](Builder&& builder)->void {
+                    release_buffered(builder);
+                });
+            }
+        }
+        else {
+            QueueType tmp;
+            swap_queues(queue, tmp, mutex);
+            for (const Builder& builder : tmp) {
+                release_buffered(builder);
+            }
+        }
+    };
+    discard(messages_, mutex_);
+    discard(retry_messages_, retry_mutex_);
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_buffer_size() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_buffer_size() const {
     size_t size = 0;
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -991,36 +1998,144 @@ size_t BufferedProducer<BufferType, Allocator>::get_buffer_size() const {
     return size;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_max_buffer_size(ssize_t max_buffer_size) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_max_buffer_size(ssize_t max_buffer_size) {
     if (max_buffer_size < -1) {
         throw Exception("Invalid buffer size.");
     }
     max_buffer_size_ = max_buffer_size;
 }
 
-template <typename BufferType, typename Allocator>
-ssize_t BufferedProducer<BufferType, Allocator>::get_max_buffer_size() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+ssize_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_max_buffer_size() const {
     return max_buffer_size_;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_flush_method(FlushMethod method) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_max_buffer_bytes(ssize_t max_bytes) {
+    if (max_bytes < -1) {
+        throw Exception("Invalid buffer byte limit.");
+    }
+    max_buffer_bytes_ = max_bytes;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+ssize_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_max_buffer_bytes() const {
+    return max_buffer_bytes_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+uint64_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_buffered_bytes() const {
+    return total_buffered_bytes_.load(std::memory_order_relaxed);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+uint64_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_buffered_bytes(const std::string& topic) const {
+    std::lock_guard<std::mutex> lock(topic_bytes_mutex_);
+    const auto it = topic_bytes_.find(topic);
+    return it != topic_bytes_.end() ? it->second->bytes.load(std::memory_order_relaxed) : 0;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+uint64_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_buffered_bytes_high_water_mark() const {
+    return buffered_bytes_high_water_mark_.load(std::memory_order_relaxed);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+uint64_t BufferedProducer<BufferType, Allocator, QueuePolicy>::
+get_buffered_bytes_high_water_mark(const std::string& topic) const {
+    std::lock_guard<std::mutex> lock(topic_bytes_mutex_);
+    const auto it = topic_bytes_.find(topic);
+    return it != topic_bytes_.end() ? it->second->high_water_mark.load(std::memory_order_relaxed)
+                                    : 0;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::TopicByteCounter&
+BufferedProducer<BufferType, Allocator, QueuePolicy>::get_topic_byte_counter(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(topic_bytes_mutex_);
+    std::unique_ptr<TopicByteCounter>& counter = topic_bytes_[topic];
+    if (!counter) {
+        counter.reset(new TopicByteCounter());
+    }
+    return *counter;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::
+raise_high_water_mark(std::atomic<uint64_t>& high_water_mark, uint64_t value) {
+    uint64_t current = high_water_mark.load(std::memory_order_relaxed);
+    while (value > current &&
+           !high_water_mark.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        //current was reloaded by the failed exchange; retry unless it passed value
+    }
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+template <typename T>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::account_buffered(const T& builder) {
+    const uint64_t bytes = make_buffer_view(builder.payload()).get_size();
+    if (bytes == 0) {
+        return;
+    }
+    TopicByteCounter& counter = get_topic_byte_counter(builder.topic());
+    raise_high_water_mark(counter.high_water_mark,
+                          counter.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    raise_high_water_mark(buffered_bytes_high_water_mark_,
+                          total_buffered_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+template <typename T>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::release_buffered(const T& builder) {
+    const uint64_t bytes = make_buffer_view(builder.payload()).get_size();
+    if (bytes == 0) {
+        return;
+    }
+    get_topic_byte_counter(builder.topic()).bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    total_buffered_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_flush_method(FlushMethod method) {
     flush_method_ = method;
 }
 
-template <typename BufferType, typename Allocator>
-typename BufferedProducer<BufferType, Allocator>::FlushMethod
-BufferedProducer<BufferType, Allocator>::get_flush_method() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::FlushMethod
+BufferedProducer<BufferType, Allocator, QueuePolicy>::get_flush_method() const {
     return flush_method_;
 }
 
-template <typename BufferType, typename Allocator>
+template <typename BufferType, typename Allocator, typename QueuePolicy>
 template <typename BuilderType>
-void BufferedProducer<BufferType, Allocator>::do_add_message(BuilderType&& builder,
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::do_add_message(BuilderType&& builder,
                                                              QueueKind queue_kind,
                                                              FlushAction flush_action) {
-    if (queue_kind == QueueKind::Retry) {
+    // Spill over the resident cap instead of enqueuing. Retry messages are
+    // exempt since spilling them would lose their delivery tracking state.
+    if (overflow_callback_ && (queue_kind == QueueKind::Produce) &&
+        (max_resident_messages_ >= 0) &&
+        (max_resident_messages_ <= (ssize_t)get_buffer_size())) {
+        // The message is handed off to the callback and never enqueued, so moving
+        // is safe even when the caller passed an lvalue; this also keeps the path
+        // compiling for non-copyable buffer types such as Buffer
+        CallbackInvoker<OverflowCallback>("buffer overflow", overflow_callback_, &producer_)
+            (Builder(std::move(builder)));
+        return;
+    }
+    //Account before the enqueue moves the builder away
+    account_buffered(builder);
+    if constexpr (detail::is_concurrent_queue<QueueType>::value) {
+        //Lock-free queue policies synchronize internally (a single CAS per push)
+        if (queue_kind == QueueKind::Retry) {
+            retry_messages_.emplace_back(std::forward<BuilderType>(builder));
+        }
+        else {
+            messages_.emplace_back(std::forward<BuilderType>(builder));
+        }
+    }
+    else if (queue_kind == QueueKind::Retry) {
         std::lock_guard<std::mutex> lock(retry_mutex_);
         retry_messages_.emplace_back(std::forward<BuilderType>(builder));
     }
@@ -1032,8 +2147,10 @@ void BufferedProducer<BufferType, Allocator>::do_add_message(BuilderType&& build
     // from on_delivery_report() during which flush()/async_flush() cannot be called.
     if (queue_kind == QueueKind::Produce &&
         flush_action == FlushAction::DoFlush &&
-        (max_buffer_size_ >= 0) &&
-        (max_buffer_size_ <= (ssize_t)get_buffer_size())) {
+        (((max_buffer_size_ >= 0) &&
+          (max_buffer_size_ <= (ssize_t)get_buffer_size())) ||
+         ((max_buffer_bytes_ >= 0) &&
+          (max_buffer_bytes_ <= (ssize_t)total_buffered_bytes_.load(std::memory_order_relaxed))))) {
         if (flush_method_ == FlushMethod::Sync) {
             flush();
         }
@@ -1043,106 +2160,180 @@ void BufferedProducer<BufferType, Allocator>::do_add_message(BuilderType&& build
     }
 }
 
-template <typename BufferType, typename Allocator>
-Producer& BufferedProducer<BufferType, Allocator>::get_producer() {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+Producer& BufferedProducer<BufferType, Allocator, QueuePolicy>::get_producer() {
     return producer_;
 }
 
-template <typename BufferType, typename Allocator>
-const Producer& BufferedProducer<BufferType, Allocator>::get_producer() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+const Producer& BufferedProducer<BufferType, Allocator, QueuePolicy>::get_producer() const {
     return producer_;
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_pending_acks() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_pending_acks() const {
     return ack_monitor_.get_pending_acks();
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_current_thread_pending_acks() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_current_thread_pending_acks() const {
     return ack_monitor_.get_current_thread_pending_acks();
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_total_messages_produced() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_total_messages_produced() const {
     return total_messages_produced_;
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_total_messages_dropped() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_total_messages_dropped() const {
     return total_messages_dropped_;
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_flushes_in_progress() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_flushes_in_progress() const {
     return flushes_in_progress_;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_max_number_retries(size_t max_number_retries) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_max_number_retries(size_t max_number_retries) {
     if (!enable_message_retries_ && (max_number_retries > 0)) {
         enable_message_retries_ = true; //enable once
     }
     max_number_retries_ = max_number_retries;
 }
 
-template <typename BufferType, typename Allocator>
-size_t BufferedProducer<BufferType, Allocator>::get_max_number_retries() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_max_number_retries() const {
     return max_number_retries_;
 }
 
-template <typename BufferType, typename Allocator>
-typename BufferedProducer<BufferType, Allocator>::Builder
-BufferedProducer<BufferType, Allocator>::make_builder(std::string topic) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::enable_latency_tracking(size_t sampling_rate) {
+    if (!enable_message_retries_) {
+        enable_message_retries_ = true; //the timestamp rides in the per-message tracker
+    }
+    latency_sampling_rate_ = std::max<size_t>(sampling_rate, 1);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::disable_latency_tracking() {
+    latency_sampling_rate_ = 0;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+const LatencyHistogram& BufferedProducer<BufferType, Allocator, QueuePolicy>::get_latency_histogram() const {
+    return latency_histogram_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::Builder
+BufferedProducer<BufferType, Allocator, QueuePolicy>::make_builder(std::string topic) {
     return Builder(std::move(topic));
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_queue_full_notification(QueueFullNotification notification) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_queue_full_notification(QueueFullNotification notification) {
     queue_full_notification_ = notification;
 }
 
-template <typename BufferType, typename Allocator>
-typename BufferedProducer<BufferType, Allocator>::QueueFullNotification
-BufferedProducer<BufferType, Allocator>::get_queue_full_notification() const {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::QueueFullNotification
+BufferedProducer<BufferType, Allocator, QueuePolicy>::get_queue_full_notification() const {
     return queue_full_notification_;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_produce_failure_callback(ProduceFailureCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_queue_full_wait_policy(QueueFullWaitPolicy policy) {
+    queue_full_wait_policy_ = policy;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+typename BufferedProducer<BufferType, Allocator, QueuePolicy>::QueueFullWaitPolicy
+BufferedProducer<BufferType, Allocator, QueuePolicy>::get_queue_full_wait_policy() const {
+    return queue_full_wait_policy_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_queue_full_backoff(std::chrono::milliseconds initial,
+                                                                     std::chrono::milliseconds maximum) {
+    if ((initial.count() <= 0) || (maximum < initial)) {
+        throw Exception("Invalid backoff range.");
+    }
+    queue_full_backoff_initial_ = initial;
+    queue_full_backoff_maximum_ = maximum;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+std::chrono::microseconds
+BufferedProducer<BufferType, Allocator, QueuePolicy>::get_total_time_blocked_on_queue_full() const {
+    return std::chrono::microseconds(total_time_blocked_us_.load());
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+size_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_total_queue_full_occurrences() const {
+    return total_queue_full_occurrences_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_produce_failure_callback(ProduceFailureCallback callback) {
     produce_failure_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_produce_termination_callback(ProduceTerminationCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_produce_termination_callback(ProduceTerminationCallback callback) {
     produce_termination_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_produce_success_callback(ProduceSuccessCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_produce_success_callback(ProduceSuccessCallback callback) {
     produce_success_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_flush_failure_callback(FlushFailureCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_produce_success_batch_callback(ProduceSuccessBatchCallback callback) {
+    produce_success_batch_callback_ = std::move(callback);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_flush_failure_callback(FlushFailureCallback callback) {
     flush_failure_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_flush_termination_callback(FlushTerminationCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_flush_termination_callback(FlushTerminationCallback callback) {
     flush_termination_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::set_queue_full_callback(QueueFullCallback callback) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_queue_full_callback(QueueFullCallback callback) {
     queue_full_callback_ = std::move(callback);
 }
 
-template <typename BufferType, typename Allocator>
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_max_resident_messages(ssize_t limit) {
+    if (limit < -1) {
+        throw Exception("Invalid resident message cap.");
+    }
+    max_resident_messages_ = limit;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+ssize_t BufferedProducer<BufferType, Allocator, QueuePolicy>::get_max_resident_messages() const {
+    return max_resident_messages_;
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::set_overflow_callback(OverflowCallback callback) {
+    overflow_callback_ = std::move(callback);
+}
+
+template <typename BufferType, typename Allocator, typename QueuePolicy>
 template <typename BuilderType>
-void BufferedProducer<BufferType, Allocator>::produce_message(BuilderType&& builder) {
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::produce_message(BuilderType&& builder) {
     using builder_type = typename std::decay<BuilderType>::type;
     bool queue_full_notify = queue_full_notification_ != QueueFullNotification::None;
+    auto backoff = queue_full_backoff_initial_;
     while (true) {
         try {
             MessageInternalGuard<builder_type> internal_guard(const_cast<builder_type&>(builder));
@@ -1150,12 +2341,37 @@ void BufferedProducer<BufferType, Allocator>::produce_message(BuilderType&& buil
             internal_guard.release();
             // Sent successfully
             ack_monitor_.increment_pending_acks();
+            const size_t sampling_rate = latency_sampling_rate_.load(std::memory_order_relaxed);
+            if (sampling_rate != 0 &&
+                (latency_sample_counter_.fetch_add(1, std::memory_order_relaxed) % sampling_rate == 0)) {
+                TrackerPtr tracker = std::static_pointer_cast<Tracker>(builder.internal());
+                if (tracker) {
+                    tracker->mark_produced(LatencyHistogram::now_us());
+                }
+            }
             break;
         }
         catch (const HandleException& ex) {
             if (ex.get_error() == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
-                // If the output queue is full, then just poll
-                producer_.poll();
+                CPPKAFKA_TRACE1(queue_full, builder.partition());
+                ++total_queue_full_occurrences_;
+                if (queue_full_wait_policy_ == QueueFullWaitPolicy::ExponentialBackoff) {
+                    // Sleep until a delivery report frees a slot or the backoff expires,
+                    // then poll once to serve any reports in case no other thread does.
+                    const auto start = std::chrono::steady_clock::now();
+                    {
+                        std::unique_lock<std::mutex> lock(queue_full_mutex_);
+                        queue_full_cv_.wait_for(lock, backoff);
+                    }
+                    producer_.poll(no_timeout);
+                    total_time_blocked_us_ += std::chrono::duration_cast<std::chrono::microseconds>
+                        (std::chrono::steady_clock::now() - start).count();
+                    backoff = std::min(backoff * 2, queue_full_backoff_maximum_);
+                }
+                else {
+                    // If the output queue is full, then just poll
+                    producer_.poll();
+                }
                 // Notify application so it can slow-down production
                 if (queue_full_notify) {
                     queue_full_notify = queue_full_notification_ == QueueFullNotification::EachOccurence;
@@ -1169,9 +2385,9 @@ void BufferedProducer<BufferType, Allocator>::produce_message(BuilderType&& buil
     }
 }
 
-template <typename BufferType, typename Allocator>
+template <typename BufferType, typename Allocator, typename QueuePolicy>
 template <typename BuilderType>
-void BufferedProducer<BufferType, Allocator>::async_produce(BuilderType&& builder, bool throw_on_error) {
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::async_produce(BuilderType&& builder, bool throw_on_error) {
     try {
         TestParameters* test_params = get_test_parameters();
         if (test_params && test_params->force_produce_error_) {
@@ -1194,6 +2410,10 @@ void BufferedProducer<BufferType, Allocator>::async_produce(BuilderType&& builde
             }
         }
         ++total_messages_dropped_;
+        // The message won't be retried anymore, complete any delivery future
+        if (TrackerPtr tracker = std::static_pointer_cast<Tracker>(builder.internal())) {
+            tracker->complete_delivery(ex.get_error());
+        }
         // Call the flush termination callback
         CallbackInvoker<FlushTerminationCallback>("flush termination", flush_termination_callback_, &producer_)
             (builder, ex.get_error());
@@ -1203,16 +2423,17 @@ void BufferedProducer<BufferType, Allocator>::async_produce(BuilderType&& builde
     }
 }
 
-template <typename BufferType, typename Allocator>
-Configuration BufferedProducer<BufferType, Allocator>::prepare_configuration(Configuration config) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+Configuration BufferedProducer<BufferType, Allocator, QueuePolicy>::prepare_configuration(Configuration config) {
     using std::placeholders::_2;
-    auto callback = std::bind(&BufferedProducer<BufferType, Allocator>::on_delivery_report, this, _2);
+    auto callback = std::bind(&BufferedProducer<BufferType, Allocator, QueuePolicy>::on_delivery_report, this, _2);
     config.set_delivery_report_callback(std::move(callback));
     return config;
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::on_delivery_report(const Message& message) {
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::on_delivery_report(const Message& message) {
+    CPPKAFKA_TRACE1(delivery_report, message.get_error().get_error());
     TestParameters* test_params = get_test_parameters();
     //Get tracker if present
     TrackerPtr tracker =
@@ -1252,21 +2473,34 @@ void BufferedProducer<BufferType, Allocator>::on_delivery_report(const Message&
     }
     else {
         // Successful delivery
+        if (tracker && (tracker->get_produce_time_us() >= 0)) {
+            // This message was sampled for latency tracking at produce time
+            latency_histogram_.record(LatencyHistogram::now_us() - tracker->get_produce_time_us());
+        }
         CallbackInvoker<ProduceSuccessCallback>("delivery success", produce_success_callback_, &producer_)(message);
         // Increment the total successful transmissions
         ++total_messages_produced_;
     }
     // Signal synchronous sender and unblock it since it's waiting for this ack to arrive.
     if (tracker) {
+        if (!retry) {
+            // The outcome is final, complete any delivery future tied to this message
+            tracker->complete_delivery(message);
+        }
         tracker->should_retry(retry);
     }
     // Decrement the expected acks and check to prevent underflow
     ack_monitor_.decrement_pending_acks();
+    // Wake up any producer thread backing off on a full queue since this
+    // report just freed a slot in it.
+    if (queue_full_wait_policy_ == QueueFullWaitPolicy::ExponentialBackoff) {
+        queue_full_cv_.notify_all();
+    }
 }
 
-template <typename BufferType, typename Allocator>
-void BufferedProducer<BufferType, Allocator>::swap_queues(BufferedProducer<BufferType, Allocator>::QueueType & queue1,
-                                                          BufferedProducer<BufferType, Allocator>::QueueType & queue2,
+template <typename BufferType, typename Allocator, typename QueuePolicy>
+void BufferedProducer<BufferType, Allocator, QueuePolicy>::swap_queues(BufferedProducer<BufferType, Allocator, QueuePolicy>::QueueType & queue1,
+                                                          BufferedProducer<BufferType, Allocator, QueuePolicy>::QueueType & queue2,
                                                           std::mutex & mutex)
 {
     std::lock_guard<std::mutex> lock(mutex);
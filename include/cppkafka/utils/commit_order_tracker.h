@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_COMMIT_ORDER_TRACKER_H
+#define CPPKAFKA_COMMIT_ORDER_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "../macros.h"
+#include "../message.h"
+#include "../topic_partition.h"
+#include "../topic_partition_list.h"
+#include "backoff_committer.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Tracks out-of-order completion and derives in-order commit offsets
+ *
+ * Committing via Consumer::commit(msg) is only safe when messages finish
+ * processing in offset order; with a worker pool they don't, and committing the
+ * newest completed offset drops everything still in flight below it on a
+ * rebalance. This class solves the ordering problem without the usual
+ * mutex-protected set per partition: completion is tracked in a per-partition
+ * bitmap ring over offsets, so marking an offset done from a worker is a single
+ * atomic fetch_or - no locks, no allocation - and the poll thread advances a
+ * committable watermark (the first offset not yet completed) by scanning the
+ * bitmap words.
+ *
+ * Usage with a BackoffCommitter:
+ *
+ * \code
+ * CommitOrderTracker tracker;
+ * BackoffCommitter committer(consumer);
+ *
+ * // Poll thread
+ * Message message = consumer.poll();
+ * if (message && !message.get_error()) {
+ *     CommitOrderTracker::Ticket ticket = tracker.track(message);
+ *     workers.dispatch(std::move(message), ticket);
+ * }
+ * tracker.commit_ready(committer); // periodically
+ *
+ * // Worker threads, in any order
+ * tracker.complete(ticket);
+ * \endcode
+ *
+ * \remark track() and commit_ready() must run on a single thread (the poll
+ * thread); complete() may be called concurrently from any thread.
+ */
+class CPPKAFKA_API CommitOrderTracker {
+public:
+    /**
+     * Default per-partition completion window, in offsets
+     */
+    static constexpr size_t DEFAULT_WINDOW_SIZE = 64 * 1024;
+
+    /**
+     * \brief Completion handle for one tracked message
+     *
+     * Tickets are trivially copyable and cheap to pass along with the message
+     * to whatever thread ends up completing it.
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+
+        /**
+         * Indicates whether this ticket refers to a tracked offset
+         */
+        explicit operator bool() const {
+            return window_ != nullptr;
+        }
+    private:
+        friend class CommitOrderTracker;
+
+        void* window_{nullptr};
+        int64_t offset_{0};
+    };
+
+    /**
+     * Constructs a tracker using the default window size
+     */
+    CommitOrderTracker();
+
+    /**
+     * \brief Constructs a tracker using the given per-partition window
+     *
+     * The window bounds how far ahead of the oldest uncompleted offset a
+     * partition may run; the value is rounded up to a multiple of 64.
+     *
+     * \param window_size The window size, in offsets
+     */
+    explicit CommitOrderTracker(size_t window_size);
+
+    /**
+     * \brief Starts tracking a message
+     *
+     * Offsets of a partition must be tracked in consumption order. A partition
+     * jumping backwards or far forwards (seek, re-assignment after a rebalance)
+     * transparently restarts its tracking at the new position.
+     *
+     * \param message The message about to be handed to a worker
+     *
+     * \return A ticket to complete later, or an empty ticket if the offset is a
+     * full window ahead of the partition's oldest uncompleted offset (the
+     * caller should then throttle and retry once completions catch up)
+     */
+    Ticket track(const Message& message);
+
+    /**
+     * \brief Starts tracking an offset of a partition
+     *
+     * Same as track(const Message&) for callers not holding the message.
+     *
+     * \param topic_partition The partition the offset belongs to
+     * \param offset The offset to be tracked
+     */
+    Ticket track(const TopicPartition& topic_partition, int64_t offset);
+
+    /**
+     * \brief Marks a tracked offset as completed
+     *
+     * A single atomic fetch_or; callable from any thread. Completing an empty
+     * ticket is a no-op.
+     *
+     * \param ticket The ticket obtained from track()
+     */
+    void complete(const Ticket& ticket);
+
+    /**
+     * \brief Gets the partitions whose committable watermark moved
+     *
+     * Advances every partition's watermark over its completed prefix and
+     * returns those above the last offsets handed out by this function. The
+     * offsets follow kafka commit semantics: each one is the next offset to be
+     * consumed, not the last completed one.
+     *
+     * \return The partitions ready to be committed; possibly empty
+     */
+    TopicPartitionList get_committable();
+
+    /**
+     * \brief Commits every partition's completed frontier through a committer
+     *
+     * If the committer's error callback aborts the commit, the offsets are
+     * simply returned by the next call.
+     *
+     * \param committer The committer the offsets are handed to
+     *
+     * \return Whether any offsets were committed
+     */
+    bool commit_ready(BackoffCommitter& committer);
+
+    /**
+     * \brief Drops all tracking state
+     *
+     * Meant for a full stop/restart of the consuming side, after all workers
+     * have drained; outstanding tickets must not be completed afterwards. There
+     * is no need to call this on rebalances, which are handled per partition by
+     * track().
+     */
+    void clear();
+private:
+    struct PartitionWindow {
+        PartitionWindow(int64_t first_offset, size_t num_words);
+
+        // Marks an offset as processed. Callable from any thread.
+        void mark(int64_t offset);
+
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        size_t num_words;
+        // All fields below are owned by the tracking thread
+        int64_t window_start; // word aligned; offsets below are complete and cleared
+        int64_t next_offset; // next offset expected from the partition
+        int64_t commit_frontier; // first offset not yet known to be complete
+        int64_t committed_frontier; // last frontier handed out for committing
+    };
+
+    PartitionWindow& get_window(const TopicPartition& topic_partition, int64_t offset);
+    static void advance(PartitionWindow& window);
+
+    std::map<TopicPartition, std::unique_ptr<PartitionWindow>> windows_;
+    // Windows replaced after a discontinuity stay alive until clear() since
+    // in-flight tickets may still complete into them
+    std::vector<std::unique_ptr<PartitionWindow>> retired_windows_;
+    size_t window_size_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_COMMIT_ORDER_TRACKER_H
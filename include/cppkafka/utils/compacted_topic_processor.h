@@ -30,14 +30,26 @@
 #ifndef CPPKAFKA_COMPACTED_TOPIC_PROCESSOR_H
 #define CPPKAFKA_COMPACTED_TOPIC_PROCESSOR_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <map>
 #include <set>
 #include <optional>
+#include <thread>
+#include <tuple>
+#include <vector>
 #include "../buffer.h"
 #include "../consumer.h"
+#include "../exceptions.h"
 #include "../macros.h"
+#include "../queue.h"
+#include "compacted_topic_store.h"
 
 namespace cppkafka {
 /**
@@ -169,12 +181,75 @@ public:
      */
     void set_error_handler(ErrorHandler callback);
 
-    /** 
+    /**
+     * \brief Enables the built-in materialized store
+     *
+     * When enabled, every processed message updates a CompactedTopicStore with the
+     * raw key/payload bytes: a message with a payload sets the entry, a null payload
+     * deletes it, and losing a partition on a rebalance drops exactly that
+     * partition's entries. This replaces the usual pattern of mirroring the topic
+     * into an application-side map; the event handler and decoders become optional
+     * and are only invoked when set.
+     *
+     * \param initial_capacity The store's initial slot count
+     */
+    void enable_store(size_t initial_capacity = CompactedTopicStore::DEFAULT_INITIAL_CAPACITY);
+
+    /**
+     * Indicates whether the built-in store is enabled
+     */
+    bool has_store() const;
+
+    /**
+     * \brief Gets the built-in store
+     *
+     * Only valid to call after enable_store()
+     */
+    CompactedTopicStore& get_store();
+
+    /**
+     * \brief Gets the built-in store
+     *
+     * Only valid to call after enable_store()
+     */
+    const CompactedTopicStore& get_store() const;
+
+    /**
      * \brief Processes the next event
      */
     void process_event();
+
+    /**
+     * \brief Loads the built-in store by consuming all assigned partitions in parallel
+     *
+     * Bootstrapping a large compacted topic through process_event() is bounded by one
+     * message and one map operation at a time on a single thread. This call instead
+     * detaches every assigned partition into its own queue
+     * (Consumer::get_partition_queue), spreads the partitions over a pool of threads
+     * and applies set/delete operations to the store in batches, taking the store
+     * lock once per batch rather than once per message. A partition is finished once
+     * it reaches the high watermark captured when the call started; when all of them
+     * are, the partition queues are forwarded back into the consumer queue and the
+     * serial process_event() path picks up exactly where bootstrap left off.
+     *
+     * Decoders and the event handler are not invoked for bootstrapped messages - the
+     * store is assumed to be the bootstrap target. The error handler is invoked,
+     * serialized across the pool. The consumer must not be polled concurrently with
+     * this call.
+     *
+     * \param num_threads The pool size; 0 picks std::thread::hardware_concurrency()
+     *
+     * \return The amount of messages applied to the store
+     *
+     * \remark Throws Exception if the built-in store is not enabled
+     */
+    size_t bootstrap_store(size_t num_threads = 0);
 private:
+    // Messages applied to the store per lock acquisition during bootstrap
+    static constexpr size_t BOOTSTRAP_BATCH_SIZE = 512;
+
     void on_assignment(TopicPartitionList& topic_partitions);
+    uint32_t get_source_id(const TopicPartition& topic_partition);
 
     Consumer& consumer_;
     KeyDecoder key_decoder_;
@@ -182,6 +257,9 @@ private:
     EventHandler event_handler_;
     ErrorHandler error_handler_;
     std::map<TopicPartition, int64_t> partition_offsets_;
+    std::unique_ptr<CompactedTopicStore> store_;
+    std::map<TopicPartition, uint32_t> partition_sources_;
+    uint32_t next_source_id_{0};
     Consumer::AssignmentCallback original_assignment_callback_;
 };
 
@@ -271,36 +349,73 @@ void CompactedTopicProcessor<K, V>::set_error_handler(ErrorHandler callback) {
     error_handler_ = std::move(callback);
 }
 
+template <typename K, typename V>
+void CompactedTopicProcessor<K, V>::enable_store(size_t initial_capacity) {
+    if (!store_) {
+        store_.reset(new CompactedTopicStore(initial_capacity));
+    }
+}
+
+template <typename K, typename V>
+bool CompactedTopicProcessor<K, V>::has_store() const {
+    return static_cast<bool>(store_);
+}
+
+template <typename K, typename V>
+CompactedTopicStore& CompactedTopicProcessor<K, V>::get_store() {
+    return *store_;
+}
+
+template <typename K, typename V>
+const CompactedTopicStore& CompactedTopicProcessor<K, V>::get_store() const {
+    return *store_;
+}
+
 template <typename Key, typename Value>
 void CompactedTopicProcessor<Key, Value>::process_event() {
     Message message = consumer_.poll();
     if (message) {
         if (!message.get_error()) {
-            std::optional<Key> key = key_decoder_(message.get_key());
-            if (key) {
+            TopicPartition topic_partition(message.get_topic(), message.get_partition());
+            if (store_) {
+                // Materialize the raw bytes, tagged with the owning partition so a
+                // revocation can drop them selectively
                 if (message.get_payload()) {
-                    std::optional<Value> value = value_decoder_(*key, message.get_payload());
-                    if (value) {
-                        // If there's a payload and we managed to parse the value, generate a
-                        // SET_ELEMENT event
-                        event_handler_({ Event::SET_ELEMENT, message.get_topic(),
-                                         message.get_partition(), *key, std::move(*value) });
-                    }
+                    store_->set(message.get_key(), message.get_payload(),
+                                get_source_id(topic_partition));
                 }
                 else {
-                    // No payload, generate a DELETE_ELEMENT event
-                    event_handler_({ Event::DELETE_ELEMENT, message.get_topic(),
-                                     message.get_partition(), *key });
+                    store_->erase(message.get_key());
+                }
+            }
+            if (event_handler_) {
+                std::optional<Key> key = key_decoder_(message.get_key());
+                if (key) {
+                    if (message.get_payload()) {
+                        std::optional<Value> value = value_decoder_(*key, message.get_payload());
+                        if (value) {
+                            // If there's a payload and we managed to parse the value, generate a
+                            // SET_ELEMENT event
+                            event_handler_({ Event::SET_ELEMENT, message.get_topic(),
+                                             message.get_partition(), *key, std::move(*value) });
+                        }
+                    }
+                    else {
+                        // No payload, generate a DELETE_ELEMENT event
+                        event_handler_({ Event::DELETE_ELEMENT, message.get_topic(),
+                                         message.get_partition(), *key });
+                    }
                 }
             }
             // Store the offset for this topic/partition
-            TopicPartition topic_partition(message.get_topic(), message.get_partition());
             partition_offsets_[topic_partition] = message.get_offset();
         }
         else {
             if (message.is_eof()) {
-                event_handler_({ Event::REACHED_EOF, message.get_topic(),
-                                 message.get_partition() });
+                if (event_handler_) {
+                    event_handler_({ Event::REACHED_EOF, message.get_topic(),
+                                     message.get_partition() });
+                }
             }
             else if (error_handler_) {
                 error_handler_(std::move(message));
@@ -309,6 +424,111 @@ void CompactedTopicProcessor<Key, Value>::process_event() {
     }
 }
 
+template <typename K, typename V>
+size_t CompactedTopicProcessor<K, V>::bootstrap_store(size_t num_threads) {
+    using std::chrono::milliseconds;
+    if (!store_) {
+        throw Exception("Bootstrapping requires the built-in store (see enable_store)");
+    }
+    TopicPartitionList assignment = consumer_.get_assignment();
+    if (assignment.empty()) {
+        return 0;
+    }
+    struct PartitionTask {
+        TopicPartition partition;
+        Queue queue;
+        int64_t end_offset;
+        uint32_t source;
+    };
+    // Capture the partition queues, target watermarks and source tags up front,
+    // on the calling thread
+    std::vector<PartitionTask> tasks;
+    tasks.reserve(assignment.size());
+    for (const TopicPartition& topic_partition : assignment) {
+        int64_t low_watermark;
+        int64_t high_watermark;
+        std::tie(low_watermark, high_watermark) = consumer_.query_offsets(topic_partition);
+        (void)low_watermark;
+        tasks.push_back({ topic_partition, consumer_.get_partition_queue(topic_partition),
+                          high_watermark, get_source_id(topic_partition) });
+    }
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    num_threads = std::max<size_t>(std::min(num_threads, tasks.size()), 1);
+
+    std::mutex mutex;
+    std::atomic<size_t> next_task{0};
+    std::atomic<size_t> total_applied{0};
+    auto worker = [&]() {
+        std::vector<Message> batch;
+        while (true) {
+            const size_t task_index = next_task.fetch_add(1);
+            if (task_index >= tasks.size()) {
+                return;
+            }
+            PartitionTask& task = tasks[task_index];
+            int64_t last_offset = -1;
+            size_t applied = 0;
+            bool caught_up = task.end_offset <= 0;
+            while (!caught_up) {
+                batch.clear();
+                task.queue.consume_batch(std::back_inserter(batch), BOOTSTRAP_BATCH_SIZE,
+                                         milliseconds(100));
+                if (batch.empty()) {
+                    // Nothing buffered; the partition may already have been consumed
+                    // up to the watermark before this call started
+                    TopicPartitionList position =
+                        consumer_.get_offsets_position({ task.partition });
+                    caught_up = !position.empty() &&
+                                position[0].get_offset() >= task.end_offset;
+                    continue;
+                }
+                std::lock_guard<std::mutex> _(mutex);
+                for (Message& message : batch) {
+                    if (message.get_error()) {
+                        if (message.is_eof()) {
+                            caught_up = caught_up || message.get_offset() >= task.end_offset;
+                        }
+                        else if (error_handler_) {
+                            error_handler_(std::move(message));
+                        }
+                        continue;
+                    }
+                    if (message.get_payload()) {
+                        store_->set(message.get_key(), message.get_payload(), task.source);
+                    }
+                    else {
+                        store_->erase(message.get_key());
+                    }
+                    last_offset = message.get_offset();
+                    ++applied;
+                    caught_up = caught_up || last_offset + 1 >= task.end_offset;
+                }
+            }
+            total_applied += applied;
+            if (last_offset >= 0) {
+                std::lock_guard<std::mutex> _(mutex);
+                partition_offsets_[task.partition] = last_offset;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i != num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Route the partitions back into the consumer queue so the serial
+    // process_event() path takes over
+    Queue consumer_queue = consumer_.get_consumer_queue();
+    for (PartitionTask& task : tasks) {
+        task.queue.forward_to_queue(consumer_queue);
+    }
+    return total_applied;
+}
+
 template <typename K, typename V>
 void CompactedTopicProcessor<K, V>::on_assignment(TopicPartitionList& topic_partitions) {
     if (original_assignment_callback_) {
@@ -331,8 +551,18 @@ void CompactedTopicProcessor<K, V>::on_assignment(TopicPartitionList& topic_part
     while (iter != partition_offsets_.end()) {
         const TopicPartition& topic_partition = iter->first;
         if (partitions_found.count(topic_partition) == 0) {
-            event_handler_({ Event::CLEAR_ELEMENTS, topic_partition.get_topic(),
-                             topic_partition.get_partition() });
+            if (event_handler_) {
+                event_handler_({ Event::CLEAR_ELEMENTS, topic_partition.get_topic(),
+                                 topic_partition.get_partition() });
+            }
+            // Drop exactly this partition's entries from the materialized store
+            auto source_iter = partition_sources_.find(topic_partition);
+            if (source_iter != partition_sources_.end()) {
+                if (store_) {
+                    store_->erase_source(source_iter->second);
+                }
+                partition_sources_.erase(source_iter);
+            }
             iter = partition_offsets_.erase(iter);
         }
         else {
@@ -341,6 +571,15 @@ void CompactedTopicProcessor<K, V>::on_assignment(TopicPartitionList& topic_part
     }
 }
 
+template <typename K, typename V>
+uint32_t CompactedTopicProcessor<K, V>::get_source_id(const TopicPartition& topic_partition) {
+    auto iter = partition_sources_.find(topic_partition);
+    if (iter == partition_sources_.end()) {
+        iter = partition_sources_.emplace(topic_partition, next_source_id_++).first;
+    }
+    return iter->second;
+}
+
 } // cppkafka
 
 #endif // CPPKAFKA_COMPACTED_TOPIC_PROCESSOR_H
@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_COMPACTED_TOPIC_STORE_H
+#define CPPKAFKA_COMPACTED_TOPIC_STORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include "../buffer.h"
+#include "payload_arena.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Flat hash map materializing the live key set of compacted topics
+ *
+ * Keys and values are raw byte strings copied into a PayloadArena; the table itself
+ * is a single flat vector of small slots using open addressing with linear probing
+ * and backward-shift deletion. Compared to a node based std::unordered_map mirror
+ * this avoids one heap allocation and ~32 bytes of node/pointer overhead per entry,
+ * which is what dominates memory usage when mirroring topics with tens of millions
+ * of keys.
+ *
+ * Each entry carries an opaque 32 bit source tag so a whole partition's worth of
+ * keys can be dropped on revocation (see erase_source) without touching the rest.
+ *
+ * Iteration yields non-owning Buffer views over the stored bytes. Iterators and
+ * views stay valid as long as the store is not modified; the store performs no
+ * internal synchronization, so snapshots are consistent by virtue of the poll loop
+ * being single threaded.
+ *
+ * \sa CompactedTopicProcessor::enable_store
+ */
+class CompactedTopicStore {
+public:
+    /**
+     * Default initial slot count
+     */
+    static constexpr size_t DEFAULT_INITIAL_CAPACITY = 1024;
+
+    /**
+     * A stored entry, viewed through non-owning buffers
+     */
+    struct Entry {
+        Buffer key;
+        Buffer value;
+        uint32_t source;
+    };
+
+    /**
+     * Forward iterator over the stored entries, in unspecified order
+     */
+    class const_iterator {
+    public:
+        const_iterator(const CompactedTopicStore* store, size_t index)
+        : store_(store), index_(index) {
+            advance_to_occupied();
+        }
+
+        Entry operator*() const {
+            const Slot& slot = store_->slots_[index_];
+            return Entry{ Buffer(slot.key, slot.key_size),
+                          Buffer(slot.value, slot.value_size), slot.source };
+        }
+
+        const_iterator& operator++() {
+            ++index_;
+            advance_to_occupied();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
+
+        bool operator!=(const const_iterator& rhs) const {
+            return !(*this == rhs);
+        }
+    private:
+        void advance_to_occupied() {
+            while (index_ < store_->slots_.size() && !store_->slots_[index_].key) {
+                ++index_;
+            }
+        }
+
+        const CompactedTopicStore* store_;
+        size_t index_;
+    };
+
+    /**
+     * \brief Constructs a store
+     *
+     * \param initial_capacity The initial slot count (rounded up to a power of two)
+     */
+    explicit CompactedTopicStore(size_t initial_capacity = DEFAULT_INITIAL_CAPACITY)
+    : slots_(round_up_to_power_of_two(initial_capacity < 8 ? 8 : initial_capacity)) {
+    }
+
+    CompactedTopicStore(const CompactedTopicStore&) = delete;
+    CompactedTopicStore& operator=(const CompactedTopicStore&) = delete;
+
+    ~CompactedTopicStore() {
+        clear();
+    }
+
+    /**
+     * \brief Inserts or replaces the value stored under the given key
+     *
+     * Both key and value bytes are copied into the store's arena.
+     *
+     * \param key The key bytes
+     * \param value The value bytes
+     * \param source Opaque tag the entry can later be dropped by (see erase_source)
+     */
+    void set(const Buffer& key, const Buffer& value, uint32_t source = 0) {
+        maybe_grow();
+        const uint64_t hash = hash_bytes(key.get_data(), key.get_size());
+        size_t index = hash & mask();
+        while (slots_[index].key) {
+            Slot& slot = slots_[index];
+            if (slot.hash == hash && keys_equal(slot, key)) {
+                // Replace in place
+                release_bytes(slot.value);
+                slot.value = copy_bytes(value.get_data(), value.get_size());
+                slot.value_size = static_cast<uint32_t>(value.get_size());
+                slot.source = source;
+                return;
+            }
+            index = (index + 1) & mask();
+        }
+        Slot& slot = slots_[index];
+        slot.key = copy_key_bytes(key.get_data(), key.get_size());
+        slot.key_size = static_cast<uint32_t>(key.get_size());
+        slot.value = copy_bytes(value.get_data(), value.get_size());
+        slot.value_size = static_cast<uint32_t>(value.get_size());
+        slot.hash = hash;
+        slot.source = source;
+        ++size_;
+    }
+
+    /**
+     * \brief Looks up the value stored under the given key
+     *
+     * \param key The key bytes
+     *
+     * \return A non-owning view of the value, or an empty optional if the key is
+     *         not present. The view is invalidated by the next modification.
+     */
+    std::optional<Buffer> get(const Buffer& key) const {
+        const size_t index = find(key);
+        if (index == NOT_FOUND) {
+            return std::nullopt;
+        }
+        return Buffer(slots_[index].value, slots_[index].value_size);
+    }
+
+    /**
+     * \brief Removes the entry stored under the given key
+     *
+     * \param key The key bytes
+     *
+     * \return true if an entry was removed
+     */
+    bool erase(const Buffer& key) {
+        size_t index = find(key);
+        if (index == NOT_FOUND) {
+            return false;
+        }
+        release_slot(slots_[index]);
+        // Backward-shift deletion: pull successors of the probe chain into the hole
+        // so lookups never need tombstones
+        size_t hole = index;
+        size_t next = (hole + 1) & mask();
+        while (slots_[next].key) {
+            const size_t ideal = slots_[next].hash & mask();
+            if (((next - ideal) & mask()) >= ((next - hole) & mask())) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+            next = (next + 1) & mask();
+        }
+        slots_[hole] = Slot{};
+        --size_;
+        return true;
+    }
+
+    /**
+     * \brief Removes every entry carrying the given source tag
+     *
+     * \param source The tag to drop
+     *
+     * \return The amount of entries removed
+     */
+    size_t erase_source(uint32_t source) {
+        std::vector<Slot> old_slots(slots_.size());
+        old_slots.swap(slots_);
+        size_t removed = 0;
+        size_ = 0;
+        for (Slot& slot : old_slots) {
+            if (!slot.key) {
+                continue;
+            }
+            if (slot.source == source) {
+                release_slot(slot);
+                ++removed;
+            }
+            else {
+                reinsert(slot);
+            }
+        }
+        return removed;
+    }
+
+    /**
+     * Removes all entries
+     */
+    void clear() {
+        for (Slot& slot : slots_) {
+            if (slot.key) {
+                release_slot(slot);
+                slot = Slot{};
+            }
+        }
+        size_ = 0;
+    }
+
+    /**
+     * Gets the amount of stored entries
+     */
+    size_t get_size() const {
+        return size_;
+    }
+
+    /**
+     * Indicates whether the store is empty
+     */
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Gets the current slot count
+     */
+    size_t get_capacity() const {
+        return slots_.size();
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, slots_.size());
+    }
+private:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    struct Slot {
+        const uint8_t* key{nullptr};
+        const uint8_t* value{nullptr};
+        uint64_t hash{0};
+        uint32_t key_size{0};
+        uint32_t value_size{0};
+        uint32_t source{0};
+    };
+
+    // FNV-1a
+    static uint64_t hash_bytes(const uint8_t* data, size_t size) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    static size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static bool keys_equal(const Slot& slot, const Buffer& key) {
+        return slot.key_size == key.get_size() &&
+               (slot.key_size == 0 ||
+                std::memcmp(slot.key, key.get_data(), slot.key_size) == 0);
+    }
+
+    size_t mask() const {
+        return slots_.size() - 1;
+    }
+
+    size_t find(const Buffer& key) const {
+        const uint64_t hash = hash_bytes(key.get_data(), key.get_size());
+        size_t index = hash & mask();
+        while (slots_[index].key) {
+            if (slots_[index].hash == hash && keys_equal(slots_[index], key)) {
+                return index;
+            }
+            index = (index + 1) & mask();
+        }
+        return NOT_FOUND;
+    }
+
+    // Keys are always backed by at least one arena byte so a stored empty key is
+    // still distinguishable from a free slot
+    const uint8_t* copy_key_bytes(const uint8_t* data, size_t size) {
+        void* copy = arena_.allocate(size > 0 ? size : 1);
+        if (size > 0) {
+            std::memcpy(copy, data, size);
+        }
+        return static_cast<const uint8_t*>(copy);
+    }
+
+    const uint8_t* copy_bytes(const uint8_t* data, size_t size) {
+        if (size == 0) {
+            return nullptr;
+        }
+        void* copy = arena_.allocate(size);
+        std::memcpy(copy, data, size);
+        return static_cast<const uint8_t*>(copy);
+    }
+
+    void release_bytes(const uint8_t* data) {
+        if (data) {
+            arena_.deallocate(const_cast<uint8_t*>(data));
+        }
+    }
+
+    void release_slot(Slot& slot) {
+        release_bytes(slot.key);
+        release_bytes(slot.value);
+    }
+
+    void maybe_grow() {
+        // Keep the load factor under 70%
+        if ((size_ + 1) * 10 < slots_.size() * 7) {
+            return;
+        }
+        std::vector<Slot> old_slots(slots_.size() * 2);
+        old_slots.swap(slots_);
+        size_ = 0;
+        for (Slot& slot : old_slots) {
+            if (slot.key) {
+                reinsert(slot);
+            }
+        }
+    }
+
+    // Re-inserts an existing slot without copying its bytes
+    void reinsert(const Slot& slot) {
+        size_t index = slot.hash & mask();
+        while (slots_[index].key) {
+            index = (index + 1) & mask();
+        }
+        slots_[index] = slot;
+        ++size_;
+    }
+
+    PayloadArena arena_;
+    std::vector<Slot> slots_;
+    size_t size_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_COMPACTED_TOPIC_STORE_H
@@ -30,7 +30,15 @@
 #ifndef CPPKAFKA_CONSUMER_DISPATCHER_H
 #define CPPKAFKA_CONSUMER_DISPATCHER_H
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
 #include "../consumer.h"
 #include "backoff_performer.h"
 
@@ -65,6 +73,10 @@ namespace cppkafka {
  *  - void(Message)
  *  - Message(Message). In this case if the message is returned, it will be buffered
  *  while calling the throttle callback until the message is actually processed.
+ *  - void(std::vector<Message>&&). In this case messages are gathered via
+ *  ConsumerType::poll_batch and handed over in bulk, which avoids per-message
+ *  dispatch overhead for vectorized processing. Messages carrying errors are
+ *  stripped from the batch and routed to the error/EOF callbacks individually.
  * * Timeout: void(BasicConsumerDispatcher::Timeout)
  * * Error: void(Error)
  * * EOF: void(BasicConsumerDispatcher::EndOfFile, TopicPartition)
@@ -104,11 +116,56 @@ public:
      *
      * This will loop until BasicConsumerDispatcher::stop is called
      *
+     * If the message callback takes a std::vector<Message>&& rather than a single
+     * Message, messages are polled in batches of up to get_batch_size() and
+     * delivered in bulk.
+     *
      * \param args The list of callbacks to be executed
      */
     template <typename... Args>
     void run(const Args&... args);
 
+    /**
+     * \brief Sets the maximum amount of messages polled at once in batch mode
+     *
+     * Only used when running with a batch message callback.
+     *
+     * \param batch_size The batch size (default 256)
+     */
+    void set_batch_size(size_t batch_size);
+
+    /**
+     * Gets the maximum amount of messages polled at once in batch mode
+     */
+    size_t get_batch_size() const;
+
+    /**
+     * \brief Consumes messages dispatching events to callbacks on a worker pool
+     *
+     * This behaves like BasicConsumerDispatcher::run except that the message, error
+     * and end of file callbacks are executed on a pool of worker threads while this
+     * thread keeps polling. Messages are grouped by partition and a partition is
+     * only ever processed by one worker at a time, so per-partition ordering is
+     * preserved. Idle workers steal pending partitions from their siblings, which
+     * keeps all workers busy when handler latency is uneven across partitions.
+     *
+     * Timeout callbacks and errors not associated with any partition are still
+     * executed on the calling thread. Any exception thrown by a callback on a
+     * worker stops consumption and is re-thrown from this function.
+     *
+     * This will loop until BasicConsumerDispatcher::stop is called; pending
+     * messages are drained before returning.
+     *
+     * \remark The message throttling protocol (a callback returning Message) is not
+     * supported in this mode; any returned message is discarded
+     *
+     * \param num_workers The number of worker threads. If 0, the amount of
+     * hardware threads is used
+     * \param args The list of callbacks to be executed
+     */
+    template <typename... Args>
+    void run_parallel(size_t num_workers, const Args&... args);
+
     /**
      * \brief Stops consumption
      *
@@ -119,11 +176,31 @@ public:
 private:
     // Define the types we need for each type of callback
     using OnMessageArgs = std::tuple<Message>;
+    using OnMessageBatchArgs = std::tuple<std::vector<Message>>;
     using OnErrorArgs = std::tuple<Error>;
     using OnEofArgs = std::tuple<EndOfFile, TopicPartition>;
     using OnTimeoutArgs = std::tuple<Timeout>;
     using OnEventArgs = std::tuple<Event>;
 
+    // Tags to pick the polling loop matching the provided message callback
+    struct single_dispatch_tag {};
+    struct batch_dispatch_tag {};
+
+    // Default size used when polling in batch mode
+    static constexpr size_t DEFAULT_BATCH_SIZE = 256;
+
+    // Scheduling state used by run_parallel
+    using PartitionKey = std::pair<std::string, int>;
+
+    struct PartitionState {
+        std::deque<Message> messages;
+        // Whether this partition is sitting in some worker's queue or being processed
+        bool scheduled{false};
+    };
+
+    // Maximum amount of messages buffered across all partitions before polling blocks
+    static constexpr size_t MAX_PENDING_MESSAGES = 64 * 1024;
+
     static void handle_error(Error error);
     static void handle_eof(EndOfFile, const TopicPartition& /*topic_partition*/) { }
     static void handle_timeout(Timeout) { }
@@ -253,6 +330,8 @@ private:
         static_assert(
             !std::is_same<type_not_found,
                           typename find_type<OnMessageArgs, Functor>::type>::value ||
+            !std::is_same<type_not_found,
+                          typename find_type<OnMessageBatchArgs, Functor>::type>::value ||
             !std::is_same<type_not_found,
                           typename find_type<OnEofArgs, Functor>::type>::value ||
             !std::is_same<type_not_found,
@@ -307,8 +386,16 @@ private:
         }
     }
 
+    // Polling loops behind run(); picked depending on the message callback type
+    template <typename... Args>
+    void run_impl(single_dispatch_tag, const Args&... args);
+
+    template <typename... Args>
+    void run_impl(batch_dispatch_tag, const Args&... args);
+
     ConsumerType& consumer_;
     bool running_;
+    size_t batch_size_{DEFAULT_BATCH_SIZE};
 };
 
 using ConsumerDispatcher = BasicConsumerDispatcher<Consumer>;
@@ -329,15 +416,37 @@ void BasicConsumerDispatcher<ConsumerType>::handle_error(Error error) {
     throw ConsumerException(error);
 }
 
+template <typename ConsumerType>
+void BasicConsumerDispatcher<ConsumerType>::set_batch_size(size_t batch_size) {
+    batch_size_ = batch_size;
+}
+
+template <typename ConsumerType>
+size_t BasicConsumerDispatcher<ConsumerType>::get_batch_size() const {
+    return batch_size_;
+}
+
 template <typename ConsumerType>
 template <typename... Args>
 void BasicConsumerDispatcher<ConsumerType>::run(const Args&... args) {
-    using self = BasicConsumerDispatcher<ConsumerType>;
-    
     // Make sure all callbacks match one of the signatures. Otherwise users could provide
     // bogus callbacks that would never be executed
     check_callbacks_match(args...);
 
+    // If a batch message callback was provided, poll and deliver in batches
+    using dispatch_tag = typename std::conditional<
+        std::is_same<type_not_found,
+                     typename find_type<OnMessageBatchArgs, Args...>::type>::value,
+        single_dispatch_tag,
+        batch_dispatch_tag>::type;
+    run_impl(dispatch_tag{}, args...);
+}
+
+template <typename ConsumerType>
+template <typename... Args>
+void BasicConsumerDispatcher<ConsumerType>::run_impl(single_dispatch_tag, const Args&... args) {
+    using self = BasicConsumerDispatcher<ConsumerType>;
+
     // This one is required
     const auto on_message = find_matching_functor<OnMessageArgs>(args...);
 
@@ -368,6 +477,229 @@ void BasicConsumerDispatcher<ConsumerType>::run(const Args&... args) {
     }
 }
 
+template <typename ConsumerType>
+template <typename... Args>
+void BasicConsumerDispatcher<ConsumerType>::run_impl(batch_dispatch_tag, const Args&... args) {
+    using self = BasicConsumerDispatcher<ConsumerType>;
+
+    // This one is required
+    const auto on_message_batch = find_matching_functor<OnMessageBatchArgs>(args...);
+
+    // For the rest, append our own implementation at the end as a fallback
+    const auto on_error = find_matching_functor<OnErrorArgs>(args..., &self::handle_error);
+    const auto on_eof = find_matching_functor<OnEofArgs>(args..., &self::handle_eof);
+    const auto on_timeout = find_matching_functor<OnTimeoutArgs>(args..., &self::handle_timeout);
+    const auto on_event = find_matching_functor<OnEventArgs>(args..., &self::handle_event);
+
+    running_ = true;
+    while (running_) {
+        std::vector<Message> messages = consumer_.poll_batch(batch_size_);
+        if (messages.empty()) {
+            on_timeout(Timeout{});
+        }
+        else {
+            // Route errors and EOFs individually, compacting the rest in place so the
+            // batch callback only ever sees valid messages
+            size_t clean_count = 0;
+            for (size_t i = 0; i != messages.size(); ++i) {
+                Message& msg = messages[i];
+                if (msg.get_error()) {
+                    if (msg.is_eof()) {
+                        on_eof(EndOfFile{}, { msg.get_topic(), msg.get_partition(),
+                                              msg.get_offset() });
+                    }
+                    else {
+                        on_error(msg.get_error());
+                    }
+                }
+                else {
+                    if (clean_count != i) {
+                        messages[clean_count] = std::move(msg);
+                    }
+                    ++clean_count;
+                }
+            }
+            messages.resize(clean_count);
+            if (!messages.empty()) {
+                on_message_batch(std::move(messages));
+            }
+        }
+        on_event(Event{});
+    }
+}
+
+template <typename ConsumerType>
+template <typename... Args>
+void BasicConsumerDispatcher<ConsumerType>::run_parallel(size_t num_workers,
+                                                         const Args&... args) {
+    using self = BasicConsumerDispatcher<ConsumerType>;
+
+    check_callbacks_match(args...);
+
+    const auto on_message = find_matching_functor<OnMessageArgs>(args...);
+    const auto on_error = find_matching_functor<OnErrorArgs>(args..., &self::handle_error);
+    const auto on_eof = find_matching_functor<OnEofArgs>(args..., &self::handle_eof);
+    const auto on_timeout = find_matching_functor<OnTimeoutArgs>(args..., &self::handle_timeout);
+    const auto on_event = find_matching_functor<OnEventArgs>(args..., &self::handle_event);
+
+    if (num_workers == 0) {
+        const unsigned int hardware_threads = std::thread::hardware_concurrency();
+        num_workers = hardware_threads > 0 ? hardware_threads : 1;
+    }
+
+    // All scheduling state is guarded by a single mutex; callbacks always run
+    // outside of it
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable space_available;
+    std::map<PartitionKey, PartitionState> partitions;
+    std::vector<std::deque<PartitionKey>> worker_queues(num_workers);
+    std::exception_ptr worker_error;
+    size_t pending_messages = 0;
+    size_t next_worker = 0;
+
+    const auto dispatch_one = [&](Message msg) {
+        if (msg.get_error()) {
+            if (msg.is_eof()) {
+                on_eof(EndOfFile{}, { msg.get_topic(), msg.get_partition(), msg.get_offset() });
+            }
+            else {
+                on_error(msg.get_error());
+            }
+        }
+        else {
+            on_message(std::move(msg));
+        }
+    };
+
+    const auto worker_loop = [&](size_t index) {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        while (true) {
+            // Prefer our own queue, otherwise steal the oldest partition of a sibling
+            std::deque<PartitionKey>* queue = nullptr;
+            if (!worker_queues[index].empty()) {
+                queue = &worker_queues[index];
+            }
+            else {
+                for (std::deque<PartitionKey>& other : worker_queues) {
+                    if (!other.empty()) {
+                        queue = &other;
+                        break;
+                    }
+                }
+            }
+            if (!queue) {
+                if (!running_ || worker_error) {
+                    // No more work is coming and everything was drained
+                    return;
+                }
+                work_available.wait(lock);
+                continue;
+            }
+            const PartitionKey key = queue->front();
+            queue->pop_front();
+            PartitionState& state = partitions[key];
+            // Take the whole backlog for this partition; it stays marked as scheduled
+            // so nobody else picks it up while we're processing it
+            std::deque<Message> batch;
+            batch.swap(state.messages);
+            pending_messages -= batch.size();
+            space_available.notify_one();
+            lock.unlock();
+            try {
+                for (Message& msg : batch) {
+                    dispatch_one(std::move(msg));
+                }
+            }
+            catch (...) {
+                lock.lock();
+                if (!worker_error) {
+                    worker_error = std::current_exception();
+                }
+                running_ = false;
+                work_available.notify_all();
+                space_available.notify_all();
+                continue;
+            }
+            lock.lock();
+            if (!state.messages.empty()) {
+                // More messages arrived meanwhile, re-queue the partition locally
+                worker_queues[index].push_back(key);
+                work_available.notify_one();
+            }
+            else {
+                state.scheduled = false;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers);
+    running_ = true;
+    for (size_t i = 0; i != num_workers; ++i) {
+        workers.emplace_back(worker_loop, i);
+    }
+
+    // The polling thread's own callbacks may throw (the default on_error
+    // handler does, for consumer errors not attributable to a partition); the
+    // workers must be stopped and joined before the exception escapes, or the
+    // joinable threads would take the whole process down via std::terminate
+    try {
+        while (running_) {
+            Message msg = consumer_.poll();
+            if (!msg) {
+                on_timeout(Timeout{});
+            }
+            else if (msg.get_error() && !msg.is_eof() && msg.get_topic().empty()) {
+                // Not attributable to any partition, handle it on this thread
+                on_error(msg.get_error());
+            }
+            else {
+                PartitionKey key{ msg.get_topic(), msg.get_partition() };
+                std::unique_lock<std::mutex> lock(state_mutex);
+                space_available.wait(lock, [&]() {
+                    return pending_messages < MAX_PENDING_MESSAGES || !running_;
+                });
+                if (!running_) {
+                    break;
+                }
+                PartitionState& state = partitions[key];
+                state.messages.push_back(std::move(msg));
+                ++pending_messages;
+                if (!state.scheduled) {
+                    state.scheduled = true;
+                    worker_queues[next_worker++ % num_workers].push_back(key);
+                }
+                work_available.notify_one();
+            }
+            on_event(Event{});
+        }
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> _(state_mutex);
+            running_ = false;
+            work_available.notify_all();
+            space_available.notify_all();
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> _(state_mutex);
+        work_available.notify_all();
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (worker_error) {
+        std::rethrow_exception(worker_error);
+    }
+}
+
 } // cppkafka
 
 #endif // CPPKAFKA_CONSUMER_DISPATCHER_H
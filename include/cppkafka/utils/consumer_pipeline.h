@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_CONSUMER_PIPELINE_H
+#define CPPKAFKA_CONSUMER_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "backoff_committer.h"
+#include "mpsc_ring_buffer.h"
+
+namespace cppkafka {
+
+/**
+ * \class ConsumerPipeline
+ *
+ * \brief Overlapped consume, process and commit stages over one Consumer
+ *
+ * Services tend to hand-roll the same three stage pipeline: a thread polling
+ * batches, a pool of workers decoding and processing the messages, and commit
+ * logic that must only advance offsets completed in order, even though the
+ * workers finish out of order. ConsumerPipeline packages that: a poll thread
+ * feeds messages through bounded lock-free channels (one ring per worker, fed
+ * round robin) to the processing workers; each completed message is marked in a
+ * per-partition completion bitmap, and the poll thread periodically commits the
+ * contiguous completion frontier of every partition through a BackoffCommitter.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * ConsumerPipeline pipeline(consumer, 4);
+ * pipeline.set_process_callback([](Message& message) {
+ *     // decode and handle the message; runs on a worker thread
+ * });
+ * pipeline.start();
+ * // ...
+ * pipeline.stop();
+ * \endcode
+ *
+ * Marking an offset complete is a single atomic fetch_or into the partition's
+ * bitmap window and pushing a message to a worker is a compare-and-swap on its
+ * ring, so the steady state takes no locks.
+ *
+ * \remark Messages of one partition may be processed concurrently by different
+ * workers; per-partition processing order is not preserved. A message is marked
+ * complete once the processing callback returns, including when it throws (the
+ * exception is routed through the consumer's error callback), so delivery is
+ * at-least-once with respect to commits but failed messages are not retried.
+ *
+ * \warning Disable enable.auto.commit; the pipeline owns offset commits. On
+ * revocation, commit_ready() may be called from a revocation callback (it runs
+ * on the poll thread) to commit completed work before the partitions move.
+ */
+class CPPKAFKA_API ConsumerPipeline {
+public:
+    /**
+     * Callback invoked on a worker thread for every consumed message
+     */
+    using ProcessCallback = std::function<void(Message&)>;
+
+    /**
+     * Default per-partition completion window, in offsets
+     */
+    static constexpr size_t DEFAULT_WINDOW_SIZE = 64 * 1024;
+
+    /**
+     * Default amount of slots in each worker's channel
+     */
+    static constexpr size_t DEFAULT_CHANNEL_CAPACITY = 1024;
+
+    /**
+     * \brief Constructor
+     *
+     * \param consumer The consumer to poll and commit through. Must outlive this
+     *                 instance and should already be subscribed.
+     * \param num_workers The amount of processing workers. Defaults to the number
+     *                    of hardware threads minus one (leaving one for the poll
+     *                    stage).
+     */
+    explicit ConsumerPipeline(Consumer& consumer, size_t num_workers = 0);
+
+    /**
+     * \brief Destructor. Stops the pipeline if still running.
+     */
+    ~ConsumerPipeline();
+
+    ConsumerPipeline(const ConsumerPipeline&) = delete;
+    ConsumerPipeline& operator=(const ConsumerPipeline&) = delete;
+
+    /**
+     * \brief Sets the message processing callback
+     *
+     * Must be called before start().
+     *
+     * \param callback The callback to be set
+     */
+    void set_process_callback(ProcessCallback callback);
+
+    /**
+     * \brief Sets the maximum amount of messages fetched per poll
+     *
+     * \param batch_size The batch size (default 64)
+     */
+    void set_poll_batch_size(size_t batch_size);
+
+    /**
+     * \brief Sets how often completed offsets are committed
+     *
+     * \param interval The commit interval (default 100 milliseconds)
+     */
+    void set_commit_interval(std::chrono::milliseconds interval);
+
+    /**
+     * \brief Sets the per-partition completion window, in offsets
+     *
+     * The window bounds how far ahead of the oldest uncompleted offset a
+     * partition may run; the poll stage stalls on a partition that exhausts it.
+     * Rounded up to a multiple of 64. Must be called before start().
+     *
+     * \param window_size The window size (default DEFAULT_WINDOW_SIZE)
+     */
+    void set_window_size(size_t window_size);
+
+    /**
+     * \brief Sets the capacity of each worker's channel
+     *
+     * Must be called before start().
+     *
+     * \param capacity The amount of slots (default DEFAULT_CHANNEL_CAPACITY)
+     */
+    void set_channel_capacity(size_t capacity);
+
+    /**
+     * \brief Gets the committer used for offset commits
+     *
+     * Exposed so its backoff policy and error callback can be tuned.
+     */
+    BackoffCommitter& get_committer();
+
+    /**
+     * Gets the consumer this pipeline polls
+     */
+    Consumer& get_consumer();
+
+    /**
+     * \brief Starts the poll and worker threads
+     */
+    void start();
+
+    /**
+     * \brief Stops the pipeline
+     *
+     * The poll thread exits first, the workers then drain their channels, and
+     * whatever completed in the meantime is committed before returning.
+     */
+    void stop();
+
+    /**
+     * \brief Commits every partition's completed frontier now
+     *
+     * Safe to call from the poll thread only, which includes rebalance
+     * callbacks fired from within the consumer's poll.
+     */
+    void commit_ready();
+private:
+    struct PartitionWindow {
+        PartitionWindow(int64_t first_offset, size_t num_words);
+
+        // Marks an offset as processed. Callable from any thread.
+        void mark(int64_t offset);
+
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        size_t num_words;
+        // All fields below are owned by the poll thread
+        int64_t window_start; // word aligned; offsets below are complete and cleared
+        int64_t next_offset; // next offset the poll stage expects from the partition
+        int64_t commit_frontier; // first offset not yet known to be complete
+        int64_t committed_frontier; // last frontier handed to the committer
+    };
+
+    struct Item {
+        Item(Message message, PartitionWindow* window, int64_t offset)
+        : message(std::move(message)), window(window), offset(offset) {
+        }
+
+        Message message;
+        PartitionWindow* window;
+        int64_t offset;
+    };
+
+    static const std::chrono::milliseconds POLL_INTERVAL;
+    static const std::chrono::milliseconds IDLE_WAIT_INTERVAL;
+
+    void poll_loop();
+    void worker_loop(size_t index);
+    bool enqueue(Message message);
+    bool wait_for_capacity(PartitionWindow& window, int64_t offset);
+    PartitionWindow& get_window(const TopicPartition& topic_partition, int64_t offset);
+    static void advance(PartitionWindow& window);
+
+    Consumer& consumer_;
+    BackoffCommitter committer_;
+    ProcessCallback process_callback_;
+    std::map<TopicPartition, std::unique_ptr<PartitionWindow>> windows_;
+    // Windows replaced after a seek/rebalance discontinuity are kept alive here
+    // until the next start() since in-flight items may still mark into them
+    std::vector<std::unique_ptr<PartitionWindow>> retired_windows_;
+    std::vector<std::unique_ptr<MpscRingBuffer<Item>>> channels_;
+    std::vector<std::thread> workers_;
+    std::thread poll_thread_;
+    std::chrono::milliseconds commit_interval_{100};
+    size_t num_workers_;
+    size_t poll_batch_size_{64};
+    size_t window_size_{DEFAULT_WINDOW_SIZE};
+    size_t channel_capacity_{DEFAULT_CHANNEL_CAPACITY};
+    size_t next_channel_{0};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> poll_done_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_CONSUMER_PIPELINE_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_EVENT_DRIVEN_POLL_STRATEGY_H
+#define CPPKAFKA_EVENT_DRIVEN_POLL_STRATEGY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "../queue.h"
+#include "poll_strategy_base.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Readiness-driven polling of the assigned partition queues
+ *
+ * Like RoundRobinPollStrategy this adapter takes over the partition queues of the
+ * consumer, but instead of sweeping all queues on every call it registers a
+ * librdkafka event callback (rd_kafka_queue_cb_event_enable) on each of them.
+ * The callback marks a queue as ready the moment it goes from empty to non-empty,
+ * so poll() only ever touches queues that actually hold messages and blocks on a
+ * condition variable otherwise. Under heavily skewed partitions this removes the
+ * latency of probing empty queues altogether.
+ *
+ * The main consumer queue participates in the same readiness mechanism, so group
+ * events and rebalances wake a blocked poll() immediately. Ready queues are
+ * serviced in FIFO order of becoming ready, which keeps servicing fair when
+ * several partitions have pending messages.
+ *
+ * Usage is identical to RoundRobinPollStrategy:
+ *
+ * \code
+ * Consumer consumer(...);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * EventDrivenPollStrategy poll_strategy(consumer);
+ * while (true) {
+ *     Message msg = poll_strategy.poll();
+ *     ...
+ * }
+ * \endcode
+ *
+ * \warning Calling directly poll() or poll_batch() on the Consumer object while using
+ * this adapter will lead to undesired results since it modifies the internal queuing
+ * mechanism of the Consumer instance it owns.
+ *
+ * \warning poll() and poll_batch() must be called from a single thread.
+ */
+class CPPKAFKA_API EventDrivenPollStrategy : public PollStrategyBase {
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param consumer A reference to the polled consumer instance
+     */
+    EventDrivenPollStrategy(Consumer& consumer);
+
+    ~EventDrivenPollStrategy();
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll() override;
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll(std::chrono::milliseconds timeout) override;
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size) override;
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size,
+                                    std::chrono::milliseconds timeout) override;
+
+    /**
+     * \sa PollStrategyBase::assign
+     */
+    void assign(TopicPartitionList& partitions) override;
+
+    /**
+     * \sa PollStrategyBase::revoke
+     */
+    void revoke(const TopicPartitionList& partitions) override;
+
+    /**
+     * \sa PollStrategyBase::revoke
+     */
+    void revoke() override;
+
+protected:
+    /**
+     * \brief Re-registers the readiness callbacks on all queues
+     *
+     * \sa PollStrategyBase::reset_state
+     */
+    void reset_state() final;
+
+private:
+    // Readiness bookkeeping for one queue. Addresses must stay stable while the
+    // librdkafka callback is registered.
+    struct ReadyContext {
+        EventDrivenPollStrategy*    strategy;
+        QueueData*                  queue_data;
+        rd_kafka_queue_t*           queue_handle;
+        bool                        ready{false};
+    };
+
+    static void queue_ready_trampoline(rd_kafka_t* handle, void* opaque);
+    void handle_queue_ready(ReadyContext* context);
+    void enable_ready_callback(QueueData& queue_data);
+    void disable_ready_callbacks();
+    void purge_ready_state();
+    ReadyContext* pop_ready(std::chrono::steady_clock::time_point deadline, bool wait);
+    void requeue_or_clear(ReadyContext* context, bool got_messages);
+    void restore_forwarding();
+
+    // Members
+    std::vector<std::unique_ptr<ReadyContext>>  contexts_;
+    std::deque<ReadyContext*>                   ready_contexts_;
+    std::mutex                                  ready_mutex_;
+    std::condition_variable                     ready_cv_;
+};
+
+} //cppkafka
+
+#endif //CPPKAFKA_EVENT_DRIVEN_POLL_STRATEGY_H
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_HANDLE_EVENT_LOOP_H
+#define CPPKAFKA_HANDLE_EVENT_LOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <librdkafka/rdkafka.h>
+#include "../consumer.h"
+#include "../macros.h"
+#include "../message.h"
+#include "../producer.h"
+#include "../queue.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Services many Producer/Consumer handles from a single thread
+ *
+ * A process running dozens of low-volume handles typically dedicates one mostly
+ * sleeping poll() thread to each of them. This class reclaims those threads:
+ * every producer's main event queue is forwarded (Queue::forward_to_queue) into
+ * the first producer's queue, so one rd_kafka_queue_poll loop serves the
+ * delivery report, error and statistics callbacks of all producers - librdkafka
+ * ops carry their own callback and opaque, so each callback still fires against
+ * the handle that produced it. Consumer queues are kept separate (messages
+ * carry no handle identity once merged) but are serviced from the same thread:
+ * each queue's event notification (Queue::enable_event_callback) marks the
+ * consumer ready and wakes the loop, which then consumes a bounded batch per
+ * consumer per cycle in round robin order, so one busy consumer can't starve
+ * the other 39.
+ *
+ * The loop thread sleeps on a condition variable whenever every queue is empty;
+ * there are no periodic wakeups beyond a coarse safety timeout.
+ *
+ * Example:
+ *
+ * \code
+ * HandleEventLoop loop;
+ * for (Producer& producer : producers) {
+ *     loop.add_producer(producer);
+ * }
+ * for (Consumer& consumer : consumers) {
+ *     loop.add_consumer(consumer, [&](Consumer& owner, Message message) {
+ *         // process message; owner identifies the handle it came from
+ *     });
+ * }
+ * loop.start();
+ * // ...
+ * loop.stop();
+ * \endcode
+ *
+ * \warning All handles must be registered before calling start() and must
+ * outlive the loop. Callbacks run on the loop thread; a blocking callback
+ * stalls every registered handle.
+ */
+class CPPKAFKA_API HandleEventLoop {
+public:
+    /**
+     * Callback invoked for each message consumed from a registered consumer
+     */
+    using MessageCallback = std::function<void(Consumer&, Message)>;
+
+    /**
+     * Default maximum amount of messages consumed per consumer per cycle
+     */
+    static constexpr size_t DEFAULT_MAX_MESSAGES_PER_TURN = 64;
+
+    HandleEventLoop();
+
+    /**
+     * \brief Destructor. Stops the loop thread if still running.
+     */
+    ~HandleEventLoop();
+
+    HandleEventLoop(const HandleEventLoop&) = delete;
+    HandleEventLoop& operator=(const HandleEventLoop&) = delete;
+
+    /**
+     * \brief Registers a producer
+     *
+     * The first registered producer's main queue becomes the master queue; the
+     * main queues of all subsequent producers are forwarded into it. The
+     * producer's poll() no longer needs to be (and should not be) called.
+     *
+     * \param producer The producer to be serviced by this loop
+     */
+    void add_producer(Producer& producer);
+
+    /**
+     * \brief Registers a consumer
+     *
+     * Messages consumed from the consumer's queue are handed to the given
+     * callback; rebalance and commit callbacks fire from the loop thread as
+     * they would from poll().
+     *
+     * \param consumer The consumer to be serviced by this loop
+     * \param callback The callback invoked for each of its messages
+     */
+    void add_consumer(Consumer& consumer, MessageCallback callback);
+
+    /**
+     * \brief Sets the per-consumer batch bound of one scheduling cycle
+     *
+     * Larger values amortize scheduling overhead; smaller ones tighten the
+     * latency bound a backlogged consumer can impose on the others.
+     *
+     * \param max_messages The maximum messages consumed per consumer per cycle
+     */
+    void set_max_messages_per_turn(size_t max_messages);
+
+    /**
+     * \brief Starts the loop thread
+     *
+     * \remark Throws Exception if the loop is already running
+     */
+    void start();
+
+    /**
+     * \brief Stops the loop thread
+     *
+     * Blocks until the current scheduling cycle finishes.
+     */
+    void stop();
+
+    /**
+     * Indicates whether the loop thread is running
+     */
+    bool is_running() const;
+
+    /**
+     * \brief Runs one scheduling cycle on the calling thread
+     *
+     * Drains the master event queue and consumes up to the per-turn bound from
+     * every ready consumer. Meant for applications that already own an event
+     * loop thread and only need the servicing logic.
+     *
+     * \return The number of messages and events serviced
+     */
+    size_t run_once();
+private:
+    struct ConsumerEntry {
+        HandleEventLoop* loop;
+        Consumer* consumer;
+        Queue queue;
+        MessageCallback callback;
+        // Set by the queue's event notification, cleared once drained
+        std::atomic<bool> ready{true};
+    };
+
+    static void queue_ready_proxy(rd_kafka_t* handle, void* opaque);
+    static void master_ready_proxy(rd_kafka_t* handle, void* opaque);
+
+    void ensure_not_running() const;
+    void event_loop();
+    size_t drain_master_queue();
+    size_t drain_consumer(ConsumerEntry& entry);
+    void wake_up();
+
+    std::vector<std::unique_ptr<ConsumerEntry>> consumers_;
+    Queue master_queue_;
+    std::vector<Message> message_buffer_;
+    std::thread loop_thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> master_ready_{true};
+    bool wake_up_pending_{false};
+    size_t max_messages_per_turn_{DEFAULT_MAX_MESSAGES_PER_TURN};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_HANDLE_EVENT_LOOP_H
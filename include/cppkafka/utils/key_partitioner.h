@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_KEY_PARTITIONER_H
+#define CPPKAFKA_KEY_PARTITIONER_H
+
+#include <cstdint>
+#include <vector>
+#include "../buffer.h"
+#include "../macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Application-side keyed partitioning without the per-message callback trip
+ *
+ * TopicConfiguration::set_partitioner_callback routes every produced message
+ * through a C trampoline and hashes its key inside librdkafka. When the
+ * application wants to know the partition up front anyway (keyed batching,
+ * partition-affine queues, produce_batch with explicit partitions), it is cheaper
+ * to compute it in-process: this class exposes the same hash kernels librdkafka's
+ * stock partitioners use - murmur2 as in the Java client's default partitioner
+ * and CRC32-C - plus a batch interface that partitions N keys in one call. The
+ * CRC32-C kernel dispatches to the SSE4.2 crc32 instruction at runtime when the
+ * CPU supports it and falls back to a table-driven implementation otherwise.
+ *
+ * Partitions computed with HashFunction::MURMUR2 match librdkafka's murmur2
+ * partitioner (and therefore the Java client's default), so messages produced
+ * with an explicit partition land where callback-partitioned ones would.
+ *
+ * Example:
+ *
+ * \code
+ * KeyPartitioner partitioner; // murmur2
+ * std::vector<int32_t> partitions(keys.size());
+ * partitioner.get_partitions(keys.data(), keys.size(), partition_count,
+ *                            partitions.data());
+ * for (size_t i = 0; i < keys.size(); ++i) {
+ *     producer.produce(MessageBuilder(topic).partition(partitions[i])
+ *                                           .key(keys[i]).payload(payloads[i]));
+ * }
+ * \endcode
+ */
+class CPPKAFKA_API KeyPartitioner {
+public:
+    /**
+     * The hash kernel used for partition selection
+     */
+    enum class HashFunction {
+        MURMUR2,
+        CRC32C
+    };
+
+    /**
+     * Constructs a murmur2 partitioner
+     */
+    KeyPartitioner();
+
+    /**
+     * \brief Constructs a partitioner using the given hash kernel
+     *
+     * \param hash_function The hash kernel to use
+     */
+    explicit KeyPartitioner(HashFunction hash_function);
+
+    /**
+     * \brief Computes the partition for one key
+     *
+     * \param key The message key bytes
+     * \param partition_count The amount of partitions of the topic
+     *
+     * \return The partition, in the range [0, partition_count)
+     *
+     * \remark Throws Exception if partition_count is not positive
+     */
+    int32_t get_partition(const Buffer& key, int32_t partition_count) const;
+
+    /**
+     * \brief Computes the partitions for a batch of keys in one call
+     *
+     * \param keys Pointer to the first of count keys
+     * \param count The amount of keys
+     * \param partition_count The amount of partitions of the topic
+     * \param partitions Output array of count partitions
+     *
+     * \remark Throws Exception if partition_count is not positive
+     */
+    void get_partitions(const Buffer* keys, size_t count, int32_t partition_count,
+                        int32_t* partitions) const;
+
+    /**
+     * \brief Computes the partitions for a batch of keys in one call
+     *
+     * \param keys The keys
+     * \param partition_count The amount of partitions of the topic
+     *
+     * \return One partition per key, in order
+     */
+    std::vector<int32_t> get_partitions(const std::vector<Buffer>& keys,
+                                        int32_t partition_count) const;
+
+    /**
+     * \brief Computes the murmur2 hash of the given bytes
+     *
+     * Uses the same seed as librdkafka's murmur2 partitioner and the Java
+     * client, so the values are interchangeable across clients.
+     */
+    static uint32_t murmur2(const void* data, size_t size);
+
+    /**
+     * \brief Computes the CRC32-C (Castagnoli) checksum of the given bytes
+     *
+     * Dispatches to the SSE4.2 crc32 instruction when available.
+     */
+    static uint32_t crc32c(const void* data, size_t size);
+
+    /**
+     * Indicates whether the CRC32-C kernel runs on the SSE4.2 instruction
+     */
+    static bool has_hardware_crc32c();
+private:
+    uint32_t hash(const Buffer& key) const;
+
+    HashFunction hash_function_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_KEY_PARTITIONER_H
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_LAG_MONITOR_H
+#define CPPKAFKA_LAG_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../consumer.h"
+#include "../kafka_statistics.h"
+#include "../macros.h"
+#include "../topic_partition_list.h"
+
+namespace cppkafka {
+
+/**
+ * \class LagMonitor
+ *
+ * \brief Tracks per-partition consumer lag behind asynchronously refreshed
+ *        watermarks
+ *
+ * Computing lag with query_offsets is a blocking RPC per partition; doing it
+ * on the consume thread stalls consumption, and doing it in the autoscaler
+ * makes every lag read pay a network round trip. LagMonitor decouples the
+ * two: the high watermarks are refreshed off the hot path - either from
+ * librdkafka's statistics payload via update (no extra RPCs at all) or by an
+ * internal query thread started with start - and each watched partition's lag
+ * lands in a cache-line-padded atomic. get_lag and get_snapshot then read at
+ * memory speed from any thread.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * LagMonitor monitor(consumer);
+ * consumer.set_assignment_callback([&](TopicPartitionList& partitions) {
+ *     monitor.watch(partitions);
+ * });
+ * monitor.start(std::chrono::seconds(5));
+ *
+ * // On the autoscaler's thread, as often as it likes:
+ * int64_t lag = monitor.get_snapshot().total_lag;
+ * \endcode
+ *
+ * \remark Lag is the distance between the partition's high watermark and the
+ * consumer's position, so it can briefly run ahead of or behind the committed
+ * offset. Partitions whose watermark or position is still unknown report -1
+ * and are excluded from snapshots.
+ */
+class CPPKAFKA_API LagMonitor {
+public:
+    /**
+     * Aggregate lag over all watched partitions with known lag
+     */
+    struct Snapshot {
+        /**
+         * Sum of the lag of all known partitions
+         */
+        int64_t total_lag{0};
+        /**
+         * Largest single-partition lag
+         */
+        int64_t max_lag{0};
+        /**
+         * Amount of partitions with known lag
+         */
+        size_t known_partitions{0};
+        /**
+         * Amount of watched partitions
+         */
+        size_t watched_partitions{0};
+    };
+
+    /**
+     * \brief Constructor
+     *
+     * \param consumer The consumer whose lag is to be tracked. Must outlive
+     *                 this instance.
+     */
+    explicit LagMonitor(Consumer& consumer);
+    LagMonitor(const LagMonitor&) = delete;
+    LagMonitor& operator=(const LagMonitor&) = delete;
+
+    /**
+     * \brief Destructor. Stops the refresh thread if running.
+     */
+    ~LagMonitor();
+
+    /**
+     * \brief Sets the partitions to be tracked
+     *
+     * Replaces the current watch set; typically called from the consumer's
+     * assignment callback. Slots of partitions that stay watched keep their
+     * last known values.
+     *
+     * \param topic_partitions The partitions to be tracked
+     */
+    void watch(const TopicPartitionList& topic_partitions);
+
+    /**
+     * \brief Starts the internal watermark refresh thread
+     *
+     * Every interval the thread queries the watched partitions' high
+     * watermarks (one blocking query_offsets per partition, off the consume
+     * thread) and the consumer's positions, and refreshes the lag atomics.
+     * Not needed if update is fed from the statistics callback.
+     *
+     * \param interval The refresh period
+     */
+    void start(std::chrono::milliseconds interval);
+
+    /**
+     * \brief Stops the internal refresh thread
+     */
+    void stop();
+
+    /**
+     * \brief Refreshes watermarks and lag from a statistics payload
+     *
+     * librdkafka already ships high watermarks and app offsets with every
+     * statistics interval, so feeding the parsed payload from the statistics
+     * callback keeps lag fresh without any additional RPCs.
+     *
+     * \param statistics The parsed statistics payload
+     */
+    void update(const KafkaStatistics& statistics);
+
+    /**
+     * \brief Gets the lag of a watched partition
+     *
+     * A single atomic load; safe to call from any thread at any rate.
+     *
+     * \param topic The topic of the partition
+     * \param partition The partition to get the lag of
+     *
+     * \return The partition's lag, or -1 if the partition is not watched or
+     *         its lag is not known yet
+     */
+    int64_t get_lag(const std::string& topic, int partition) const;
+
+    /**
+     * \brief Gets the aggregate lag over all watched partitions
+     */
+    Snapshot get_snapshot() const;
+private:
+    // One cache line per slot so refreshes of one partition don't bounce
+    // the line readers of another partition are loading
+    struct alignas(64) Slot {
+        std::atomic<int64_t> lag{-1};
+        std::atomic<int64_t> hi_offset{-1};
+        std::atomic<int64_t> position{-1};
+    };
+
+    // Structurally immutable once published (only the slot atomics are
+    // written); replaced wholesale by watch()
+    struct WatchSet {
+        TopicPartitionList partitions;
+        std::unique_ptr<Slot[]> slots;
+    };
+    using WatchSetPtr = std::shared_ptr<WatchSet>;
+
+    WatchSetPtr get_watch_set() const;
+    static void refresh_slot(Slot& slot, int64_t hi_offset, int64_t position);
+    void refresh_loop();
+    void refresh_once(const WatchSet& watch_set);
+
+    Consumer& consumer_;
+    WatchSetPtr watch_set_;
+    mutable std::mutex watch_set_mutex_;
+    std::thread refresh_thread_;
+    std::mutex refresh_mutex_;
+    std::condition_variable refresh_condition_;
+    std::chrono::milliseconds interval_{0};
+    bool running_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_LAG_MONITOR_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_LATENCY_HISTOGRAM_H
+#define CPPKAFKA_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "../macros.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Lock-free log-linear latency histogram (HDR style)
+ *
+ * Values (microseconds) are bucketed into power-of-two segments of 64 linear
+ * sub-buckets each, giving a fixed relative error of at most 1/64 (~1.6%) over
+ * the whole range, which covers up to roughly 19 hours. Recording a value is a
+ * handful of relaxed atomic increments, so any number of threads can record
+ * concurrently without locking, and the memory footprint is fixed at
+ * construction.
+ *
+ * Percentiles are computed on demand by scanning the bucket counters; this is
+ * intended for periodic metric scrapes, not per-message reads.
+ *
+ * \sa BufferedProducer::enable_latency_tracking
+ */
+class CPPKAFKA_API LatencyHistogram {
+public:
+    /**
+     * A consistent-enough view of the histogram, taken in one pass
+     */
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t minimum{0};
+        uint64_t maximum{0};
+        uint64_t average{0};
+        uint64_t p50{0};
+        uint64_t p95{0};
+        uint64_t p99{0};
+        uint64_t p999{0};
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * \brief Records a value
+     *
+     * Safe to call from any number of threads concurrently.
+     *
+     * \param value The value to record, in microseconds
+     */
+    void record(uint64_t value);
+
+    /**
+     * Gets the amount of recorded values
+     */
+    uint64_t get_count() const;
+
+    /**
+     * \brief Gets the value at the given percentile
+     *
+     * \param percentile The percentile, in the range (0, 100]
+     *
+     * \return The lower bound of the bucket containing the percentile, 0 if
+     * nothing was recorded
+     */
+    uint64_t get_percentile(double percentile) const;
+
+    /**
+     * \brief Takes a snapshot of the common percentiles and aggregates
+     *
+     * Values recorded concurrently with the snapshot may or may not be included.
+     */
+    Snapshot get_snapshot() const;
+
+    /**
+     * \brief Discards all recorded values
+     *
+     * Not atomic with respect to concurrent record() calls; a value being
+     * recorded while resetting may survive into the fresh histogram.
+     */
+    void reset();
+
+    /**
+     * Gets the current monotonic time in microseconds, the time base record()
+     * callers are expected to subtract in
+     */
+    static int64_t now_us();
+private:
+    // 64 linear sub-buckets per power-of-two segment
+    static constexpr size_t SUB_BUCKET_BITS = 6;
+    static constexpr size_t SUB_BUCKET_COUNT = size_t(1) << SUB_BUCKET_BITS;
+    // Largest distinguishable exponent; 2^37 - 1 microseconds is ~38 hours
+    static constexpr size_t MAX_EXPONENT = 36;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) *
+                                           SUB_BUCKET_COUNT;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_value(size_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> minimum_{UINT64_MAX};
+    std::atomic<uint64_t> maximum_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_LATENCY_HISTOGRAM_H
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MAPPED_FILE_PAYLOAD_H
+#define CPPKAFKA_MAPPED_FILE_PAYLOAD_H
+
+#if defined(_WIN32)
+#error "mapped_file_payload.h is only supported on POSIX systems"
+#endif
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../buffer.h"
+#include "../exceptions.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Memory-mapped file region usable as a zero-copy message payload
+ *
+ * This maps a file read-only and exposes it as cppkafka::Buffer views, so file
+ * contents can be produced without first reading them into an owned buffer. Combined
+ * with Producer::PayloadPolicy::PASSTHROUGH_PAYLOAD (the default for Buffer payloads),
+ * librdkafka won't copy the payload either, taking a file-to-broker produce from two
+ * copies down to zero.
+ *
+ * The mapping is released on destruction. Since with a passthrough policy the mapped
+ * memory must stay valid until the broker acknowledges the message, tie the payload's
+ * lifetime to the delivery report:
+ *
+ * \code
+ * // Buffer payloads default to PASSTHROUGH_PAYLOAD
+ * BufferedProducer<Buffer> producer(config);
+ *
+ * // Unmap the file once its message is acknowledged
+ * producer.set_produce_success_callback([](const Message& message) {
+ *     delete static_cast<MappedFilePayload*>(message.get_user_data());
+ * });
+ *
+ * auto* payload = new MappedFilePayload("/data/blob.bin");
+ * MessageBuilder builder("blobs");
+ * builder.payload(payload->get_buffer()).user_data(payload);
+ * producer.add_message(builder);
+ * \endcode
+ *
+ * \warning When a message can be dropped (see ProduceTerminationCallback and
+ * FlushTerminationCallback), release the payload on those paths as well.
+ */
+class MappedFilePayload {
+public:
+    /**
+     * \brief Maps the given file read-only
+     *
+     * The file descriptor is closed right after mapping; the mapping keeps the
+     * file contents alive. The kernel is advised that the region will be read
+     * sequentially.
+     *
+     * \param path The path of the file to map
+     */
+    explicit MappedFilePayload(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw Exception("Failed to open file: " + path);
+        }
+        struct stat file_info;
+        if (::fstat(fd, &file_info) == -1) {
+            ::close(fd);
+            throw Exception("Failed to stat file: " + path);
+        }
+        size_ = static_cast<size_t>(file_info.st_size);
+        if (size_ > 0) {
+            void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw Exception("Failed to map file: " + path);
+            }
+            ::madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const unsigned char*>(mapping);
+        }
+        ::close(fd);
+    }
+
+    MappedFilePayload(const MappedFilePayload&) = delete;
+    MappedFilePayload& operator=(const MappedFilePayload&) = delete;
+
+    MappedFilePayload(MappedFilePayload&& rhs) noexcept
+    : data_(rhs.data_),
+      size_(rhs.size_) {
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+    }
+
+    MappedFilePayload& operator=(MappedFilePayload&& rhs) noexcept {
+        if (this != &rhs) {
+            unmap();
+            data_ = rhs.data_;
+            size_ = rhs.size_;
+            rhs.data_ = nullptr;
+            rhs.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFilePayload() {
+        unmap();
+    }
+
+    /**
+     * Getter for the mapped data
+     */
+    const unsigned char* get_data() const {
+        return data_;
+    }
+
+    /**
+     * Getter for the size of the mapped file
+     */
+    size_t get_size() const {
+        return size_;
+    }
+
+    /**
+     * \brief Gets a non-owning Buffer over the whole mapped file
+     */
+    Buffer get_buffer() const {
+        return Buffer(data_, size_);
+    }
+
+    /**
+     * \brief Gets a non-owning Buffer over a slice of the mapped file
+     *
+     * \param offset The offset of the slice within the file
+     * \param size The size of the slice
+     */
+    Buffer get_buffer(size_t offset, size_t size) const {
+        if ((offset > size_) || (size > size_ - offset)) {
+            throw Exception("Buffer slice out of mapped range");
+        }
+        return Buffer(data_ + offset, size);
+    }
+private:
+    void unmap() {
+        if (data_) {
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    const unsigned char* data_{nullptr};
+    size_t size_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_MAPPED_FILE_PAYLOAD_H
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MAPPED_REPLAY_PRODUCER_H
+#define CPPKAFKA_MAPPED_REPLAY_PRODUCER_H
+
+#if defined(_WIN32)
+#error "mapped_replay_producer.h is only supported on POSIX systems"
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../producer.h"
+#include "../message_builder.h"
+#include "../exceptions.h"
+#include "../detail/endianness.h"
+#include "mapped_file_payload.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Replays length-prefixed record files into kafka without copying payloads
+ *
+ * This is meant for bulk re-ingestion paths (e.g. disaster recovery) where multi-GB
+ * dump files need to be pushed through a producer as fast as the network allows.
+ * Instead of parsing records into owned buffers, the file is memory-mapped (see
+ * MappedFilePayload), Buffer views are constructed directly over the mapping and
+ * produced with PayloadPolicy::PASSTHROUGH_PAYLOAD in produce_batch sized chunks,
+ * so record bytes are never copied between the page cache and the NIC.
+ *
+ * The expected file format is a plain sequence of records, each one being a 32 bit
+ * little endian payload length followed by that many payload bytes. A file ending
+ * in the middle of a record is reported via an Exception.
+ *
+ * As delivery reports confirm records, a watermark of contiguously acknowledged
+ * file bytes is advanced; if a replay is interrupted, get_watermark() is a safe
+ * byte offset to resume from. Records failing delivery with a retryable error are
+ * produced again from the mapping.
+ *
+ * Example:
+ *
+ * \code
+ * MappedReplayProducer replayer(config, "events");
+ * const size_t records = replayer.replay("/backups/events.dump");
+ * \endcode
+ *
+ * \warning Delivery Report Callback: This class makes internal use of this function
+ * and will overwrite anything the user has supplied as part of the configuration
+ * options.
+ *
+ * \remark This class is not thread safe; replay() drives the producer from the
+ * calling thread. get_watermark() may be read concurrently for progress monitoring.
+ */
+class MappedReplayProducer {
+public:
+    /**
+     * Default amount of records enqueued per produce_batch call
+     */
+    static constexpr size_t DEFAULT_BATCH_SIZE = 1024;
+
+    /**
+     * \brief Constructs a replay producer
+     *
+     * \param config The configuration for the underlying Producer
+     * \param topic The topic the records will be produced into
+     */
+    MappedReplayProducer(Configuration config, std::string topic)
+    : producer_(prepare_configuration(std::move(config))),
+      topic_(std::move(topic)) {
+        producer_.set_payload_policy(Producer::PayloadPolicy::PASSTHROUGH_PAYLOAD);
+    }
+
+    MappedReplayProducer(const MappedReplayProducer&) = delete;
+    MappedReplayProducer& operator=(const MappedReplayProducer&) = delete;
+
+    /**
+     * \brief Sets the amount of records enqueued per produce_batch call
+     */
+    void set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size > 0 ? batch_size : 1;
+    }
+
+    /**
+     * \brief Sets the partition all records are produced into
+     *
+     * By default the partition is unassigned and rdkafka's partitioner is used.
+     */
+    void set_partition(int partition) {
+        partition_ = partition;
+    }
+
+    /**
+     * \brief Replays a whole record file
+     *
+     * This maps the file, produces every record in it and blocks until all of
+     * them have been acknowledged by the brokers.
+     *
+     * \param path The path of the record file
+     *
+     * \return The number of records produced
+     */
+    size_t replay(const std::string& path) {
+        MappedFilePayload file(path);
+        watermark_ = 0;
+        pending_acks_.clear();
+        retries_.clear();
+        records_in_flight_ = 0;
+        size_t records = 0;
+        uint64_t offset = 0;
+        std::vector<MessageBuilder> batch;
+        while (offset < file.get_size()) {
+            batch.clear();
+            while ((batch.size() < batch_size_) && (offset < file.get_size())) {
+                offset += parse_record(file, offset, batch);
+                ++records;
+            }
+            produce_batch(batch);
+            // Serve delivery reports so the watermark keeps moving and
+            // re-enqueue any records which failed delivery meanwhile
+            producer_.poll(std::chrono::milliseconds(0));
+            flush_retries(file, batch);
+        }
+        // Everything is enqueued; drain delivery reports until all records
+        // (including late retries) have been acknowledged
+        while ((records_in_flight_ > 0) || !retries_.empty()) {
+            flush_retries(file, batch);
+            producer_.poll(std::chrono::milliseconds(100));
+        }
+        return records;
+    }
+
+    /**
+     * \brief Gets the replay watermark
+     *
+     * All file bytes below the watermark belong to records already acknowledged
+     * by the brokers, making it a safe offset to resume an interrupted replay from.
+     */
+    uint64_t get_watermark() const {
+        return watermark_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Gets the underlying Producer object
+     */
+    Producer& get_producer() {
+        return producer_;
+    }
+
+    /**
+     * Gets the underlying Producer object
+     */
+    const Producer& get_producer() const {
+        return producer_;
+    }
+private:
+    // The record length prefix
+    using LengthType = uint32_t;
+
+    Configuration prepare_configuration(Configuration config) {
+        config.set_delivery_report_callback([this](Producer&, const Message& message) {
+            on_delivery_report(message);
+        });
+        return config;
+    }
+
+    // Parses the record starting at the given offset, appending a builder over
+    // its payload to the batch. Returns the total size of the record.
+    size_t parse_record(const MappedFilePayload& file,
+                        uint64_t offset,
+                        std::vector<MessageBuilder>& batch) {
+        LengthType length;
+        if (offset + sizeof(LengthType) > file.get_size()) {
+            throw Exception("Truncated record length at offset " + std::to_string(offset));
+        }
+        std::memcpy(&length, file.get_data() + offset, sizeof(LengthType));
+        length = le32toh(length);
+        if (offset + sizeof(LengthType) + length > file.get_size()) {
+            throw Exception("Truncated record payload at offset " + std::to_string(offset));
+        }
+        const uint64_t end = offset + sizeof(LengthType) + length;
+        batch.emplace_back(topic_);
+        batch.back().partition(partition_)
+                    .payload(file.get_buffer(offset + sizeof(LengthType), length))
+                    .user_data(reinterpret_cast<void*>(static_cast<uintptr_t>(end)));
+        return sizeof(LengthType) + length;
+    }
+
+    // Enqueues a batch, polling and retrying until rdkafka accepts every record
+    void produce_batch(std::vector<MessageBuilder>& batch) {
+        std::vector<MessageBuilder> rejected;
+        while (!batch.empty()) {
+            const size_t enqueued = producer_.produce_batch(batch,
+                [&](MessageBuilder& builder, Error error)->void {
+                    if (error != RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+                        throw HandleException(error);
+                    }
+                    rejected.emplace_back(std::move(builder));
+                });
+            records_in_flight_ += enqueued;
+            batch.swap(rejected);
+            rejected.clear();
+            if (!batch.empty()) {
+                // The output queue is full; serve delivery reports to drain it
+                producer_.poll();
+            }
+        }
+    }
+
+    // Converts delivery failures stashed by on_delivery_report() back into
+    // builders over the mapping and produces them again
+    void flush_retries(const MappedFilePayload& file, std::vector<MessageBuilder>& batch) {
+        if (retries_.empty()) {
+            return;
+        }
+        batch.clear();
+        for (const std::pair<uint64_t, LengthType>& retry : retries_) {
+            const uint64_t end = retry.first;
+            const LengthType length = retry.second;
+            batch.emplace_back(topic_);
+            batch.back().partition(partition_)
+                        .payload(file.get_buffer(end - length, length))
+                        .user_data(reinterpret_cast<void*>(static_cast<uintptr_t>(end)));
+        }
+        retries_.clear();
+        produce_batch(batch);
+    }
+
+    void on_delivery_report(const Message& message) {
+        const uint64_t end = static_cast<uint64_t>(
+            reinterpret_cast<uintptr_t>(message.get_user_data()));
+        // The record is out of flight either way; a failed one re-enters when
+        // the replay loop produces it again
+        --records_in_flight_;
+        if (message.get_error()) {
+            // Stash it; the replay loop will produce it again from the mapping.
+            // Producing from within the delivery report (a poll context) could
+            // deadlock on a full queue.
+            retries_.emplace_back(end, static_cast<LengthType>(message.get_payload().get_size()));
+            return;
+        }
+        advance_watermark(end - sizeof(LengthType) - message.get_payload().get_size(), end);
+    }
+
+    // Advances the contiguous watermark given an acknowledged record [begin, end)
+    void advance_watermark(uint64_t begin, uint64_t end) {
+        if (begin != watermark_.load(std::memory_order_relaxed)) {
+            // Acknowledged out of order; park it until the gap closes
+            pending_acks_.emplace(begin, end);
+            return;
+        }
+        while (true) {
+            watermark_.store(end, std::memory_order_release);
+            const auto iter = pending_acks_.find(end);
+            if (iter == pending_acks_.end()) {
+                break;
+            }
+            end = iter->second;
+            pending_acks_.erase(iter);
+        }
+    }
+
+    Producer producer_;
+    std::string topic_;
+    // Acknowledged records whose predecessors are still in flight (begin -> end)
+    std::map<uint64_t, uint64_t> pending_acks_;
+    // Failed records awaiting re-production (end offset, payload length)
+    std::deque<std::pair<uint64_t, LengthType>> retries_;
+    std::atomic<uint64_t> watermark_{0};
+    size_t records_in_flight_{0};
+    size_t batch_size_{DEFAULT_BATCH_SIZE};
+    int partition_{RD_KAFKA_PARTITION_UA};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_MAPPED_REPLAY_PRODUCER_H
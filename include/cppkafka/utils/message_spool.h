@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MESSAGE_SPOOL_H
+#define CPPKAFKA_MESSAGE_SPOOL_H
+
+#if defined(_WIN32)
+#error "message_spool.h is only supported on POSIX systems"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "../buffer.h"
+#include "../exceptions.h"
+#include "../message_builder.h"
+#include "../detail/endianness.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Append-only disk spool for message builders
+ *
+ * This serializes messages (topic, partition, timestamp, key and payload) into an
+ * append-only file and streams them back later, so a producer buffer can spill to
+ * disk instead of growing without bound in RAM when brokers are unreachable.
+ *
+ * Writes are batched: serialized records accumulate in memory and are written with
+ * a single writev call once DEFAULT_WRITE_BATCH_SIZE records are pending (or on
+ * flush()). Draining reads records back from the front of the file and hands them
+ * to a callback as freshly built message builders; once every spooled record has
+ * been drained the file is truncated so the spool never grows across outages.
+ *
+ * Typical wiring with BufferedProducer, spilling over a resident cap and streaming
+ * back on recovery:
+ *
+ * \code
+ * BufferedProducer<std::string> producer(config);
+ * MessageSpool spool("/var/spool/app/kafka.spool");
+ *
+ * producer.set_max_resident_messages(100000);
+ * producer.set_overflow_callback([&](BufferedProducer<std::string>::Builder&& builder) {
+ *     spool.spool(builder);
+ * });
+ *
+ * // On recovery (e.g. when a metadata refresh succeeds), stream the spool back
+ * // through the normal buffering path
+ * spool.drain<std::string>([&](ConcreteMessageBuilder<std::string>&& builder) {
+ *     producer.add_message(std::move(builder));
+ * });
+ * \endcode
+ *
+ * If the file already contains records when the spool is opened (e.g. after a
+ * restart mid-outage), they are preserved and will be drained first.
+ *
+ * \remark This class is thread safe.
+ *
+ * \warning Message headers and the user data pointer are not serialized; spilled
+ * messages lose them.
+ */
+class MessageSpool {
+public:
+    /**
+     * Amount of pending records which triggers an automatic writev flush
+     */
+    static constexpr size_t DEFAULT_WRITE_BATCH_SIZE = 64;
+
+    /**
+     * \brief Opens (or creates) the spool file
+     *
+     * Records already present in the file are preserved and drained first.
+     *
+     * \param path The path of the spool file
+     */
+    explicit MessageSpool(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            throw Exception("Failed to open spool file: " + path);
+        }
+        const off_t end = ::lseek(fd_, 0, SEEK_END);
+        write_offset_ = static_cast<uint64_t>(end);
+        // Count any records surviving from a previous run
+        records_spooled_ = scan_existing_records();
+    }
+
+    MessageSpool(const MessageSpool&) = delete;
+    MessageSpool& operator=(const MessageSpool&) = delete;
+
+    ~MessageSpool() {
+        try {
+            flush();
+        }
+        catch (const Exception&) {
+            // Nothing we can do at this point
+        }
+        ::close(fd_);
+    }
+
+    /**
+     * \brief Serializes a message builder into the spool
+     *
+     * The record lands on disk once the pending write batch fills up or flush()
+     * is called.
+     *
+     * \param builder The builder holding the message to spill
+     */
+    template <typename BufferType, typename Concrete>
+    void spool(const BasicMessageBuilder<BufferType, Concrete>& builder) {
+        const Buffer key = make_view(builder.key());
+        const Buffer payload = make_view(builder.payload());
+        std::vector<char> record;
+        record.reserve(HEADER_SIZE + builder.topic().size() +
+                       key.get_size() + payload.get_size());
+        append_value(record, htole32(static_cast<uint32_t>(
+            HEADER_SIZE - sizeof(uint32_t) + builder.topic().size() +
+            key.get_size() + payload.get_size())));
+        append_value(record, htole16(static_cast<uint16_t>(builder.topic().size())));
+        append_value(record, htole32(static_cast<uint32_t>(builder.partition())));
+        append_value(record, htole64(static_cast<uint64_t>(builder.timestamp().count())));
+        append_value(record, htole32(static_cast<uint32_t>(key.get_size())));
+        append_value(record, htole32(static_cast<uint32_t>(payload.get_size())));
+        record.insert(record.end(), builder.topic().begin(), builder.topic().end());
+        record.insert(record.end(), key.get_data(), key.get_data() + key.get_size());
+        record.insert(record.end(), payload.get_data(),
+                      payload.get_data() + payload.get_size());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.emplace_back(std::move(record));
+        ++records_spooled_;
+        if (pending_.size() >= DEFAULT_WRITE_BATCH_SIZE) {
+            write_pending();
+        }
+    }
+
+    /**
+     * \brief Writes all pending records to disk
+     */
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_pending();
+    }
+
+    /**
+     * \brief Streams spooled records back out of the file
+     *
+     * Records are drained oldest first and removed from the spool; once the last
+     * one is gone the file is truncated back to zero length.
+     *
+     * \param consumer The callback receiving a builder per drained record
+     * \param max_records The maximum amount of records to drain
+     *
+     * \return The number of records drained
+     *
+     * \remark BufferType must own its contents (e.g. std::string); the bytes the
+     * builders are constructed from don't outlive the callback invocation.
+     */
+    template <typename BufferType = std::string>
+    size_t drain(const std::function<void(ConcreteMessageBuilder<BufferType>&&)>& consumer,
+                 size_t max_records = std::numeric_limits<size_t>::max()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_pending();
+        size_t drained = 0;
+        while ((drained < max_records) && (read_offset_ < write_offset_)) {
+            consumer(read_record<BufferType>());
+            ++drained;
+        }
+        records_spooled_ -= drained;
+        if (read_offset_ == write_offset_) {
+            // Everything was drained; shrink the file back so the spool
+            // doesn't keep dead records around across outages
+            if (::ftruncate(fd_, 0) == 0) {
+                read_offset_ = 0;
+                write_offset_ = 0;
+            }
+        }
+        return drained;
+    }
+
+    /**
+     * Gets the amount of records currently in the spool (on disk or pending write)
+     */
+    size_t get_pending_records() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_spooled_;
+    }
+private:
+    // record length (u32) + topic length (u16) + partition (u32) +
+    // timestamp (u64) + key length (u32) + payload length (u32)
+    static constexpr size_t HEADER_SIZE = 4 + 2 + 4 + 8 + 4 + 4;
+
+    static Buffer make_view(const Buffer& buffer) {
+        return Buffer(buffer.get_data(), buffer.get_size());
+    }
+
+    template <typename T>
+    static Buffer make_view(const T& container) {
+        return Buffer(container);
+    }
+
+    template <typename T>
+    static void append_value(std::vector<char>& record, T value) {
+        const char* raw = reinterpret_cast<const char*>(&value);
+        record.insert(record.end(), raw, raw + sizeof(T));
+    }
+
+    // Expects the lock to be held
+    void write_pending() {
+        if (pending_.empty()) {
+            return;
+        }
+        std::vector<struct iovec> iovecs;
+        iovecs.reserve(pending_.size());
+        for (std::vector<char>& record : pending_) {
+            iovecs.push_back(iovec{record.data(), record.size()});
+        }
+        // writev caps the amount of segments per call
+        size_t written_records = 0;
+        while (written_records < iovecs.size()) {
+            const size_t count = std::min<size_t>(iovecs.size() - written_records, IOV_MAX);
+            size_t expected = 0;
+            for (size_t i = 0; i < count; ++i) {
+                expected += iovecs[written_records + i].iov_len;
+            }
+            const ssize_t written = ::pwritev(fd_, iovecs.data() + written_records,
+                                              static_cast<int>(count),
+                                              static_cast<off_t>(write_offset_));
+            if (written == -1 || static_cast<size_t>(written) != expected) {
+                // A short write on a regular file means the disk is full; leaving
+                // a torn record behind would corrupt the spool
+                throw Exception("Failed to write to spool file");
+            }
+            write_offset_ += static_cast<uint64_t>(written);
+            written_records += count;
+        }
+        pending_.clear();
+    }
+
+    // Expects the lock to be held and a complete record at read_offset_
+    template <typename BufferType>
+    ConcreteMessageBuilder<BufferType> read_record() {
+        uint32_t record_size;
+        read_exactly(&record_size, sizeof(record_size), read_offset_);
+        record_size = le32toh(record_size);
+        std::vector<char> record(record_size);
+        read_exactly(record.data(), record.size(), read_offset_ + sizeof(record_size));
+        const char* cursor = record.data();
+        uint16_t topic_size;
+        uint32_t partition;
+        uint64_t timestamp;
+        uint32_t key_size;
+        uint32_t payload_size;
+        cursor = read_value(cursor, topic_size);
+        cursor = read_value(cursor, partition);
+        cursor = read_value(cursor, timestamp);
+        cursor = read_value(cursor, key_size);
+        cursor = read_value(cursor, payload_size);
+        topic_size = le16toh(topic_size);
+        if (HEADER_SIZE - sizeof(uint32_t) + topic_size + le32toh(key_size) +
+            le32toh(payload_size) != record_size) {
+            throw Exception("Corrupt spool record");
+        }
+        ConcreteMessageBuilder<BufferType> builder(std::string(cursor, topic_size));
+        cursor += topic_size;
+        builder.partition(static_cast<int>(le32toh(partition)));
+        builder.timestamp(std::chrono::milliseconds(
+            static_cast<int64_t>(le64toh(timestamp))));
+        if (le32toh(key_size) > 0) {
+            builder.key(BufferType(cursor, cursor + le32toh(key_size)));
+        }
+        cursor += le32toh(key_size);
+        if (le32toh(payload_size) > 0) {
+            builder.payload(BufferType(cursor, cursor + le32toh(payload_size)));
+        }
+        read_offset_ += sizeof(record_size) + record_size;
+        return builder;
+    }
+
+    void read_exactly(void* output, size_t size, uint64_t offset) const {
+        const ssize_t result = ::pread(fd_, output, size, static_cast<off_t>(offset));
+        if (result == -1 || static_cast<size_t>(result) != size) {
+            throw Exception("Failed to read from spool file");
+        }
+    }
+
+    template <typename T>
+    static const char* read_value(const char* cursor, T& value) {
+        std::memcpy(&value, cursor, sizeof(T));
+        return cursor + sizeof(T);
+    }
+
+    // Walks the record headers of a pre-existing file; truncates away any
+    // torn record left over by a crash mid-write
+    size_t scan_existing_records() {
+        size_t count = 0;
+        uint64_t offset = 0;
+        while (offset + sizeof(uint32_t) <= write_offset_) {
+            uint32_t record_size;
+            read_exactly(&record_size, sizeof(record_size), offset);
+            record_size = le32toh(record_size);
+            if (offset + sizeof(uint32_t) + record_size > write_offset_) {
+                break;
+            }
+            offset += sizeof(uint32_t) + record_size;
+            ++count;
+        }
+        if (offset != write_offset_) {
+            if (::ftruncate(fd_, static_cast<off_t>(offset)) == 0) {
+                write_offset_ = offset;
+            }
+        }
+        return count;
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<std::vector<char>> pending_;
+    uint64_t write_offset_{0};
+    uint64_t read_offset_{0};
+    size_t records_spooled_{0};
+    int fd_{-1};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_MESSAGE_SPOOL_H
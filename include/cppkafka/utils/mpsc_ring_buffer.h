@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_MPSC_RING_BUFFER_H
+#define CPPKAFKA_MPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace cppkafka {
+
+/**
+ * \brief Bounded lock-free multi-producer ring buffer
+ *
+ * This container can be plugged into BufferedProducer as its queue policy in order to
+ * replace the default mutex protected std::deque. Pushing an element translates into a
+ * single compare-and-swap on the producer cursor, so any number of threads can call
+ * BufferedProducer::add_message concurrently without contending on a mutex. Consuming
+ * (i.e. flushing) pops elements in slot order, which drains the underlying storage in
+ * cache-line friendly sequential chunks.
+ *
+ * The implementation is a sequence-number based ring (Vyukov style): each slot carries
+ * an atomic sequence counter which producers and consumers use to claim it without
+ * locking. The capacity is fixed at construction time and rounded up to a power of two.
+ *
+ * Example:
+ *
+ * \code
+ * using Builder = ConcreteMessageBuilder<std::string>;
+ * using Ring = MpscRingBuffer<Builder>;
+ *
+ * // A buffered producer whose add_message is a single CAS
+ * BufferedProducer<std::string, std::allocator<Builder>, Ring> producer(config);
+ * \endcode
+ *
+ * \remark Producers never block each other. When the ring is full, emplace_back spins
+ * (yielding the cpu) until a consumer frees a slot, mimicking the unbounded deque
+ * semantics of the default policy.
+ *
+ * \warning Elements may be consumed from multiple threads (flush is allowed concurrently)
+ * but consumption order across threads is then unspecified, just like with the default
+ * queue policy.
+ */
+template <typename T>
+class MpscRingBuffer {
+public:
+    /**
+     * Marker used by BufferedProducer to detect internally synchronized queue policies
+     */
+    static constexpr bool concurrent = true;
+
+    /**
+     * Default amount of slots in the ring
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    /**
+     * \brief Constructs a ring with the given capacity
+     *
+     * \param capacity The maximum number of buffered elements. Will be rounded up
+     *                 to the next power of two.
+     */
+    explicit MpscRingBuffer(size_t capacity = DEFAULT_CAPACITY)
+    : mask_(round_up_to_power_of_two(capacity) - 1),
+      cells_(new Cell[mask_ + 1]),
+      enqueue_pos_(0),
+      dequeue_pos_(0) {
+        for (size_t i = 0; i != mask_ + 1; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * \brief Constructs a ring with the default capacity
+     *
+     * This overload exists so this class can be dropped into BufferedProducer, which
+     * constructs its queues from the element allocator. The allocator itself is unused
+     * since slots are managed in-place.
+     */
+    template <typename Allocator,
+              typename = typename std::enable_if<!std::is_integral<Allocator>::value>::type>
+    explicit MpscRingBuffer(const Allocator& /*alloc*/)
+    : MpscRingBuffer() {
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    ~MpscRingBuffer() {
+        clear();
+    }
+
+    /**
+     * \brief Attempts to push an element into the ring
+     *
+     * This is safe to call from any number of threads concurrently.
+     *
+     * \param args Arguments forwarded to the element's constructor
+     *
+     * \return True if the element was enqueued, false if the ring is full
+     */
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                        static_cast<intptr_t>(pos);
+            if (difference == 0) {
+                // The slot is free. Claim it by moving the producer cursor.
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    new (&cell.storage) T(std::forward<Args>(args)...);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                // The consumer hasn't released this slot yet
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * \brief Pushes an element into the ring, waiting for a free slot if necessary
+     *
+     * When the ring is full this will yield and retry until a slot becomes available,
+     * which matches the behavior callers expect from the default std::deque policy.
+     *
+     * \param args Arguments forwarded to the element's constructor
+     */
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        while (!try_emplace(std::forward<Args>(args)...)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * \brief Pops the oldest element and hands it to the given functor
+     *
+     * The element's slot is released back to the producers before the functor
+     * runs, so the functor may itself push into the ring.
+     *
+     * \param on_element Functor invoked as on_element(T&&)
+     *
+     * \return True if an element was consumed, false if the ring was empty
+     */
+    template <typename Functor>
+    bool try_pop(Functor&& on_element) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                        static_cast<intptr_t>(pos + 1);
+            if (difference == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    T* slot = reinterpret_cast<T*>(&cell.storage);
+                    T element = std::move(*slot);
+                    slot->~T();
+                    // Mark the slot as writable before invoking the functor: it
+                    // may re-enter emplace_back, and on a full ring it would
+                    // otherwise spin on this very slot forever
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    on_element(std::move(element));
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Discards all buffered elements
+     */
+    void clear() {
+        while (try_pop([](T&&) { })) {
+        }
+    }
+
+    /**
+     * \brief Gets the approximate amount of buffered elements
+     *
+     * The value is approximate since producers and consumers may be operating
+     * concurrently with this call.
+     */
+    size_t size() const {
+        const size_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+        const size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueue_pos >= dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+
+    /**
+     * Indicates whether the ring is (approximately) empty
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Gets the maximum number of elements this ring can hold
+     */
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+private:
+    // Slots are deliberately not padded: positions are claimed and drained
+    // sequentially, so packing several slots per cache line favors the
+    // consumer's linear scan over isolating concurrent producers from each
+    // other
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    static constexpr size_t CACHELINE_SIZE = 64;
+
+    static size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    // Keep both cursors on separate cache lines to avoid false sharing between
+    // the producing and consuming sides
+    alignas(CACHELINE_SIZE) std::atomic<size_t> enqueue_pos_;
+    alignas(CACHELINE_SIZE) std::atomic<size_t> dequeue_pos_;
+};
+
+namespace detail {
+
+// Detects whether a queue policy synchronizes internally and therefore doesn't
+// need the external mutex BufferedProducer uses for plain containers
+template <typename Queue, typename = void>
+struct is_concurrent_queue : std::false_type {
+};
+
+template <typename Queue>
+struct is_concurrent_queue<Queue, typename std::enable_if<Queue::concurrent>::type>
+: std::true_type {
+};
+
+} // detail
+
+} // cppkafka
+
+#endif // CPPKAFKA_MPSC_RING_BUFFER_H
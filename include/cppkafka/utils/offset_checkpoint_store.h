@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_OFFSET_CHECKPOINT_STORE_H
+#define CPPKAFKA_OFFSET_CHECKPOINT_STORE_H
+
+#if defined(_WIN32)
+#error "offset_checkpoint_store.h is only supported on POSIX systems"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../exceptions.h"
+#include "../message.h"
+#include "../topic_partition.h"
+#include "../topic_partition_list.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Memory-mapped per-partition offset checkpoints for fast seek-on-start
+ *
+ * This is meant for commit-less consumers (enable.auto.commit=false) which track
+ * their progress outside of kafka. The store is a fixed-layout memory-mapped file
+ * of (topic, partition, offset) slots, each one occupying its own cache line.
+ * Checkpointing an offset is a single in-place atomic store into the mapping - no
+ * syscall, no serialization - so it can be done per processed batch (or even per
+ * message) without showing up in a profile. The kernel flushes dirty pages in the
+ * background, and an msync() based sync() is available for explicit barriers.
+ *
+ * On restart the file is mapped again and the surviving offsets can be applied to
+ * a partition list before assigning it, removing the external offset lookup from
+ * the startup path:
+ *
+ * \code
+ * OffsetCheckpointStore store("/var/lib/app/offsets.ckpt");
+ * TopicPartitionList partitions = { { "events", 0 }, { "events", 1 } };
+ * store.seed(partitions); // fills in checkpointed offsets
+ * consumer.assign(partitions);
+ * // ... while processing:
+ * store.checkpoint(message); // next offset to consume, one atomic store
+ * \endcode
+ *
+ * Slots are claimed on first checkpoint of a (topic, partition) pair and found via
+ * linear probing on a topic name hash; the store throws once all slots are in use.
+ * Offsets are 8 byte aligned so slot updates are atomic with respect to crashes -
+ * a torn file cannot contain a half-written offset.
+ *
+ * \warning The file stores integers in host byte order and is not meant to be
+ * copied between architectures.
+ *
+ * \remark Thread safe. Checkpoints of already-claimed slots are lock free.
+ */
+class OffsetCheckpointStore {
+public:
+    /**
+     * Default number of (topic, partition) slots in the file
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    /**
+     * \brief Opens or creates a checkpoint store
+     *
+     * If the file does not exist it is created and sized for the given capacity.
+     * If it exists, its header is validated and the capacity stored in the file
+     * is used; offsets checkpointed by previous runs remain readable.
+     *
+     * \param path The path of the checkpoint file
+     * \param capacity The number of slots when creating a new file
+     */
+    OffsetCheckpointStore(const std::string& path, size_t capacity = DEFAULT_CAPACITY) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) {
+            throw Exception("Failed to open checkpoint file: " + path);
+        }
+        struct stat file_info;
+        if (fstat(fd_, &file_info) == -1) {
+            ::close(fd_);
+            throw Exception("Failed to stat checkpoint file: " + path);
+        }
+        if (file_info.st_size == 0) {
+            initialize_file(path, capacity);
+        }
+        else {
+            map_existing_file(path, static_cast<size_t>(file_info.st_size));
+        }
+        index_slots();
+    }
+
+    OffsetCheckpointStore(const OffsetCheckpointStore&) = delete;
+    OffsetCheckpointStore& operator=(const OffsetCheckpointStore&) = delete;
+
+    ~OffsetCheckpointStore() {
+        munmap(mapping_, mapping_size_);
+        ::close(fd_);
+    }
+
+    /**
+     * \brief Checkpoints an offset for a (topic, partition) pair
+     *
+     * The first checkpoint of a pair claims a slot (taking a lock); subsequent
+     * ones are a single atomic store into the mapped file.
+     *
+     * \param topic The topic name
+     * \param partition The partition
+     * \param offset The offset to checkpoint (typically the next one to consume)
+     */
+    void checkpoint(const std::string& topic, int partition, int64_t offset) {
+        find_or_claim_slot(topic, partition)->offset
+            .store(offset, std::memory_order_release);
+    }
+
+    /**
+     * \brief Checkpoints a processed message
+     *
+     * Stores the offset following the message's, i.e. the next offset to consume.
+     *
+     * \param message The message that was processed
+     */
+    void checkpoint(const Message& message) {
+        checkpoint(message.get_topic(), message.get_partition(), message.get_offset() + 1);
+    }
+
+    /**
+     * \brief Gets the checkpointed offset for a (topic, partition) pair
+     *
+     * \return The offset, or TopicPartition::OFFSET_INVALID if this pair was
+     * never checkpointed
+     */
+    int64_t get_offset(const std::string& topic, int partition) const {
+        std::lock_guard<std::mutex> _(mutex_);
+        const auto iter = slot_index_.find(make_key(topic, partition));
+        if (iter == slot_index_.end()) {
+            return TopicPartition::OFFSET_INVALID;
+        }
+        return iter->second->offset.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Seeds a partition list with checkpointed offsets
+     *
+     * Sets the offset of every partition in the list which has a checkpoint,
+     * leaving the rest untouched, so the list can be handed to Consumer::assign
+     * and consumption resumes where the previous run stopped.
+     *
+     * \param partitions The partitions about to be assigned
+     *
+     * \return The number of partitions seeded
+     */
+    size_t seed(TopicPartitionList& partitions) const {
+        size_t seeded = 0;
+        for (TopicPartition& partition : partitions) {
+            const int64_t offset = get_offset(partition.get_topic(),
+                                              partition.get_partition());
+            if (offset != TopicPartition::OFFSET_INVALID) {
+                partition.set_offset(offset);
+                ++seeded;
+            }
+        }
+        return seeded;
+    }
+
+    /**
+     * \brief Synchronizes the mapping with the backing file
+     *
+     * This is not required for crash consistency within the same host (the page
+     * cache survives a process crash); it only forces the offsets to disk, e.g.
+     * before the file is backed up.
+     */
+    void sync() {
+        if (msync(mapping_, mapping_size_, MS_SYNC) == -1) {
+            throw Exception("Failed to sync checkpoint file");
+        }
+    }
+
+    /**
+     * Gets the number of claimed slots
+     */
+    size_t get_size() const {
+        std::lock_guard<std::mutex> _(mutex_);
+        // The hash index has exactly one entry per claimed slot; the name index
+        // may alias a slot under both a full and a truncated name
+        return hash_index_.size();
+    }
+
+    /**
+     * Gets the total number of slots in the file
+     */
+    size_t get_capacity() const {
+        return header()->capacity;
+    }
+private:
+    static constexpr uint32_t MAGIC = 0x43504b43; // "CKPC"
+    static constexpr uint32_t VERSION = 1;
+    // Topic names longer than this are disambiguated by their hash alone
+    static constexpr size_t TOPIC_PREFIX_SIZE = 36;
+
+    // Padded to a full cache line so the slot array behind it stays 64 byte
+    // aligned within the page aligned mapping
+    struct alignas(64) Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+    };
+    static_assert(sizeof(Header) == 64, "Header must span exactly one cache line");
+
+    // One cache line per slot so concurrent checkpoints of different partitions
+    // never share a line
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> state; // 0 = empty, 1 = claimed
+        uint64_t topic_hash;
+        int32_t partition;
+        char topic_prefix[TOPIC_PREFIX_SIZE];
+        std::atomic<int64_t> offset;
+    };
+    static_assert(sizeof(Slot) == 64, "Slot must span exactly one cache line");
+    static_assert(std::is_trivially_destructible<Slot>::value,
+                  "Slot must be usable over a raw mapping");
+
+    using SlotKey = std::pair<std::string, int>;
+    struct SlotKeyHash {
+        size_t operator()(const SlotKey& key) const {
+            return std::hash<std::string>()(key.first) ^
+                   (std::hash<int>()(key.second) << 1);
+        }
+    };
+
+    static SlotKey make_key(const std::string& topic, int partition) {
+        return SlotKey(topic, partition);
+    }
+
+    // FNV-1a; stable across runs, unlike std::hash
+    static uint64_t hash_topic(const std::string& topic) {
+        uint64_t output = 0xcbf29ce484222325ULL;
+        for (const char character : topic) {
+            output ^= static_cast<unsigned char>(character);
+            output *= 0x100000001b3ULL;
+        }
+        return output;
+    }
+
+    void initialize_file(const std::string& path, size_t capacity) {
+        if (capacity == 0) {
+            ::close(fd_);
+            throw Exception("Checkpoint store capacity can't be 0");
+        }
+        mapping_size_ = sizeof(Header) + capacity * sizeof(Slot);
+        if (ftruncate(fd_, static_cast<off_t>(mapping_size_)) == -1) {
+            ::close(fd_);
+            throw Exception("Failed to size checkpoint file: " + path);
+        }
+        map_file(path);
+        // The file is zero-filled, so every slot is already in the empty state;
+        // publish the header last
+        Header* file_header = header();
+        file_header->version = VERSION;
+        file_header->capacity = capacity;
+        file_header->magic = MAGIC;
+    }
+
+    void map_existing_file(const std::string& path, size_t file_size) {
+        if (file_size < sizeof(Header)) {
+            ::close(fd_);
+            throw Exception("Not a checkpoint file: " + path);
+        }
+        mapping_size_ = file_size;
+        map_file(path);
+        const Header* file_header = header();
+        if (file_header->magic != MAGIC) {
+            throw Exception("Not a checkpoint file: " + path);
+        }
+        if (file_header->version != VERSION) {
+            throw Exception("Unsupported checkpoint file version: " +
+                            std::to_string(file_header->version));
+        }
+        if (mapping_size_ != sizeof(Header) + file_header->capacity * sizeof(Slot)) {
+            throw Exception("Corrupt checkpoint file: " + path);
+        }
+    }
+
+    void map_file(const std::string& path) {
+        mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd_, 0);
+        if (mapping_ == MAP_FAILED) {
+            ::close(fd_);
+            throw Exception("Failed to map checkpoint file: " + path);
+        }
+    }
+
+    // Rebuilds the (topic, partition) -> slot index from the mapped file
+    void index_slots() {
+        Slot* slots = first_slot();
+        const size_t capacity = header()->capacity;
+        for (size_t i = 0; i < capacity; ++i) {
+            Slot& slot = slots[i];
+            if (slot.state.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            const size_t prefix_length = strnlen(slot.topic_prefix, TOPIC_PREFIX_SIZE);
+            if (prefix_length < TOPIC_PREFIX_SIZE) {
+                // The prefix holds the complete topic name
+                slot_index_.emplace(make_key(std::string(slot.topic_prefix, prefix_length),
+                                             slot.partition),
+                                    &slot);
+            }
+            // Possibly truncated names are only reachable through their hash
+            hash_index_.emplace(std::make_pair(slot.topic_hash, slot.partition), &slot);
+        }
+    }
+
+    Slot* find_or_claim_slot(const std::string& topic, int partition) {
+        std::lock_guard<std::mutex> _(mutex_);
+        const auto iter = slot_index_.find(make_key(topic, partition));
+        if (iter != slot_index_.end()) {
+            return iter->second;
+        }
+        // Long topic names are truncated in the prefix; fall back to the hash
+        // index so they still map to their original slot
+        const uint64_t topic_hash = hash_topic(topic);
+        const auto hash_iter = hash_index_.find(std::make_pair(topic_hash, partition));
+        if (hash_iter != hash_index_.end()) {
+            slot_index_.emplace(make_key(topic, partition), hash_iter->second);
+            return hash_iter->second;
+        }
+        // Claim an empty slot, probing linearly from the hash position
+        Slot* slots = first_slot();
+        const size_t capacity = header()->capacity;
+        for (size_t i = 0; i < capacity; ++i) {
+            Slot& slot = slots[(topic_hash + i) % capacity];
+            if (slot.state.load(std::memory_order_relaxed) != 0) {
+                continue;
+            }
+            slot.topic_hash = topic_hash;
+            slot.partition = partition;
+            std::memset(slot.topic_prefix, 0, TOPIC_PREFIX_SIZE);
+            std::memcpy(slot.topic_prefix, topic.data(),
+                        std::min(topic.size(), TOPIC_PREFIX_SIZE));
+            slot.offset.store(TopicPartition::OFFSET_INVALID, std::memory_order_relaxed);
+            // Publish the slot only once its identity is in place
+            slot.state.store(1, std::memory_order_release);
+            slot_index_.emplace(make_key(topic, partition), &slot);
+            hash_index_.emplace(std::make_pair(topic_hash, partition), &slot);
+            return &slot;
+        }
+        throw Exception("Checkpoint store is full");
+    }
+
+    Header* header() {
+        return static_cast<Header*>(mapping_);
+    }
+
+    const Header* header() const {
+        return static_cast<const Header*>(mapping_);
+    }
+
+    Slot* first_slot() {
+        return reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(Header));
+    }
+
+    struct HashKeyHash {
+        size_t operator()(const std::pair<uint64_t, int>& key) const {
+            return static_cast<size_t>(key.first) ^
+                   (std::hash<int>()(key.second) << 1);
+        }
+    };
+
+    std::unordered_map<SlotKey, Slot*, SlotKeyHash> slot_index_;
+    std::unordered_map<std::pair<uint64_t, int>, Slot*, HashKeyHash> hash_index_;
+    mutable std::mutex mutex_;
+    void* mapping_{nullptr};
+    size_t mapping_size_{0};
+    int fd_{-1};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_OFFSET_CHECKPOINT_STORE_H
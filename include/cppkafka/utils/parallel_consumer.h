@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_PARALLEL_CONSUMER_H
+#define CPPKAFKA_PARALLEL_CONSUMER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "poll_strategy_base.h"
+
+namespace cppkafka {
+
+/**
+ * \class ParallelConsumer
+ *
+ * \brief Processes assigned partitions on a pool of worker threads
+ *
+ * Each assigned partition's queue is pinned to exactly one worker, so messages
+ * belonging to one partition are always processed in order by a single thread while
+ * different partitions progress in parallel. Partition queues are created and torn
+ * down through the rebalance bookkeeping inherited from PollStrategyBase, chaining
+ * any assignment/revocation callbacks the application had already installed.
+ *
+ * A separate service thread keeps consuming the main consumer queue so group
+ * membership, rebalances and messages not belonging to any partition queue keep
+ * being serviced.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * ParallelConsumer parallel(consumer, 8);
+ * parallel.set_message_callback([](Message message) {
+ *     if (message.get_error()) {
+ *         // handle error
+ *         return;
+ *     }
+ *     // process message (called concurrently, one thread per partition)
+ * });
+ * parallel.start();
+ * ...
+ * parallel.stop();
+ * \endcode
+ *
+ * \warning The message callback runs concurrently on multiple workers. It is only
+ * serialized with respect to messages of the same partition.
+ */
+class CPPKAFKA_API ParallelConsumer : public PollStrategyBase {
+public:
+    /**
+     * Callback invoked on a worker thread for each consumed message.
+     *
+     * Messages carrying an error (including EOF notifications if enabled) are
+     * passed through as well and should be checked via Message::get_error.
+     */
+    using MessageCallback = std::function<void(Message)>;
+
+    /**
+     * \brief Constructor
+     *
+     * \param consumer A reference to the polled consumer instance
+     * \param num_workers The number of worker threads. Defaults to the amount of
+     *                    hardware threads.
+     */
+    explicit ParallelConsumer(Consumer& consumer, size_t num_workers = 0);
+
+    /**
+     * \brief Destructor. Stops the workers if still running.
+     */
+    ~ParallelConsumer();
+
+    /**
+     * \brief Sets the per-message callback invoked on the workers
+     *
+     * Must be called before start().
+     *
+     * \param callback The callback to be set
+     */
+    void set_message_callback(MessageCallback callback);
+
+    /**
+     * \brief Sets the maximum amount of messages consumed from a partition queue at once
+     *
+     * \param batch_size The batch size (default 64)
+     */
+    void set_batch_size(size_t batch_size);
+
+    /**
+     * Gets the maximum amount of messages consumed from a partition queue at once
+     */
+    size_t get_batch_size() const;
+
+    /**
+     * Gets the number of worker threads
+     */
+    size_t get_num_workers() const;
+
+    /**
+     * \brief Starts the worker and service threads
+     */
+    void start();
+
+    /**
+     * \brief Stops all threads and waits for them to finish
+     */
+    void stop();
+
+    /**
+     * \sa PollStrategyBase::assign
+     */
+    void assign(TopicPartitionList& partitions) override;
+
+    /**
+     * \sa PollStrategyBase::revoke
+     */
+    void revoke(const TopicPartitionList& partitions) override;
+
+    /**
+     * \sa PollStrategyBase::revoke
+     */
+    void revoke() override;
+protected:
+    /**
+     * \brief Rebuilds the partition-to-worker pinning
+     *
+     * \sa PollStrategyBase::reset_state
+     */
+    void reset_state() override;
+private:
+    // The queues owned by one worker, guarded against rebalances
+    struct WorkerContext {
+        std::mutex mutex;
+        std::vector<Queue*> queues;
+    };
+
+    static const std::chrono::milliseconds IDLE_WAIT_INTERVAL;
+    static const std::chrono::milliseconds SERVICE_POLL_INTERVAL;
+
+    void worker_loop(size_t index);
+    void service_loop();
+    std::vector<std::unique_lock<std::mutex>> lock_all_workers();
+
+    std::vector<std::unique_ptr<WorkerContext>> workers_;
+    std::vector<std::thread> threads_;
+    std::thread service_thread_;
+    MessageCallback message_callback_;
+    size_t batch_size_{64};
+    std::atomic<bool> running_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_PARALLEL_CONSUMER_H
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_PAYLOAD_ARENA_H
+#define CPPKAFKA_PAYLOAD_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace cppkafka {
+
+/**
+ * \brief Slab arena for message builder payload storage
+ *
+ * Allocations are carved sequentially out of large slabs (a pointer bump plus a
+ * reference count increment) instead of hitting the system allocator once per
+ * payload/key/header string. A slab is returned wholesale once every allocation
+ * made from it has been freed, which for a BufferedProducer happens when the
+ * corresponding delivery reports arrive and the buffered builders are destroyed.
+ *
+ * Use it through ArenaAllocator, which satisfies the standard Allocator
+ * requirements and can therefore cover both the builder queue nodes and the
+ * payload bytes themselves:
+ *
+ * \code
+ * using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+ * using ArenaBuilder = ConcreteMessageBuilder<ArenaString>;
+ *
+ * auto arena = std::make_shared<PayloadArena>();
+ * BufferedProducer<ArenaString, ArenaAllocator<ArenaBuilder>>
+ *     producer(config, ArenaAllocator<ArenaBuilder>(arena));
+ * \endcode
+ *
+ * \remark This class is thread safe.
+ */
+class PayloadArena {
+public:
+    /**
+     * Default slab size (1MB)
+     */
+    static constexpr size_t DEFAULT_SLAB_SIZE = 1024 * 1024;
+
+    /**
+     * Maximum number of empty slabs kept around for reuse
+     */
+    static constexpr size_t MAX_FREE_SLABS = 4;
+
+    /**
+     * \brief Constructs an arena
+     *
+     * \param slab_size The size of each slab. Allocations larger than this get a
+     *                  dedicated slab.
+     */
+    explicit PayloadArena(size_t slab_size = DEFAULT_SLAB_SIZE)
+    : slab_size_(slab_size) {
+    }
+
+    PayloadArena(const PayloadArena&) = delete;
+    PayloadArena& operator=(const PayloadArena&) = delete;
+
+    ~PayloadArena() {
+        destroy_slab(current_slab_);
+        for (Slab* slab : free_slabs_) {
+            destroy_slab(slab);
+        }
+    }
+
+    /**
+     * \brief Allocates a chunk of the given size out of the current slab
+     *
+     * \param size The amount of bytes to allocate
+     *
+     * \return A pointer aligned for any scalar type
+     */
+    void* allocate(size_t size) {
+        const size_t total_size = aligned_size(size) + HEADER_SIZE;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (total_size > slab_size_) {
+            // Payload doesn't fit in a regular slab; give it a dedicated one
+            Slab* slab = create_slab(total_size);
+            slab->live_allocations.store(1, std::memory_order_relaxed);
+            slab->used = slab->size;
+            return write_header(slab, slab->data());
+        }
+        if (!current_slab_ || (current_slab_->size - current_slab_->used) < total_size) {
+            retire_current_slab();
+            current_slab_ = acquire_slab();
+        }
+        unsigned char* ptr = current_slab_->data() + current_slab_->used;
+        current_slab_->used += total_size;
+        current_slab_->live_allocations.fetch_add(1, std::memory_order_relaxed);
+        return write_header(current_slab_, ptr);
+    }
+
+    /**
+     * \brief Releases a chunk previously returned by allocate
+     *
+     * The memory is not reclaimed individually; once the last live allocation of a
+     * retired slab is released, the whole slab is recycled at once.
+     *
+     * \param ptr The pointer to be released
+     */
+    void deallocate(void* ptr) {
+        Slab* slab = read_header(ptr);
+        // The arena holds a +1 bias on the current slab (dropped by
+        // retire_current_slab), so the count can only hit zero here once the
+        // slab was retired - reaching it is an exclusive claim to reclaim
+        if (slab->live_allocations.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            recycle_slab(slab);
+        }
+    }
+
+    /**
+     * \brief Gets the total number of bytes currently held in slabs
+     */
+    size_t get_reserved_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t total = current_slab_ ? current_slab_->size : 0;
+        for (const Slab* slab : free_slabs_) {
+            total += slab->size;
+        }
+        return total;
+    }
+private:
+    // Aligned (and thereby padded) so data() starts on a max_align_t boundary;
+    // together with the max_align_t sized header and aligned_size bumps this
+    // keeps every returned pointer aligned for any scalar type, as promised
+    struct alignas(alignof(std::max_align_t)) Slab {
+        std::atomic<size_t> live_allocations{0};
+        size_t used{0};
+        size_t size{0};
+
+        unsigned char* data() {
+            return reinterpret_cast<unsigned char*>(this + 1);
+        }
+    };
+
+    // Each allocation is prefixed with a pointer back to its owning slab
+    static constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+    static size_t aligned_size(size_t size) {
+        const size_t alignment = alignof(std::max_align_t);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    static void* write_header(Slab* slab, unsigned char* ptr) {
+        *reinterpret_cast<Slab**>(ptr) = slab;
+        return ptr + HEADER_SIZE;
+    }
+
+    static Slab* read_header(void* ptr) {
+        unsigned char* header = static_cast<unsigned char*>(ptr) - HEADER_SIZE;
+        return *reinterpret_cast<Slab**>(header);
+    }
+
+    static Slab* create_slab(size_t size) {
+        void* memory = ::operator new(sizeof(Slab) + size);
+        Slab* slab = new (memory) Slab();
+        slab->size = size;
+        return slab;
+    }
+
+    static void destroy_slab(Slab* slab) {
+        if (slab) {
+            slab->~Slab();
+            ::operator delete(slab);
+        }
+    }
+
+    // The following helpers assume mutex_ is held
+
+    Slab* acquire_slab() {
+        Slab* slab;
+        if (!free_slabs_.empty()) {
+            slab = free_slabs_.back();
+            free_slabs_.pop_back();
+            slab->used = 0;
+        }
+        else {
+            slab = create_slab(slab_size_);
+        }
+        // Bias the count while the slab is current so concurrent deallocations
+        // can never drive it to zero and reclaim it out from under the arena
+        slab->live_allocations.store(1, std::memory_order_relaxed);
+        return slab;
+    }
+
+    void retire_current_slab() {
+        if (current_slab_) {
+            // Drop the arena's bias. Exactly one party observes the drop to
+            // zero - this call if every allocation was already released, or
+            // the last deallocate otherwise - so the slab is reclaimed once
+            if (current_slab_->live_allocations.fetch_sub(1,
+                                                          std::memory_order_acq_rel) == 1) {
+                recycle_slab(current_slab_);
+            }
+            current_slab_ = nullptr;
+        }
+    }
+
+    void recycle_slab(Slab* slab) {
+        if (slab->size == slab_size_ && free_slabs_.size() < MAX_FREE_SLABS) {
+            free_slabs_.push_back(slab);
+        }
+        else {
+            destroy_slab(slab);
+        }
+    }
+
+    const size_t slab_size_;
+    mutable std::mutex mutex_;
+    Slab* current_slab_{nullptr};
+    std::vector<Slab*> free_slabs_;
+};
+
+/**
+ * \brief Standard conforming allocator backed by a PayloadArena
+ *
+ * All instances rebound from the same arena compare equal, so this allocator can be
+ * used both as the BufferedProducer queue allocator and inside payload-owning buffer
+ * types such as std::basic_string or std::vector.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    /**
+     * Constructs an allocator backed by its own arena
+     */
+    ArenaAllocator()
+    : arena_(std::make_shared<PayloadArena>()) {
+    }
+
+    /**
+     * Constructs an allocator backed by the given arena
+     *
+     * \param arena The arena to allocate from
+     */
+    ArenaAllocator(std::shared_ptr<PayloadArena> arena)
+    : arena_(std::move(arena)) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs)
+    : arena_(rhs.get_arena()) {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena_->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t /*count*/) {
+        arena_->deallocate(ptr);
+    }
+
+    /**
+     * Gets the underlying arena
+     */
+    const std::shared_ptr<PayloadArena>& get_arena() const {
+        return arena_;
+    }
+private:
+    std::shared_ptr<PayloadArena> arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+    return lhs.get_arena() == rhs.get_arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+    return !(lhs == rhs);
+}
+
+} // cppkafka
+
+#endif // CPPKAFKA_PAYLOAD_ARENA_H
@@ -30,10 +30,10 @@
 #ifndef CPPKAFKA_POLL_STRATEGY_BASE_H
 #define CPPKAFKA_POLL_STRATEGY_BASE_H
 
-#include <map>
 #include <any>
 #include "../queue.h"
 #include "../topic_partition_list.h"
+#include "../topic_partition_map.h"
 #include "poll_interface.h"
 #include "../macros.h"
 
@@ -55,7 +55,9 @@ struct QueueData {
  */
 class CPPKAFKA_API PollStrategyBase : public PollInterface {
 public:
-    using QueueMap = std::map<TopicPartition, QueueData>;
+    // Interned topics + dense partition arrays; per-message queue lookups
+    // don't pay the per-tree-level string compares of a std::map
+    using QueueMap = TopicPartitionMap<QueueData>;
     
     /**
      * \brief Constructor
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_POLLING_CONSUMER_H
+#define CPPKAFKA_POLLING_CONSUMER_H
+
+#include <chrono>
+#include <utility>
+#include <vector>
+#include "../consumer.h"
+#include "../message.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Statically dispatched front end for a poll strategy
+ *
+ * Holding a strategy behind a PollInterface pointer makes every poll() an
+ * indirect virtual call, and at high poll rates the call can neither be
+ * inlined nor predicted reliably. PollingConsumer composes the strategy by
+ * value instead: member calls on an object - as opposed to a pointer or
+ * reference - are bound statically by the language, so
+ * PollingConsumer<RoundRobinPollStrategy>::poll() resolves at compile time
+ * and the queue selection logic is inlineable into the caller's poll loop.
+ * The strategy's rebalance hooks keep their virtual dispatch, but those only
+ * run on assignment changes, not per fetch.
+ *
+ * Any type providing the PollInterface method set works as the strategy;
+ * deriving from PollInterface is not required.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ * PollingConsumer<RoundRobinPollStrategy> polling_consumer(consumer);
+ *
+ * while (running) {
+ *     Message message = polling_consumer.poll();
+ *     if (message) {
+ *         // process it
+ *     }
+ * }
+ * \endcode
+ *
+ * \tparam PollStrategy The strategy type, composed by value
+ */
+template <typename PollStrategy>
+class PollingConsumer {
+public:
+    /**
+     * \brief Constructs an instance, forwarding the arguments to the strategy
+     *
+     * \param args The strategy's constructor arguments (typically the Consumer)
+     */
+    template <typename... Args>
+    explicit PollingConsumer(Args&&... args)
+    : strategy_(std::forward<Args>(args)...) {
+    }
+
+    /**
+     * \sa PollInterface::get_consumer
+     */
+    Consumer& get_consumer() {
+        return strategy_.get_consumer();
+    }
+
+    /**
+     * \sa PollInterface::set_timeout
+     */
+    void set_timeout(std::chrono::milliseconds timeout) {
+        strategy_.set_timeout(timeout);
+    }
+
+    /**
+     * \sa PollInterface::get_timeout
+     */
+    std::chrono::milliseconds get_timeout() {
+        return strategy_.get_timeout();
+    }
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll() {
+        return strategy_.poll();
+    }
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll(std::chrono::milliseconds timeout) {
+        return strategy_.poll(timeout);
+    }
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size) {
+        return strategy_.poll_batch(max_batch_size);
+    }
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size, std::chrono::milliseconds timeout) {
+        return strategy_.poll_batch(max_batch_size, timeout);
+    }
+
+    /**
+     * \brief Gets the composed strategy
+     *
+     * For strategy-specific operations such as PollStrategyBase::assign
+     */
+    PollStrategy& get_strategy() {
+        return strategy_;
+    }
+
+    /**
+     * \brief Gets the composed strategy
+     */
+    const PollStrategy& get_strategy() const {
+        return strategy_;
+    }
+private:
+    PollStrategy strategy_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_POLLING_CONSUMER_H
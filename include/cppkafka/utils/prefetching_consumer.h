@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_PREFETCHING_CONSUMER_H
+#define CPPKAFKA_PREFETCHING_CONSUMER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "poll_interface.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Hides poll latency by prefetching message batches on a background thread
+ *
+ * A plain consume loop alternates between polling (I/O bound) and processing (CPU
+ * bound), leaving each side idle half of the time. This adapter runs
+ * Consumer::poll_batch on a dedicated fetcher thread which deposits full batches
+ * into a small bounded buffer, so the application thread nearly always finds a
+ * batch ready and never waits on the broker round trip itself.
+ *
+ * Backpressure is applied through the consumer's pause/resume mechanism: when the
+ * buffer is full the fetcher pauses all assigned partitions but keeps polling, so
+ * heartbeats and rebalance callbacks continue to be serviced while no new messages
+ * are fetched. Partitions are resumed as soon as the application drains a batch.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(config);
+ * consumer.subscribe({ "my_topic" });
+ *
+ * PrefetchingConsumer prefetcher(consumer);
+ * prefetcher.start();
+ * while (running) {
+ *     Message msg = prefetcher.poll();
+ *     if (msg) {
+ *         // process, overlapping with the next fetch
+ *     }
+ * }
+ * prefetcher.stop();
+ * \endcode
+ *
+ * \warning poll() and poll_batch() must be called from a single application thread.
+ *
+ * \warning Calling poll() or poll_batch() directly on the Consumer object while the
+ * prefetcher is running will interleave with the fetcher thread and lead to
+ * undesired results.
+ */
+class CPPKAFKA_API PrefetchingConsumer : public PollInterface {
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param consumer A reference to the polled consumer instance
+     * \param batch_size The batch size used when fetching (default 256)
+     * \param max_buffered_batches Maximum amount of batches buffered ahead of the
+     *                             application (default 2, i.e. double buffering)
+     */
+    explicit PrefetchingConsumer(Consumer& consumer,
+                                 size_t batch_size = 256,
+                                 size_t max_buffered_batches = 2);
+
+    /**
+     * \brief Destructor. Stops the fetcher thread if still running.
+     */
+    ~PrefetchingConsumer();
+
+    /**
+     * \brief Starts the fetcher thread
+     */
+    void start();
+
+    /**
+     * \brief Stops the fetcher thread and waits for it to finish
+     *
+     * Batches already buffered remain available through poll()/poll_batch().
+     */
+    void stop();
+
+    /**
+     * \sa PollInterface::get_consumer
+     */
+    Consumer& get_consumer() override;
+
+    /**
+     * \sa PollInterface::set_timeout
+     */
+    void set_timeout(std::chrono::milliseconds timeout) override;
+
+    /**
+     * \sa PollInterface::get_timeout
+     */
+    std::chrono::milliseconds get_timeout() override;
+
+    /**
+     * \brief Polls the next prefetched message
+     *
+     * \sa PollInterface::poll
+     */
+    Message poll() override;
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll(std::chrono::milliseconds timeout) override;
+
+    /**
+     * \brief Polls up to max_batch_size prefetched messages
+     *
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size) override;
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size,
+                                    std::chrono::milliseconds timeout) override;
+private:
+    void fetcher_loop();
+    // Ensures the front batch has unconsumed messages, waiting up to the deadline
+    bool refill_current_batch(std::chrono::steady_clock::time_point deadline);
+
+    Consumer& consumer_;
+    std::thread fetcher_thread_;
+    std::mutex buffer_mutex_;
+    std::condition_variable batch_available_;
+    std::deque<std::vector<Message>> buffered_batches_;
+    // Batch currently being drained by the application thread
+    std::vector<Message> current_batch_;
+    size_t current_index_{0};
+    size_t batch_size_;
+    size_t max_buffered_batches_;
+    std::atomic<bool> running_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_PREFETCHING_CONSUMER_H
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_SHARDED_CONSUMER_H
+#define CPPKAFKA_SHARDED_CONSUMER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../consumer.h"
+#include "../macros.h"
+#include "mpsc_ring_buffer.h"
+
+namespace cppkafka {
+
+/**
+ * \class ShardedConsumer
+ *
+ * \brief Scales group consumption across multiple Consumer instances
+ *
+ * A single Consumer is serviced by one poll thread, which caps how much of a box a
+ * consumer group member can use. ShardedConsumer owns N Consumer instances created
+ * from the same Configuration (and therefore joining the same group), runs one poll
+ * thread per shard, optionally pins each thread to a CPU, and merges the consumed
+ * messages into a single stream exposed through an aggregate poll_batch. The broker
+ * balances the subscribed partitions across the shards like it would across separate
+ * processes.
+ *
+ * Rebalance notifications from all shards are funneled through one set of callbacks
+ * that additionally receive the shard index, so applications observe assignment
+ * changes in one place instead of wiring up N consumers themselves.
+ *
+ * Example:
+ *
+ * \code
+ * ShardedConsumer consumer(config, 4);
+ * consumer.subscribe({ "my_topic" });
+ * consumer.start();
+ * while (running) {
+ *     for (Message& message : consumer.poll_batch(512, milliseconds(100))) {
+ *         // process message
+ *     }
+ * }
+ * consumer.stop();
+ * \endcode
+ *
+ * \remark Messages of one partition always come from the same shard, so the merged
+ * stream preserves per-partition ordering; the interleaving between partitions is
+ * unspecified.
+ *
+ * \warning Offsets should be committed either automatically (enable.auto.commit) or
+ * through the owning shard obtained via get_shard; messages do not track which shard
+ * consumed them.
+ */
+class CPPKAFKA_API ShardedConsumer {
+public:
+    /**
+     * Callback invoked on a shard's poll thread when partitions are assigned to it
+     */
+    using AssignmentCallback = std::function<void(size_t shard, TopicPartitionList&)>;
+
+    /**
+     * Callback invoked on a shard's poll thread when partitions are revoked from it
+     */
+    using RevocationCallback = std::function<void(size_t shard,
+                                                  const TopicPartitionList&)>;
+
+    /**
+     * Callback invoked on a shard's poll thread on rebalance errors
+     */
+    using RebalanceErrorCallback = std::function<void(size_t shard, Error)>;
+
+    /**
+     * \brief Constructor
+     *
+     * Creates one Consumer per shard, each from a copy of the given configuration.
+     * The configuration must therefore carry a group.id.
+     *
+     * \param config The configuration used for every shard
+     * \param num_shards The number of shards. Defaults to the amount of hardware
+     *                   threads.
+     */
+    explicit ShardedConsumer(Configuration config, size_t num_shards = 0);
+
+    /**
+     * \brief Destructor. Stops the poll threads if still running.
+     */
+    ~ShardedConsumer();
+
+    ShardedConsumer(const ShardedConsumer&) = delete;
+    ShardedConsumer& operator=(const ShardedConsumer&) = delete;
+
+    /**
+     * \brief Sets the unified assignment callback
+     *
+     * Must be called before start().
+     *
+     * \param callback The callback to be set
+     */
+    void set_assignment_callback(AssignmentCallback callback);
+
+    /**
+     * \brief Sets the unified revocation callback
+     *
+     * Must be called before start().
+     *
+     * \param callback The callback to be set
+     */
+    void set_revocation_callback(RevocationCallback callback);
+
+    /**
+     * \brief Sets the unified rebalance error callback
+     *
+     * Must be called before start().
+     *
+     * \param callback The callback to be set
+     */
+    void set_rebalance_error_callback(RebalanceErrorCallback callback);
+
+    /**
+     * \brief Sets the CPUs the shard poll threads are pinned to
+     *
+     * Shard i is pinned to cpus[i % cpus.size()]. By default shard i is pinned to
+     * CPU i modulo the amount of hardware threads; passing an empty list disables
+     * pinning altogether. Only effective on Linux; a no-op elsewhere.
+     *
+     * Must be called before start().
+     *
+     * \param cpus The CPU indexes to pin to
+     */
+    void set_cpu_affinity(std::vector<int> cpus);
+
+    /**
+     * \brief Sets the maximum amount of messages each shard fetches per poll
+     *
+     * \param batch_size The batch size (default 64)
+     */
+    void set_shard_batch_size(size_t batch_size);
+
+    /**
+     * \brief Subscribes every shard to the given topics
+     *
+     * \param topics The topics to subscribe to
+     */
+    void subscribe(const std::vector<std::string>& topics);
+
+    /**
+     * Unsubscribes every shard
+     */
+    void unsubscribe();
+
+    /**
+     * Gets the number of shards
+     */
+    size_t get_num_shards() const;
+
+    /**
+     * \brief Gets the consumer backing the given shard
+     *
+     * \param index The shard index
+     */
+    Consumer& get_shard(size_t index);
+
+    /**
+     * \brief Gets the partitions currently assigned across all shards
+     */
+    TopicPartitionList get_assignment();
+
+    /**
+     * \brief Starts the shard poll threads
+     */
+    void start();
+
+    /**
+     * \brief Stops the shard poll threads and waits for them to finish
+     *
+     * The shard consumers themselves stay alive (and leave the group) only when the
+     * ShardedConsumer is destroyed.
+     */
+    void stop();
+
+    /**
+     * \brief Polls the merged stream for a batch of messages
+     *
+     * Waits up to the given timeout for the first message, then drains whatever the
+     * shards have already produced, up to max_batch_size messages.
+     *
+     * \param messages The vector the messages are appended to
+     * \param max_batch_size The maximum amount of messages to return
+     * \param timeout The maximum time to wait for the first message
+     *
+     * \return The amount of messages appended
+     */
+    size_t poll_batch(std::vector<Message>& messages, size_t max_batch_size,
+                      std::chrono::milliseconds timeout);
+
+    /**
+     * \brief Polls the merged stream for a batch of messages
+     *
+     * \param max_batch_size The maximum amount of messages to return
+     * \param timeout The maximum time to wait for the first message
+     *
+     * \return The polled messages
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size,
+                                    std::chrono::milliseconds timeout);
+private:
+    static const std::chrono::milliseconds SHARD_POLL_INTERVAL;
+    static const std::chrono::milliseconds IDLE_WAIT_INTERVAL;
+
+    void shard_loop(size_t index);
+    void apply_affinity(size_t index);
+
+    std::vector<std::unique_ptr<Consumer>> shards_;
+    std::vector<std::thread> threads_;
+    MpscRingBuffer<Message> ring_;
+    AssignmentCallback assignment_callback_;
+    RevocationCallback revocation_callback_;
+    RebalanceErrorCallback rebalance_error_callback_;
+    std::optional<std::vector<int>> affinity_;
+    size_t shard_batch_size_{64};
+    std::atomic<bool> running_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_SHARDED_CONSUMER_H
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_SHARDED_QUEUE_H
+#define CPPKAFKA_SHARDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cppkafka {
+
+/**
+ * \brief Thread-sharded queue policy for BufferedProducer
+ *
+ * The queue is split into a fixed number of shards, each one a std::deque guarded by
+ * its own mutex. Every producing thread is pinned to one shard (assigned round-robin
+ * on first use), so with at least as many shards as producing threads, add_message
+ * never contends on a shared lock or dirties another thread's cache lines. Consuming
+ * (i.e. flushing) visits the shards in rotating order and merges their contents.
+ *
+ * Example:
+ *
+ * \code
+ * using Builder = ConcreteMessageBuilder<std::string>;
+ * using Shards = ShardedQueue<Builder>;
+ *
+ * BufferedProducer<std::string, std::allocator<Builder>, Shards> producer(config);
+ * \endcode
+ *
+ * \remark Messages are popped in per-shard FIFO order; the interleaving between
+ * shards is unspecified, just like the ordering between producing threads already is
+ * with the default single-queue policy.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class ShardedQueue {
+public:
+    /**
+     * Marker used by BufferedProducer to detect internally synchronized queue policies
+     */
+    static constexpr bool concurrent = true;
+
+    /**
+     * \brief Constructs a queue with one shard per hardware thread
+     *
+     * \param alloc The optionally supplied allocator for the shard deques
+     */
+    explicit ShardedQueue(const Allocator& alloc = Allocator())
+    : ShardedQueue(default_shard_count(), alloc) {
+    }
+
+    /**
+     * \brief Constructs a queue with the given amount of shards
+     *
+     * \param shard_count The number of shards to create
+     * \param alloc The optionally supplied allocator for the shard deques
+     */
+    ShardedQueue(size_t shard_count, const Allocator& alloc = Allocator()) {
+        shards_.reserve(shard_count > 0 ? shard_count : 1);
+        for (size_t i = 0; i != (shard_count > 0 ? shard_count : 1); ++i) {
+            shards_.emplace_back(new Shard(alloc));
+        }
+    }
+
+    ShardedQueue(const ShardedQueue&) = delete;
+    ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+    /**
+     * \brief Pushes an element into the calling thread's shard
+     *
+     * \param args Arguments forwarded to the element's constructor
+     */
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        Shard& shard = *shards_[shard_index()];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.queue.emplace_back(std::forward<Args>(args)...);
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Pops the next element and hands it to the given functor
+     *
+     * Shards are visited in rotating order so consumption is fair across producing
+     * threads.
+     *
+     * \param on_element Functor invoked as on_element(T&&)
+     *
+     * \return True if an element was consumed, false if all shards were empty
+     */
+    template <typename Functor>
+    bool try_pop(Functor&& on_element) {
+        const size_t count = shards_.size();
+        const size_t start = pop_cursor_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i != count; ++i) {
+            Shard& shard = *shards_[(start + i) % count];
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            if (!shard.queue.empty()) {
+                T element = std::move(shard.queue.front());
+                shard.queue.pop_front();
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                // Invoke the functor outside the lock: a failed delivery
+                // re-enqueues through emplace_back on this same thread, and
+                // its shard may well be the one being popped
+                lock.unlock();
+                on_element(std::move(element));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Discards all buffered elements
+     */
+    void clear() {
+        for (const std::unique_ptr<Shard>& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            size_.fetch_sub(shard->queue.size(), std::memory_order_relaxed);
+            shard->queue.clear();
+        }
+    }
+
+    /**
+     * Gets the total amount of buffered elements across all shards
+     */
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Indicates whether all shards are empty
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Gets the number of shards
+     */
+    size_t get_shard_count() const {
+        return shards_.size();
+    }
+private:
+    static constexpr size_t CACHELINE_SIZE = 64;
+
+    // Each shard sits on its own cache line(s) so producing threads don't
+    // false-share while appending
+    struct alignas(CACHELINE_SIZE) Shard {
+        explicit Shard(const Allocator& alloc)
+        : queue(alloc) {
+        }
+        std::mutex mutex;
+        std::deque<T, Allocator> queue;
+    };
+
+    static size_t default_shard_count() {
+        const unsigned int threads = std::thread::hardware_concurrency();
+        return threads > 0 ? threads : 1;
+    }
+
+    // Assigns each thread a stable shard, round-robin over all ShardedQueue
+    // instances on first use
+    size_t shard_index() const {
+        static std::atomic<size_t> next_thread_index{0};
+        static thread_local size_t thread_index =
+            next_thread_index.fetch_add(1, std::memory_order_relaxed);
+        return thread_index % shards_.size();
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> pop_cursor_{0};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_SHARDED_QUEUE_H
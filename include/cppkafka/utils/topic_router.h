@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_TOPIC_ROUTER_H
+#define CPPKAFKA_TOPIC_ROUTER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include "../exceptions.h"
+#include "../message_builder.h"
+#include "../producer.h"
+#include "../topic.h"
+#include "../topic_configuration.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Routes produced messages to a fixed set of pre-created topics
+ *
+ * Producers serving a fixed topic set pay a per-message cost for resolving the
+ * topic by name: rdkafka looks the string up in its internal topic table under
+ * a lock on every producev call. TopicRouter creates each topic handle exactly
+ * once at registration time and stores it in an array indexed by the user's
+ * enum, so routing a message is an array index; with the compile-time overload
+ * even the index is a constant:
+ *
+ * \code
+ * enum class TopicId { Orders, Trades, NUM_TOPICS };
+ *
+ * TopicRouter<TopicId> router(producer);
+ * router.register_topic(TopicId::Orders, "gateway.orders");
+ * router.register_topic(TopicId::Trades, "gateway.trades");
+ *
+ * MessageBuilder builder("");  // the routed topic supersedes the builder's
+ * builder.partition(0).payload(payload);
+ * router.produce<TopicId::Orders>(builder);
+ * \endcode
+ *
+ * The enum's values must be contiguous starting at 0; by default the table
+ * size comes from a NUM_TOPICS terminal enumerator, or it can be passed as the
+ * second template argument.
+ *
+ * \tparam TopicEnum The enum identifying the topics
+ * \tparam NumTopics The table size
+ */
+template <typename TopicEnum, size_t NumTopics = static_cast<size_t>(TopicEnum::NUM_TOPICS)>
+class TopicRouter {
+public:
+    /**
+     * \brief Constructs a router over the given producer
+     *
+     * The producer must outlive the router.
+     *
+     * \param producer The producer used to create topics and produce
+     */
+    explicit TopicRouter(Producer& producer)
+    : producer_(producer) {
+    }
+
+    /**
+     * \brief Creates and stores the topic handle for the given id
+     *
+     * This is the only call that touches rdkafka's topic table; produce calls
+     * afterwards hand rdkafka the stored handle directly. Registering an id
+     * again replaces its topic.
+     *
+     * \param id The topic id to be registered
+     * \param name The topic's name
+     */
+    void register_topic(TopicEnum id, const std::string& name) {
+        topics_.at(to_index(id)) = producer_.get_topic(name);
+    }
+
+    /**
+     * \brief Creates and stores the topic handle for the given id
+     *
+     * \param id The topic id to be registered
+     * \param name The topic's name
+     * \param config The configuration to be used for the new topic
+     */
+    void register_topic(TopicEnum id, const std::string& name, TopicConfiguration config) {
+        topics_.at(to_index(id)) = producer_.get_topic(name, std::move(config));
+    }
+
+    /**
+     * \brief Produces a message to the topic selected at compile time
+     *
+     * The table index is a constant, so after inlining the topic resolution
+     * disappears entirely; rdkafka receives the pre-created handle.
+     *
+     * \tparam Id The topic id to produce to
+     * \param builder The builder class used to compose a message
+     */
+    template <TopicEnum Id>
+    void produce(const MessageBuilder& builder) {
+        static_assert(to_index(Id) < NumTopics, "topic id is out of range");
+        produce_on(topics_[to_index(Id)], builder);
+    }
+
+    /**
+     * \brief Produces a message to the topic selected at runtime
+     *
+     * Still an array index per message; no string hashing or locking.
+     *
+     * \param id The topic id to produce to
+     * \param builder The builder class used to compose a message
+     */
+    void produce(TopicEnum id, const MessageBuilder& builder) {
+        produce_on(topics_.at(to_index(id)), builder);
+    }
+
+    /**
+     * \brief Gets the topic registered under the given compile-time id
+     *
+     * \tparam Id The topic id
+     */
+    template <TopicEnum Id>
+    const Topic& get_topic() const {
+        static_assert(to_index(Id) < NumTopics, "topic id is out of range");
+        return topics_[to_index(Id)];
+    }
+
+    /**
+     * \brief Gets the topic registered under the given id
+     *
+     * \param id The topic id
+     */
+    const Topic& get_topic(TopicEnum id) const {
+        return topics_.at(to_index(id));
+    }
+
+    /**
+     * Gets the producer this router produces through
+     */
+    Producer& get_producer() {
+        return producer_;
+    }
+private:
+    static constexpr size_t to_index(TopicEnum id) {
+        return static_cast<size_t>(id);
+    }
+
+    void produce_on(const Topic& topic, const MessageBuilder& builder) {
+        if (!topic) {
+            throw Exception("Topic id is not registered");
+        }
+        producer_.produce(topic, builder);
+    }
+
+    Producer& producer_;
+    std::array<Topic, NumTopics> topics_;
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_TOPIC_ROUTER_H
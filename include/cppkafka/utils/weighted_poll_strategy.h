@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_WEIGHTED_POLL_STRATEGY_H
+#define CPPKAFKA_WEIGHTED_POLL_STRATEGY_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "../consumer.h"
+#include "../queue.h"
+#include "poll_strategy_base.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Priority- and weight-aware polling of the assigned partition queues
+ *
+ * Like RoundRobinPollStrategy this adapter takes over the partition queues of the
+ * consumer, but instead of treating all queues equally it services them according
+ * to per-topic priorities and weights:
+ *
+ * * Topics with a higher priority strictly preempt lower ones: as long as any
+ *   higher-priority queue has messages, lower-priority queues are not serviced.
+ * * Within the same priority, queues are serviced in deficit round-robin fashion
+ *   proportionally to their weights, so a topic with weight 4 receives roughly
+ *   four times the messages of a topic with weight 1 under sustained load.
+ *
+ * This allows running a latency-sensitive control topic and a bulk topic on a
+ * single consumer without the bulk traffic delaying the control messages, avoiding
+ * the cost of a second consumer group.
+ *
+ * Example:
+ *
+ * \code
+ * Consumer consumer(...);
+ * consumer.subscribe({ "control", "bulk" });
+ *
+ * WeightedPollStrategy poll_strategy(consumer);
+ * // Control messages always preempt bulk ones
+ * poll_strategy.set_topic_priority("control", 1);
+ * while (true) {
+ *     Message msg = poll_strategy.poll();
+ *     ...
+ * }
+ * \endcode
+ *
+ * \warning Calling directly poll() or poll_batch() on the Consumer object while using
+ * this adapter will lead to undesired results since it modifies the internal queuing
+ * mechanism of the Consumer instance it owns.
+ */
+class CPPKAFKA_API WeightedPollStrategy : public PollStrategyBase {
+public:
+    /**
+     * \brief Constructor
+     *
+     * All topics start with priority 0 and weight 1, which behaves like plain
+     * round-robin polling.
+     *
+     * \param consumer A reference to the polled consumer instance
+     */
+    WeightedPollStrategy(Consumer& consumer);
+
+    ~WeightedPollStrategy();
+
+    /**
+     * \brief Sets the priority of a topic's partition queues
+     *
+     * Queues of a higher priority are always serviced before lower-priority ones.
+     *
+     * \param topic The topic name
+     * \param priority The priority (default 0; higher values preempt lower ones)
+     */
+    void set_topic_priority(const std::string& topic, int priority);
+
+    /**
+     * \brief Sets the scheduling weight of a topic's partition queues
+     *
+     * Within the same priority, queues receive service proportionally to their
+     * weights.
+     *
+     * \param topic The topic name
+     * \param weight The weight (default 1; must be greater than 0)
+     */
+    void set_topic_weight(const std::string& topic, size_t weight);
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll() override;
+
+    /**
+     * \sa PollInterface::poll
+     */
+    Message poll(std::chrono::milliseconds timeout) override;
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size) override;
+
+    /**
+     * \sa PollInterface::poll_batch
+     */
+    std::vector<Message> poll_batch(size_t max_batch_size,
+                                    std::chrono::milliseconds timeout) override;
+
+protected:
+    /**
+     * \brief Rebuilds the priority bands from the current assignment
+     *
+     * \sa PollStrategyBase::reset_state
+     */
+    void reset_state() final;
+
+private:
+    // Scheduling state of one partition queue within its priority band
+    struct ScheduledQueue {
+        QueueData*  queue_data;
+        size_t      weight;
+        // Remaining messages this queue may consume before yielding to its peers
+        size_t      credits;
+    };
+
+    // One band per priority; all queues of a band share service proportionally
+    struct PriorityBand {
+        std::vector<ScheduledQueue> queues;
+        // Rotating start position so service within the band is fair across calls
+        size_t                      next_index{0};
+    };
+
+    void rebuild_bands();
+    Message consume_band(PriorityBand& band);
+    void consume_band_batch(PriorityBand& band, std::vector<Message>& messages,
+                            ssize_t& count);
+    static void advance_band(PriorityBand& band);
+    void restore_forwarding();
+
+    // Members. Bands are ordered by descending priority
+    std::map<int, PriorityBand, std::greater<int>>  bands_;
+    std::map<std::string, int>                      topic_priorities_;
+    std::map<std::string, size_t>                   topic_weights_;
+};
+
+} //cppkafka
+
+#endif //CPPKAFKA_WEIGHTED_POLL_STRATEGY_H
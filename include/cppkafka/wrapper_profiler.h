@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef CPPKAFKA_WRAPPER_PROFILER_H
+#define CPPKAFKA_WRAPPER_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "macros.h"
+#include "utils/latency_histogram.h"
+
+namespace cppkafka {
+
+/**
+ * \brief Sampling attribution of cppkafka's own overhead on the hot paths
+ *
+ * In a CPU profile the wrapper's frames interleave with librdkafka's and
+ * attributing cost to one or the other is guesswork. This singleton owns one
+ * nanosecond histogram per instrumented boundary - the stretches of a hot
+ * path that are pure cppkafka, ending where librdkafka takes over (or
+ * starting where it hands back) - and the hot paths feed them through scoped
+ * probes:
+ *
+ * - ProduceWrap: produce() preamble up to the rd_kafka_producev call
+ * - ConsumeWrap: librdkafka's poll returning up to the Message being ready
+ * - PartitionListConversion: topic partition list conversions to/from the
+ *   librdkafka representation
+ *
+ * Disabled by default; a disabled probe is one relaxed atomic load. When
+ * enabled, only one in every SAMPLING_INTERVAL passes through a boundary
+ * takes the two clock readings and records, so the cost stays negligible in
+ * production and the histograms still converge within seconds at any real
+ * throughput.
+ *
+ * \code
+ * WrapperProfiler::instance().enable();
+ * // ... traffic ...
+ * for (const auto& boundary : WrapperProfiler::instance().get_report()) {
+ *     log_histogram(boundary.name, boundary.latencies); // nanoseconds
+ * }
+ * \endcode
+ */
+class CPPKAFKA_API WrapperProfiler {
+public:
+    /**
+     * The instrumented boundaries, each a pure-wrapper stretch of a hot path
+     */
+    enum class Boundary : size_t {
+        ProduceWrap = 0,
+        ConsumeWrap,
+        PartitionListConversion,
+    };
+    static constexpr size_t BOUNDARY_COUNT = 3;
+
+    /**
+     * One in every this many passes through a boundary is timed
+     */
+    static constexpr uint32_t SAMPLING_INTERVAL = 1024;
+
+    /**
+     * Report entry for one boundary
+     */
+    struct BoundaryReport {
+        /**
+         * Stable name of the boundary, suitable as a metric label
+         */
+        const char* name;
+        /**
+         * Sampled durations, in nanoseconds
+         */
+        LatencyHistogram::Snapshot latencies;
+    };
+    using Report = std::array<BoundaryReport, BOUNDARY_COUNT>;
+
+    /**
+     * \brief Times one boundary pass, subject to sampling
+     *
+     * Construct at the start of the boundary and either let it go out of
+     * scope or call stop() where librdkafka takes over. Skipped passes cost
+     * an atomic load and a thread local increment.
+     */
+    class ScopedProbe {
+    public:
+        explicit ScopedProbe(Boundary boundary)
+        : boundary_(boundary) {
+            WrapperProfiler& profiler = instance();
+            if (profiler.is_enabled() && profiler.should_sample()) {
+                start_ = std::chrono::steady_clock::now();
+                sampled_ = true;
+            }
+        }
+
+        ScopedProbe(const ScopedProbe&) = delete;
+        ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+        ~ScopedProbe() {
+            stop();
+        }
+
+        /**
+         * Ends the boundary before the end of the scope
+         */
+        void stop() {
+            if (sampled_) {
+                sampled_ = false;
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                instance().record(boundary_, std::chrono::duration_cast<
+                    std::chrono::nanoseconds>(elapsed).count());
+            }
+        }
+    private:
+        Boundary boundary_;
+        std::chrono::steady_clock::time_point start_;
+        bool sampled_{false};
+    };
+
+    /**
+     * Gets the process wide profiler
+     */
+    static WrapperProfiler& instance();
+
+    WrapperProfiler(const WrapperProfiler&) = delete;
+    WrapperProfiler& operator=(const WrapperProfiler&) = delete;
+
+    /**
+     * Starts sampling the instrumented boundaries
+     */
+    void enable() {
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stops sampling; already recorded samples are kept
+     */
+    void disable() {
+        enabled_.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * Gets whether sampling is enabled
+     */
+    bool is_enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Takes a snapshot of every boundary's histogram
+     *
+     * Intended for periodic scrapes; sampling may continue concurrently.
+     */
+    Report get_report() const;
+
+    /**
+     * Discards all recorded samples
+     */
+    void reset();
+private:
+    WrapperProfiler() = default;
+
+    // Deciding via a plain thread local counter keeps the skip path free of
+    // shared state; each thread samples every 1024th of its own passes,
+    // which over all threads is still ~1/1024 of the traffic
+    bool should_sample() {
+        static thread_local uint32_t counter = 0;
+        return (counter++ % SAMPLING_INTERVAL) == 0;
+    }
+
+    void record(Boundary boundary, uint64_t nanoseconds);
+
+    std::array<LatencyHistogram, BOUNDARY_COUNT> histograms_;
+    std::atomic<bool> enabled_{false};
+};
+
+} // cppkafka
+
+#endif // CPPKAFKA_WRAPPER_PROFILER_H
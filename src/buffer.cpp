@@ -28,19 +28,146 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include "buffer.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define CPPKAFKA_BUFFER_X86_DISPATCH
+    #include <immintrin.h>
+#endif
+
+using std::min;
 using std::string;
-using std::equal;
-using std::lexicographical_compare;
 using std::ostream;
-using std::hex;
-using std::dec;
 
 namespace cppkafka {
 
+namespace {
+
+// Every byte value as a lowercase two-character hex pair
+const char HEX_PAIRS[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+bool is_printable(Buffer::DataType value) {
+    return value >= 0x20 && value < 0x7f;
+}
+
+// Writes the 4 character \xHH escape for the given byte
+void write_escaped(char* output, Buffer::DataType value) {
+    const char* pair = HEX_PAIRS + value * 2;
+    output[0] = '\\';
+    output[1] = 'x';
+    output[2] = pair[0];
+    output[3] = pair[1];
+}
+
+#ifdef CPPKAFKA_BUFFER_X86_DISPATCH
+
+// Returns the index of the first mismatching byte, or size if both ranges
+// are equal. SSE2 is part of the x86-64 baseline so this needs no check.
+size_t find_mismatch_sse2(const Buffer::DataType* lhs, const Buffer::DataType* rhs,
+                          size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i lhs_chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        const __m128i rhs_chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(lhs_chunk, rhs_chunk));
+        if (mask != 0xFFFF) {
+            return i + __builtin_ctz(~mask & 0xFFFF);
+        }
+    }
+    while (i != size && lhs[i] == rhs[i]) {
+        ++i;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t find_mismatch_avx2(const Buffer::DataType* lhs, const Buffer::DataType* rhs,
+                          size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i lhs_chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        const __m256i rhs_chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        const unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs_chunk, rhs_chunk)));
+        if (mask != 0xFFFFFFFFu) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+    return i + find_mismatch_sse2(lhs + i, rhs + i, size - i);
+}
+
+size_t find_mismatch(const Buffer::DataType* lhs, const Buffer::DataType* rhs,
+                     size_t size) {
+    // Pick the widest kernel this host supports, once
+    static const auto impl = __builtin_cpu_supports("avx2") ? &find_mismatch_avx2
+                                                            : &find_mismatch_sse2;
+    return impl(lhs, rhs, size);
+}
+
+// Three way comparison over the common prefix, then by length
+int compare_buffers(const Buffer& lhs, const Buffer& rhs) {
+    const size_t common_size = min(lhs.get_size(), rhs.get_size());
+    const size_t index = find_mismatch(lhs.get_data(), rhs.get_data(), common_size);
+    if (index != common_size) {
+        return lhs.get_data()[index] < rhs.get_data()[index] ? -1 : 1;
+    }
+    if (lhs.get_size() == rhs.get_size()) {
+        return 0;
+    }
+    return lhs.get_size() < rhs.get_size() ? -1 : 1;
+}
+
+bool buffers_equal(const Buffer& lhs, const Buffer& rhs) {
+    if (lhs.get_size() != rhs.get_size()) {
+        return false;
+    }
+    return find_mismatch(lhs.get_data(), rhs.get_data(), lhs.get_size()) ==
+           lhs.get_size();
+}
+
+#else // CPPKAFKA_BUFFER_X86_DISPATCH
+
+int compare_buffers(const Buffer& lhs, const Buffer& rhs) {
+    const size_t common_size = min(lhs.get_size(), rhs.get_size());
+    if (common_size != 0) {
+        const int result = memcmp(lhs.get_data(), rhs.get_data(), common_size);
+        if (result != 0) {
+            return result;
+        }
+    }
+    if (lhs.get_size() == rhs.get_size()) {
+        return 0;
+    }
+    return lhs.get_size() < rhs.get_size() ? -1 : 1;
+}
+
+bool buffers_equal(const Buffer& lhs, const Buffer& rhs) {
+    if (lhs.get_size() != rhs.get_size()) {
+        return false;
+    }
+    return lhs.get_size() == 0 ||
+           memcmp(lhs.get_data(), rhs.get_data(), lhs.get_size()) == 0;
+}
+
+#endif // CPPKAFKA_BUFFER_X86_DISPATCH
+
+} // anonymous namespace
+
 Buffer::Buffer() 
 : data_(nullptr), size_(0) {
 
@@ -76,48 +203,107 @@ Buffer::operator string() const {
 }
 
 ostream& operator<<(ostream& output, const Buffer& rhs) {
-    for (const uint8_t value : rhs) {
-        if (value >= 0x20 && value < 0x7f) {
-            output << value;
+    const Buffer::DataType* data = rhs.get_data();
+    const size_t size = rhs.get_size();
+    size_t i = 0;
+    while (i != size) {
+        // Emit each printable run with a single bulk write
+        const size_t run_start = i;
+        while (i != size && is_printable(data[i])) {
+            ++i;
+        }
+        if (i != run_start) {
+            output.write(reinterpret_cast<const char*>(data + run_start), i - run_start);
+        }
+        while (i != size && !is_printable(data[i])) {
+            char escaped[4];
+            write_escaped(escaped, data[i]);
+            output.write(escaped, sizeof(escaped));
+            ++i;
+        }
+    }
+    return output;
+}
+
+size_t to_hex(const Buffer& input, char* output, size_t output_size) {
+    const Buffer::DataType* data = input.get_data();
+    const size_t count = min(input.get_size(), output_size / 2);
+    char* position = output;
+    for (size_t i = 0; i != count; ++i) {
+        const char* pair = HEX_PAIRS + data[i] * 2;
+        *position++ = pair[0];
+        *position++ = pair[1];
+    }
+    return position - output;
+}
+
+string to_hex(const Buffer& input) {
+    string output(input.get_size() * 2, 0);
+    to_hex(input, &output[0], output.size());
+    return output;
+}
+
+size_t to_printable(const Buffer& input, char* output, size_t output_size) {
+    const Buffer::DataType* data = input.get_data();
+    const size_t size = input.get_size();
+    char* position = output;
+    char* const end = output + output_size;
+    for (size_t i = 0; i != size; ++i) {
+        if (is_printable(data[i])) {
+            if (position == end) {
+                break;
+            }
+            *position++ = static_cast<char>(data[i]);
         }
         else {
-            output << "\\x";
-            if (value < 16) {
-                output << '0';
+            if (static_cast<size_t>(end - position) < 4) {
+                break;
             }
-            output << hex << static_cast<int>(value) << dec;
+            write_escaped(position, data[i]);
+            position += 4;
         }
     }
+    return position - output;
+}
+
+string to_printable(const Buffer& input) {
+    const Buffer::DataType* data = input.get_data();
+    const size_t size = input.get_size();
+    size_t output_size = 0;
+    for (size_t i = 0; i != size; ++i) {
+        output_size += is_printable(data[i]) ? 1 : 4;
+    }
+    string output(output_size, 0);
+    to_printable(input, &output[0], output.size());
     return output;
 }
 
+int compare(const Buffer& lhs, const Buffer& rhs) {
+    return compare_buffers(lhs, rhs);
+}
+
 bool operator==(const Buffer& lhs, const Buffer& rhs) {
-    if (lhs.get_size() != rhs.get_size()) {
-        return false;
-    }
-    return equal(lhs.get_data(), lhs.get_data() + lhs.get_size(), rhs.get_data());
+    return buffers_equal(lhs, rhs);
 }
 
-bool operator!=(const Buffer& lhs, const Buffer& rhs) { 
+bool operator!=(const Buffer& lhs, const Buffer& rhs) {
     return !(lhs == rhs);
 }
 
 bool operator<(const Buffer& lhs, const Buffer& rhs) {
-    return lexicographical_compare(lhs.get_data(), lhs.get_data() + lhs.get_size(),
-                                   rhs.get_data(), rhs.get_data() + rhs.get_size());
+    return compare_buffers(lhs, rhs) < 0;
 }
 
 bool operator>(const Buffer& lhs, const Buffer& rhs) {
-    return lexicographical_compare(rhs.get_data(), rhs.get_data() + rhs.get_size(),
-                                   lhs.get_data(), lhs.get_data() + lhs.get_size());
+    return compare_buffers(lhs, rhs) > 0;
 }
 
 bool operator<=(const Buffer& lhs, const Buffer& rhs) {
-    return !(lhs > rhs);
+    return compare_buffers(lhs, rhs) <= 0;
 }
 
 bool operator>=(const Buffer& lhs, const Buffer& rhs) {
-    return !(lhs < rhs);
+    return compare_buffers(lhs, rhs) >= 0;
 }
 
 } // cppkafka
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "cached_topic_partition_list.h"
+#include "topic_partition.h"
+
+namespace cppkafka {
+
+CachedTopicPartitionList::CachedTopicPartitionList()
+: handle_(nullptr, &rd_kafka_topic_partition_list_destroy) {
+
+}
+
+CachedTopicPartitionList::CachedTopicPartitionList(const TopicPartitionList& topic_partitions)
+: handle_(convert(topic_partitions)) {
+
+}
+
+void CachedTopicPartitionList::update(const TopicPartitionList& topic_partitions) {
+    if (handle_ && matches(topic_partitions)) {
+        for (int i = 0; i < handle_->cnt; ++i) {
+            handle_->elems[i].offset = topic_partitions[i].get_offset();
+        }
+    }
+    else {
+        handle_ = convert(topic_partitions);
+    }
+}
+
+void CachedTopicPartitionList::set_offset(size_t index, int64_t offset) {
+    handle_->elems[index].offset = offset;
+}
+
+size_t CachedTopicPartitionList::get_size() const {
+    return handle_ ? handle_->cnt : 0;
+}
+
+rd_kafka_topic_partition_list_t* CachedTopicPartitionList::get_handle() const {
+    return handle_.get();
+}
+
+TopicPartitionList CachedTopicPartitionList::get_topic_partitions() const {
+    return handle_ ? convert(handle_.get()) : TopicPartitionList{};
+}
+
+CachedTopicPartitionList::operator bool() const {
+    return handle_ != nullptr;
+}
+
+bool CachedTopicPartitionList::matches(const TopicPartitionList& topic_partitions) const {
+    if (static_cast<size_t>(handle_->cnt) != topic_partitions.size()) {
+        return false;
+    }
+    for (int i = 0; i < handle_->cnt; ++i) {
+        const rd_kafka_topic_partition_t& elem = handle_->elems[i];
+        const TopicPartition& topic_partition = topic_partitions[i];
+        if (elem.partition != topic_partition.get_partition() ||
+            elem.topic != topic_partition.get_topic()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // cppkafka
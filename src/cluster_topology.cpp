@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "cluster_topology.h"
+#include "exceptions.h"
+
+using std::string;
+using std::vector;
+
+namespace cppkafka {
+
+const size_t ClusterTopology::npos;
+const int32_t ClusterTopology::UNKNOWN_LEADER;
+
+ClusterTopology::ClusterTopology() = default;
+
+ClusterTopology::ClusterTopology(const Metadata& metadata)
+: ClusterTopology(metadata.get_handle()) {
+
+}
+
+ClusterTopology::ClusterTopology(const rd_kafka_metadata_t* handle) {
+    update(handle);
+}
+
+void ClusterTopology::update(const Metadata& metadata) {
+    update(metadata.get_handle());
+}
+
+void ClusterTopology::update(const rd_kafka_metadata_t* handle) {
+    if (!try_patch(handle)) {
+        rebuild(handle);
+    }
+    ++version_;
+}
+
+size_t ClusterTopology::find_topic(const string& topic) const {
+    auto iter = topic_index_.find(topic);
+    return iter != topic_index_.end() ? iter->second : npos;
+}
+
+size_t ClusterTopology::get_partition_count(size_t topic_index) const {
+    return topics_[topic_index].partition_count;
+}
+
+size_t ClusterTopology::get_partition_count(const string& topic) const {
+    const size_t index = find_topic(topic);
+    if (index == npos) {
+        throw ElementNotFound("topology entry", topic);
+    }
+    return get_partition_count(index);
+}
+
+int32_t ClusterTopology::get_leader(size_t topic_index, int partition) const {
+    const TopicEntry& entry = topics_[topic_index];
+    if (partition < 0 || static_cast<uint32_t>(partition) >= entry.partition_count) {
+        return UNKNOWN_LEADER;
+    }
+    return leaders_[entry.first_partition + partition];
+}
+
+int32_t ClusterTopology::get_leader(const string& topic, int partition) const {
+    const size_t index = find_topic(topic);
+    if (index == npos) {
+        throw ElementNotFound("topology entry", topic);
+    }
+    return get_leader(index, partition);
+}
+
+const vector<ClusterTopology::Broker>& ClusterTopology::get_brokers() const {
+    return brokers_;
+}
+
+const ClusterTopology::Broker* ClusterTopology::find_broker(int32_t broker_id) const {
+    for (const Broker& broker : brokers_) {
+        if (broker.id == broker_id) {
+            return &broker;
+        }
+    }
+    return nullptr;
+}
+
+size_t ClusterTopology::get_topic_count() const {
+    return topics_.size();
+}
+
+uint64_t ClusterTopology::get_version() const {
+    return version_;
+}
+
+bool ClusterTopology::empty() const {
+    return topics_.empty();
+}
+
+bool ClusterTopology::try_patch(const rd_kafka_metadata_t* handle) {
+    if (static_cast<size_t>(handle->topic_cnt) != topics_.size() || topics_.empty()) {
+        return false;
+    }
+    for (int i = 0; i < handle->topic_cnt; ++i) {
+        const rd_kafka_metadata_topic_t& topic = handle->topics[i];
+        auto iter = topic_index_.find(topic.topic);
+        if (iter == topic_index_.end()) {
+            return false;
+        }
+        const TopicEntry& entry = topics_[iter->second];
+        if (entry.partition_count != static_cast<uint32_t>(topic.partition_cnt)) {
+            return false;
+        }
+        for (int j = 0; j < topic.partition_cnt; ++j) {
+            const rd_kafka_metadata_partition_t& partition = topic.partitions[j];
+            // Partition ids are dense (0..count-1) outside of transient
+            // reassignment states; anything else forces a rebuild
+            if (partition.id < 0 ||
+                static_cast<uint32_t>(partition.id) >= entry.partition_count) {
+                return false;
+            }
+            leaders_[entry.first_partition + partition.id] = partition.leader;
+        }
+    }
+    // Brokers rarely change; only reallocate when the set does
+    bool brokers_match = static_cast<size_t>(handle->broker_cnt) == brokers_.size();
+    for (int i = 0; brokers_match && i < handle->broker_cnt; ++i) {
+        brokers_match = brokers_[i].id == handle->brokers[i].id &&
+                        brokers_[i].port == handle->brokers[i].port &&
+                        brokers_[i].host == handle->brokers[i].host;
+    }
+    if (!brokers_match) {
+        brokers_.clear();
+        brokers_.reserve(handle->broker_cnt);
+        for (int i = 0; i < handle->broker_cnt; ++i) {
+            const rd_kafka_metadata_broker_t& broker = handle->brokers[i];
+            brokers_.push_back({ broker.id, broker.port, broker.host });
+        }
+    }
+    return true;
+}
+
+void ClusterTopology::rebuild(const rd_kafka_metadata_t* handle) {
+    topic_index_.clear();
+    topics_.clear();
+    leaders_.clear();
+    brokers_.clear();
+
+    brokers_.reserve(handle->broker_cnt);
+    for (int i = 0; i < handle->broker_cnt; ++i) {
+        const rd_kafka_metadata_broker_t& broker = handle->brokers[i];
+        brokers_.push_back({ broker.id, broker.port, broker.host });
+    }
+
+    size_t total_partitions = 0;
+    for (int i = 0; i < handle->topic_cnt; ++i) {
+        total_partitions += handle->topics[i].partition_cnt;
+    }
+    leaders_.assign(total_partitions, UNKNOWN_LEADER);
+
+    topics_.reserve(handle->topic_cnt);
+    topic_index_.reserve(handle->topic_cnt);
+    uint32_t first_partition = 0;
+    for (int i = 0; i < handle->topic_cnt; ++i) {
+        const rd_kafka_metadata_topic_t& topic = handle->topics[i];
+        const uint32_t partition_count = static_cast<uint32_t>(topic.partition_cnt);
+        for (int j = 0; j < topic.partition_cnt; ++j) {
+            const rd_kafka_metadata_partition_t& partition = topic.partitions[j];
+            if (partition.id >= 0 && static_cast<uint32_t>(partition.id) < partition_count) {
+                leaders_[first_partition + partition.id] = partition.leader;
+            }
+        }
+        topic_index_.emplace(topic.topic, topics_.size());
+        topics_.push_back({ first_partition, partition_count });
+        first_partition += partition_count;
+    }
+}
+
+} // cppkafka
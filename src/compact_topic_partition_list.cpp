@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+#include "compact_topic_partition_list.h"
+
+using std::equal;
+using std::set;
+using std::string;
+using std::toupper;
+
+namespace cppkafka {
+
+namespace {
+
+bool topic_equals_case_insensitive(const string& lhs, const string& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), [](char c1, char c2) -> bool {
+        return toupper(c1) == toupper(c2);
+    });
+}
+
+} // anonymous namespace
+
+const size_t CompactTopicPartitionList::npos;
+
+CompactTopicPartitionList::CompactTopicPartitionList(const TopicPartitionList& topic_partitions) {
+    for (const TopicPartition& topic_partition : topic_partitions) {
+        add(topic_partition);
+    }
+}
+
+void CompactTopicPartitionList::add(const string& topic, int partition, int64_t offset) {
+    topic_ids_.push_back(intern_topic(topic));
+    partitions_.push_back(partition);
+    offsets_.push_back(offset);
+}
+
+void CompactTopicPartitionList::add(const TopicPartition& topic_partition) {
+    add(topic_partition.get_topic(), topic_partition.get_partition(),
+        topic_partition.get_offset());
+}
+
+size_t CompactTopicPartitionList::find(const string& topic, int partition) const {
+    // Resolve the topic id once, then scan the dense partition array
+    uint16_t topic_id = 0;
+    while (topic_id != topics_.size() && topics_[topic_id] != topic) {
+        ++topic_id;
+    }
+    if (topic_id == topics_.size()) {
+        return npos;
+    }
+    for (size_t i = 0; i != partitions_.size(); ++i) {
+        if (partitions_[i] == partition && topic_ids_[i] == topic_id) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+const string& CompactTopicPartitionList::get_topic(size_t index) const {
+    return topics_[topic_ids_[index]];
+}
+
+int CompactTopicPartitionList::get_partition(size_t index) const {
+    return partitions_[index];
+}
+
+int64_t CompactTopicPartitionList::get_offset(size_t index) const {
+    return offsets_[index];
+}
+
+void CompactTopicPartitionList::set_offset(size_t index, int64_t offset) {
+    offsets_[index] = offset;
+}
+
+size_t CompactTopicPartitionList::get_size() const {
+    return partitions_.size();
+}
+
+bool CompactTopicPartitionList::empty() const {
+    return partitions_.empty();
+}
+
+size_t CompactTopicPartitionList::get_topic_count() const {
+    return topics_.size();
+}
+
+CompactTopicPartitionList
+CompactTopicPartitionList::find_matches(const set<string>& topics) const {
+    // Match against the interned table once per distinct topic instead of
+    // once per entry
+    std::vector<bool> topic_matches(topics_.size(), false);
+    for (size_t i = 0; i != topics_.size(); ++i) {
+        for (const string& topic : topics) {
+            if (topic_equals_case_insensitive(topics_[i], topic)) {
+                topic_matches[i] = true;
+                break;
+            }
+        }
+    }
+    CompactTopicPartitionList subset;
+    for (size_t i = 0; i != topic_ids_.size(); ++i) {
+        if (topic_matches[topic_ids_[i]]) {
+            subset.add(topics_[topic_ids_[i]], partitions_[i], offsets_[i]);
+        }
+    }
+    return subset;
+}
+
+CompactTopicPartitionList CompactTopicPartitionList::find_matches(const set<int>& ids) const {
+    CompactTopicPartitionList subset;
+    for (size_t i = 0; i != partitions_.size(); ++i) {
+        if (ids.count(partitions_[i]) > 0) {
+            subset.add(topics_[topic_ids_[i]], partitions_[i], offsets_[i]);
+        }
+    }
+    return subset;
+}
+
+TopicPartitionList CompactTopicPartitionList::get_topic_partitions() const {
+    TopicPartitionList output;
+    output.reserve(partitions_.size());
+    for (size_t i = 0; i != partitions_.size(); ++i) {
+        output.emplace_back(topics_[topic_ids_[i]], partitions_[i], offsets_[i]);
+    }
+    return output;
+}
+
+uint16_t CompactTopicPartitionList::intern_topic(const string& topic) {
+    // The table virtually always holds one or two entries, so a linear scan
+    // beats any hashing scheme
+    for (size_t i = 0; i != topics_.size(); ++i) {
+        if (topics_[i] == topic) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    topics_.push_back(topic);
+    return static_cast<uint16_t>(topics_.size() - 1);
+}
+
+} // cppkafka
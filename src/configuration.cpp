@@ -89,9 +89,21 @@ void log_callback_proxy(const rd_kafka_t* h, int level,
 
 int stats_callback_proxy(rd_kafka_t*, char *json, size_t json_len, void *opaque) {
     KafkaHandleBase* handle = static_cast<KafkaHandleBase*>(opaque);
-    CallbackInvoker<Configuration::StatsCallback>
-        ("statistics", handle->get_configuration().get_stats_callback(), handle)
-        (*handle, string(json, json + json_len));
+    const Configuration& config = handle->get_configuration();
+    if (config.get_parsed_stats_callback()) {
+        // Reused across intervals so steady state parsing performs no allocations
+        thread_local KafkaStatistics statistics;
+        if (KafkaStatistics::parse(json, json_len, statistics)) {
+            CallbackInvoker<Configuration::ParsedStatsCallback>
+                ("statistics", config.get_parsed_stats_callback(), handle)
+                (*handle, statistics);
+        }
+    }
+    if (config.get_stats_callback()) {
+        CallbackInvoker<Configuration::StatsCallback>
+            ("statistics", config.get_stats_callback(), handle)
+            (*handle, string(json, json + json_len));
+    }
     return 0;
 }
 
@@ -109,9 +121,57 @@ void background_event_callback_proxy(rd_kafka_t*, rd_kafka_event_t* event_ptr, v
         (*handle, Event{event_ptr});
 }
 
+#if RD_KAFKA_VERSION >= RD_KAFKA_INTERCEPTOR_SUPPORT_VERSION
+constexpr const char* THREAD_CONFIGURATION_INTERCEPTOR = "cppkafka_thread_configuration";
+
+void install_thread_configuration(rd_kafka_conf_t* conf, const ThreadConfiguration& config);
+
+rd_kafka_resp_err_t thread_start_proxy(rd_kafka_t*, rd_kafka_thread_type_t,
+                                       const char* thread_name, void* ic_opaque) {
+    const ThreadConfiguration* config = static_cast<const ThreadConfiguration*>(ic_opaque);
+    config->apply_to_current_thread(thread_name);
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+
+rd_kafka_resp_err_t thread_configuration_on_new_proxy(rd_kafka_t* handle,
+                                                      const rd_kafka_conf_t*, void* ic_opaque,
+                                                      char*, size_t) {
+    return rd_kafka_interceptor_add_on_thread_start(handle, THREAD_CONFIGURATION_INTERCEPTOR,
+                                                    &thread_start_proxy, ic_opaque);
+}
+
+rd_kafka_resp_err_t thread_configuration_on_conf_dup_proxy(rd_kafka_conf_t* new_conf,
+                                                           const rd_kafka_conf_t*, size_t,
+                                                           const char**, void* ic_opaque) {
+    // Interceptors don't propagate through rd_kafka_conf_dup on their own, so attach
+    // a fresh copy to the duplicated configuration handle
+    install_thread_configuration(new_conf,
+                                 *static_cast<const ThreadConfiguration*>(ic_opaque));
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+
+rd_kafka_resp_err_t thread_configuration_on_conf_destroy_proxy(void* ic_opaque) {
+    delete static_cast<ThreadConfiguration*>(ic_opaque);
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+
+void install_thread_configuration(rd_kafka_conf_t* conf, const ThreadConfiguration& config) {
+    // The conf owns this copy (and rd_kafka_new takes over the conf), so it outlives
+    // every thread the handle spawns
+    ThreadConfiguration* copy = new ThreadConfiguration(config);
+    rd_kafka_conf_interceptor_add_on_new(conf, THREAD_CONFIGURATION_INTERCEPTOR,
+                                         &thread_configuration_on_new_proxy, copy);
+    rd_kafka_conf_interceptor_add_on_conf_dup(conf, THREAD_CONFIGURATION_INTERCEPTOR,
+                                              &thread_configuration_on_conf_dup_proxy, copy);
+    rd_kafka_conf_interceptor_add_on_conf_destroy(conf, THREAD_CONFIGURATION_INTERCEPTOR,
+                                                  &thread_configuration_on_conf_destroy_proxy,
+                                                  copy);
+}
+#endif
+
 // Configuration
 
-Configuration::Configuration() 
+Configuration::Configuration()
 : handle_(make_handle(rd_kafka_conf_new())) {
 
 }
@@ -178,6 +238,12 @@ Configuration& Configuration::set_stats_callback(StatsCallback callback) {
     return *this;
 }
 
+Configuration& Configuration::set_stats_callback(ParsedStatsCallback callback) {
+    parsed_stats_callback_ = std::move(callback);
+    rd_kafka_conf_set_stats_cb(handle_.get(), &stats_callback_proxy);
+    return *this;
+}
+
 Configuration& Configuration::set_socket_callback(SocketCallback callback) {
     socket_callback_ = std::move(callback);
     rd_kafka_conf_set_socket_cb(handle_.get(), &socket_callback_proxy);
@@ -197,6 +263,14 @@ Configuration& Configuration::set_events(int events) {
 }
 #endif
 
+#if RD_KAFKA_VERSION >= RD_KAFKA_INTERCEPTOR_SUPPORT_VERSION
+Configuration& Configuration::set_thread_configuration(ThreadConfiguration config) {
+    thread_configuration_ = std::move(config);
+    install_thread_configuration(handle_.get(), *thread_configuration_);
+    return *this;
+}
+#endif
+
 Configuration&
 Configuration::set_default_topic_configuration(TopicConfiguration config) {
     default_topic_config_ = std::move(config);
@@ -255,6 +329,10 @@ const Configuration::StatsCallback& Configuration::get_stats_callback() const {
     return stats_callback_;
 }
 
+const Configuration::ParsedStatsCallback& Configuration::get_parsed_stats_callback() const {
+    return parsed_stats_callback_;
+}
+
 const Configuration::SocketCallback& Configuration::get_socket_callback() const {
     return socket_callback_;
 }
@@ -264,6 +342,10 @@ Configuration::get_background_event_callback() const {
     return background_event_callback_;
 }
 
+const optional<ThreadConfiguration>& Configuration::get_thread_configuration() const {
+    return thread_configuration_;
+}
+
 const optional<TopicConfiguration>& Configuration::get_default_topic_configuration() const {
     return default_topic_config_;
 }
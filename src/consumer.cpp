@@ -29,26 +29,58 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <map>
 #include "macros.h"
 #include "consumer.h"
 #include "exceptions.h"
 #include "logging.h"
 #include "configuration.h"
 #include "topic_partition_list.h"
+#include "cached_topic_partition_list.h"
+#include "message_internal.h"
+#include "wrapper_profiler.h"
 #include "detail/callback_invoker.h"
+#include "detail/tracepoints.h"
 
 using std::vector;
 using std::string;
+using std::map;
+using std::max;
 using std::move;
 using std::make_tuple;
 using std::ostringstream;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
 using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 using std::toupper;
 using std::equal;
 using std::allocator;
 
 namespace cppkafka {
 
+namespace {
+
+// Rides inside a tracked Message so the held-bytes gauge drops exactly when
+// the application destroys (or overwrites) the message, wherever that happens
+class HeldBytesAccounting : public Internal {
+public:
+    HeldBytesAccounting(HandleStatistics& statistics, uint64_t bytes)
+    : statistics_(statistics),
+      bytes_(bytes) {
+        statistics_.record_message_hold(bytes_);
+    }
+
+    ~HeldBytesAccounting() override {
+        statistics_.record_message_release(bytes_);
+    }
+private:
+    HandleStatistics& statistics_;
+    uint64_t bytes_;
+};
+
+} // anonymous namespace
+
 void Consumer::rebalance_proxy(rd_kafka_t*, rd_kafka_resp_err_t error,
                                rd_kafka_topic_partition_list_t *partitions, void *opaque) {
     TopicPartitionList list = convert(partitions);
@@ -56,14 +88,17 @@ void Consumer::rebalance_proxy(rd_kafka_t*, rd_kafka_resp_err_t error,
 }
 
 Consumer::Consumer(Configuration config)
+: Consumer(FrozenConfiguration(std::move(config))) {
+}
+
+Consumer::Consumer(FrozenConfiguration config)
 : KafkaHandleBase(std::move(config)) {
     char error_buffer[512];
-    rd_kafka_conf_t* config_handle = get_configuration_handle();
-    // Set ourselves as the opaque pointer
-    rd_kafka_conf_set_opaque(config_handle, this);
+    // The duplicate carries our opaque and is consumed by rd_kafka_new
+    rd_kafka_conf_t* config_handle = get_frozen_configuration().make_handle_configuration(this);
     rd_kafka_conf_set_rebalance_cb(config_handle, &Consumer::rebalance_proxy);
     rd_kafka_t* ptr = rd_kafka_new(RD_KAFKA_CONSUMER,
-                                   rd_kafka_conf_dup(config_handle),
+                                   config_handle,
                                    error_buffer, sizeof(error_buffer));
     if (!ptr) {
         throw Exception("Failed to create consumer handle: " + string(error_buffer));
@@ -134,6 +169,61 @@ void Consumer::unassign() {
     check_error(error);
 }
 
+#if (RD_KAFKA_VERSION >= RD_KAFKA_INCREMENTAL_REBALANCE_SUPPORT_VERSION)
+void Consumer::incremental_assign(const TopicPartitionList& topic_partitions) {
+    TopicPartitionsListPtr topic_list_handle = convert(topic_partitions);
+    rd_kafka_error_t* error = rd_kafka_incremental_assign(get_handle(), topic_list_handle.get());
+    if (error) {
+        const rd_kafka_resp_err_t code = rd_kafka_error_code(error);
+        rd_kafka_error_destroy(error);
+        throw HandleException(code);
+    }
+}
+
+void Consumer::incremental_unassign(const TopicPartitionList& topic_partitions) {
+    TopicPartitionsListPtr topic_list_handle = convert(topic_partitions);
+    rd_kafka_error_t* error = rd_kafka_incremental_unassign(get_handle(), topic_list_handle.get());
+    if (error) {
+        const rd_kafka_resp_err_t code = rd_kafka_error_code(error);
+        rd_kafka_error_destroy(error);
+        throw HandleException(code);
+    }
+}
+
+string Consumer::get_rebalance_protocol() const {
+    const char* protocol = rd_kafka_rebalance_protocol(get_handle());
+    return protocol ? protocol : "NONE";
+}
+#endif
+
+TopicPartitionList Consumer::seek_to_timestamps(const TopicPartitionsTimestampsMap& queries) {
+    return seek_to_timestamps(queries, get_timeout());
+}
+
+TopicPartitionList Consumer::seek_to_timestamps(const TopicPartitionsTimestampsMap& queries,
+                                                milliseconds timeout) {
+    // Build the native list once, with the timestamp riding in the offset
+    // field as rd_kafka_offsets_for_times expects
+    TopicPartitionsListPtr topic_list_handle =
+        make_handle(rd_kafka_topic_partition_list_new(queries.size()));
+    for (const auto& query : queries) {
+        rd_kafka_topic_partition_t* entry = rd_kafka_topic_partition_list_add(
+            topic_list_handle.get(),
+            query.first.get_topic().data(),
+            query.first.get_partition());
+        entry->offset = query.second.count();
+    }
+    const int timeout_ms = static_cast<int>(timeout.count());
+    rd_kafka_resp_err_t error = rd_kafka_offsets_for_times(get_handle(),
+                                                           topic_list_handle.get(),
+                                                           timeout_ms);
+    check_error(error, topic_list_handle.get());
+    // The lookup patched the offsets in place; hand the same list to assign
+    error = rd_kafka_assign(get_handle(), topic_list_handle.get());
+    check_error(error, topic_list_handle.get());
+    return convert(topic_list_handle);
+}
+
 void Consumer::pause() {
     pause_partitions(get_assignment());
 }
@@ -200,6 +290,52 @@ Consumer::get_offsets_position(const TopicPartitionList& topic_partitions) const
     return convert(topic_list_handle);
 }
 
+size_t Consumer::get_offsets_committed(const CachedTopicPartitionList& topic_partitions,
+                                       PartitionOffsetResult* results, size_t capacity) const {
+    return get_offsets_committed(topic_partitions, results, capacity, get_timeout());
+}
+
+size_t Consumer::get_offsets_committed(const CachedTopicPartitionList& topic_partitions,
+                                       PartitionOffsetResult* results, size_t capacity,
+                                       milliseconds timeout) const {
+    rd_kafka_topic_partition_list_t* handle = topic_partitions.get_handle();
+    if (!handle || handle->cnt == 0) {
+        return 0;
+    }
+    if (capacity < static_cast<size_t>(handle->cnt)) {
+        throw Exception("Results capacity is smaller than the queried list");
+    }
+    rd_kafka_resp_err_t error = rd_kafka_committed(get_handle(), handle,
+                                                   static_cast<int>(timeout.count()));
+    // Only call-level failures throw; per-partition errors are part of the
+    // results, so one flapping partition doesn't hide the others' offsets
+    check_error(error);
+    // rd_kafka_committed patched offsets and per-partition errors in place
+    for (int i = 0; i < handle->cnt; ++i) {
+        const rd_kafka_topic_partition_t& element = handle->elems[i];
+        results[i] = PartitionOffsetResult(element.partition, element.offset, element.err);
+    }
+    return static_cast<size_t>(handle->cnt);
+}
+
+size_t Consumer::get_offsets_position(const CachedTopicPartitionList& topic_partitions,
+                                      PartitionOffsetResult* results, size_t capacity) const {
+    rd_kafka_topic_partition_list_t* handle = topic_partitions.get_handle();
+    if (!handle || handle->cnt == 0) {
+        return 0;
+    }
+    if (capacity < static_cast<size_t>(handle->cnt)) {
+        throw Exception("Results capacity is smaller than the queried list");
+    }
+    rd_kafka_resp_err_t error = rd_kafka_position(get_handle(), handle);
+    check_error(error);
+    for (int i = 0; i < handle->cnt; ++i) {
+        const rd_kafka_topic_partition_t& element = handle->elems[i];
+        results[i] = PartitionOffsetResult(element.partition, element.offset, element.err);
+    }
+    return static_cast<size_t>(handle->cnt);
+}
+
 #if (RD_KAFKA_VERSION >= RD_KAFKA_STORE_OFFSETS_SUPPORT_VERSION)
 void Consumer::store_consumed_offsets() const {
     store_offsets(get_offsets_position(get_assignment()));
@@ -210,6 +346,33 @@ void Consumer::store_offsets(const TopicPartitionList& topic_partitions) const {
     rd_kafka_resp_err_t error = rd_kafka_offsets_store(get_handle(), topic_list_handle.get());
     check_error(error, topic_list_handle.get());
 }
+
+void Consumer::store_offsets(const vector<Message>& messages) const {
+    if (messages.empty()) {
+        return;
+    }
+    // Keep the highest offset seen per partition
+    map<TopicPartition, int64_t> maximum_offsets;
+    for (const Message& message : messages) {
+        // Like rd_kafka_offset_store, store the offset following this message
+        const int64_t next_offset = message.get_offset() + 1;
+        const TopicPartition topic_partition(message.get_topic(), message.get_partition());
+        auto iter = maximum_offsets.find(topic_partition);
+        if (iter == maximum_offsets.end()) {
+            maximum_offsets.emplace(topic_partition, next_offset);
+        }
+        else {
+            iter->second = max(iter->second, next_offset);
+        }
+    }
+    TopicPartitionList topic_partitions;
+    topic_partitions.reserve(maximum_offsets.size());
+    for (const auto& offset_pair : maximum_offsets) {
+        topic_partitions.emplace_back(offset_pair.first.get_topic(),
+                                      offset_pair.first.get_partition(), offset_pair.second);
+    }
+    store_offsets(topic_partitions);
+}
 #endif
 
 void Consumer::store_offset(const Message& msg) const {
@@ -258,12 +421,47 @@ const Consumer::RebalanceErrorCallback& Consumer::get_rebalance_error_callback()
     return rebalance_error_callback_;
 }
 
+void Consumer::set_message_byte_tracking(bool enabled) {
+    message_byte_tracking_ = enabled;
+}
+
+bool Consumer::get_message_byte_tracking() const {
+    return message_byte_tracking_;
+}
+
+void Consumer::account_held_message(Message& message) {
+    if (!message || message.get_error()) {
+        return;
+    }
+    const uint64_t bytes = message.get_payload().get_size();
+    if (bytes == 0) {
+        return;
+    }
+    message.internal(std::make_shared<HeldBytesAccounting>(get_statistics(), bytes));
+}
+
 Message Consumer::poll() {
     return poll(get_timeout());
 }
 
 Message Consumer::poll(milliseconds timeout) {
-    return rd_kafka_consumer_poll(get_handle(), static_cast<int>(timeout.count()));
+    const auto start = steady_clock::now();
+    rd_kafka_message_t* message_ptr = rd_kafka_consumer_poll(get_handle(),
+                                                             static_cast<int>(timeout.count()));
+    const auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+    WrapperProfiler::ScopedProbe probe(WrapperProfiler::Boundary::ConsumeWrap);
+    Message message(message_ptr);
+    probe.stop();
+    CPPKAFKA_TRACE2(poll_end, message ? 1 : 0, elapsed.count());
+    HandleStatistics& statistics = get_statistics();
+    statistics.record_poll(elapsed, static_cast<bool>(message));
+    if (message && !message.get_error()) {
+        statistics.record_consume(message.get_payload().get_size());
+        if (message_byte_tracking_) {
+            account_held_message(message);
+        }
+    }
+    return message;
 }
 
 std::vector<Message> Consumer::poll_batch(size_t max_batch_size) {
@@ -274,6 +472,38 @@ std::vector<Message> Consumer::poll_batch(size_t max_batch_size, milliseconds ti
     return poll_batch(max_batch_size, timeout, allocator<Message>());
 }
 
+size_t Consumer::poll_batch(MessageBatch& batch) {
+    return poll_batch(batch, get_timeout());
+}
+
+size_t Consumer::poll_batch(MessageBatch& batch, milliseconds timeout) {
+    batch.clear();
+    // Note that this will leak the queue when using rdkafka < 0.11.5 (see get_queue comment)
+    Queue queue = Queue::make_queue(rd_kafka_queue_get_consumer(get_handle()));
+    const auto start = steady_clock::now();
+    ssize_t result = rd_kafka_consume_batch_queue(queue.get_handle(),
+                                                  timeout.count(),
+                                                  batch.get_buffer(),
+                                                  batch.get_max_batch_size());
+    const auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+    CPPKAFKA_TRACE2(poll_end, result > 0 ? result : 0, elapsed.count());
+    HandleStatistics& statistics = get_statistics();
+    statistics.record_poll(elapsed, result > 0);
+    if (result == -1) {
+        check_error(rd_kafka_last_error());
+        // on the off-chance that check_error() does not throw an error
+        return 0;
+    }
+    rd_kafka_message_t* const* messages = batch.get_buffer();
+    for (ssize_t i = 0; i < result; ++i) {
+        if (messages[i]->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+            statistics.record_consume(messages[i]->len);
+        }
+    }
+    batch.load(static_cast<size_t>(result));
+    return static_cast<size_t>(result);
+}
+
 Queue Consumer::get_main_queue() const {
     Queue queue = Queue::make_queue(rd_kafka_queue_get_main(get_handle()));
     queue.disable_queue_forwarding();
@@ -303,6 +533,20 @@ void Consumer::commit(const Message& msg, bool async) {
     check_error(error);
 }
 
+void Consumer::commit(const CachedTopicPartitionList& topic_partitions) {
+    commit(topic_partitions, false);
+}
+
+void Consumer::async_commit(const CachedTopicPartitionList& topic_partitions) {
+    commit(topic_partitions, true);
+}
+
+void Consumer::commit(const CachedTopicPartitionList& topic_partitions, bool async) {
+    rd_kafka_resp_err_t error = rd_kafka_commit(get_handle(), topic_partitions.get_handle(),
+                                                async ? 1 : 0);
+    check_error(error, topic_partitions.get_handle());
+}
+
 void Consumer::commit(const TopicPartitionList* topic_partitions, bool async) {
     rd_kafka_resp_err_t error;
     if (topic_partitions == nullptr) {
@@ -318,6 +562,25 @@ void Consumer::commit(const TopicPartitionList* topic_partitions, bool async) {
 
 void Consumer::handle_rebalance(rd_kafka_resp_err_t error,
                                 TopicPartitionList& topic_partitions) {
+#if (RD_KAFKA_VERSION >= RD_KAFKA_INCREMENTAL_REBALANCE_SUPPORT_VERSION)
+    if (get_rebalance_protocol() == "COOPERATIVE") {
+        // Cooperative rebalances hand us deltas, so only the listed partitions
+        // are added or removed; the rest of the assignment keeps consuming
+        if (error == RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS) {
+            CallbackInvoker<AssignmentCallback>("assignment", assignment_callback_, this)(topic_partitions);
+            incremental_assign(topic_partitions);
+        }
+        else if (error == RD_KAFKA_RESP_ERR__REVOKE_PARTITIONS) {
+            CallbackInvoker<RevocationCallback>("revocation", revocation_callback_, this)(topic_partitions);
+            incremental_unassign(topic_partitions);
+        }
+        else {
+            CallbackInvoker<RebalanceErrorCallback>("rebalance error", rebalance_error_callback_, this)(error);
+            unassign();
+        }
+        return;
+    }
+#endif
     if (error == RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS) {
         CallbackInvoker<AssignmentCallback>("assignment", assignment_callback_, this)(topic_partitions);
         assign(topic_partitions);
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Unity translation unit: compiles the whole library in one TU so the
+// implementations of hot wrappers (Message construction, Buffer accessors,
+// topic partition list conversions, ...) are visible to the optimizer at once
+// and can inline into each other without LTO.
+//
+// This file backs the cppkafka::header_only interface target, which compiles
+// it as part of the consuming target so those wrappers can also inline into
+// the application's own loops. It is not part of the regular library build;
+// keep the list below in sync with SOURCES in CMakeLists.txt.
+
+#include "configuration.cpp"
+#include "frozen_configuration.cpp"
+#include "gathered_payload.cpp"
+#include "topic_configuration.cpp"
+#include "configuration_option.cpp"
+#include "exceptions.cpp"
+#include "topic.cpp"
+#include "buffer.cpp"
+#include "queue.cpp"
+#include "message.cpp"
+#include "message_batch.cpp"
+#include "message_timestamp.cpp"
+#include "message_internal.cpp"
+#include "message_pool.cpp"
+#include "topic_partition.cpp"
+#include "topic_partition_list.cpp"
+#include "cached_topic_partition_list.cpp"
+#include "compact_topic_partition_list.cpp"
+#include "metadata.cpp"
+#include "cluster_topology.cpp"
+#include "group_information.cpp"
+#include "header_schema.cpp"
+#include "error.cpp"
+#include "partition_offset_result.cpp"
+#include "event.cpp"
+#include "handle_statistics.cpp"
+#include "kafka_statistics.cpp"
+#include "thread_configuration.cpp"
+#include "mock_cluster.cpp"
+#include "wrapper_profiler.cpp"
+#include "kafka_handle_base.cpp"
+#include "producer.cpp"
+#include "consumer.cpp"
+#include "utils/backoff_performer.cpp"
+#include "utils/backoff_committer.cpp"
+#include "utils/backoff_scheduler.cpp"
+#include "utils/poll_strategy_base.cpp"
+#include "utils/roundrobin_poll_strategy.cpp"
+#include "utils/event_driven_poll_strategy.cpp"
+#include "utils/weighted_poll_strategy.cpp"
+#include "utils/prefetching_consumer.cpp"
+#include "utils/parallel_consumer.cpp"
+#include "utils/background_event_pump.cpp"
+#include "utils/sharded_consumer.cpp"
+#include "utils/consumer_pipeline.cpp"
+#include "utils/latency_histogram.cpp"
+#include "utils/adaptive_batch_controller.cpp"
+#include "utils/handle_event_loop.cpp"
+#include "utils/commit_order_tracker.cpp"
+#include "utils/key_partitioner.cpp"
+#include "utils/batch_transform.cpp"
+#include "utils/lag_monitor.cpp"
@@ -44,10 +44,14 @@ rd_kafka_resp_err_t Error::get_error() const {
     return error_;
 }
 
-string Error::to_string() const {
+const char* Error::get_message() const {
     return rd_kafka_err2str(error_);
 }
 
+string Error::to_string() const {
+    return get_message();
+}
+
 Error::operator bool() const {
     return error_ != RD_KAFKA_RESP_ERR_NO_ERROR;
 }
@@ -61,7 +65,9 @@ bool Error::operator!=(const Error& rhs) const {
 }
 
 ostream& operator<<(ostream& output, const Error& rhs) {
-    return output << rhs.to_string();
+    // Stream the static rdkafka string directly instead of materializing a
+    // std::string copy
+    return output << rhs.get_message();
 }
 
 } // cppkafka
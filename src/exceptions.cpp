@@ -88,20 +88,28 @@ UnexpectedVersion::UnexpectedVersion(uint32_t version)
 
 // HandleException
 
-HandleException::HandleException(Error error) 
-: Exception(error.to_string()), error_(error) {
+HandleException::HandleException(Error error)
+: Exception({}), error_(error) {
 
 }
 
+const char* HandleException::what() const noexcept {
+    return error_.get_message();
+}
+
 Error HandleException::get_error() const {
     return error_;
 }
 
 // ConsumerException
 
-ConsumerException::ConsumerException(Error error) 
-: Exception(error.to_string()), error_(error) {
+ConsumerException::ConsumerException(Error error)
+: Exception({}), error_(error) {
+
+}
 
+const char* ConsumerException::what() const noexcept {
+    return error_.get_message();
 }
 
 Error ConsumerException::get_error() const {
@@ -111,8 +119,12 @@ Error ConsumerException::get_error() const {
 // QueueException
 
 QueueException::QueueException(Error error)
-: Exception(error.to_string()), error_(error) {
+: Exception({}), error_(error) {
+
+}
 
+const char* QueueException::what() const noexcept {
+    return error_.get_message();
 }
 
 Error QueueException::get_error() const {
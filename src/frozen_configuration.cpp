@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "frozen_configuration.h"
+#include "topic_configuration.h"
+
+using std::make_shared;
+
+namespace cppkafka {
+
+FrozenConfiguration::FrozenConfiguration(Configuration config) {
+    auto& maybe_config = config.get_default_topic_configuration();
+    if (maybe_config) {
+        maybe_config->set_as_opaque();
+        auto conf_handle = rd_kafka_topic_conf_dup(maybe_config->get_handle());
+        rd_kafka_conf_set_default_topic_conf(config.get_handle(), conf_handle);
+    }
+    config_ = make_shared<const Configuration>(std::move(config));
+}
+
+const Configuration& FrozenConfiguration::get_configuration() const {
+    return *config_;
+}
+
+rd_kafka_conf_t* FrozenConfiguration::make_handle_configuration(void* opaque) const {
+    rd_kafka_conf_t* handle = rd_kafka_conf_dup(config_->get_handle());
+    rd_kafka_conf_set_opaque(handle, opaque);
+    return handle;
+}
+
+} // cppkafka
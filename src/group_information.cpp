@@ -6,6 +6,7 @@
 #include "detail/endianness.h"
 
 using std::string;
+using std::string_view;
 using std::vector;
 using std::memcpy;
 using std::distance;
@@ -142,4 +143,98 @@ const vector<GroupMemberInformation>& GroupInformation::get_members() const {
     return members_;
 }
 
+// GroupMemberInformationView
+
+GroupMemberInformationView::GroupMemberInformationView(const rd_kafka_group_member_info& info)
+: info_(&info) {
+
+}
+
+string_view GroupMemberInformationView::get_member_id() const {
+    return info_->member_id;
+}
+
+string_view GroupMemberInformationView::get_client_id() const {
+    return info_->client_id;
+}
+
+string_view GroupMemberInformationView::get_client_host() const {
+    return info_->client_host;
+}
+
+Buffer GroupMemberInformationView::get_member_metadata() const {
+    return Buffer((const uint8_t*)info_->member_metadata, info_->member_metadata_size);
+}
+
+Buffer GroupMemberInformationView::get_member_assignment() const {
+    return Buffer((const uint8_t*)info_->member_assignment, info_->member_assignment_size);
+}
+
+// GroupInformationView
+
+GroupInformationView::GroupInformationView(const rd_kafka_group_info& info)
+: info_(&info) {
+
+}
+
+BrokerMetadata GroupInformationView::get_broker() const {
+    return BrokerMetadata(info_->broker);
+}
+
+string_view GroupInformationView::get_name() const {
+    return info_->group;
+}
+
+Error GroupInformationView::get_error() const {
+    return info_->err;
+}
+
+string_view GroupInformationView::get_state() const {
+    return info_->state;
+}
+
+string_view GroupInformationView::get_protocol_type() const {
+    return info_->protocol_type;
+}
+
+string_view GroupInformationView::get_protocol() const {
+    return info_->protocol;
+}
+
+size_t GroupInformationView::get_member_count() const {
+    return info_->member_cnt;
+}
+
+GroupMemberInformationView GroupInformationView::get_member(size_t index) const {
+    return GroupMemberInformationView(info_->members[index]);
+}
+
+// GroupInformationSnapshot
+
+GroupInformationSnapshot::GroupInformationSnapshot()
+: handle_(nullptr, &rd_kafka_group_list_destroy) {
+
+}
+
+GroupInformationSnapshot::GroupInformationSnapshot(const rd_kafka_group_list* handle)
+: handle_(handle, &rd_kafka_group_list_destroy) {
+
+}
+
+size_t GroupInformationSnapshot::get_size() const {
+    return handle_->group_cnt;
+}
+
+GroupInformationView GroupInformationSnapshot::get_group(size_t index) const {
+    return GroupInformationView(handle_->groups[index]);
+}
+
+GroupInformationSnapshot::operator bool() const {
+    return handle_ != nullptr;
+}
+
+const rd_kafka_group_list* GroupInformationSnapshot::get_handle() const {
+    return handle_.get();
+}
+
 } // cppkafka
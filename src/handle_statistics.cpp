@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "handle_statistics.h"
+
+namespace cppkafka {
+
+HandleStatistics::Snapshot HandleStatistics::get_snapshot() const {
+    Snapshot snapshot;
+    snapshot.messages_produced = messages_produced_.value.load(std::memory_order_relaxed);
+    snapshot.bytes_produced = bytes_produced_.value.load(std::memory_order_relaxed);
+    snapshot.queue_full_events = queue_full_events_.value.load(std::memory_order_relaxed);
+    snapshot.messages_consumed = messages_consumed_.value.load(std::memory_order_relaxed);
+    snapshot.bytes_consumed = bytes_consumed_.value.load(std::memory_order_relaxed);
+    snapshot.polls = polls_.value.load(std::memory_order_relaxed);
+    snapshot.empty_polls = empty_polls_.value.load(std::memory_order_relaxed);
+    snapshot.poll_time_us = poll_time_us_.value.load(std::memory_order_relaxed);
+    snapshot.bytes_held = bytes_held_.value.load(std::memory_order_relaxed);
+    snapshot.bytes_held_high_water_mark =
+        bytes_held_high_water_mark_.value.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void HandleStatistics::reset() {
+    messages_produced_.value.store(0, std::memory_order_relaxed);
+    bytes_produced_.value.store(0, std::memory_order_relaxed);
+    queue_full_events_.value.store(0, std::memory_order_relaxed);
+    messages_consumed_.value.store(0, std::memory_order_relaxed);
+    bytes_consumed_.value.store(0, std::memory_order_relaxed);
+    polls_.value.store(0, std::memory_order_relaxed);
+    empty_polls_.value.store(0, std::memory_order_relaxed);
+    poll_time_us_.value.store(0, std::memory_order_relaxed);
+    // bytes_held_ is deliberately left alone: zeroing it would desynchronize
+    // the gauge from the releases of messages still alive
+    bytes_held_high_water_mark_.value.store(0, std::memory_order_relaxed);
+}
+
+} // cppkafka
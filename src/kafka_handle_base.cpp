@@ -27,6 +27,9 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "kafka_handle_base.h"
 #include "metadata.h"
 #include "group_information.h"
@@ -47,14 +50,15 @@ namespace cppkafka {
 
 const milliseconds KafkaHandleBase::DEFAULT_TIMEOUT{1000};
 
-KafkaHandleBase::KafkaHandleBase(Configuration config) 
-: timeout_ms_(DEFAULT_TIMEOUT), config_(std::move(config)), handle_(nullptr, HandleDeleter(this)), destroy_flags_(0) {
-    auto& maybe_config = config_.get_default_topic_configuration();
-    if (maybe_config) {
-        maybe_config->set_as_opaque();
-        auto conf_handle = rd_kafka_topic_conf_dup(maybe_config->get_handle());
-        rd_kafka_conf_set_default_topic_conf(config_.get_handle(), conf_handle);
-    }
+KafkaHandleBase::KafkaHandleBase(Configuration config)
+: KafkaHandleBase(FrozenConfiguration(std::move(config))) {
+}
+
+KafkaHandleBase::KafkaHandleBase(FrozenConfiguration config)
+: timeout_ms_(DEFAULT_TIMEOUT), config_(std::move(config)), handle_(nullptr, HandleDeleter(this)), destroy_flags_(0),
+  metadata_cache_ttl_(0) {
+    // The default topic configuration (if any) was attached when the
+    // configuration was frozen
 }
 
 void KafkaHandleBase::pause_partitions(const TopicPartitionList& topic_partitions) {
@@ -65,7 +69,7 @@ void KafkaHandleBase::pause_partitions(const TopicPartitionList& topic_partition
 }
 
 void KafkaHandleBase::pause(const std::string& topic) {
-    pause_partitions(convert(topic, get_metadata(get_topic(topic)).get_partitions()));
+    pause_partitions(convert(topic, get_metadata(get_cached_topic(topic)).get_partitions()));
 }
 
 void KafkaHandleBase::resume_partitions(const TopicPartitionList& topic_partitions) {
@@ -76,7 +80,7 @@ void KafkaHandleBase::resume_partitions(const TopicPartitionList& topic_partitio
 }
 
 void KafkaHandleBase::resume(const std::string& topic) {
-    resume_partitions(convert(topic, get_metadata(get_topic(topic)).get_partitions()));
+    resume_partitions(convert(topic, get_metadata(get_cached_topic(topic)).get_partitions()));
 }
 
 void KafkaHandleBase::set_timeout(milliseconds timeout) {
@@ -91,6 +95,64 @@ void KafkaHandleBase::add_brokers(const string& brokers) {
     rd_kafka_brokers_add(handle_.get(), brokers.data());
 }
 
+bool KafkaHandleBase::warmup(milliseconds timeout) {
+    // Retrying with short metadata round trips instead of one request with
+    // the full timeout catches a broker that comes up halfway through quickly
+    static const milliseconds RETRY_STEP(250);
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const auto remaining = [&]() {
+        return std::chrono::duration_cast<milliseconds>(deadline -
+                                                        std::chrono::steady_clock::now());
+    };
+    // The metadata request forces the bootstrap; librdkafka resolves and
+    // connects to the configured brokers in parallel internally and serves
+    // the request once any of them completes the handshake
+    bool bootstrapped = false;
+    while (!bootstrapped) {
+        const milliseconds left = remaining();
+        if (left <= milliseconds::zero()) {
+            return false;
+        }
+        try {
+            // Locally known topics only; keeps the response small on big clusters
+            bootstrapped = !get_metadata(false, std::min(left, RETRY_STEP))
+                                .get_brokers().empty();
+        }
+        catch (const HandleException&) {
+            // Not reachable yet; retry until the deadline
+        }
+    }
+    ready_ = true;
+    // Best effort: pre-fetch metadata for the topics registered on this
+    // handle so the first produce/consume doesn't pay the per-topic round
+    // trip. Failures here (e.g. a topic pending auto-creation) don't make
+    // the warmed up connections any less useful, so they don't fail the call.
+    vector<string> topic_names;
+    {
+        lock_guard<mutex> _(topic_configurations_mutex_);
+        for (const auto& topic_config : topic_configurations_) {
+            topic_names.push_back(topic_config.first);
+        }
+    }
+    for (const string& name : topic_names) {
+        const milliseconds left = remaining();
+        if (left <= milliseconds::zero()) {
+            break;
+        }
+        try {
+            get_metadata(get_cached_topic(name), left);
+        }
+        catch (const HandleException&) {
+            continue;
+        }
+    }
+    return true;
+}
+
+bool KafkaHandleBase::is_ready() const {
+    return ready_.load(std::memory_order_relaxed);
+}
+
 rd_kafka_t* KafkaHandleBase::get_handle() const {
     return handle_.get();
 }
@@ -106,6 +168,22 @@ Topic KafkaHandleBase::get_topic(const string& name, TopicConfiguration config)
     return get_topic(name, rd_kafka_topic_conf_dup(handle));
 }
 
+Topic KafkaHandleBase::get_cached_topic(const string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(topic_cache_mutex_);
+        auto iter = topic_cache_.find(name);
+        if (iter != topic_cache_.end()) {
+            return Topic::make_non_owning(iter->second.get_handle());
+        }
+    }
+    // Create the handle outside the lock; if we raced another thread, the
+    // loser's topic is simply discarded
+    Topic topic = get_topic(name);
+    std::lock_guard<std::shared_mutex> _(topic_cache_mutex_);
+    auto iter = topic_cache_.emplace(name, std::move(topic)).first;
+    return Topic::make_non_owning(iter->second.get_handle());
+}
+
 KafkaHandleBase::OffsetTuple
 KafkaHandleBase::query_offsets(const TopicPartition& topic_partition) const {
     return query_offsets(topic_partition, timeout_ms_);
@@ -126,6 +204,60 @@ KafkaHandleBase::query_offsets(const TopicPartition& topic_partition,
     return make_tuple(low, high);
 }
 
+vector<KafkaHandleBase::OffsetTuple>
+KafkaHandleBase::query_offsets(const TopicPartitionList& topic_partitions) const {
+    return query_offsets(topic_partitions, timeout_ms_);
+}
+
+vector<KafkaHandleBase::OffsetTuple>
+KafkaHandleBase::query_offsets(const TopicPartitionList& topic_partitions,
+                               milliseconds timeout) const {
+    const size_t count = topic_partitions.size();
+    vector<OffsetTuple> output(count, OffsetTuple(0, 0));
+    if (count == 0) {
+        return output;
+    }
+    const int timeout_ms = static_cast<int>(timeout.count());
+    std::atomic<size_t> next_index{0};
+    std::atomic<rd_kafka_resp_err_t> first_error{RD_KAFKA_RESP_ERR_NO_ERROR};
+    const auto worker = [&]() {
+        size_t index;
+        while ((index = next_index.fetch_add(1)) < count) {
+            const TopicPartition& topic_partition = topic_partitions[index];
+            int64_t low;
+            int64_t high;
+            rd_kafka_resp_err_t result =
+                rd_kafka_query_watermark_offsets(handle_.get(),
+                                                 topic_partition.get_topic().data(),
+                                                 topic_partition.get_partition(),
+                                                 &low, &high, timeout_ms);
+            if (result != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                rd_kafka_resp_err_t expected = RD_KAFKA_RESP_ERR_NO_ERROR;
+                first_error.compare_exchange_strong(expected, result);
+            }
+            else {
+                output[index] = make_tuple(low, high);
+            }
+        }
+    };
+    // The queries are network bound (each worker just waits on a broker round
+    // trip), so the pool size is capped independently of the core count
+    static const size_t MAX_WORKERS = 16;
+    const size_t worker_count = std::min(count, MAX_WORKERS);
+    vector<std::thread> workers;
+    // The calling thread doubles as one of the workers
+    workers.reserve(worker_count - 1);
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    check_error(first_error.load());
+    return output;
+}
+
 Metadata KafkaHandleBase::get_metadata(bool all_topics) const {
     return get_metadata(all_topics, nullptr, timeout_ms_);
 }
@@ -141,6 +273,9 @@ TopicMetadata KafkaHandleBase::get_metadata(const Topic& topic) const {
 
 TopicMetadata KafkaHandleBase::get_metadata(const Topic& topic,
                                             milliseconds timeout) const {
+    if (metadata_cache_ttl_.count() > 0) {
+        return get_cached_metadata(topic, timeout);
+    }
     Metadata md = get_metadata(false, topic.get_handle(), timeout);
     auto topics = md.get_topics();
     if (topics.empty()) {
@@ -149,6 +284,20 @@ TopicMetadata KafkaHandleBase::get_metadata(const Topic& topic,
     return topics.front();
 }
 
+void KafkaHandleBase::set_metadata_cache_ttl(milliseconds ttl) {
+    metadata_cache_ttl_ = ttl;
+}
+
+milliseconds KafkaHandleBase::get_metadata_cache_ttl() const {
+    return metadata_cache_ttl_;
+}
+
+void KafkaHandleBase::invalidate_metadata_cache() {
+    lock_guard<mutex> _(metadata_cache_mutex_);
+    metadata_cache_.clear();
+    metadata_cache_expiration_ = MetadataCacheClock::time_point{};
+}
+
 GroupInformation KafkaHandleBase::get_consumer_group(const string& name) {
     return get_consumer_group(name, timeout_ms_);
 }
@@ -170,6 +319,14 @@ vector<GroupInformation> KafkaHandleBase::get_consumer_groups(milliseconds timeo
     return fetch_consumer_groups(nullptr, timeout);
 }
 
+GroupInformationSnapshot KafkaHandleBase::get_consumer_groups_snapshot() {
+    return get_consumer_groups_snapshot(timeout_ms_);
+}
+
+GroupInformationSnapshot KafkaHandleBase::get_consumer_groups_snapshot(milliseconds timeout) {
+    return fetch_consumer_groups_snapshot(nullptr, timeout);
+}
+
 TopicPartitionList
 KafkaHandleBase::get_offsets_for_times(const TopicPartitionsTimestampsMap& queries) const {
     return get_offsets_for_times(queries, timeout_ms_);
@@ -201,9 +358,21 @@ milliseconds KafkaHandleBase::get_timeout() const {
 }
 
 const Configuration& KafkaHandleBase::get_configuration() const {
+    return config_.get_configuration();
+}
+
+const FrozenConfiguration& KafkaHandleBase::get_frozen_configuration() const {
     return config_;
 }
 
+HandleStatistics& KafkaHandleBase::get_statistics() {
+    return statistics_;
+}
+
+const HandleStatistics& KafkaHandleBase::get_statistics() const {
+    return statistics_;
+}
+
 int KafkaHandleBase::get_out_queue_length() const {
     return rd_kafka_outq_len(handle_.get());
 }
@@ -235,18 +404,39 @@ Metadata KafkaHandleBase::get_metadata(bool all_topics,
     return Metadata(metadata);
 }
 
+TopicMetadata KafkaHandleBase::get_cached_metadata(const Topic& topic,
+                                                   milliseconds timeout) const {
+    lock_guard<mutex> _(metadata_cache_mutex_);
+    const auto now = MetadataCacheClock::now();
+    if (now >= metadata_cache_expiration_) {
+        // Refresh the whole snapshot in one round trip so a burst of topic
+        // lookups (e.g. pausing every assigned topic) only pays for one RPC
+        Metadata md = get_metadata(true, nullptr, timeout);
+        metadata_cache_.clear();
+        for (auto& topic_metadata : md.get_topics()) {
+            const string& name = topic_metadata.get_name();
+            metadata_cache_.emplace(name, std::move(topic_metadata));
+        }
+        metadata_cache_expiration_ = now + metadata_cache_ttl_;
+    }
+    auto iter = metadata_cache_.find(topic.get_name());
+    if (iter == metadata_cache_.end()) {
+        // The topic may have been created after the snapshot was taken; fall
+        // back to a topic scoped fetch and remember it until the next refresh
+        Metadata md = get_metadata(false, topic.get_handle(), timeout);
+        auto topics = md.get_topics();
+        if (topics.empty()) {
+            throw ElementNotFound("topic metadata", topic.get_name());
+        }
+        iter = metadata_cache_.emplace(topic.get_name(), std::move(topics.front())).first;
+    }
+    return iter->second;
+}
+
 vector<GroupInformation> KafkaHandleBase::fetch_consumer_groups(const char* name,
                                                                 milliseconds timeout) {
-    const rd_kafka_group_list* list = nullptr;
-    const int timeout_ms = static_cast<int>(timeout.count());
-    auto result = rd_kafka_list_groups(get_handle(), name, &list, timeout_ms);
-    check_error(result);
-
-    // Wrap this in a unique_ptr so it gets auto deleted
-    using GroupHandle = std::unique_ptr<const rd_kafka_group_list,
-                                        decltype(&rd_kafka_group_list_destroy)>;
-    GroupHandle group_handle(list, &rd_kafka_group_list_destroy);
-
+    GroupInformationSnapshot snapshot = fetch_consumer_groups_snapshot(name, timeout);
+    const rd_kafka_group_list* list = snapshot.get_handle();
     vector<GroupInformation> groups;
     for (int i = 0; i < list->group_cnt; ++i) {
         groups.emplace_back(list->groups[i]);
@@ -254,6 +444,16 @@ vector<GroupInformation> KafkaHandleBase::fetch_consumer_groups(const char* name
     return groups;
 }
 
+GroupInformationSnapshot KafkaHandleBase::fetch_consumer_groups_snapshot(const char* name,
+                                                                         milliseconds timeout) {
+    const rd_kafka_group_list* list = nullptr;
+    const int timeout_ms = static_cast<int>(timeout.count());
+    auto result = rd_kafka_list_groups(get_handle(), name, &list, timeout_ms);
+    check_error(result);
+    // The snapshot takes ownership of the list
+    return GroupInformationSnapshot(list);
+}
+
 void KafkaHandleBase::save_topic_config(const string& topic_name, TopicConfiguration config) {
     lock_guard<mutex> _(topic_configurations_mutex_);
     auto iter = topic_configurations_.emplace(topic_name, std::move(config)).first;
@@ -282,7 +482,7 @@ void KafkaHandleBase::check_error(rd_kafka_resp_err_t error,
 }
 
 rd_kafka_conf_t* KafkaHandleBase::get_configuration_handle() {
-    return config_.get_handle();
+    return config_.get_configuration().get_handle();
 }
 
 #if RD_KAFKA_VERSION >= RD_KAFKA_DESTROY_FLAGS_SUPPORT_VERSION
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <string_view>
+#include "kafka_statistics.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cppkafka {
+
+namespace {
+
+// Returns the next reusable slot in the vector, appending only when every
+// existing slot has already been handed out this pass
+template <typename T>
+T& next_entry(vector<T>& entries, size_t& used) {
+    if (used == entries.size()) {
+        entries.emplace_back();
+    }
+    return entries[used++];
+}
+
+void reset_window(KafkaStatistics::WindowStatistics& output) {
+    output = KafkaStatistics::WindowStatistics{};
+}
+
+void reset_broker(KafkaStatistics::BrokerStatistics& output) {
+    output.name.clear();
+    output.state.clear();
+    output.node_id = -1;
+    output.outbuf_cnt = 0;
+    output.outbuf_msg_cnt = 0;
+    output.waitresp_cnt = 0;
+    output.waitresp_msg_cnt = 0;
+    output.tx = 0;
+    output.tx_bytes = 0;
+    output.rx = 0;
+    output.rx_bytes = 0;
+    reset_window(output.rtt);
+    reset_window(output.int_latency);
+}
+
+void reset_topic(KafkaStatistics::TopicStatistics& output) {
+    output.name.clear();
+    reset_window(output.batch_size);
+}
+
+void reset_top_level(KafkaStatistics& output) {
+    output.name.clear();
+    output.client_id.clear();
+    output.type.clear();
+    output.ts = 0;
+    output.time = 0;
+    output.msg_cnt = 0;
+    output.msg_size = 0;
+    output.replyq = 0;
+    output.tx = 0;
+    output.tx_bytes = 0;
+    output.rx = 0;
+    output.rx_bytes = 0;
+    output.txmsgs = 0;
+    output.txmsg_bytes = 0;
+    output.rxmsgs = 0;
+    output.rxmsg_bytes = 0;
+}
+
+// Single pass, allocation free scanner over the statistics JSON. Only the keys
+// that map to KafkaStatistics fields are materialized; everything else is
+// skipped in place.
+class StatisticsJsonParser {
+public:
+    StatisticsJsonParser(const char* data, size_t length)
+    : current_(data), end_(data + length) {
+
+    }
+
+    bool parse(KafkaStatistics& output) {
+        reset_top_level(output);
+        size_t brokers_used = 0;
+        size_t topics_used = 0;
+        const bool ok = parse_object([&](string_view key) {
+            if (key == "name") return parse_string(output.name);
+            if (key == "client_id") return parse_string(output.client_id);
+            if (key == "type") return parse_string(output.type);
+            if (key == "ts") return parse_int(output.ts);
+            if (key == "time") return parse_int(output.time);
+            if (key == "msg_cnt") return parse_int(output.msg_cnt);
+            if (key == "msg_size") return parse_int(output.msg_size);
+            if (key == "replyq") return parse_int(output.replyq);
+            if (key == "tx") return parse_int(output.tx);
+            if (key == "tx_bytes") return parse_int(output.tx_bytes);
+            if (key == "rx") return parse_int(output.rx);
+            if (key == "rx_bytes") return parse_int(output.rx_bytes);
+            if (key == "txmsgs") return parse_int(output.txmsgs);
+            if (key == "txmsg_bytes") return parse_int(output.txmsg_bytes);
+            if (key == "rxmsgs") return parse_int(output.rxmsgs);
+            if (key == "rxmsg_bytes") return parse_int(output.rxmsg_bytes);
+            if (key == "brokers") {
+                return parse_object([&](string_view) {
+                    return parse_broker(next_entry(output.brokers, brokers_used));
+                });
+            }
+            if (key == "topics") {
+                return parse_object([&](string_view) {
+                    return parse_topic(next_entry(output.topics, topics_used));
+                });
+            }
+            return skip_value();
+        });
+        if (!ok) {
+            return false;
+        }
+        output.brokers.resize(brokers_used);
+        output.topics.resize(topics_used);
+        return true;
+    }
+private:
+    bool parse_broker(KafkaStatistics::BrokerStatistics& output) {
+        reset_broker(output);
+        return parse_object([&](string_view key) {
+            if (key == "name") return parse_string(output.name);
+            if (key == "state") return parse_string(output.state);
+            if (key == "nodeid") return parse_int32(output.node_id);
+            if (key == "outbuf_cnt") return parse_int(output.outbuf_cnt);
+            if (key == "outbuf_msg_cnt") return parse_int(output.outbuf_msg_cnt);
+            if (key == "waitresp_cnt") return parse_int(output.waitresp_cnt);
+            if (key == "waitresp_msg_cnt") return parse_int(output.waitresp_msg_cnt);
+            if (key == "tx") return parse_int(output.tx);
+            if (key == "txbytes") return parse_int(output.tx_bytes);
+            if (key == "rx") return parse_int(output.rx);
+            if (key == "rxbytes") return parse_int(output.rx_bytes);
+            if (key == "rtt") return parse_window(output.rtt);
+            if (key == "int_latency") return parse_window(output.int_latency);
+            return skip_value();
+        });
+    }
+
+    bool parse_topic(KafkaStatistics::TopicStatistics& output) {
+        reset_topic(output);
+        size_t partitions_used = 0;
+        const bool ok = parse_object([&](string_view key) {
+            if (key == "topic") return parse_string(output.name);
+            if (key == "batchsize") return parse_window(output.batch_size);
+            if (key == "partitions") {
+                return parse_object([&](string_view) {
+                    return parse_partition(next_entry(output.partitions, partitions_used));
+                });
+            }
+            return skip_value();
+        });
+        if (!ok) {
+            return false;
+        }
+        output.partitions.resize(partitions_used);
+        return true;
+    }
+
+    bool parse_partition(KafkaStatistics::PartitionStatistics& output) {
+        output = KafkaStatistics::PartitionStatistics{};
+        return parse_object([&](string_view key) {
+            if (key == "partition") return parse_int32(output.partition);
+            if (key == "leader") return parse_int32(output.leader);
+            if (key == "msgq_cnt") return parse_int(output.msgq_cnt);
+            if (key == "msgq_bytes") return parse_int(output.msgq_bytes);
+            if (key == "xmit_msgq_cnt") return parse_int(output.xmit_msgq_cnt);
+            if (key == "xmit_msgq_bytes") return parse_int(output.xmit_msgq_bytes);
+            if (key == "fetchq_cnt") return parse_int(output.fetchq_cnt);
+            if (key == "fetchq_size") return parse_int(output.fetchq_size);
+            if (key == "lo_offset") return parse_int(output.lo_offset);
+            if (key == "hi_offset") return parse_int(output.hi_offset);
+            if (key == "app_offset") return parse_int(output.app_offset);
+            if (key == "committed_offset") return parse_int(output.committed_offset);
+            if (key == "consumer_lag") return parse_int(output.consumer_lag);
+            if (key == "txmsgs") return parse_int(output.txmsgs);
+            if (key == "txbytes") return parse_int(output.txbytes);
+            if (key == "rxmsgs") return parse_int(output.rxmsgs);
+            if (key == "rxbytes") return parse_int(output.rxbytes);
+            return skip_value();
+        });
+    }
+
+    bool parse_window(KafkaStatistics::WindowStatistics& output) {
+        reset_window(output);
+        return parse_object([&](string_view key) {
+            if (key == "min") return parse_int(output.min);
+            if (key == "max") return parse_int(output.max);
+            if (key == "avg") return parse_int(output.avg);
+            if (key == "cnt") return parse_int(output.cnt);
+            return skip_value();
+        });
+    }
+
+    // Parses an object, invoking member(key) for every member. The callback is
+    // responsible for consuming (or skipping) the member's value
+    template <typename Member>
+    bool parse_object(const Member& member) {
+        if (!expect('{')) {
+            return false;
+        }
+        skip_whitespace();
+        if (!eof() && *current_ == '}') {
+            ++current_;
+            return true;
+        }
+        while (true) {
+            string_view key;
+            if (!parse_key(key) || !expect(':') || !member(key)) {
+                return false;
+            }
+            skip_whitespace();
+            if (eof()) {
+                return false;
+            }
+            const char separator = *current_++;
+            if (separator == '}') {
+                return true;
+            }
+            if (separator != ',') {
+                return false;
+            }
+        }
+    }
+
+    // Parses a key as a view over the input; keys are only compared against
+    // literals so escapes are left undecoded
+    bool parse_key(string_view& output) {
+        skip_whitespace();
+        if (eof() || *current_++ != '"') {
+            return false;
+        }
+        const char* start = current_;
+        while (!eof()) {
+            const char c = *current_++;
+            if (c == '\\') {
+                if (!eof()) {
+                    ++current_;
+                }
+            }
+            else if (c == '"') {
+                output = string_view(start, current_ - start - 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parse_string(string& output) {
+        skip_whitespace();
+        if (eof() || *current_++ != '"') {
+            return false;
+        }
+        output.clear();
+        while (!eof()) {
+            char c = *current_++;
+            if (c == '"') {
+                return true;
+            }
+            if (c == '\\') {
+                if (eof()) {
+                    return false;
+                }
+                c = *current_++;
+                switch (c) {
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u':
+                        // Not decoded; these never show up in rdkafka's output
+                        current_ += (end_ - current_) < 4 ? (end_ - current_) : 4;
+                        c = '?';
+                        break;
+                    default: break;
+                }
+            }
+            output.push_back(c);
+        }
+        return false;
+    }
+
+    bool parse_int(int64_t& output) {
+        skip_whitespace();
+        bool negative = false;
+        if (!eof() && *current_ == '-') {
+            negative = true;
+            ++current_;
+        }
+        if (eof() || !is_digit(*current_)) {
+            return false;
+        }
+        uint64_t value = 0;
+        while (!eof() && is_digit(*current_)) {
+            value = value * 10 + static_cast<uint64_t>(*current_++ - '0');
+        }
+        // rdkafka only emits integers; tolerate (and truncate) anything else
+        if (!eof() && *current_ == '.') {
+            ++current_;
+            while (!eof() && is_digit(*current_)) {
+                ++current_;
+            }
+        }
+        if (!eof() && (*current_ == 'e' || *current_ == 'E')) {
+            ++current_;
+            if (!eof() && (*current_ == '-' || *current_ == '+')) {
+                ++current_;
+            }
+            while (!eof() && is_digit(*current_)) {
+                ++current_;
+            }
+        }
+        output = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+        return true;
+    }
+
+    bool parse_int32(int32_t& output) {
+        int64_t value;
+        if (!parse_int(value)) {
+            return false;
+        }
+        output = static_cast<int32_t>(value);
+        return true;
+    }
+
+    bool skip_value() {
+        skip_whitespace();
+        if (eof()) {
+            return false;
+        }
+        switch (*current_) {
+            case '"': {
+                string_view ignored;
+                return parse_key(ignored);
+            }
+            case '{':
+                return skip_composite('{', '}');
+            case '[':
+                return skip_composite('[', ']');
+            case 't':
+                return skip_literal("true");
+            case 'f':
+                return skip_literal("false");
+            case 'n':
+                return skip_literal("null");
+            default: {
+                int64_t ignored;
+                return parse_int(ignored);
+            }
+        }
+    }
+
+    bool skip_composite(char open, char close) {
+        size_t depth = 0;
+        while (!eof()) {
+            const char c = *current_++;
+            if (c == '"') {
+                while (!eof()) {
+                    const char s = *current_++;
+                    if (s == '\\') {
+                        if (!eof()) {
+                            ++current_;
+                        }
+                    }
+                    else if (s == '"') {
+                        break;
+                    }
+                }
+            }
+            else if (c == open) {
+                ++depth;
+            }
+            else if (c == close) {
+                if (--depth == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool skip_literal(string_view literal) {
+        if (static_cast<size_t>(end_ - current_) < literal.size() ||
+            string_view(current_, literal.size()) != literal) {
+            return false;
+        }
+        current_ += literal.size();
+        return true;
+    }
+
+    bool expect(char expected) {
+        skip_whitespace();
+        if (eof() || *current_ != expected) {
+            return false;
+        }
+        ++current_;
+        return true;
+    }
+
+    void skip_whitespace() {
+        while (!eof() && (*current_ == ' ' || *current_ == '\t' ||
+                          *current_ == '\n' || *current_ == '\r')) {
+            ++current_;
+        }
+    }
+
+    static bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool eof() const {
+        return current_ == end_;
+    }
+
+    const char* current_;
+    const char* end_;
+};
+
+} // anonymous namespace
+
+bool KafkaStatistics::parse(const char* data, size_t length, KafkaStatistics& output) {
+    return StatisticsJsonParser(data, length).parse(output);
+}
+
+} // cppkafka
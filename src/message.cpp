@@ -75,6 +75,28 @@ Message::Message(HandlePtr handle)
 #endif
 }
 
+rd_kafka_message_t* Message::release_owned_handle() {
+    rd_kafka_message_t* handle = nullptr;
+    if (handle_ && handle_.get_deleter() == &rd_kafka_message_destroy) {
+        handle = handle_.release();
+    }
+    // Leave this message in the empty state; the buffer views would otherwise
+    // dangle once the released handle is destroyed
+    handle_ = HandlePtr(nullptr, nullptr);
+    payload_ = Buffer();
+    key_ = Buffer();
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+    header_list_ = HeaderListType();
+#endif
+    user_data_ = nullptr;
+    internal_.reset();
+    cached_topic_name_ = nullptr;
+    raw_timestamp_ = -1;
+    raw_timestamp_type_ = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
+    timestamp_loaded_ = false;
+    return handle;
+}
+
 Message& Message::load_internal() {
     if (user_data_) {
         MessageInternal* mi = static_cast<MessageInternal*>(user_data_);
@@ -84,14 +106,43 @@ Message& Message::load_internal() {
     return *this;
 }
 
-std::optional<MessageTimestamp> Message::get_timestamp() const {
+void Message::load_timestamp() const {
+    if (timestamp_loaded_) {
+        return;
+    }
     rd_kafka_timestamp_type_t type = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
-    int64_t timestamp = rd_kafka_message_timestamp(handle_.get(), &type);
-    if (timestamp == -1 || type == RD_KAFKA_TIMESTAMP_NOT_AVAILABLE) {
+    raw_timestamp_ = rd_kafka_message_timestamp(handle_.get(), &type);
+    raw_timestamp_type_ = type;
+    if (type == RD_KAFKA_TIMESTAMP_NOT_AVAILABLE) {
+        raw_timestamp_ = -1;
+    }
+    timestamp_loaded_ = true;
+}
+
+std::optional<MessageTimestamp> Message::get_timestamp() const {
+    load_timestamp();
+    if (raw_timestamp_ == -1) {
         return {};
     }
-    return MessageTimestamp(std::chrono::milliseconds(timestamp),
-                            static_cast<MessageTimestamp::TimestampType>(type));
+    return MessageTimestamp(std::chrono::milliseconds(raw_timestamp_),
+                            static_cast<MessageTimestamp::TimestampType>(raw_timestamp_type_));
+}
+
+void extract_timestamps(const MessageList& messages, int64_t* timestamps, uint8_t* types) {
+    const size_t count = messages.size();
+    for (size_t i = 0; i != count; ++i) {
+        rd_kafka_timestamp_type_t type = RD_KAFKA_TIMESTAMP_NOT_AVAILABLE;
+        int64_t timestamp = -1;
+        rd_kafka_message_t* handle = messages[i].get_handle();
+        if (handle) {
+            timestamp = rd_kafka_message_timestamp(handle, &type);
+        }
+        // Normalize so consumers only need to test for -1
+        timestamps[i] = type == RD_KAFKA_TIMESTAMP_NOT_AVAILABLE ? -1 : timestamp;
+        if (types) {
+            types[i] = static_cast<uint8_t>(type);
+        }
+    }
 }
 
 } // cppkafka
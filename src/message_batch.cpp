@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "message_batch.h"
+
+namespace cppkafka {
+
+MessageBatch::MessageBatch(size_t max_batch_size)
+: buffer_(max_batch_size) {
+    messages_.reserve(max_batch_size);
+}
+
+size_t MessageBatch::get_max_batch_size() const {
+    return buffer_.size();
+}
+
+size_t MessageBatch::get_size() const {
+    return messages_.size();
+}
+
+bool MessageBatch::empty() const {
+    return messages_.empty();
+}
+
+void MessageBatch::clear() {
+    messages_.clear();
+}
+
+const std::vector<Message>& MessageBatch::get_messages() const {
+    return messages_;
+}
+
+const Message& MessageBatch::operator[](size_t index) const {
+    return messages_[index];
+}
+
+Message& MessageBatch::operator[](size_t index) {
+    return messages_[index];
+}
+
+MessageBatch::iterator MessageBatch::begin() {
+    return messages_.begin();
+}
+
+MessageBatch::iterator MessageBatch::end() {
+    return messages_.end();
+}
+
+MessageBatch::const_iterator MessageBatch::begin() const {
+    return messages_.begin();
+}
+
+MessageBatch::const_iterator MessageBatch::end() const {
+    return messages_.end();
+}
+
+rd_kafka_message_t** MessageBatch::get_buffer() {
+    return buffer_.data();
+}
+
+void MessageBatch::load(size_t message_count) {
+    for (size_t i = 0; i != message_count; ++i) {
+        messages_.emplace_back(buffer_[i]);
+    }
+}
+
+} // cppkafka
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "message_pool.h"
+
+using std::vector;
+
+namespace cppkafka {
+
+const size_t MessagePool::DEFAULT_FLUSH_THRESHOLD = 512;
+
+MessagePool::MessagePool(size_t flush_threshold)
+: flush_threshold_(flush_threshold) {
+    pending_handles_.reserve(flush_threshold_);
+}
+
+MessagePool::~MessagePool() {
+    flush();
+}
+
+void MessagePool::recycle(Message& message) {
+    rd_kafka_message_t* handle = message.release_owned_handle();
+    if (handle) {
+        pending_handles_.push_back(handle);
+    }
+    maybe_flush();
+}
+
+void MessagePool::recycle(vector<Message>& messages) {
+    for (Message& message : messages) {
+        rd_kafka_message_t* handle = message.release_owned_handle();
+        if (handle) {
+            pending_handles_.push_back(handle);
+        }
+    }
+    maybe_flush();
+}
+
+void MessagePool::flush() {
+    // Retire the whole batch back to back; this is where the per-message
+    // destructor storm is amortized
+    for (rd_kafka_message_t* handle : pending_handles_) {
+        rd_kafka_message_destroy(handle);
+    }
+    pending_handles_.clear();
+}
+
+size_t MessagePool::get_pending_count() const {
+    return pending_handles_.size();
+}
+
+void MessagePool::maybe_flush() {
+    if (pending_handles_.size() >= flush_threshold_) {
+        flush();
+    }
+}
+
+} // cppkafka
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "mock_cluster.h"
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+
+#include "exceptions.h"
+
+using std::string;
+using std::vector;
+using std::chrono::milliseconds;
+
+namespace cppkafka {
+
+MockCluster::MockCluster(size_t broker_count)
+: broker_count_(broker_count) {
+    char error_buffer[512];
+    // The mock cluster is owned by a plain producer instance which is never
+    // used to produce; it just hosts the cluster's background thread
+    handle_ = rd_kafka_new(RD_KAFKA_PRODUCER, rd_kafka_conf_new(),
+                           error_buffer, sizeof(error_buffer));
+    if (!handle_) {
+        throw Exception("Failed to create mock cluster handle: " + string(error_buffer));
+    }
+    cluster_ = rd_kafka_mock_cluster_new(handle_, static_cast<int>(broker_count));
+    if (!cluster_) {
+        rd_kafka_destroy(handle_);
+        throw Exception("Failed to create mock cluster");
+    }
+    bootstrap_servers_ = rd_kafka_mock_cluster_bootstraps(cluster_);
+}
+
+MockCluster::~MockCluster() {
+    rd_kafka_mock_cluster_destroy(cluster_);
+    rd_kafka_destroy(handle_);
+}
+
+const string& MockCluster::get_bootstrap_servers() const {
+    return bootstrap_servers_;
+}
+
+Configuration MockCluster::make_configuration() const {
+    Configuration config;
+    config.set("metadata.broker.list", bootstrap_servers_);
+    return config;
+}
+
+void MockCluster::create_topic(const string& topic, size_t partition_count,
+                               size_t replication_factor) {
+    if (replication_factor == 0) {
+        replication_factor = broker_count_;
+    }
+    const rd_kafka_resp_err_t error =
+        rd_kafka_mock_topic_create(cluster_, topic.data(),
+                                   static_cast<int>(partition_count),
+                                   static_cast<int>(replication_factor));
+    if (error != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        throw HandleException(error);
+    }
+}
+
+void MockCluster::set_broker_rtt(int32_t broker_id, milliseconds rtt) {
+    const rd_kafka_resp_err_t error =
+        rd_kafka_mock_broker_set_rtt(cluster_, broker_id, static_cast<int>(rtt.count()));
+    if (error != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        throw HandleException(error);
+    }
+}
+
+void MockCluster::set_broker_down(int32_t broker_id) {
+    const rd_kafka_resp_err_t error = rd_kafka_mock_broker_set_down(cluster_, broker_id);
+    if (error != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        throw HandleException(error);
+    }
+}
+
+void MockCluster::set_broker_up(int32_t broker_id) {
+    const rd_kafka_resp_err_t error = rd_kafka_mock_broker_set_up(cluster_, broker_id);
+    if (error != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        throw HandleException(error);
+    }
+}
+
+void MockCluster::push_request_errors(int16_t api_key,
+                                      const vector<rd_kafka_resp_err_t>& errors) {
+    // The variadic push interface is the only one available on every supported
+    // version; successive pushes accumulate, so push the errors one at a time
+    for (const rd_kafka_resp_err_t error : errors) {
+        rd_kafka_mock_push_request_errors(cluster_, api_key, 1, error);
+    }
+}
+
+rd_kafka_mock_cluster_t* MockCluster::get_handle() const {
+    return cluster_;
+}
+
+} // cppkafka
+
+#endif // RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION
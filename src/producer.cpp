@@ -28,13 +28,22 @@
  */
 
 #include <errno.h>
+#include <cstdlib>
+#include <map>
 #include <memory>
+#include <new>
+#include <vector>
 #include "producer.h"
 #include "exceptions.h"
 #include "message_internal.h"
+#include "topic.h"
+#include "wrapper_profiler.h"
+#include "detail/tracepoints.h"
 
+using std::map;
 using std::move;
 using std::string;
+using std::vector;
 using std::chrono::milliseconds;
 using std::unique_ptr;
 using std::get;
@@ -42,12 +51,15 @@ using std::get;
 namespace cppkafka {
 
 Producer::Producer(Configuration config)
+: Producer(FrozenConfiguration(std::move(config))) {
+}
+
+Producer::Producer(FrozenConfiguration config)
 : KafkaHandleBase(std::move(config)), message_payload_policy_(PayloadPolicy::COPY_PAYLOAD) {
     char error_buffer[512];
-    auto config_handle = get_configuration().get_handle();
-    rd_kafka_conf_set_opaque(config_handle, this);
+    // The returned duplicate carries our opaque and is consumed by rd_kafka_new
     rd_kafka_t* ptr = rd_kafka_new(RD_KAFKA_PRODUCER,
-                                   rd_kafka_conf_dup(config_handle),
+                                   get_frozen_configuration().make_handle_configuration(this),
                                    error_buffer, sizeof(error_buffer));
     if (!ptr) {
         throw Exception("Failed to create producer handle: " + string(error_buffer));
@@ -66,13 +78,24 @@ Producer::PayloadPolicy Producer::get_payload_policy() const {
 #if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
 
 void Producer::produce(const MessageBuilder& builder) {
-    do_produce(builder, MessageBuilder::HeaderListType(builder.header_list())); //copy headers
+    WrapperProfiler::ScopedProbe probe(WrapperProfiler::Boundary::ProduceWrap);
+    MessageBuilder::HeaderListType headers(builder.header_list()); //copy headers
+    probe.stop(); //from here on rd_kafka_producev dominates
+    do_produce(builder, std::move(headers));
 }
 
 void Producer::produce(MessageBuilder&& builder) {
     do_produce(builder, std::move(builder.header_list())); //move headers
 }
 
+void Producer::produce(const Topic& topic, const MessageBuilder& builder) {
+    do_produce(topic, builder, MessageBuilder::HeaderListType(builder.header_list())); //copy headers
+}
+
+void Producer::produce(const Topic& topic, MessageBuilder&& builder) {
+    do_produce(topic, builder, std::move(builder.header_list())); //move headers
+}
+
 void Producer::produce(const Message& message) {
     do_produce(message, HeaderList<Message::HeaderType>(message.get_header_list())); //copy headers
 }
@@ -91,6 +114,14 @@ void Producer::produce(MessageBuilder&& builder) {
     do_produce(builder);
 }
 
+void Producer::produce(const Topic& topic, const MessageBuilder& builder) {
+    do_produce(topic, builder);
+}
+
+void Producer::produce(const Topic& topic, MessageBuilder&& builder) {
+    do_produce(topic, builder);
+}
+
 void Producer::produce(const Message& message) {
     do_produce(message);
 }
@@ -101,6 +132,142 @@ void Producer::produce(Message&& message) {
 
 #endif
 
+void Producer::produce(const MessageBuilder& builder, const GatheredPayload& payload) {
+    const size_t payload_size = payload.get_size();
+    void* output = std::malloc(payload_size);
+    if (!output) {
+        throw std::bad_alloc();
+    }
+    payload.copy_to(output);
+    produce_owned(builder, output, payload_size);
+}
+
+void Producer::produce_owned(const MessageBuilder& builder, void* payload, size_t payload_size) {
+    const Buffer& key = builder.key();
+    // rdkafka owns the payload, so the copy flag (if set) is replaced by the
+    // free flag; any other policy bits (e.g. blocking on a full queue) remain
+    const int policy = (static_cast<int>(message_payload_policy_) & ~RD_KAFKA_MSG_F_COPY) |
+                       RD_KAFKA_MSG_F_FREE;
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+    MessageBuilder::HeaderListType headers(builder.header_list()); //copy headers
+#endif
+    CPPKAFKA_TRACE2(produce_start, builder.partition(), payload_size);
+    auto result = rd_kafka_producev(get_handle(),
+                                    RD_KAFKA_V_TOPIC(builder.topic().data()),
+                                    RD_KAFKA_V_PARTITION(builder.partition()),
+                                    RD_KAFKA_V_MSGFLAGS(policy),
+                                    RD_KAFKA_V_TIMESTAMP(builder.timestamp().count()),
+                                    RD_KAFKA_V_KEY((void*)key.get_data(), key.get_size()),
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+                                    RD_KAFKA_V_HEADERS(headers.get_handle()), //pass ownership to rdkafka
+#endif
+                                    RD_KAFKA_V_VALUE(payload, payload_size),
+                                    RD_KAFKA_V_OPAQUE(builder.user_data()),
+                                    RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, builder.partition(), payload_size, result);
+    if (result == RD_KAFKA_RESP_ERR_NO_ERROR) {
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+        headers.release_handle(); //headers now owned by rdkafka
+#endif
+        get_statistics().record_produce(payload_size);
+    }
+    else {
+        // On failure rdkafka takes ownership of neither the payload nor the headers
+        std::free(payload);
+        if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+            get_statistics().record_queue_full();
+        }
+    }
+    check_error(result);
+}
+
+size_t Producer::produce_batch(vector<MessageBuilder>& builders) {
+    return produce_batch(builders, BatchFailureCallback());
+}
+
+size_t Producer::produce_batch(vector<MessageBuilder>& builders,
+                               const BatchFailureCallback& callback) {
+    // Group the builders by topic, keeping their original positions
+    map<string, vector<size_t>> batches;
+    for (size_t i = 0; i < builders.size(); ++i) {
+        batches[builders[i].topic()].push_back(i);
+    }
+    // Use the per-message partition carried by each rd_kafka_message_t
+    const int policy = static_cast<int>(message_payload_policy_) | RD_KAFKA_MSG_F_PARTITION;
+    size_t produced = 0;
+    for (auto& batch : batches) {
+        Topic topic = get_topic(batch.first);
+        vector<rd_kafka_message_t> messages;
+        vector<size_t> message_indexes;
+        messages.reserve(batch.second.size());
+        message_indexes.reserve(batch.second.size());
+        for (const size_t index : batch.second) {
+            MessageBuilder& builder = builders[index];
+            bool batchable = builder.timestamp().count() == 0;
+#if (RD_KAFKA_VERSION >= RD_KAFKA_HEADERS_SUPPORT_VERSION)
+            batchable = batchable && !builder.header_list();
+#endif
+            if (!batchable) {
+                // rd_kafka_produce_batch supports neither headers nor timestamps,
+                // so these messages take the regular producev path
+                try {
+                    produce(builder);
+                    ++produced;
+                }
+                catch (const HandleException& ex) {
+                    if (!callback) {
+                        throw;
+                    }
+                    callback(builder, ex.get_error());
+                }
+                continue;
+            }
+            const Buffer& payload = builder.payload();
+            const Buffer& key = builder.key();
+            rd_kafka_message_t message{};
+            message.partition = builder.partition();
+            message.payload = (void*)payload.get_data();
+            message.len = payload.get_size();
+            message.key = (void*)key.get_data();
+            message.key_len = key.get_size();
+            message._private = builder.user_data();
+            messages.emplace_back(message);
+            message_indexes.emplace_back(index);
+        }
+        if (messages.empty()) {
+            continue;
+        }
+        const int enqueued = rd_kafka_produce_batch(topic.get_handle(),
+                                                    RD_KAFKA_PARTITION_UA,
+                                                    policy,
+                                                    messages.data(),
+                                                    static_cast<int>(messages.size()));
+        if (enqueued > 0) {
+            produced += enqueued;
+        }
+        for (const rd_kafka_message_t& message : messages) {
+            if (message.err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+                get_statistics().record_produce(message.len);
+            }
+            else if (message.err == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+                get_statistics().record_queue_full();
+            }
+        }
+        if (enqueued < 0 || static_cast<size_t>(enqueued) != messages.size()) {
+            // The per-message error field indicates which ones failed
+            for (size_t i = 0; i < messages.size(); ++i) {
+                if (messages[i].err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                    if (!callback) {
+                        check_error(messages[i].err);
+                    }
+                    callback(builders[message_indexes[i]], Error(messages[i].err));
+                }
+            }
+        }
+    }
+    return produced;
+}
+
 int Producer::poll() {
     return poll(get_timeout());
 }
@@ -125,6 +292,7 @@ void Producer::do_produce(const MessageBuilder& builder,
     const Buffer& payload = builder.payload();
     const Buffer& key = builder.key();
     const int policy = static_cast<int>(message_payload_policy_);
+    CPPKAFKA_TRACE2(produce_start, builder.partition(), payload.get_size());
     auto result = rd_kafka_producev(get_handle(),
                                     RD_KAFKA_V_TOPIC(builder.topic().data()),
                                     RD_KAFKA_V_PARTITION(builder.partition()),
@@ -135,11 +303,46 @@ void Producer::do_produce(const MessageBuilder& builder,
                                     RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
                                     RD_KAFKA_V_OPAQUE(builder.user_data()),
                                     RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, builder.partition(), payload.get_size(), result);
+    // We only want to release the handle on the headers data
+    // if the rd_kafka_producev function returned no error, otherwise
+    // the function doesn't take ownership of the headers data.
+    if(result == RD_KAFKA_RESP_ERR_NO_ERROR) {
+        headers.release_handle();
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
+    }
+    check_error(result);
+}
+
+void Producer::do_produce(const Topic& topic, const MessageBuilder& builder,
+                          MessageBuilder::HeaderListType&& headers) {
+    const Buffer& payload = builder.payload();
+    const Buffer& key = builder.key();
+    const int policy = static_cast<int>(message_payload_policy_);
+    CPPKAFKA_TRACE2(produce_start, builder.partition(), payload.get_size());
+    auto result = rd_kafka_producev(get_handle(),
+                                    RD_KAFKA_V_RKT(topic.get_handle()),
+                                    RD_KAFKA_V_PARTITION(builder.partition()),
+                                    RD_KAFKA_V_MSGFLAGS(policy),
+                                    RD_KAFKA_V_TIMESTAMP(builder.timestamp().count()),
+                                    RD_KAFKA_V_KEY((void*)key.get_data(), key.get_size()),
+                                    RD_KAFKA_V_HEADERS(headers.get_handle()), //pass ownership to rdkafka
+                                    RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
+                                    RD_KAFKA_V_OPAQUE(builder.user_data()),
+                                    RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, builder.partition(), payload.get_size(), result);
     // We only want to release the handle on the headers data
     // if the rd_kafka_producev function returned no error, otherwise
-    // the function doesn't take ownership of the headers data.    
+    // the function doesn't take ownership of the headers data.
     if(result == RD_KAFKA_RESP_ERR_NO_ERROR) {
         headers.release_handle();
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
     }
     check_error(result);
 }
@@ -151,6 +354,7 @@ void Producer::do_produce(const Message& message,
     const int policy = static_cast<int>(message_payload_policy_);
     int64_t duration = message.get_timestamp() ? message.get_timestamp()->get_timestamp().count() : 0;
     auto data = message.get_topic();
+    CPPKAFKA_TRACE2(produce_start, message.get_partition(), payload.get_size());
     auto result = rd_kafka_producev(get_handle(),
                                     RD_KAFKA_V_TOPIC(data.data()),
                                     RD_KAFKA_V_PARTITION(message.get_partition()),
@@ -161,11 +365,16 @@ void Producer::do_produce(const Message& message,
                                     RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
                                     RD_KAFKA_V_OPAQUE(message.get_user_data()),
                                     RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, message.get_partition(), payload.get_size(), result);
     // We only want to release the handle on the headers data
     // if the rd_kafka_producev function returned no error, otherwise
-    // the function doesn't take ownership of the headers data.    
+    // the function doesn't take ownership of the headers data.
     if(result == RD_KAFKA_RESP_ERR_NO_ERROR) {
         headers.release_handle();
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
     }
     check_error(result);
 }
@@ -176,6 +385,7 @@ void Producer::do_produce(const MessageBuilder& builder) {
     const Buffer& payload = builder.payload();
     const Buffer& key = builder.key();
     const int policy = static_cast<int>(message_payload_policy_);
+    CPPKAFKA_TRACE2(produce_start, builder.partition(), payload.get_size());
     auto result = rd_kafka_producev(get_handle(),
                                     RD_KAFKA_V_TOPIC(builder.topic().data()),
                                     RD_KAFKA_V_PARTITION(builder.partition()),
@@ -185,6 +395,37 @@ void Producer::do_produce(const MessageBuilder& builder) {
                                     RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
                                     RD_KAFKA_V_OPAQUE(builder.user_data()),
                                     RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, builder.partition(), payload.get_size(), result);
+    if (result == RD_KAFKA_RESP_ERR_NO_ERROR) {
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
+    }
+    check_error(result);
+}
+
+void Producer::do_produce(const Topic& topic, const MessageBuilder& builder) {
+    const Buffer& payload = builder.payload();
+    const Buffer& key = builder.key();
+    const int policy = static_cast<int>(message_payload_policy_);
+    CPPKAFKA_TRACE2(produce_start, builder.partition(), payload.get_size());
+    auto result = rd_kafka_producev(get_handle(),
+                                    RD_KAFKA_V_RKT(topic.get_handle()),
+                                    RD_KAFKA_V_PARTITION(builder.partition()),
+                                    RD_KAFKA_V_MSGFLAGS(policy),
+                                    RD_KAFKA_V_TIMESTAMP(builder.timestamp().count()),
+                                    RD_KAFKA_V_KEY((void*)key.get_data(), key.get_size()),
+                                    RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
+                                    RD_KAFKA_V_OPAQUE(builder.user_data()),
+                                    RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, builder.partition(), payload.get_size(), result);
+    if (result == RD_KAFKA_RESP_ERR_NO_ERROR) {
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
+    }
     check_error(result);
 }
 
@@ -193,6 +434,7 @@ void Producer::do_produce(const Message& message) {
     const Buffer& key = message.get_key();
     const int policy = static_cast<int>(message_payload_policy_);
     int64_t duration = message.get_timestamp() ? message.get_timestamp().get().get_timestamp().count() : 0;
+    CPPKAFKA_TRACE2(produce_start, message.get_partition(), payload.get_size());
     auto result = rd_kafka_producev(get_handle(),
                                     RD_KAFKA_V_TOPIC(message.get_topic().data()),
                                     RD_KAFKA_V_PARTITION(message.get_partition()),
@@ -202,6 +444,13 @@ void Producer::do_produce(const Message& message) {
                                     RD_KAFKA_V_VALUE((void*)payload.get_data(), payload.get_size()),
                                     RD_KAFKA_V_OPAQUE(message.get_user_data()),
                                     RD_KAFKA_V_END);
+    CPPKAFKA_TRACE3(produce_end, message.get_partition(), payload.get_size(), result);
+    if (result == RD_KAFKA_RESP_ERR_NO_ERROR) {
+        get_statistics().record_produce(payload.get_size());
+    }
+    else if (result == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        get_statistics().record_queue_full();
+    }
     check_error(result);
 }
 
@@ -88,6 +88,14 @@ void Queue::disable_queue_forwarding() const {
     return rd_kafka_queue_forward(handle_.get(), nullptr);
 }
 
+void Queue::enable_event_callback(void (*callback)(rd_kafka_t*, void*), void* opaque) const {
+    rd_kafka_queue_cb_event_enable(handle_.get(), callback, opaque);
+}
+
+void Queue::disable_event_callback() const {
+    rd_kafka_queue_cb_event_enable(handle_.get(), nullptr, nullptr);
+}
+
 void Queue::set_timeout(milliseconds timeout) {
     timeout_ms_ = timeout;
 }
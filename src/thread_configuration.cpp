@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "thread_configuration.h"
+#ifdef __linux__
+    #include <fstream>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace cppkafka {
+
+#ifdef __linux__
+namespace {
+
+// Parses a sysfs cpulist such as "0-3,8-11" into the individual CPU indexes
+vector<int> parse_cpu_list(const string& text) {
+    vector<int> output;
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t consumed = 0;
+        int first = std::stoi(text.substr(position), &consumed);
+        position += consumed;
+        int last = first;
+        if (position < text.size() && text[position] == '-') {
+            ++position;
+            last = std::stoi(text.substr(position), &consumed);
+            position += consumed;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            output.push_back(cpu);
+        }
+        if (position < text.size() && text[position] == ',') {
+            ++position;
+        }
+        else {
+            break;
+        }
+    }
+    return output;
+}
+
+vector<int> numa_node_cpus(int node) {
+    std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    string line;
+    if (!input || !std::getline(input, line)) {
+        return {};
+    }
+    return parse_cpu_list(line);
+}
+
+} // anonymous namespace
+#endif // __linux__
+
+ThreadConfiguration& ThreadConfiguration::set_cpu_set(vector<int> cpus) {
+    cpus_ = std::move(cpus);
+    return *this;
+}
+
+ThreadConfiguration& ThreadConfiguration::set_numa_node(int node) {
+    numa_node_ = node;
+    return *this;
+}
+
+ThreadConfiguration& ThreadConfiguration::set_nice_level(int level) {
+    nice_level_ = level;
+    return *this;
+}
+
+ThreadConfiguration& ThreadConfiguration::set_name_prefix(string prefix) {
+    name_prefix_ = std::move(prefix);
+    return *this;
+}
+
+const vector<int>& ThreadConfiguration::get_cpu_set() const {
+    return cpus_;
+}
+
+int ThreadConfiguration::get_numa_node() const {
+    return numa_node_;
+}
+
+const std::optional<int>& ThreadConfiguration::get_nice_level() const {
+    return nice_level_;
+}
+
+const string& ThreadConfiguration::get_name_prefix() const {
+    return name_prefix_;
+}
+
+void ThreadConfiguration::apply_to_current_thread(const string& thread_name) const {
+#ifdef __linux__
+    // Everything here is best effort: a CPU that went offline or insufficient
+    // privileges should never take the handle down
+    vector<int> cpus = cpus_;
+    if (cpus.empty() && numa_node_ >= 0) {
+        cpus = numa_node_cpus(numa_node_);
+    }
+    if (!cpus.empty()) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &cpu_set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+    if (nice_level_) {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), *nice_level_);
+    }
+    if (!name_prefix_.empty()) {
+        // Thread names are limited to 15 characters plus the null terminator
+        string name = (name_prefix_ + thread_name).substr(0, 15);
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+#else
+    (void)thread_name;
+#endif // __linux__
+}
+
+} // cppkafka
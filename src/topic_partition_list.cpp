@@ -33,6 +33,7 @@
 #include "topic_partition.h"
 #include "exceptions.h"
 #include "metadata.h"
+#include "wrapper_profiler.h"
 
 using std::vector;
 using std::set;
@@ -43,6 +44,7 @@ using std::equal;
 namespace cppkafka {
 
 TopicPartitionsListPtr convert(const TopicPartitionList& topic_partitions) {
+    WrapperProfiler::ScopedProbe probe(WrapperProfiler::Boundary::PartitionListConversion);
     TopicPartitionsListPtr handle(rd_kafka_topic_partition_list_new(topic_partitions.size()),
                                   &rd_kafka_topic_partition_list_destroy);
     for (const auto& item : topic_partitions) {
@@ -61,6 +63,7 @@ TopicPartitionList convert(const TopicPartitionsListPtr& topic_partitions) {
 }
 
 TopicPartitionList convert(rd_kafka_topic_partition_list_t* topic_partitions) {
+    WrapperProfiler::ScopedProbe probe(WrapperProfiler::Boundary::PartitionListConversion);
     TopicPartitionList output;
     for (int i = 0; i < topic_partitions->cnt; ++i) {
         const auto& elem = topic_partitions->elems[i];
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/adaptive_batch_controller.h"
+#include <algorithm>
+#include "exceptions.h"
+
+using std::chrono::microseconds;
+
+namespace cppkafka {
+
+constexpr size_t AdaptiveBatchController::DEFAULT_MINIMUM_BATCH_SIZE;
+constexpr size_t AdaptiveBatchController::DEFAULT_MAXIMUM_BATCH_SIZE;
+constexpr size_t AdaptiveBatchController::ADJUSTMENT_INTERVAL;
+constexpr double AdaptiveBatchController::SMOOTHING;
+
+AdaptiveBatchController::AdaptiveBatchController()
+: AdaptiveBatchController(DEFAULT_MINIMUM_BATCH_SIZE, DEFAULT_MAXIMUM_BATCH_SIZE) {
+
+}
+
+AdaptiveBatchController::AdaptiveBatchController(size_t minimum_batch_size,
+                                                size_t maximum_batch_size)
+: minimum_batch_size_(std::max<size_t>(minimum_batch_size, 1)),
+  maximum_batch_size_(maximum_batch_size) {
+    if (maximum_batch_size_ < minimum_batch_size_) {
+        throw Exception("Maximum batch size can't be lower than the minimum");
+    }
+    batch_size_ = minimum_batch_size_;
+    // One sixteenth of the range per step reaches the maximum within a few
+    // hundred batches while staying gentle on small ranges
+    increase_step_ = std::max<size_t>((maximum_batch_size_ - minimum_batch_size_) / 16, 1);
+}
+
+void AdaptiveBatchController::set_target_fill_ratio(double ratio) {
+    if (ratio <= 0 || ratio > 1) {
+        throw Exception("Target fill ratio must be in the (0, 1] range");
+    }
+    target_fill_ratio_ = ratio;
+}
+
+void AdaptiveBatchController::set_latency_budget(microseconds budget) {
+    latency_budget_ = budget;
+}
+
+void AdaptiveBatchController::record_batch(size_t requested, size_t received,
+                                           microseconds latency) {
+    const double observed_latency = static_cast<double>(latency.count());
+    average_latency_us_ = average_latency_us_ < 0
+        ? observed_latency
+        : SMOOTHING * observed_latency + (1 - SMOOTHING) * average_latency_us_;
+    record_batch(requested, received);
+}
+
+void AdaptiveBatchController::record_batch(size_t requested, size_t received) {
+    if (requested == 0) {
+        return;
+    }
+    const double fill = static_cast<double>(std::min(received, requested)) / requested;
+    average_fill_ratio_ = average_fill_ratio_ < 0
+        ? fill
+        : SMOOTHING * fill + (1 - SMOOTHING) * average_fill_ratio_;
+    if (++observed_batches_ % ADJUSTMENT_INTERVAL == 0) {
+        adjust();
+    }
+}
+
+size_t AdaptiveBatchController::get_batch_size() const {
+    return batch_size_;
+}
+
+double AdaptiveBatchController::get_average_fill_ratio() const {
+    return average_fill_ratio_ < 0 ? 0 : average_fill_ratio_;
+}
+
+microseconds AdaptiveBatchController::get_average_latency() const {
+    return microseconds(average_latency_us_ < 0
+                        ? 0
+                        : static_cast<microseconds::rep>(average_latency_us_));
+}
+
+void AdaptiveBatchController::reset() {
+    batch_size_ = minimum_batch_size_;
+    observed_batches_ = 0;
+    average_fill_ratio_ = -1;
+    average_latency_us_ = -1;
+}
+
+void AdaptiveBatchController::adjust() {
+    const bool over_budget = (latency_budget_.count() > 0) &&
+                             (average_latency_us_ > latency_budget_.count());
+    if (over_budget || average_fill_ratio_ < target_fill_ratio_ / 2) {
+        // Multiplicative decrease: either batches take too long or most of the
+        // requested slots come back empty
+        batch_size_ = std::max(batch_size_ / 2, minimum_batch_size_);
+    }
+    else if (average_fill_ratio_ >= target_fill_ratio_) {
+        // Additive increase: batches are saturated, probe for more
+        batch_size_ = std::min(batch_size_ + increase_step_, maximum_batch_size_);
+    }
+}
+
+} // cppkafka
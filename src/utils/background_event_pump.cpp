@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include "utils/background_event_pump.h"
+
+using std::lock_guard;
+using std::min;
+using std::move;
+using std::mutex;
+using std::chrono::milliseconds;
+
+namespace cppkafka {
+
+const size_t BackgroundEventPump::MAX_BATCH_SIZE;
+
+BackgroundEventPump::BackgroundEventPump(KafkaHandleBase& handle)
+: queue_(Queue::make_queue(rd_kafka_queue_get_main(handle.get_handle()))) {
+
+}
+
+BackgroundEventPump::BackgroundEventPump(Queue queue)
+: queue_(move(queue)) {
+
+}
+
+BackgroundEventPump::~BackgroundEventPump() {
+    stop();
+}
+
+void BackgroundEventPump::set_handler(rd_kafka_event_type_t type, EventHandler handler) {
+    lock_guard<mutex> _(handlers_mutex_);
+    handlers_[type] = move(handler);
+}
+
+void BackgroundEventPump::set_default_handler(EventHandler handler) {
+    lock_guard<mutex> _(handlers_mutex_);
+    default_handler_ = move(handler);
+}
+
+void BackgroundEventPump::set_poll_interval(milliseconds minimum, milliseconds maximum) {
+    min_poll_interval_ = minimum;
+    max_poll_interval_ = maximum > minimum ? maximum : minimum;
+}
+
+void BackgroundEventPump::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    pump_thread_ = std::thread(&BackgroundEventPump::pump_loop, this);
+}
+
+void BackgroundEventPump::stop() {
+    running_ = false;
+    if (pump_thread_.joinable()) {
+        pump_thread_.join();
+    }
+}
+
+void BackgroundEventPump::pump_loop() {
+    milliseconds wait = min_poll_interval_;
+    while (running_) {
+        // Wait for the head of the next batch. rd_kafka_queue_poll wakes up as
+        // soon as an event is enqueued, so the timeout only controls how often
+        // an idle pump checks running_
+        rd_kafka_event_t* event = rd_kafka_queue_poll(queue_.get_handle(),
+                                                      static_cast<int>(wait.count()));
+        if (!event) {
+            wait = min(wait * 2, max_poll_interval_);
+            continue;
+        }
+        wait = min_poll_interval_;
+        // Drain whatever queued up behind it without blocking again
+        size_t drained = 0;
+        while (event) {
+            dispatch(Event(event));
+            if (++drained == MAX_BATCH_SIZE) {
+                break;
+            }
+            event = rd_kafka_queue_poll(queue_.get_handle(), 0);
+        }
+    }
+}
+
+void BackgroundEventPump::dispatch(Event event) {
+    EventHandler handler;
+    {
+        lock_guard<mutex> _(handlers_mutex_);
+        auto iter = handlers_.find(event.get_type());
+        if (iter != handlers_.end()) {
+            handler = iter->second;
+        }
+        else {
+            handler = default_handler_;
+        }
+    }
+    if (handler) {
+        handler(move(event));
+    }
+}
+
+} // cppkafka
@@ -30,13 +30,27 @@
 #include <algorithm>
 #include "utils/backoff_committer.h"
 
+using std::max;
 using std::min;
 
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
 namespace cppkafka {
 
 BackoffCommitter::BackoffCommitter(Consumer& consumer)
-: consumer_(consumer) {
+: consumer_(consumer), last_commit_time_(steady_clock::now()) {
+
+}
 
+BackoffCommitter::~BackoffCommitter() {
+    try {
+        flush_commit();
+    }
+    catch (...) {
+        // Don't throw from the destructor. Uncommitted offsets will simply be
+        // re-consumed after the next rebalance
+    }
 }
 
 void BackoffCommitter::set_error_callback(ErrorCallback callback) {
@@ -50,17 +64,119 @@ void BackoffCommitter::commit() {
 }
 
 void BackoffCommitter::commit(const Message& msg) {
+    if (coalescing_enabled_) {
+        // Committed offsets point to the next message to be consumed
+        record_offset({ msg.get_topic(), msg.get_partition() }, msg.get_offset() + 1);
+        maybe_flush();
+        return;
+    }
     perform([&] {
         return do_commit(msg);
     });
 }
 
 void BackoffCommitter::commit(const TopicPartitionList& topic_partitions) {
+    if (coalescing_enabled_) {
+        for (const TopicPartition& topic_partition : topic_partitions) {
+            record_offset(topic_partition, topic_partition.get_offset());
+        }
+        maybe_flush();
+        return;
+    }
     perform([&] {
         return do_commit(topic_partitions);
     });
 }
 
+void BackoffCommitter::set_commit_coalescing(size_t max_messages, milliseconds max_interval) {
+    coalescing_enabled_ = true;
+    maximum_pending_messages_ = max_messages;
+    maximum_pending_interval_ = max_interval;
+    last_commit_time_ = steady_clock::now();
+}
+
+void BackoffCommitter::disable_commit_coalescing() {
+    flush_commit();
+    coalescing_enabled_ = false;
+}
+
+void BackoffCommitter::flush_commit() {
+    if (pending_offsets_.empty()) {
+        last_commit_time_ = steady_clock::now();
+        return;
+    }
+    // Steady-state assignments flush the same partitions over and over, so the
+    // scratch list and the cached native handle are reused across flushes: when
+    // the layout is unchanged only the offsets are patched in place and the
+    // whole flush performs no allocation
+    if (flush_offsets_matches()) {
+        size_t index = 0;
+        for (const auto& offset_pair : pending_offsets_) {
+            flush_offsets_[index++].set_offset(offset_pair.second);
+        }
+    }
+    else {
+        flush_offsets_.clear();
+        flush_offsets_.reserve(pending_offsets_.size());
+        for (const auto& offset_pair : pending_offsets_) {
+            flush_offsets_.emplace_back(offset_pair.first.get_topic(),
+                                        offset_pair.first.get_partition(), offset_pair.second);
+        }
+    }
+    cached_offsets_.update(flush_offsets_);
+    perform([&] {
+        return do_commit(cached_offsets_);
+    });
+    pending_offsets_.clear();
+    pending_message_count_ = 0;
+    last_commit_time_ = steady_clock::now();
+}
+
+bool BackoffCommitter::flush_offsets_matches() const {
+    if (flush_offsets_.size() != pending_offsets_.size()) {
+        return false;
+    }
+    // pending_offsets_ is ordered, so a matching scratch list built from it
+    // lines up entry by entry
+    size_t index = 0;
+    for (const auto& offset_pair : pending_offsets_) {
+        const TopicPartition& topic_partition = flush_offsets_[index++];
+        if (topic_partition.get_partition() != offset_pair.first.get_partition() ||
+            topic_partition.get_topic() != offset_pair.first.get_topic()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t BackoffCommitter::get_pending_commit_count() const {
+    return pending_message_count_;
+}
+
+void BackoffCommitter::record_offset(const TopicPartition& topic_partition,
+                                     int64_t next_offset) {
+    auto iter = pending_offsets_.find(topic_partition);
+    if (iter == pending_offsets_.end()) {
+        pending_offsets_.emplace(topic_partition, next_offset);
+    }
+    else {
+        // Out of order commits only ever move the watermark forward
+        iter->second = max(iter->second, next_offset);
+    }
+    ++pending_message_count_;
+}
+
+void BackoffCommitter::maybe_flush() {
+    const bool message_threshold_hit = maximum_pending_messages_ > 0 &&
+                                       pending_message_count_ >= maximum_pending_messages_;
+    const bool time_threshold_hit = maximum_pending_interval_.count() > 0 &&
+                                    steady_clock::now() - last_commit_time_ >=
+                                    maximum_pending_interval_;
+    if (message_threshold_hit || time_threshold_hit) {
+        flush_commit();
+    }
+}
+
 Consumer& BackoffCommitter::get_consumer() {
     return consumer_;
 }
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/backoff_scheduler.h"
+
+using std::chrono::duration_cast;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace cppkafka {
+
+constexpr double BackoffScheduler::DEFAULT_JITTER_RATIO;
+
+BackoffScheduler::BackoffScheduler()
+: jitter_generator_(std::random_device{}()), running_(true),
+  timer_thread_(&BackoffScheduler::timer_loop, this) {
+
+}
+
+BackoffScheduler::~BackoffScheduler() {
+    stop();
+}
+
+void BackoffScheduler::set_jitter_ratio(double ratio) {
+    lock_guard<mutex> _(mutex_);
+    jitter_ratio_ = ratio;
+}
+
+void BackoffScheduler::schedule(OperationCallback operation) {
+    schedule(std::move(operation), ExhaustedCallback{});
+}
+
+void BackoffScheduler::schedule(OperationCallback operation, ExhaustedCallback on_exhausted) {
+    {
+        lock_guard<mutex> _(mutex_);
+        operations_.push(Operation{ std::move(operation), std::move(on_exhausted),
+                                    initial_backoff_, maximum_retries_, Clock::now() });
+    }
+    condition_.notify_one();
+}
+
+size_t BackoffScheduler::get_pending_count() const {
+    lock_guard<mutex> _(mutex_);
+    return operations_.size();
+}
+
+void BackoffScheduler::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    condition_.notify_one();
+    if (timer_thread_.joinable()) {
+        timer_thread_.join();
+    }
+}
+
+void BackoffScheduler::timer_loop() {
+    unique_lock<mutex> lock(mutex_);
+    while (running_) {
+        if (operations_.empty()) {
+            condition_.wait(lock);
+            continue;
+        }
+        const Clock::time_point deadline = operations_.top().deadline;
+        if (Clock::now() < deadline) {
+            condition_.wait_until(lock, deadline);
+            continue;
+        }
+        Operation operation = operations_.top();
+        operations_.pop();
+        // Run the attempt without holding the lock so schedule() never blocks on
+        // a slow operation
+        lock.unlock();
+        const bool succeeded = operation.callback();
+        lock.lock();
+        if (succeeded) {
+            continue;
+        }
+        if (operation.retries_left <= 1) {
+            if (operation.on_exhausted) {
+                lock.unlock();
+                operation.on_exhausted();
+                lock.lock();
+            }
+            continue;
+        }
+        --operation.retries_left;
+        operation.deadline = Clock::now() + apply_jitter(operation.backoff);
+        operation.backoff = increase_backoff(operation.backoff);
+        operations_.push(std::move(operation));
+    }
+}
+
+BackoffScheduler::TimeUnit BackoffScheduler::apply_jitter(TimeUnit value) {
+    if (jitter_ratio_ <= 0) {
+        return value;
+    }
+    std::uniform_real_distribution<double> distribution(1.0 - jitter_ratio_,
+                                                        1.0 + jitter_ratio_);
+    return duration_cast<TimeUnit>(value * distribution(jitter_generator_));
+}
+
+} // cppkafka
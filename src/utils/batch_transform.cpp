@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include "utils/batch_transform.h"
+
+using std::exception_ptr;
+using std::lock_guard;
+using std::min;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+namespace cppkafka {
+
+BatchTransform::BatchTransform(size_t num_workers)
+: num_workers_(num_workers ? num_workers : std::max(thread::hardware_concurrency(), 1u)) {
+    workers_.reserve(num_workers_);
+    for (size_t i = 0; i < num_workers_; ++i) {
+        workers_.emplace_back(&BatchTransform::worker_loop, this, i);
+    }
+}
+
+BatchTransform::~BatchTransform() {
+    {
+        lock_guard<mutex> _(mutex_);
+        running_ = false;
+    }
+    job_available_.notify_all();
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void BatchTransform::run_batch(RangeJob job, size_t item_count) {
+    if (item_count == 0) {
+        return;
+    }
+    unique_lock<mutex> lock(mutex_);
+    job_ = std::move(job);
+    item_count_ = item_count;
+    pending_workers_ = num_workers_;
+    exception_ = nullptr;
+    ++generation_;
+    job_available_.notify_all();
+    batch_done_.wait(lock, [&]() { return pending_workers_ == 0; });
+    job_ = nullptr;
+    if (exception_) {
+        exception_ptr exception = exception_;
+        exception_ = nullptr;
+        lock.unlock();
+        std::rethrow_exception(exception);
+    }
+}
+
+void BatchTransform::worker_loop(size_t worker_index) {
+    uint64_t last_generation = 0;
+    while (true) {
+        size_t first;
+        size_t last;
+        {
+            unique_lock<mutex> lock(mutex_);
+            job_available_.wait(lock, [&]() {
+                return !running_ || generation_ != last_generation;
+            });
+            if (!running_) {
+                return;
+            }
+            last_generation = generation_;
+            // Each worker takes one contiguous block of the batch; the split is
+            // computed locally so claiming work needs no shared state updates
+            const size_t chunk = (item_count_ + num_workers_ - 1) / num_workers_;
+            first = min(worker_index * chunk, item_count_);
+            last = min(first + chunk, item_count_);
+        }
+        if (first < last) {
+            try {
+                // job_ is stable until every worker reports done, so it's safe
+                // to invoke without holding the lock
+                job_(first, last);
+            }
+            catch (...) {
+                lock_guard<mutex> _(mutex_);
+                if (!exception_) {
+                    exception_ = std::current_exception();
+                }
+            }
+        }
+        {
+            lock_guard<mutex> _(mutex_);
+            if (--pending_workers_ == 0) {
+                batch_done_.notify_one();
+            }
+        }
+    }
+}
+
+} // cppkafka
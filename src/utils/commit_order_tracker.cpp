@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/commit_order_tracker.h"
+#include <algorithm>
+#include "exceptions.h"
+
+using std::unique_ptr;
+using std::vector;
+
+namespace cppkafka {
+
+constexpr size_t CommitOrderTracker::DEFAULT_WINDOW_SIZE;
+
+// PartitionWindow
+
+CommitOrderTracker::PartitionWindow::PartitionWindow(int64_t first_offset, size_t word_count)
+: words(new std::atomic<uint64_t>[word_count]),
+  num_words(word_count),
+  window_start(first_offset & ~int64_t(63)),
+  next_offset(first_offset),
+  commit_frontier(first_offset),
+  committed_frontier(first_offset) {
+    for (size_t i = 0; i != num_words; ++i) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void CommitOrderTracker::PartitionWindow::mark(int64_t offset) {
+    std::atomic<uint64_t>& word = words[(offset / 64) % num_words];
+    word.fetch_or(uint64_t(1) << (offset % 64), std::memory_order_release);
+}
+
+// CommitOrderTracker
+
+CommitOrderTracker::CommitOrderTracker()
+: CommitOrderTracker(DEFAULT_WINDOW_SIZE) {
+
+}
+
+CommitOrderTracker::CommitOrderTracker(size_t window_size)
+: window_size_(std::max<size_t>((window_size + 63) & ~size_t(63), 64)) {
+
+}
+
+CommitOrderTracker::Ticket CommitOrderTracker::track(const Message& message) {
+    return track(TopicPartition(message.get_topic(), message.get_partition()),
+                 message.get_offset());
+}
+
+CommitOrderTracker::Ticket CommitOrderTracker::track(const TopicPartition& topic_partition,
+                                                     int64_t offset) {
+    PartitionWindow& window = get_window(topic_partition, offset);
+    if (offset >= window.window_start + static_cast<int64_t>(window_size_)) {
+        // Try to reclaim capacity from completed offsets first
+        advance(window);
+        if (offset >= window.window_start + static_cast<int64_t>(window_size_)) {
+            return Ticket();
+        }
+    }
+    window.next_offset = offset + 1;
+    Ticket ticket;
+    ticket.window_ = &window;
+    ticket.offset_ = offset;
+    return ticket;
+}
+
+void CommitOrderTracker::complete(const Ticket& ticket) {
+    if (ticket.window_) {
+        static_cast<PartitionWindow*>(ticket.window_)->mark(ticket.offset_);
+    }
+}
+
+TopicPartitionList CommitOrderTracker::get_committable() {
+    TopicPartitionList completed;
+    for (auto& window_pair : windows_) {
+        PartitionWindow& window = *window_pair.second;
+        advance(window);
+        if (window.commit_frontier > window.committed_frontier) {
+            completed.emplace_back(window_pair.first.get_topic(),
+                                   window_pair.first.get_partition(),
+                                   window.commit_frontier);
+            window.committed_frontier = window.commit_frontier;
+        }
+    }
+    return completed;
+}
+
+bool CommitOrderTracker::commit_ready(BackoffCommitter& committer) {
+    TopicPartitionList completed;
+    vector<PartitionWindow*> touched;
+    for (auto& window_pair : windows_) {
+        PartitionWindow& window = *window_pair.second;
+        advance(window);
+        if (window.commit_frontier > window.committed_frontier) {
+            completed.emplace_back(window_pair.first.get_topic(),
+                                   window_pair.first.get_partition(),
+                                   window.commit_frontier);
+            touched.push_back(&window);
+        }
+    }
+    if (completed.empty()) {
+        return false;
+    }
+    try {
+        committer.commit(completed);
+    }
+    catch (const HandleException&) {
+        // The committer's error callback aborted this commit; the offsets will
+        // be picked up by the next call
+        return false;
+    }
+    for (PartitionWindow* window : touched) {
+        window->committed_frontier = window->commit_frontier;
+    }
+    return true;
+}
+
+void CommitOrderTracker::clear() {
+    windows_.clear();
+    retired_windows_.clear();
+}
+
+CommitOrderTracker::PartitionWindow&
+CommitOrderTracker::get_window(const TopicPartition& topic_partition, int64_t offset) {
+    const size_t num_words = window_size_ / 64;
+    auto iter = windows_.find(topic_partition);
+    if (iter == windows_.end()) {
+        iter = windows_.emplace(topic_partition,
+                                unique_ptr<PartitionWindow>(
+                                    new PartitionWindow(offset, num_words))).first;
+    }
+    else if (offset < iter->second->next_offset ||
+             offset >= iter->second->next_offset + static_cast<int64_t>(window_size_)) {
+        // The partition jumped (seek or re-assignment after a rebalance); tracking
+        // state from before the discontinuity is meaningless, so start over. The
+        // old window stays alive for any in-flight completions.
+        retired_windows_.push_back(std::move(iter->second));
+        iter->second.reset(new PartitionWindow(offset, num_words));
+    }
+    return *iter->second;
+}
+
+void CommitOrderTracker::advance(PartitionWindow& window) {
+    // Offsets at or past next_offset were never handed out, so the scan must
+    // stop there; with a single-word ring their bits alias completed ones
+    while (window.commit_frontier < window.next_offset) {
+        const std::atomic<uint64_t>& word =
+            window.words[(window.commit_frontier / 64) % window.num_words];
+        const uint64_t bit = uint64_t(1) << (window.commit_frontier % 64);
+        if (!(word.load(std::memory_order_acquire) & bit)) {
+            break;
+        }
+        ++window.commit_frontier;
+    }
+    // Release fully completed words so the ring can lap around
+    while (window.window_start + 64 <= window.commit_frontier) {
+        window.words[(window.window_start / 64) % window.num_words]
+            .store(0, std::memory_order_relaxed);
+        window.window_start += 64;
+    }
+}
+
+} // cppkafka
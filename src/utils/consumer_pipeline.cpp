@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/consumer_pipeline.h"
+#include <algorithm>
+#include "detail/callback_invoker.h"
+#include "exceptions.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::unique_ptr;
+using std::vector;
+
+namespace cppkafka {
+
+const milliseconds ConsumerPipeline::POLL_INTERVAL{100};
+const milliseconds ConsumerPipeline::IDLE_WAIT_INTERVAL{1};
+constexpr size_t ConsumerPipeline::DEFAULT_WINDOW_SIZE;
+constexpr size_t ConsumerPipeline::DEFAULT_CHANNEL_CAPACITY;
+
+// PartitionWindow
+
+ConsumerPipeline::PartitionWindow::PartitionWindow(int64_t first_offset, size_t word_count)
+: words(new std::atomic<uint64_t>[word_count]),
+  num_words(word_count),
+  window_start(first_offset & ~int64_t(63)),
+  next_offset(first_offset),
+  commit_frontier(first_offset),
+  committed_frontier(first_offset) {
+    for (size_t i = 0; i != num_words; ++i) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ConsumerPipeline::PartitionWindow::mark(int64_t offset) {
+    std::atomic<uint64_t>& word = words[(offset / 64) % num_words];
+    word.fetch_or(uint64_t(1) << (offset % 64), std::memory_order_release);
+}
+
+// ConsumerPipeline
+
+ConsumerPipeline::ConsumerPipeline(Consumer& consumer, size_t num_workers)
+: consumer_(consumer),
+  committer_(consumer),
+  num_workers_(num_workers) {
+    if (num_workers_ == 0) {
+        // Leave one hardware thread for the poll stage
+        const size_t hardware_threads = std::thread::hardware_concurrency();
+        num_workers_ = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+}
+
+ConsumerPipeline::~ConsumerPipeline() {
+    stop();
+}
+
+void ConsumerPipeline::set_process_callback(ProcessCallback callback) {
+    process_callback_ = std::move(callback);
+}
+
+void ConsumerPipeline::set_poll_batch_size(size_t batch_size) {
+    poll_batch_size_ = batch_size;
+}
+
+void ConsumerPipeline::set_commit_interval(milliseconds interval) {
+    commit_interval_ = interval;
+}
+
+void ConsumerPipeline::set_window_size(size_t window_size) {
+    window_size_ = std::max<size_t>((window_size + 63) & ~size_t(63), 64);
+}
+
+void ConsumerPipeline::set_channel_capacity(size_t capacity) {
+    channel_capacity_ = capacity;
+}
+
+BackoffCommitter& ConsumerPipeline::get_committer() {
+    return committer_;
+}
+
+Consumer& ConsumerPipeline::get_consumer() {
+    return consumer_;
+}
+
+void ConsumerPipeline::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    poll_done_ = false;
+    windows_.clear();
+    retired_windows_.clear();
+    channels_.clear();
+    for (size_t i = 0; i != num_workers_; ++i) {
+        channels_.emplace_back(new MpscRingBuffer<Item>(channel_capacity_));
+    }
+    next_channel_ = 0;
+    for (size_t i = 0; i != num_workers_; ++i) {
+        workers_.emplace_back(&ConsumerPipeline::worker_loop, this, i);
+    }
+    poll_thread_ = std::thread(&ConsumerPipeline::poll_loop, this);
+}
+
+void ConsumerPipeline::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (poll_thread_.joinable()) {
+        poll_thread_.join();
+    }
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    // The workers drained their channels before exiting; commit their work
+    commit_ready();
+}
+
+void ConsumerPipeline::commit_ready() {
+    TopicPartitionList completed;
+    vector<PartitionWindow*> touched;
+    for (auto& window_pair : windows_) {
+        PartitionWindow& window = *window_pair.second;
+        advance(window);
+        if (window.commit_frontier > window.committed_frontier) {
+            completed.emplace_back(window_pair.first.get_topic(),
+                                   window_pair.first.get_partition(),
+                                   window.commit_frontier);
+            touched.push_back(&window);
+        }
+    }
+    if (completed.empty()) {
+        return;
+    }
+    try {
+        committer_.commit(completed);
+    }
+    catch (const HandleException&) {
+        // The committer's error callback aborted this commit; the offsets will be
+        // retried on the next interval
+        return;
+    }
+    for (PartitionWindow* window : touched) {
+        window->committed_frontier = window->commit_frontier;
+    }
+}
+
+void ConsumerPipeline::poll_loop() {
+    steady_clock::time_point last_commit = steady_clock::now();
+    while (running_) {
+        vector<Message> messages = consumer_.poll_batch(poll_batch_size_, POLL_INTERVAL);
+        for (Message& message : messages) {
+            if (!message || message.get_error()) {
+                continue;
+            }
+            if (!enqueue(std::move(message))) {
+                // We were stopped while waiting for channel or window space
+                break;
+            }
+        }
+        const steady_clock::time_point now = steady_clock::now();
+        if (now - last_commit >= commit_interval_) {
+            commit_ready();
+            last_commit = now;
+        }
+    }
+    poll_done_ = true;
+}
+
+void ConsumerPipeline::worker_loop(size_t index) {
+    MpscRingBuffer<Item>& channel = *channels_[index];
+    const auto process_item = [&](Item&& item) {
+        CallbackInvoker<ProcessCallback>("message processing", process_callback_,
+                                         &consumer_)(item.message);
+        item.window->mark(item.offset);
+    };
+    while (true) {
+        if (channel.try_pop(process_item)) {
+            continue;
+        }
+        if (poll_done_) {
+            // One final drain in case the poll stage pushed between our miss and
+            // its own exit
+            while (channel.try_pop(process_item)) {
+            }
+            return;
+        }
+        std::this_thread::sleep_for(IDLE_WAIT_INTERVAL);
+    }
+}
+
+bool ConsumerPipeline::enqueue(Message message) {
+    const TopicPartition topic_partition(message.get_topic(), message.get_partition());
+    const int64_t offset = message.get_offset();
+    PartitionWindow* window = &get_window(topic_partition, offset);
+    // Offsets we will never see (compaction, transaction markers) would stall
+    // the frontier forever, so mark the holes completed up front
+    for (int64_t gap = window->next_offset; gap < offset; ++gap) {
+        if (!wait_for_capacity(*window, gap)) {
+            return false;
+        }
+        window->mark(gap);
+    }
+    if (!wait_for_capacity(*window, offset)) {
+        return false;
+    }
+    window->next_offset = offset + 1;
+    while (true) {
+        for (size_t i = 0; i != channels_.size(); ++i) {
+            const size_t index = (next_channel_ + i) % channels_.size();
+            if (channels_[index]->try_emplace(std::move(message), window, offset)) {
+                next_channel_ = (index + 1) % channels_.size();
+                return true;
+            }
+        }
+        if (!running_) {
+            return false;
+        }
+        std::this_thread::sleep_for(IDLE_WAIT_INTERVAL);
+    }
+}
+
+bool ConsumerPipeline::wait_for_capacity(PartitionWindow& window, int64_t offset) {
+    // Stall this partition while it is a full window ahead of its oldest
+    // uncompleted offset; capacity frees up as workers complete messages
+    while (offset >= window.window_start + static_cast<int64_t>(window_size_)) {
+        advance(window);
+        if (offset < window.window_start + static_cast<int64_t>(window_size_)) {
+            break;
+        }
+        if (!running_) {
+            return false;
+        }
+        std::this_thread::sleep_for(IDLE_WAIT_INTERVAL);
+    }
+    return true;
+}
+
+ConsumerPipeline::PartitionWindow&
+ConsumerPipeline::get_window(const TopicPartition& topic_partition, int64_t offset) {
+    const size_t num_words = window_size_ / 64;
+    auto iter = windows_.find(topic_partition);
+    if (iter == windows_.end()) {
+        iter = windows_.emplace(topic_partition,
+                                unique_ptr<PartitionWindow>(
+                                    new PartitionWindow(offset, num_words))).first;
+    }
+    else if (offset < iter->second->next_offset ||
+             offset >= iter->second->next_offset + static_cast<int64_t>(window_size_)) {
+        // The partition jumped (seek or re-assignment after a rebalance); tracking
+        // state from before the discontinuity is meaningless, so start over. The
+        // old window stays alive for any in-flight completions.
+        retired_windows_.push_back(std::move(iter->second));
+        iter->second.reset(new PartitionWindow(offset, num_words));
+    }
+    return *iter->second;
+}
+
+void ConsumerPipeline::advance(PartitionWindow& window) {
+    while (true) {
+        const std::atomic<uint64_t>& word =
+            window.words[(window.commit_frontier / 64) % window.num_words];
+        const uint64_t bit = uint64_t(1) << (window.commit_frontier % 64);
+        if (!(word.load(std::memory_order_acquire) & bit)) {
+            break;
+        }
+        ++window.commit_frontier;
+    }
+    // Release fully completed words so the ring can lap around
+    while (window.window_start + 64 <= window.commit_frontier) {
+        window.words[(window.window_start / 64) % window.num_words]
+            .store(0, std::memory_order_relaxed);
+        window.window_start += 64;
+    }
+}
+
+} // cppkafka
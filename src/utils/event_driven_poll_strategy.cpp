@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/event_driven_poll_strategy.h"
+
+using std::lock_guard;
+using std::make_move_iterator;
+using std::mutex;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace cppkafka {
+
+EventDrivenPollStrategy::EventDrivenPollStrategy(Consumer& consumer)
+: PollStrategyBase(consumer) {
+    reset_state();
+}
+
+EventDrivenPollStrategy::~EventDrivenPollStrategy() {
+    disable_ready_callbacks();
+    restore_forwarding();
+}
+
+Message EventDrivenPollStrategy::poll() {
+    return poll(get_consumer().get_timeout());
+}
+
+Message EventDrivenPollStrategy::poll(milliseconds timeout) {
+    const steady_clock::time_point deadline = steady_clock::now() + timeout;
+    while (true) {
+        ReadyContext* context = pop_ready(deadline, true);
+        if (!context) {
+            // Nothing became ready within the timeout
+            return Message();
+        }
+        Message message = context->queue_data->queue.consume(milliseconds(0));
+        requeue_or_clear(context, static_cast<bool>(message));
+        if (!message) {
+            // The readiness callback is edge-triggered; re-check once after clearing
+            // the ready flag so messages racing with the drain aren't lost
+            message = context->queue_data->queue.consume(milliseconds(0));
+            if (message) {
+                handle_queue_ready(context);
+            }
+        }
+        if (message) {
+            return message;
+        }
+        if (steady_clock::now() >= deadline) {
+            return Message();
+        }
+    }
+}
+
+vector<Message> EventDrivenPollStrategy::poll_batch(size_t max_batch_size) {
+    return poll_batch(max_batch_size, get_consumer().get_timeout());
+}
+
+vector<Message> EventDrivenPollStrategy::poll_batch(size_t max_batch_size,
+                                                    milliseconds timeout) {
+    vector<Message> messages;
+    const steady_clock::time_point deadline = steady_clock::now() + timeout;
+    while (messages.size() < max_batch_size) {
+        // Only block while we have nothing to return yet
+        ReadyContext* context = pop_ready(deadline, messages.empty());
+        if (!context) {
+            break;
+        }
+        vector<Message> batch =
+            context->queue_data->queue.consume_batch(max_batch_size - messages.size(),
+                                                     milliseconds(0));
+        requeue_or_clear(context, !batch.empty());
+        if (batch.empty()) {
+            batch = context->queue_data->queue.consume_batch(max_batch_size - messages.size(),
+                                                             milliseconds(0));
+            if (!batch.empty()) {
+                handle_queue_ready(context);
+            }
+        }
+        if (!batch.empty()) {
+            messages.insert(messages.end(),
+                            make_move_iterator(batch.begin()),
+                            make_move_iterator(batch.end()));
+        }
+        else if (messages.empty() && steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+    return messages;
+}
+
+void EventDrivenPollStrategy::assign(TopicPartitionList& partitions) {
+    disable_ready_callbacks();
+    purge_ready_state();
+    PollStrategyBase::assign(partitions); //calls reset_state()
+}
+
+void EventDrivenPollStrategy::revoke(const TopicPartitionList& partitions) {
+    disable_ready_callbacks();
+    purge_ready_state();
+    PollStrategyBase::revoke(partitions); //calls reset_state()
+}
+
+void EventDrivenPollStrategy::revoke() {
+    disable_ready_callbacks();
+    purge_ready_state();
+    PollStrategyBase::revoke(); //calls reset_state()
+}
+
+void EventDrivenPollStrategy::reset_state() {
+    disable_ready_callbacks();
+    purge_ready_state();
+    enable_ready_callback(get_consumer_queue());
+    for (auto& queue_entry : get_partition_queues()) {
+        enable_ready_callback(queue_entry.second);
+    }
+}
+
+void EventDrivenPollStrategy::queue_ready_trampoline(rd_kafka_t* /*handle*/, void* opaque) {
+    ReadyContext* context = static_cast<ReadyContext*>(opaque);
+    context->strategy->handle_queue_ready(context);
+}
+
+void EventDrivenPollStrategy::handle_queue_ready(ReadyContext* context) {
+    lock_guard<mutex> lock(ready_mutex_);
+    if (!context->ready) {
+        context->ready = true;
+        ready_contexts_.push_back(context);
+        ready_cv_.notify_one();
+    }
+}
+
+void EventDrivenPollStrategy::enable_ready_callback(QueueData& queue_data) {
+    unique_ptr<ReadyContext> context(new ReadyContext{ this, &queue_data,
+                                                       queue_data.queue.get_handle() });
+    rd_kafka_queue_cb_event_enable(context->queue_handle, &queue_ready_trampoline,
+                                   context.get());
+    contexts_.push_back(std::move(context));
+    // The queue may already hold pre-fetched messages; the callback only fires on
+    // the next empty to non-empty transition, so consider it ready right away
+    handle_queue_ready(contexts_.back().get());
+}
+
+void EventDrivenPollStrategy::disable_ready_callbacks() {
+    // Deliberately not holding ready_mutex_: the callback may be firing concurrently
+    // holding internal librdkafka locks which this call acquires as well
+    for (const unique_ptr<ReadyContext>& context : contexts_) {
+        rd_kafka_queue_cb_event_enable(context->queue_handle, nullptr, nullptr);
+    }
+}
+
+void EventDrivenPollStrategy::purge_ready_state() {
+    lock_guard<mutex> lock(ready_mutex_);
+    ready_contexts_.clear();
+    contexts_.clear();
+}
+
+EventDrivenPollStrategy::ReadyContext*
+EventDrivenPollStrategy::pop_ready(steady_clock::time_point deadline, bool wait) {
+    unique_lock<mutex> lock(ready_mutex_);
+    if (ready_contexts_.empty() && wait) {
+        ready_cv_.wait_until(lock, deadline, [this]() {
+            return !ready_contexts_.empty();
+        });
+    }
+    if (ready_contexts_.empty()) {
+        return nullptr;
+    }
+    ReadyContext* context = ready_contexts_.front();
+    ready_contexts_.pop_front();
+    return context;
+}
+
+void EventDrivenPollStrategy::requeue_or_clear(ReadyContext* context, bool got_messages) {
+    lock_guard<mutex> lock(ready_mutex_);
+    if (got_messages) {
+        // The queue may hold more messages; service it again after the others
+        ready_contexts_.push_back(context);
+    }
+    else {
+        context->ready = false;
+    }
+}
+
+void EventDrivenPollStrategy::restore_forwarding() {
+    // forward all partition queues
+    for (const auto& toppar : get_partition_queues()) {
+        toppar.second.queue.forward_to_queue(get_consumer_queue().queue);
+    }
+}
+
+} //cppkafka
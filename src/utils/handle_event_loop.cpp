@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/handle_event_loop.h"
+#include <iterator>
+#include "detail/callback_invoker.h"
+#include "exceptions.h"
+
+using std::back_inserter;
+using std::lock_guard;
+using std::make_unique;
+using std::move;
+using std::unique_lock;
+using std::chrono::milliseconds;
+
+namespace cppkafka {
+
+constexpr size_t HandleEventLoop::DEFAULT_MAX_MESSAGES_PER_TURN;
+
+// How long an idle loop sleeps before re-checking, guarding against a lost
+// wakeup; not a bound on event latency
+static const milliseconds IDLE_TIMEOUT{100};
+
+HandleEventLoop::HandleEventLoop() = default;
+
+HandleEventLoop::~HandleEventLoop() {
+    stop();
+}
+
+void HandleEventLoop::add_producer(Producer& producer) {
+    ensure_not_running();
+    Queue main_queue = Queue::make_queue(rd_kafka_queue_get_main(producer.get_handle()));
+    if (!master_queue_) {
+        master_queue_ = move(main_queue);
+    }
+    else {
+        // Forwarding outlives the local Queue wrapper; ops of this handle are
+        // served (and their callbacks fired) off the master queue from now on
+        main_queue.forward_to_queue(master_queue_);
+    }
+}
+
+void HandleEventLoop::add_consumer(Consumer& consumer, MessageCallback callback) {
+    ensure_not_running();
+    auto entry = make_unique<ConsumerEntry>();
+    entry->loop = this;
+    entry->consumer = &consumer;
+    entry->queue = consumer.get_consumer_queue();
+    entry->callback = move(callback);
+    entry->queue.enable_event_callback(&HandleEventLoop::queue_ready_proxy, entry.get());
+    consumers_.push_back(move(entry));
+}
+
+void HandleEventLoop::set_max_messages_per_turn(size_t max_messages) {
+    if (max_messages == 0) {
+        throw Exception("Max messages per turn can't be 0");
+    }
+    max_messages_per_turn_ = max_messages;
+}
+
+void HandleEventLoop::start() {
+    if (running_.exchange(true)) {
+        throw Exception("Event loop is already running");
+    }
+    if (master_queue_) {
+        master_queue_.enable_event_callback(&HandleEventLoop::master_ready_proxy, this);
+    }
+    // (Re-)arm the per-consumer notifications disabled by stop() and mark every
+    // consumer ready, since messages that arrived while stopped won't notify
+    for (const auto& entry : consumers_) {
+        entry->queue.enable_event_callback(&HandleEventLoop::queue_ready_proxy, entry.get());
+        entry->ready.store(true);
+    }
+    loop_thread_ = std::thread(&HandleEventLoop::event_loop, this);
+}
+
+void HandleEventLoop::stop() {
+    running_ = false;
+    wake_up();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+    if (master_queue_) {
+        master_queue_.disable_event_callback();
+    }
+    // The per-consumer callbacks point at our ConsumerEntry objects, and the
+    // handles outlive this loop; they must not fire into destroyed entries
+    // once the loop is torn down
+    for (const auto& entry : consumers_) {
+        entry->queue.disable_event_callback();
+    }
+}
+
+bool HandleEventLoop::is_running() const {
+    return running_;
+}
+
+size_t HandleEventLoop::run_once() {
+    size_t serviced = 0;
+    if (master_queue_ && master_ready_.exchange(false)) {
+        serviced += drain_master_queue();
+    }
+    for (const auto& entry : consumers_) {
+        if (entry->ready.exchange(false)) {
+            serviced += drain_consumer(*entry);
+        }
+    }
+    return serviced;
+}
+
+void HandleEventLoop::queue_ready_proxy(rd_kafka_t*, void* opaque) {
+    // Runs on an rdkafka internal thread: only flag and signal
+    ConsumerEntry* entry = static_cast<ConsumerEntry*>(opaque);
+    entry->ready.store(true);
+    entry->loop->wake_up();
+}
+
+void HandleEventLoop::master_ready_proxy(rd_kafka_t*, void* opaque) {
+    HandleEventLoop* loop = static_cast<HandleEventLoop*>(opaque);
+    loop->master_ready_.store(true);
+    loop->wake_up();
+}
+
+void HandleEventLoop::ensure_not_running() const {
+    if (running_) {
+        throw Exception("Handles can't be registered on a running event loop");
+    }
+}
+
+void HandleEventLoop::event_loop() {
+    while (running_) {
+        if (run_once() > 0) {
+            continue;
+        }
+        unique_lock<std::mutex> lock(mutex_);
+        condition_.wait_for(lock, IDLE_TIMEOUT, [this]() {
+            return wake_up_pending_ || !running_;
+        });
+        wake_up_pending_ = false;
+    }
+}
+
+size_t HandleEventLoop::drain_master_queue() {
+    size_t count = 0;
+    // Legacy callbacks (delivery reports etc) fire from inside next_event
+    // against their own handle; only callback-less events are returned
+    while (Event event = master_queue_.next_event(milliseconds(0))) {
+        ++count;
+    }
+    return count;
+}
+
+size_t HandleEventLoop::drain_consumer(ConsumerEntry& entry) {
+    message_buffer_.clear();
+    const size_t count = entry.queue.consume_batch(back_inserter(message_buffer_),
+                                                   max_messages_per_turn_,
+                                                   milliseconds(0));
+    CallbackRefInvoker<void(Consumer&, Message)> invoker("message", entry.callback,
+                                                         entry.consumer);
+    for (Message& message : message_buffer_) {
+        invoker(*entry.consumer, move(message));
+    }
+    message_buffer_.clear();
+    if (count == max_messages_per_turn_) {
+        // The queue may still hold messages and, since it never went empty, no
+        // new notification will fire - keep the consumer scheduled
+        entry.ready.store(true);
+    }
+    return count;
+}
+
+void HandleEventLoop::wake_up() {
+    lock_guard<std::mutex> _(mutex_);
+    wake_up_pending_ = true;
+    condition_.notify_one();
+}
+
+} // cppkafka
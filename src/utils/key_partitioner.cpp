@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/key_partitioner.h"
+#include <cstring>
+#include "exceptions.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define CPPKAFKA_HAVE_SSE42_CRC32 1
+    #include <nmmintrin.h>
+#endif
+
+namespace cppkafka {
+
+namespace {
+
+using CrcFunction = uint32_t (*)(const uint8_t*, size_t);
+
+uint32_t crc32c_software(const uint8_t* data, size_t size) {
+    // CRC32-C (Castagnoli), reflected polynomial 0x82f63b78; table built once
+    static const auto table = []() {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0);
+            }
+            entries[i] = crc;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xff];
+    }
+    return crc ^ 0xffffffffu;
+}
+
+#ifdef CPPKAFKA_HAVE_SSE42_CRC32
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware(const uint8_t* data, size_t size) {
+    uint64_t crc = 0xffffffffu;
+    while (size >= 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, data, 8);
+        crc = _mm_crc32_u64(crc, chunk);
+        data += 8;
+        size -= 8;
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc);
+    while (size--) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+    }
+    return crc32 ^ 0xffffffffu;
+}
+#endif // CPPKAFKA_HAVE_SSE42_CRC32
+
+CrcFunction select_crc32c() {
+#ifdef CPPKAFKA_HAVE_SSE42_CRC32
+    if (__builtin_cpu_supports("sse4.2")) {
+        return &crc32c_hardware;
+    }
+#endif
+    return &crc32c_software;
+}
+
+// Resolved once, before main
+const CrcFunction crc32c_impl = select_crc32c();
+
+} // anonymous namespace
+
+KeyPartitioner::KeyPartitioner()
+: KeyPartitioner(HashFunction::MURMUR2) {
+
+}
+
+KeyPartitioner::KeyPartitioner(HashFunction hash_function)
+: hash_function_(hash_function) {
+
+}
+
+int32_t KeyPartitioner::get_partition(const Buffer& key, int32_t partition_count) const {
+    if (partition_count <= 0) {
+        throw Exception("Partition count must be positive");
+    }
+    // Mask off the sign bit as the stock partitioners do, so the mapping matches
+    return static_cast<int32_t>((hash(key) & 0x7fffffffu) %
+                                static_cast<uint32_t>(partition_count));
+}
+
+void KeyPartitioner::get_partitions(const Buffer* keys, size_t count, int32_t partition_count,
+                                    int32_t* partitions) const {
+    if (partition_count <= 0) {
+        throw Exception("Partition count must be positive");
+    }
+    const uint32_t divisor = static_cast<uint32_t>(partition_count);
+    if (hash_function_ == HashFunction::CRC32C) {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t value = crc32c_impl(keys[i].get_data(), keys[i].get_size());
+            partitions[i] = static_cast<int32_t>((value & 0x7fffffffu) % divisor);
+        }
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t value = murmur2(keys[i].get_data(), keys[i].get_size());
+            partitions[i] = static_cast<int32_t>((value & 0x7fffffffu) % divisor);
+        }
+    }
+}
+
+std::vector<int32_t> KeyPartitioner::get_partitions(const std::vector<Buffer>& keys,
+                                                    int32_t partition_count) const {
+    std::vector<int32_t> partitions(keys.size());
+    get_partitions(keys.data(), keys.size(), partition_count, partitions.data());
+    return partitions;
+}
+
+uint32_t KeyPartitioner::murmur2(const void* data, size_t size) {
+    // Matches librdkafka's rd_murmur2 / the Java client's murmur2
+    const uint32_t seed = 0x9747b28cu;
+    const uint32_t m = 0x5bd1e995u;
+    const int r = 24;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t h = seed ^ static_cast<uint32_t>(size);
+    while (size >= 4) {
+        uint32_t k;
+        std::memcpy(&k, bytes, 4);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h *= m;
+        h ^= k;
+        bytes += 4;
+        size -= 4;
+    }
+    switch (size) {
+        case 3:
+            h ^= static_cast<uint32_t>(bytes[2]) << 16;
+            // Fallthrough
+        case 2:
+            h ^= static_cast<uint32_t>(bytes[1]) << 8;
+            // Fallthrough
+        case 1:
+            h ^= bytes[0];
+            h *= m;
+            break;
+        default:
+            break;
+    }
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+    return h;
+}
+
+uint32_t KeyPartitioner::crc32c(const void* data, size_t size) {
+    return crc32c_impl(static_cast<const uint8_t*>(data), size);
+}
+
+bool KeyPartitioner::has_hardware_crc32c() {
+#ifdef CPPKAFKA_HAVE_SSE42_CRC32
+    return crc32c_impl != &crc32c_software;
+#else
+    return false;
+#endif
+}
+
+uint32_t KeyPartitioner::hash(const Buffer& key) const {
+    if (hash_function_ == HashFunction::CRC32C) {
+        return crc32c_impl(key.get_data(), key.get_size());
+    }
+    return murmur2(key.get_data(), key.get_size());
+}
+
+} // cppkafka
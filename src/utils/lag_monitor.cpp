@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/lag_monitor.h"
+#include <algorithm>
+#include "exceptions.h"
+
+using std::lock_guard;
+using std::make_shared;
+using std::memory_order_relaxed;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+using std::chrono::milliseconds;
+
+namespace cppkafka {
+
+LagMonitor::LagMonitor(Consumer& consumer)
+: consumer_(consumer) {
+}
+
+LagMonitor::~LagMonitor() {
+    stop();
+}
+
+void LagMonitor::watch(const TopicPartitionList& topic_partitions) {
+    auto watch_set = make_shared<WatchSet>();
+    watch_set->partitions = topic_partitions;
+    watch_set->slots.reset(new Slot[topic_partitions.size()]);
+    // Carry over the values of partitions that stay watched
+    const WatchSetPtr previous = get_watch_set();
+    if (previous) {
+        for (size_t i = 0; i < watch_set->partitions.size(); ++i) {
+            const TopicPartition& partition = watch_set->partitions[i];
+            for (size_t j = 0; j < previous->partitions.size(); ++j) {
+                if (previous->partitions[j] == partition) {
+                    const Slot& old_slot = previous->slots[j];
+                    Slot& slot = watch_set->slots[i];
+                    slot.lag.store(old_slot.lag.load(memory_order_relaxed),
+                                   memory_order_relaxed);
+                    slot.hi_offset.store(old_slot.hi_offset.load(memory_order_relaxed),
+                                         memory_order_relaxed);
+                    slot.position.store(old_slot.position.load(memory_order_relaxed),
+                                        memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+    }
+    lock_guard<mutex> _(watch_set_mutex_);
+    watch_set_ = std::move(watch_set);
+}
+
+void LagMonitor::start(milliseconds interval) {
+    lock_guard<mutex> _(refresh_mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    interval_ = interval;
+    refresh_thread_ = std::thread(&LagMonitor::refresh_loop, this);
+}
+
+void LagMonitor::stop() {
+    {
+        lock_guard<mutex> _(refresh_mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    refresh_condition_.notify_all();
+    refresh_thread_.join();
+}
+
+void LagMonitor::update(const KafkaStatistics& statistics) {
+    const WatchSetPtr watch_set = get_watch_set();
+    if (!watch_set) {
+        return;
+    }
+    for (const KafkaStatistics::TopicStatistics& topic : statistics.topics) {
+        for (const KafkaStatistics::PartitionStatistics& partition : topic.partitions) {
+            for (size_t i = 0; i < watch_set->partitions.size(); ++i) {
+                const TopicPartition& watched = watch_set->partitions[i];
+                if (watched.get_partition() == partition.partition &&
+                    watched.get_topic() == topic.name) {
+                    refresh_slot(watch_set->slots[i], partition.hi_offset,
+                                 partition.app_offset);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int64_t LagMonitor::get_lag(const string& topic, int partition) const {
+    const WatchSetPtr watch_set = get_watch_set();
+    if (!watch_set) {
+        return -1;
+    }
+    for (size_t i = 0; i < watch_set->partitions.size(); ++i) {
+        const TopicPartition& watched = watch_set->partitions[i];
+        if (watched.get_partition() == partition && watched.get_topic() == topic) {
+            return watch_set->slots[i].lag.load(memory_order_relaxed);
+        }
+    }
+    return -1;
+}
+
+LagMonitor::Snapshot LagMonitor::get_snapshot() const {
+    Snapshot output;
+    const WatchSetPtr watch_set = get_watch_set();
+    if (!watch_set) {
+        return output;
+    }
+    output.watched_partitions = watch_set->partitions.size();
+    for (size_t i = 0; i < watch_set->partitions.size(); ++i) {
+        const int64_t lag = watch_set->slots[i].lag.load(memory_order_relaxed);
+        if (lag < 0) {
+            continue;
+        }
+        output.total_lag += lag;
+        output.max_lag = std::max(output.max_lag, lag);
+        ++output.known_partitions;
+    }
+    return output;
+}
+
+LagMonitor::WatchSetPtr LagMonitor::get_watch_set() const {
+    lock_guard<mutex> _(watch_set_mutex_);
+    return watch_set_;
+}
+
+void LagMonitor::refresh_slot(Slot& slot, int64_t hi_offset, int64_t position) {
+    if (hi_offset >= 0) {
+        slot.hi_offset.store(hi_offset, memory_order_relaxed);
+    }
+    else {
+        hi_offset = slot.hi_offset.load(memory_order_relaxed);
+    }
+    if (position >= 0) {
+        slot.position.store(position, memory_order_relaxed);
+    }
+    else {
+        position = slot.position.load(memory_order_relaxed);
+    }
+    if (hi_offset >= 0 && position >= 0) {
+        slot.lag.store(std::max<int64_t>(hi_offset - position, 0), memory_order_relaxed);
+    }
+}
+
+void LagMonitor::refresh_loop() {
+    unique_lock<mutex> lock(refresh_mutex_);
+    while (running_) {
+        const WatchSetPtr watch_set = get_watch_set();
+        if (watch_set && !watch_set->partitions.empty()) {
+            lock.unlock();
+            try {
+                refresh_once(*watch_set);
+            }
+            catch (const Exception&) {
+                // Watermark queries against a flapping broker may time out;
+                // keep the last known values and retry next interval
+            }
+            lock.lock();
+        }
+        refresh_condition_.wait_for(lock, interval_, [&]() { return !running_; });
+    }
+}
+
+void LagMonitor::refresh_once(const WatchSet& watch_set) {
+    // The positions are local state, one call covers every partition; the
+    // watermarks are one blocking broker query per partition
+    const TopicPartitionList positions =
+        consumer_.get_offsets_position(watch_set.partitions);
+    for (size_t i = 0; i < watch_set.partitions.size(); ++i) {
+        int64_t hi_offset = -1;
+        try {
+            hi_offset = std::get<1>(consumer_.query_offsets(watch_set.partitions[i]));
+        }
+        catch (const Exception&) {
+            // Leave the watermark unknown for this round
+        }
+        const int64_t position = positions[i].get_offset() >= 0 ? positions[i].get_offset()
+                                                                : -1;
+        refresh_slot(watch_set.slots[i], hi_offset, position);
+    }
+}
+
+} // cppkafka
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/latency_histogram.h"
+#include <algorithm>
+#include <chrono>
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+namespace cppkafka {
+
+constexpr size_t LatencyHistogram::SUB_BUCKET_BITS;
+constexpr size_t LatencyHistogram::SUB_BUCKET_COUNT;
+constexpr size_t LatencyHistogram::MAX_EXPONENT;
+constexpr size_t LatencyHistogram::BUCKET_COUNT;
+
+LatencyHistogram::LatencyHistogram() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t current = minimum_.load(std::memory_order_relaxed);
+    while (value < current &&
+           !minimum_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = maximum_.load(std::memory_order_relaxed);
+    while (value > current &&
+           !maximum_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::get_count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::get_percentile(double percentile) const {
+    const uint64_t count = get_count();
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t target = std::max<uint64_t>(
+        static_cast<uint64_t>(percentile / 100.0 * count + 0.5), 1);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i != BUCKET_COUNT; ++i) {
+        cumulative += buckets_[i].load(std::memory_order_relaxed);
+        if (cumulative >= target) {
+            return bucket_value(i);
+        }
+    }
+    return bucket_value(BUCKET_COUNT - 1);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::get_snapshot() const {
+    Snapshot output;
+    // Copy the counters once so all percentiles come from the same view
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t count = 0;
+    for (size_t i = 0; i != BUCKET_COUNT; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+    if (count == 0) {
+        return output;
+    }
+    output.count = count;
+    output.minimum = minimum_.load(std::memory_order_relaxed);
+    output.maximum = maximum_.load(std::memory_order_relaxed);
+    output.average = sum_.load(std::memory_order_relaxed) / count;
+    const auto percentile_target = [&](double percentile) {
+        return std::max<uint64_t>(static_cast<uint64_t>(percentile * count + 0.5), 1);
+    };
+    const uint64_t targets[] = { percentile_target(0.50), percentile_target(0.95),
+                                 percentile_target(0.99), percentile_target(0.999) };
+    uint64_t* outputs[] = { &output.p50, &output.p95, &output.p99, &output.p999 };
+    uint64_t cumulative = 0;
+    size_t current = 0;
+    for (size_t i = 0; i != BUCKET_COUNT && current != 4; ++i) {
+        cumulative += counts[i];
+        while (current != 4 && cumulative >= targets[current]) {
+            *outputs[current++] = bucket_value(i);
+        }
+    }
+    return output;
+}
+
+void LatencyHistogram::reset() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    minimum_.store(UINT64_MAX, std::memory_order_relaxed);
+    maximum_.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::now_us() {
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    const uint64_t capped = std::min(value, (uint64_t(1) << (MAX_EXPONENT + 1)) - 1);
+    size_t exponent = 0;
+    for (uint64_t remaining = capped >> 1; remaining != 0; remaining >>= 1) {
+        ++exponent;
+    }
+    return (exponent - (SUB_BUCKET_BITS - 1)) * SUB_BUCKET_COUNT +
+           ((capped >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+}
+
+uint64_t LatencyHistogram::bucket_value(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const size_t segment = index / SUB_BUCKET_COUNT;
+    const size_t sub_bucket = index % SUB_BUCKET_COUNT;
+    const size_t exponent = segment + SUB_BUCKET_BITS - 1;
+    return uint64_t(SUB_BUCKET_COUNT + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+} // cppkafka
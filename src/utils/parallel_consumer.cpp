@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <functional>
+#include "utils/parallel_consumer.h"
+#include "detail/callback_invoker.h"
+
+using std::chrono::milliseconds;
+using std::lock_guard;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+
+namespace cppkafka {
+
+// How long an idle worker sleeps before re-checking its queues
+const milliseconds ParallelConsumer::IDLE_WAIT_INTERVAL{10};
+// How long the service thread waits on the main consumer queue
+const milliseconds ParallelConsumer::SERVICE_POLL_INTERVAL{100};
+
+ParallelConsumer::ParallelConsumer(Consumer& consumer, size_t num_workers)
+: PollStrategyBase(consumer) {
+    if (num_workers == 0) {
+        const unsigned int hardware_threads = thread::hardware_concurrency();
+        num_workers = hardware_threads > 0 ? hardware_threads : 1;
+    }
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i != num_workers; ++i) {
+        workers_.emplace_back(new WorkerContext());
+    }
+    // Pin any partitions which were already assigned before construction
+    reset_state();
+}
+
+ParallelConsumer::~ParallelConsumer() {
+    stop();
+}
+
+void ParallelConsumer::set_message_callback(MessageCallback callback) {
+    message_callback_ = std::move(callback);
+}
+
+void ParallelConsumer::set_batch_size(size_t batch_size) {
+    batch_size_ = batch_size;
+}
+
+size_t ParallelConsumer::get_batch_size() const {
+    return batch_size_;
+}
+
+size_t ParallelConsumer::get_num_workers() const {
+    return workers_.size();
+}
+
+void ParallelConsumer::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    threads_.reserve(workers_.size());
+    for (size_t i = 0; i != workers_.size(); ++i) {
+        threads_.emplace_back(&ParallelConsumer::worker_loop, this, i);
+    }
+    service_thread_ = thread(&ParallelConsumer::service_loop, this);
+}
+
+void ParallelConsumer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (thread& worker : threads_) {
+        worker.join();
+    }
+    threads_.clear();
+    if (service_thread_.joinable()) {
+        service_thread_.join();
+    }
+}
+
+void ParallelConsumer::assign(TopicPartitionList& partitions) {
+    // Keep the workers away from their queue lists while the queue map mutates
+    auto locks = lock_all_workers();
+    PollStrategyBase::assign(partitions); //calls reset_state()
+}
+
+void ParallelConsumer::revoke(const TopicPartitionList& partitions) {
+    auto locks = lock_all_workers();
+    PollStrategyBase::revoke(partitions); //calls reset_state()
+}
+
+void ParallelConsumer::revoke() {
+    auto locks = lock_all_workers();
+    PollStrategyBase::revoke(); //calls reset_state()
+}
+
+void ParallelConsumer::reset_state() {
+    // Rebuild the partition-to-worker pinning. The worker mutexes are expected
+    // to be held by the caller when workers are running.
+    for (const unique_ptr<WorkerContext>& worker : workers_) {
+        worker->queues.clear();
+    }
+    for (auto& entry : get_partition_queues()) {
+        const TopicPartition& partition = entry.first;
+        // Hash the partition to a stable worker so its queue is always consumed
+        // by the same thread, preserving per-partition ordering
+        const size_t index = (std::hash<std::string>()(partition.get_topic()) +
+                              static_cast<size_t>(partition.get_partition())) % workers_.size();
+        workers_[index]->queues.push_back(&entry.second.queue);
+    }
+}
+
+void ParallelConsumer::worker_loop(size_t index) {
+    WorkerContext& context = *workers_[index];
+    while (running_) {
+        bool consumed = false;
+        {
+            lock_guard<mutex> lock(context.mutex);
+            for (Queue* queue : context.queues) {
+                vector<Message> messages = queue->consume_batch(batch_size_, milliseconds(0));
+                for (Message& message : messages) {
+                    if (message) {
+                        CallbackInvoker<MessageCallback>
+                            ("parallel consume", message_callback_, &get_consumer())(std::move(message));
+                        consumed = true;
+                    }
+                }
+            }
+        }
+        if (!consumed) {
+            // All owned queues were empty, don't spin
+            std::this_thread::sleep_for(IDLE_WAIT_INTERVAL);
+        }
+    }
+}
+
+void ParallelConsumer::service_loop() {
+    while (running_) {
+        // Serving the main consumer queue keeps the group membership alive and
+        // triggers the rebalance callbacks, which re-pin the partition queues
+        Message message = get_consumer_queue().queue.consume(SERVICE_POLL_INTERVAL);
+        if (message) {
+            // Messages consumed before partition queues got unforwarded (or not
+            // belonging to any partition) are delivered from here
+            CallbackInvoker<MessageCallback>
+                ("parallel consume", message_callback_, &get_consumer())(std::move(message));
+        }
+    }
+}
+
+vector<unique_lock<mutex>> ParallelConsumer::lock_all_workers() {
+    vector<unique_lock<mutex>> locks;
+    locks.reserve(workers_.size());
+    for (const unique_ptr<WorkerContext>& worker : workers_) {
+        locks.emplace_back(worker->mutex);
+    }
+    return locks;
+}
+
+} // cppkafka
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include "utils/prefetching_consumer.h"
+
+using std::lock_guard;
+using std::min;
+using std::make_move_iterator;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace cppkafka {
+
+PrefetchingConsumer::PrefetchingConsumer(Consumer& consumer,
+                                         size_t batch_size,
+                                         size_t max_buffered_batches)
+: consumer_(consumer),
+  batch_size_(batch_size),
+  max_buffered_batches_(max_buffered_batches > 0 ? max_buffered_batches : 1) {
+
+}
+
+PrefetchingConsumer::~PrefetchingConsumer() {
+    stop();
+}
+
+void PrefetchingConsumer::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    fetcher_thread_ = std::thread(&PrefetchingConsumer::fetcher_loop, this);
+}
+
+void PrefetchingConsumer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (fetcher_thread_.joinable()) {
+        fetcher_thread_.join();
+    }
+}
+
+Consumer& PrefetchingConsumer::get_consumer() {
+    return consumer_;
+}
+
+void PrefetchingConsumer::set_timeout(milliseconds timeout) {
+    consumer_.set_timeout(timeout);
+}
+
+milliseconds PrefetchingConsumer::get_timeout() {
+    return consumer_.get_timeout();
+}
+
+Message PrefetchingConsumer::poll() {
+    return poll(consumer_.get_timeout());
+}
+
+Message PrefetchingConsumer::poll(milliseconds timeout) {
+    if (!refill_current_batch(steady_clock::now() + timeout)) {
+        return Message();
+    }
+    return std::move(current_batch_[current_index_++]);
+}
+
+vector<Message> PrefetchingConsumer::poll_batch(size_t max_batch_size) {
+    return poll_batch(max_batch_size, consumer_.get_timeout());
+}
+
+vector<Message> PrefetchingConsumer::poll_batch(size_t max_batch_size,
+                                                milliseconds timeout) {
+    vector<Message> messages;
+    if (!refill_current_batch(steady_clock::now() + timeout)) {
+        return messages;
+    }
+    const size_t count = min(max_batch_size, current_batch_.size() - current_index_);
+    messages.reserve(count);
+    messages.insert(messages.end(),
+                    make_move_iterator(current_batch_.begin() + current_index_),
+                    make_move_iterator(current_batch_.begin() + current_index_ + count));
+    current_index_ += count;
+    return messages;
+}
+
+void PrefetchingConsumer::fetcher_loop() {
+    bool paused = false;
+    while (running_) {
+        bool full;
+        {
+            lock_guard<mutex> lock(buffer_mutex_);
+            full = buffered_batches_.size() >= max_buffered_batches_;
+        }
+        if (full != paused) {
+            // Pausing stops message delivery but polling below still serves
+            // heartbeats and rebalance callbacks
+            if (full) {
+                consumer_.pause_partitions(consumer_.get_assignment());
+            }
+            else {
+                consumer_.resume_partitions(consumer_.get_assignment());
+            }
+            paused = full;
+        }
+        vector<Message> batch = consumer_.poll_batch(batch_size_);
+        if (!batch.empty()) {
+            lock_guard<mutex> lock(buffer_mutex_);
+            buffered_batches_.push_back(std::move(batch));
+            batch_available_.notify_one();
+        }
+    }
+    if (paused) {
+        consumer_.resume_partitions(consumer_.get_assignment());
+    }
+}
+
+bool PrefetchingConsumer::refill_current_batch(steady_clock::time_point deadline) {
+    if (current_index_ < current_batch_.size()) {
+        return true;
+    }
+    unique_lock<mutex> lock(buffer_mutex_);
+    if (buffered_batches_.empty()) {
+        batch_available_.wait_until(lock, deadline, [this]() {
+            return !buffered_batches_.empty();
+        });
+        if (buffered_batches_.empty()) {
+            return false;
+        }
+    }
+    current_batch_ = std::move(buffered_batches_.front());
+    buffered_batches_.pop_front();
+    current_index_ = 0;
+    return true;
+}
+
+} // cppkafka
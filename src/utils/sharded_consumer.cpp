@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+#include "utils/sharded_consumer.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::string;
+using std::this_thread::sleep_for;
+using std::unique_ptr;
+using std::vector;
+
+namespace cppkafka {
+
+const milliseconds ShardedConsumer::SHARD_POLL_INTERVAL{100};
+const milliseconds ShardedConsumer::IDLE_WAIT_INTERVAL{1};
+
+ShardedConsumer::ShardedConsumer(Configuration config, size_t num_shards) {
+    if (num_shards == 0) {
+        num_shards = std::thread::hardware_concurrency();
+        if (num_shards == 0) {
+            num_shards = 1;
+        }
+    }
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        shards_.emplace_back(new Consumer(config));
+        Consumer& shard = *shards_.back();
+        shard.set_assignment_callback([this, i](TopicPartitionList& partitions) {
+            if (assignment_callback_) {
+                assignment_callback_(i, partitions);
+            }
+        });
+        shard.set_revocation_callback([this, i](const TopicPartitionList& partitions) {
+            if (revocation_callback_) {
+                revocation_callback_(i, partitions);
+            }
+        });
+        shard.set_rebalance_error_callback([this, i](Error error) {
+            if (rebalance_error_callback_) {
+                rebalance_error_callback_(i, error);
+            }
+        });
+    }
+}
+
+ShardedConsumer::~ShardedConsumer() {
+    stop();
+}
+
+void ShardedConsumer::set_assignment_callback(AssignmentCallback callback) {
+    assignment_callback_ = std::move(callback);
+}
+
+void ShardedConsumer::set_revocation_callback(RevocationCallback callback) {
+    revocation_callback_ = std::move(callback);
+}
+
+void ShardedConsumer::set_rebalance_error_callback(RebalanceErrorCallback callback) {
+    rebalance_error_callback_ = std::move(callback);
+}
+
+void ShardedConsumer::set_cpu_affinity(vector<int> cpus) {
+    affinity_ = std::move(cpus);
+}
+
+void ShardedConsumer::set_shard_batch_size(size_t batch_size) {
+    shard_batch_size_ = batch_size;
+}
+
+void ShardedConsumer::subscribe(const vector<string>& topics) {
+    for (const unique_ptr<Consumer>& shard : shards_) {
+        shard->subscribe(topics);
+    }
+}
+
+void ShardedConsumer::unsubscribe() {
+    for (const unique_ptr<Consumer>& shard : shards_) {
+        shard->unsubscribe();
+    }
+}
+
+size_t ShardedConsumer::get_num_shards() const {
+    return shards_.size();
+}
+
+Consumer& ShardedConsumer::get_shard(size_t index) {
+    return *shards_[index];
+}
+
+TopicPartitionList ShardedConsumer::get_assignment() {
+    TopicPartitionList assignment;
+    for (const unique_ptr<Consumer>& shard : shards_) {
+        TopicPartitionList partitions = shard->get_assignment();
+        assignment.insert(assignment.end(),
+                          std::make_move_iterator(partitions.begin()),
+                          std::make_move_iterator(partitions.end()));
+    }
+    return assignment;
+}
+
+void ShardedConsumer::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    threads_.reserve(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        threads_.emplace_back(&ShardedConsumer::shard_loop, this, i);
+    }
+}
+
+void ShardedConsumer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+size_t ShardedConsumer::poll_batch(vector<Message>& messages, size_t max_batch_size,
+                                   milliseconds timeout) {
+    const auto deadline = steady_clock::now() + timeout;
+    size_t count = 0;
+    while (count < max_batch_size) {
+        const bool popped = ring_.try_pop([&](Message&& message) {
+            messages.emplace_back(std::move(message));
+        });
+        if (popped) {
+            ++count;
+            continue;
+        }
+        // Once something was returned, drain only what's already buffered
+        if (count > 0 || steady_clock::now() >= deadline) {
+            break;
+        }
+        sleep_for(IDLE_WAIT_INTERVAL);
+    }
+    return count;
+}
+
+vector<Message> ShardedConsumer::poll_batch(size_t max_batch_size, milliseconds timeout) {
+    vector<Message> messages;
+    messages.reserve(max_batch_size < 1024 ? max_batch_size : 1024);
+    poll_batch(messages, max_batch_size, timeout);
+    return messages;
+}
+
+void ShardedConsumer::shard_loop(size_t index) {
+    apply_affinity(index);
+    Consumer& consumer = *shards_[index];
+    while (running_) {
+        vector<Message> messages = consumer.poll_batch(shard_batch_size_,
+                                                       SHARD_POLL_INTERVAL);
+        for (Message& message : messages) {
+            // Bounded push with a shutdown check so a full ring can't hang stop()
+            while (!ring_.try_emplace(std::move(message))) {
+                if (!running_) {
+                    return;
+                }
+                sleep_for(IDLE_WAIT_INTERVAL);
+            }
+        }
+    }
+}
+
+void ShardedConsumer::apply_affinity(size_t index) {
+#ifdef __linux__
+    int cpu = -1;
+    if (affinity_) {
+        if (!affinity_->empty()) {
+            cpu = (*affinity_)[index % affinity_->size()];
+        }
+    }
+    else {
+        const unsigned hardware_threads = std::thread::hardware_concurrency();
+        if (hardware_threads > 0) {
+            cpu = static_cast<int>(index % hardware_threads);
+        }
+    }
+    if (cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        // Best effort; consumption works either way
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    }
+#else
+    (void)index;
+#endif
+}
+
+} // cppkafka
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include "utils/weighted_poll_strategy.h"
+#include "exceptions.h"
+
+using std::make_move_iterator;
+using std::min;
+using std::string;
+using std::vector;
+using std::chrono::milliseconds;
+
+namespace cppkafka {
+
+WeightedPollStrategy::WeightedPollStrategy(Consumer& consumer)
+: PollStrategyBase(consumer) {
+    reset_state();
+}
+
+WeightedPollStrategy::~WeightedPollStrategy() {
+    restore_forwarding();
+}
+
+void WeightedPollStrategy::set_topic_priority(const string& topic, int priority) {
+    topic_priorities_[topic] = priority;
+    rebuild_bands();
+}
+
+void WeightedPollStrategy::set_topic_weight(const string& topic, size_t weight) {
+    if (weight == 0) {
+        throw Exception("Invalid weight.");
+    }
+    topic_weights_[topic] = weight;
+    rebuild_bands();
+}
+
+Message WeightedPollStrategy::poll() {
+    return poll(get_consumer().get_timeout());
+}
+
+Message WeightedPollStrategy::poll(milliseconds timeout) {
+    // Always give priority to group and global events
+    Message message = get_consumer_queue().queue.consume(milliseconds(0));
+    if (message) {
+        return message;
+    }
+    // Service the bands in strict priority order (non-blocking)
+    for (auto& band_pair : bands_) {
+        message = consume_band(band_pair.second);
+        if (message) {
+            return message;
+        }
+    }
+    // We still don't have a valid message so we block on the event queue
+    return get_consumer_queue().queue.consume(timeout);
+}
+
+vector<Message> WeightedPollStrategy::poll_batch(size_t max_batch_size) {
+    return poll_batch(max_batch_size, get_consumer().get_timeout());
+}
+
+vector<Message> WeightedPollStrategy::poll_batch(size_t max_batch_size,
+                                                 milliseconds timeout) {
+    vector<Message> messages;
+    ssize_t count = max_batch_size;
+
+    // batch from the group event queue first (non-blocking)
+    vector<Message> event_messages =
+        get_consumer_queue().queue.consume_batch(count, milliseconds(0));
+    count -= event_messages.size();
+    messages.insert(messages.end(),
+                    make_move_iterator(event_messages.begin()),
+                    make_move_iterator(event_messages.end()));
+    // batch from the bands in strict priority order (non-blocking)
+    for (auto& band_pair : bands_) {
+        if (count <= 0) {
+            break;
+        }
+        consume_band_batch(band_pair.second, messages, count);
+    }
+    // we still have space left in the buffer
+    if (count > 0) {
+        // wait on the event queue until timeout
+        vector<Message> queue_messages =
+            get_consumer_queue().queue.consume_batch(count, timeout);
+        messages.insert(messages.end(),
+                        make_move_iterator(queue_messages.begin()),
+                        make_move_iterator(queue_messages.end()));
+    }
+    return messages;
+}
+
+void WeightedPollStrategy::reset_state() {
+    rebuild_bands();
+}
+
+void WeightedPollStrategy::rebuild_bands() {
+    bands_.clear();
+    for (auto& queue_entry : get_partition_queues()) {
+        const string& topic = queue_entry.first.get_topic();
+        auto priority_iter = topic_priorities_.find(topic);
+        const int priority = priority_iter == topic_priorities_.end()
+                             ? 0 : priority_iter->second;
+        auto weight_iter = topic_weights_.find(topic);
+        const size_t weight = weight_iter == topic_weights_.end()
+                              ? 1 : weight_iter->second;
+        bands_[priority].queues.push_back(ScheduledQueue{ &queue_entry.second,
+                                                          weight, weight });
+    }
+}
+
+Message WeightedPollStrategy::consume_band(PriorityBand& band) {
+    size_t attempts = band.queues.size();
+    while (attempts--) {
+        ScheduledQueue& scheduled = band.queues[band.next_index];
+        Message message = scheduled.queue_data->queue.consume(milliseconds(0));
+        if (message) {
+            // Stay on this queue until its per-visit quantum is used up
+            if (--scheduled.credits == 0) {
+                advance_band(band);
+            }
+            return message;
+        }
+        // The queue is drained; move on and don't let leftover credits starve peers
+        advance_band(band);
+    }
+    return Message();
+}
+
+void WeightedPollStrategy::consume_band_batch(PriorityBand& band,
+                                              vector<Message>& messages,
+                                              ssize_t& count) {
+    size_t attempts = band.queues.size();
+    while (count > 0 && attempts--) {
+        ScheduledQueue& scheduled = band.queues[band.next_index];
+        const size_t wanted = min(static_cast<size_t>(count), scheduled.credits);
+        vector<Message> batch =
+            scheduled.queue_data->queue.consume_batch(wanted, milliseconds(0));
+        count -= batch.size();
+        scheduled.credits -= batch.size();
+        messages.insert(messages.end(),
+                        make_move_iterator(batch.begin()),
+                        make_move_iterator(batch.end()));
+        if (batch.size() < wanted || scheduled.credits == 0) {
+            advance_band(band);
+        }
+    }
+}
+
+void WeightedPollStrategy::advance_band(PriorityBand& band) {
+    band.next_index = (band.next_index + 1) % band.queues.size();
+    // Refill the quantum of the queue now entering service
+    ScheduledQueue& scheduled = band.queues[band.next_index];
+    scheduled.credits = scheduled.weight;
+}
+
+void WeightedPollStrategy::restore_forwarding() {
+    // forward all partition queues
+    for (const auto& toppar : get_partition_queues()) {
+        toppar.second.queue.forward_to_queue(get_consumer_queue().queue);
+    }
+}
+
+} //cppkafka
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017, Matias Fontanini
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above
+ *   copyright notice, this list of conditions and the following disclaimer
+ *   in the documentation and/or other materials provided with the
+ *   distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "wrapper_profiler.h"
+
+namespace cppkafka {
+
+namespace {
+
+const char* BOUNDARY_NAMES[WrapperProfiler::BOUNDARY_COUNT] = {
+    "produce_wrap",
+    "consume_wrap",
+    "partition_list_conversion",
+};
+
+} // anonymous namespace
+
+WrapperProfiler& WrapperProfiler::instance() {
+    static WrapperProfiler profiler;
+    return profiler;
+}
+
+WrapperProfiler::Report WrapperProfiler::get_report() const {
+    Report report;
+    for (size_t i = 0; i < BOUNDARY_COUNT; ++i) {
+        report[i].name = BOUNDARY_NAMES[i];
+        report[i].latencies = histograms_[i].get_snapshot();
+    }
+    return report;
+}
+
+void WrapperProfiler::reset() {
+    for (LatencyHistogram& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+void WrapperProfiler::record(Boundary boundary, uint64_t nanoseconds) {
+    histograms_[static_cast<size_t>(boundary)].record(nanoseconds);
+}
+
+} // cppkafka
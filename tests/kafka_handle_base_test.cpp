@@ -97,6 +97,13 @@ TEST_CASE("metadata", "[handle_base]") {
     }
 }
 
+TEST_CASE("warmup", "[handle_base]") {
+    Producer producer(make_config());
+    CHECK(producer.is_ready() == false);
+    CHECK(producer.warmup(std::chrono::seconds(10)) == true);
+    CHECK(producer.is_ready() == true);
+}
+
 TEST_CASE("consumer groups", "[handle_base]") {
     string consumer_group = "kafka_handle_test";
     string client_id = "my_client_id";
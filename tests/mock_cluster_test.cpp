@@ -0,0 +1,59 @@
+#include <chrono>
+#include <string>
+#include <utility>
+#include <catch.hpp>
+#include "cppkafka/consumer.h"
+#include "cppkafka/mock_cluster.h"
+#include "cppkafka/producer.h"
+#include "test_utils.h"
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+
+using std::string;
+using std::chrono::seconds;
+
+using namespace cppkafka;
+
+TEST_CASE("mock cluster roundtrip", "[mock_cluster]") {
+    auto cluster = make_mock_cluster();
+
+    // Consume through the mock brokers, no external instance involved
+    Consumer consumer(cluster->make_configuration()
+                             .set("enable.auto.commit", false)
+                             .set("group.id", make_consumer_group_id())
+                             .set("auto.offset.reset", "earliest"));
+    consumer.subscribe({ KAFKA_TOPICS[0] });
+    ConsumerRunner runner(consumer, 1, KAFKA_NUM_PARTITIONS);
+
+    Producer producer(cluster->make_configuration());
+    const string payload = "mock payload";
+    producer.produce(MessageBuilder(KAFKA_TOPICS[0]).partition(0).payload(payload));
+    producer.flush();
+    runner.try_join();
+
+    REQUIRE(runner.get_messages().size() == 1);
+    CHECK(runner.get_messages()[0].get_payload() == payload);
+}
+
+TEST_CASE("mock cluster error injection", "[mock_cluster]") {
+    auto cluster = make_mock_cluster(1);
+
+    bool delivered = false;
+    Configuration config = cluster->make_configuration();
+    config.set("message.timeout.ms", 5000);
+    config.set_delivery_report_callback([&](Producer&, const Message& message) {
+        delivered = !message.get_error();
+    });
+    Producer producer(std::move(config));
+
+    // Answer the next produce request with a retriable error; the message
+    // must still get through on the retry
+    cluster->push_request_errors(0 /*Produce*/,
+                                 { RD_KAFKA_RESP_ERR_NOT_ENOUGH_REPLICAS });
+    const string payload = "retried payload";
+    producer.produce(MessageBuilder(KAFKA_TOPICS[0]).partition(0).payload(payload));
+    producer.flush(seconds(10));
+    CHECK(delivered);
+}
+
+#endif // RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION
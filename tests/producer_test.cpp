@@ -2,6 +2,9 @@
 #include <mutex>
 #include <chrono>
 #include <set>
+#include <atomic>
+#include <memory>
+#include <type_traits>
 #include <condition_variable>
 #include <catch.hpp>
 #include "cppkafka/producer.h"
@@ -555,6 +558,28 @@ TEST_CASE("buffered producer with limited buffer", "[producer]") {
     REQUIRE(messages.size() == producer.get_max_buffer_size());
 }
 
+TEST_CASE("buffered producer byte accounting", "[producer][buffered_producer]") {
+    int partition = 0;
+
+    BufferedProducer<string> producer(make_producer_config());
+    const string payload = "some payload bytes";
+    REQUIRE(producer.get_buffered_bytes() == 0);
+    REQUIRE(producer.get_max_buffer_bytes() == -1);
+
+    producer.add_message(MessageBuilder(KAFKA_TOPICS[0]).partition(partition).payload(payload));
+    producer.add_message(MessageBuilder(KAFKA_TOPICS[0]).partition(partition).payload(payload));
+    CHECK(producer.get_buffered_bytes() == 2 * payload.size());
+    CHECK(producer.get_buffered_bytes(KAFKA_TOPICS[0]) == 2 * payload.size());
+    CHECK(producer.get_buffered_bytes("some_other_topic") == 0);
+
+    producer.flush();
+    CHECK(producer.get_buffered_bytes() == 0);
+    CHECK(producer.get_buffered_bytes(KAFKA_TOPICS[0]) == 0);
+    // The high water mark keeps the worst backlog even after the drain
+    CHECK(producer.get_buffered_bytes_high_water_mark() == 2 * payload.size());
+    CHECK(producer.get_buffered_bytes_high_water_mark(KAFKA_TOPICS[0]) == 2 * payload.size());
+}
+
 TEST_CASE("multi-threaded buffered producer", "[producer][buffered_producer]") {
     int partition = 0;
     vector<thread> threads;
@@ -608,3 +633,71 @@ TEST_CASE("clear multi-threaded buffered producer", "[producer][buffered_produce
     REQUIRE(producer.get_pending_acks() == 0);
     REQUIRE(producer.get_buffer_size() < num_messages);
 }
+
+// Allocator that counts every allocation made through it, so the tests below
+// can assert that relocating builders between queue slots never touches the
+// heap. The counter is shared across all instantiations.
+struct AllocationCounter {
+    static std::atomic<size_t> count;
+};
+std::atomic<size_t> AllocationCounter::count{0};
+
+template <typename T>
+struct CountingAllocator : AllocationCounter {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++count;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* ptr, size_t n) {
+        std::allocator<T>().deallocate(ptr, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&) {
+    return true;
+}
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&) {
+    return false;
+}
+
+TEST_CASE("builder moves are noexcept and allocation free", "[producer][allocation]") {
+    using CountingString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+    using TestBuilder = ConcreteMessageBuilder<CountingString>;
+
+    // Throwing moves would downgrade queue growth to copy construction
+    static_assert(std::is_nothrow_move_constructible<MessageBuilder>::value,
+                  "MessageBuilder move must be noexcept");
+    static_assert(std::is_nothrow_move_constructible<Message>::value,
+                  "Message move must be noexcept");
+    static_assert(std::is_nothrow_move_constructible<TestBuilder>::value,
+                  "builder move must be noexcept");
+
+    const size_t num_messages = 64;
+    const CountingString payload(128, 'x'); // well beyond any SSO threshold
+    vector<TestBuilder> builders;
+    builders.reserve(num_messages);
+    for (size_t i = 0; i < num_messages; ++i) {
+        TestBuilder builder(KAFKA_TOPICS[0]);
+        builder.partition(0).payload(CountingString(payload));
+        builders.push_back(move(builder));
+    }
+
+    // Relocating every builder must move the payloads, not copy them; a copy
+    // would show up as one counted allocation per message
+    const size_t allocations_before = AllocationCounter::count;
+    vector<TestBuilder> relocated(std::make_move_iterator(builders.begin()),
+                                  std::make_move_iterator(builders.end()));
+    CHECK(AllocationCounter::count == allocations_before);
+    REQUIRE(relocated.size() == num_messages);
+    for (const TestBuilder& builder : relocated) {
+        REQUIRE(builder.payload() == payload);
+    }
+}
@@ -0,0 +1,202 @@
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "cppkafka/utils/mpsc_ring_buffer.h"
+#include "cppkafka/utils/partition_affine_queue.h"
+#include "cppkafka/utils/sharded_queue.h"
+
+using std::atomic;
+using std::multiset;
+using std::string;
+using std::thread;
+using std::vector;
+
+using namespace cppkafka;
+
+// The queue policies are plain data structures, so unlike the rest of the
+// suite these tests need no broker. The re-entrant sections mirror what
+// BufferedProducer::flush does: the try_pop functor produces, and a failed
+// delivery re-enqueues through emplace_back on the very same thread.
+
+namespace {
+
+// Stands in for a message builder: PartitionAffineQueue keys its sub-queues
+// off these accessors
+struct FakeBuilder {
+    string topic_;
+    int partition_;
+    int value_;
+
+    const string& topic() const {
+        return topic_;
+    }
+
+    int partition() const {
+        return partition_;
+    }
+};
+
+template <typename Queue>
+void run_concurrent_push_pop(Queue& queue, size_t producer_count, size_t per_producer) {
+    const size_t total = producer_count * per_producer;
+    vector<thread> producers;
+    for (size_t producer = 0; producer != producer_count; ++producer) {
+        producers.emplace_back([&, producer]() {
+            for (size_t i = 0; i != per_producer; ++i) {
+                queue.emplace_back(static_cast<int>(producer * per_producer + i));
+            }
+        });
+    }
+    multiset<int> popped;
+    size_t consumed = 0;
+    while (consumed != total) {
+        if (queue.try_pop([&](int&& value) { popped.insert(value); })) {
+            ++consumed;
+        }
+    }
+    for (thread& producer : producers) {
+        producer.join();
+    }
+    CHECK(queue.empty());
+    REQUIRE(popped.size() == total);
+    // Every pushed value came out exactly once
+    for (size_t i = 0; i != total; ++i) {
+        CHECK(popped.count(static_cast<int>(i)) == 1);
+    }
+}
+
+} // namespace
+
+TEST_CASE("mpsc ring buffer", "[queue_policy]") {
+    SECTION("fifo order and capacity") {
+        MpscRingBuffer<int> ring(4);
+        CHECK(ring.capacity() == 4);
+        CHECK(ring.empty());
+        for (int i = 0; i != 4; ++i) {
+            CHECK(ring.try_emplace(i));
+        }
+        // The ring is full now
+        CHECK(!ring.try_emplace(4));
+        CHECK(ring.size() == 4);
+        for (int i = 0; i != 4; ++i) {
+            int popped = -1;
+            REQUIRE(ring.try_pop([&](int&& value) { popped = value; }));
+            CHECK(popped == i);
+        }
+        CHECK(!ring.try_pop([](int&&) { }));
+    }
+
+    SECTION("re-entrant push from the pop functor on a full ring") {
+        MpscRingBuffer<int> ring(4);
+        while (ring.try_emplace(0)) {
+        }
+        // The popped slot must be released before the functor runs, otherwise
+        // this emplace_back would spin on it forever
+        REQUIRE(ring.try_pop([&](int&&) { ring.emplace_back(1); }));
+        CHECK(ring.size() == ring.capacity());
+    }
+
+    SECTION("concurrent push/pop") {
+        MpscRingBuffer<int> ring(1024);
+        run_concurrent_push_pop(ring, 4, 10000);
+    }
+}
+
+TEST_CASE("sharded queue", "[queue_policy]") {
+    SECTION("push and pop across shards") {
+        ShardedQueue<int> queue(4);
+        CHECK(queue.get_shard_count() == 4);
+        for (int i = 0; i != 16; ++i) {
+            queue.emplace_back(i);
+        }
+        CHECK(queue.size() == 16);
+        multiset<int> popped;
+        while (queue.try_pop([&](int&& value) { popped.insert(value); })) {
+        }
+        CHECK(queue.empty());
+        CHECK(popped.size() == 16);
+    }
+
+    SECTION("re-entrant push from the pop functor") {
+        ShardedQueue<int> queue(1);
+        queue.emplace_back(0);
+        // With a single shard the re-entrant push targets the shard being
+        // popped; the lock must not be held across the functor
+        REQUIRE(queue.try_pop([&](int&&) { queue.emplace_back(1); }));
+        CHECK(queue.size() == 1);
+    }
+
+    SECTION("concurrent push/pop") {
+        ShardedQueue<int> queue(4);
+        run_concurrent_push_pop(queue, 4, 10000);
+    }
+}
+
+TEST_CASE("partition affine queue", "[queue_policy]") {
+    SECTION("drains one partition before the next") {
+        PartitionAffineQueue<FakeBuilder> queue;
+        // Interleave two partitions on the way in
+        queue.emplace_back(FakeBuilder{ "topic", 0, 1 });
+        queue.emplace_back(FakeBuilder{ "topic", 1, 2 });
+        queue.emplace_back(FakeBuilder{ "topic", 0, 3 });
+        queue.emplace_back(FakeBuilder{ "topic", 1, 4 });
+        CHECK(queue.size() == 4);
+        CHECK(queue.get_partition_count() == 2);
+
+        vector<int> partitions;
+        vector<int> values;
+        while (queue.try_pop([&](FakeBuilder&& builder) {
+                   partitions.push_back(builder.partition());
+                   values.push_back(builder.value_);
+               })) {
+        }
+        CHECK(queue.empty());
+        // Grouped by partition, FIFO within each
+        CHECK(partitions == vector<int>{ 0, 0, 1, 1 });
+        CHECK(values == vector<int>{ 1, 3, 2, 4 });
+    }
+
+    SECTION("re-entrant push from the pop functor") {
+        PartitionAffineQueue<FakeBuilder> queue;
+        queue.emplace_back(FakeBuilder{ "topic", 0, 1 });
+        REQUIRE(queue.try_pop([&](FakeBuilder&&) {
+            queue.emplace_back(FakeBuilder{ "topic", 0, 2 });
+        }));
+        CHECK(queue.size() == 1);
+    }
+
+    SECTION("concurrent push/pop") {
+        PartitionAffineQueue<FakeBuilder> queue;
+        const size_t producer_count = 4;
+        const size_t per_producer = 10000;
+        vector<thread> producers;
+        for (size_t producer = 0; producer != producer_count; ++producer) {
+            producers.emplace_back([&, producer]() {
+                for (size_t i = 0; i != per_producer; ++i) {
+                    queue.emplace_back(FakeBuilder{
+                        "topic",
+                        static_cast<int>(producer),
+                        static_cast<int>(producer * per_producer + i)
+                    });
+                }
+            });
+        }
+        multiset<int> popped;
+        size_t consumed = 0;
+        while (consumed != producer_count * per_producer) {
+            if (queue.try_pop([&](FakeBuilder&& builder) {
+                    popped.insert(builder.value_);
+                })) {
+                ++consumed;
+            }
+        }
+        for (thread& producer : producers) {
+            producer.join();
+        }
+        CHECK(queue.empty());
+        CHECK(popped.size() == producer_count * per_producer);
+    }
+}
@@ -92,3 +92,13 @@ string make_consumer_group_id() {
     output << now.count() << random_number;
     return output.str();
 }
+
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+unique_ptr<MockCluster> make_mock_cluster(size_t broker_count) {
+    unique_ptr<MockCluster> cluster(new MockCluster(broker_count));
+    for (const string& topic : KAFKA_TOPICS) {
+        cluster->create_topic(topic, KAFKA_NUM_PARTITIONS);
+    }
+    return cluster;
+}
+#endif
@@ -1,10 +1,12 @@
 #ifndef CPPKAFKA_TEST_UTILS_H
 #define CPPKAFKA_TEST_UTILS_H
 
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
 #include "cppkafka/consumer.h"
+#include "cppkafka/mock_cluster.h"
 #include "cppkafka/utils/roundrobin_poll_strategy.h"
 #include "cppkafka/utils/consumer_dispatcher.h"
 
@@ -61,6 +63,12 @@ private:
 
 std::string make_consumer_group_id();
 
+#if (RD_KAFKA_VERSION >= RD_KAFKA_MOCK_CLUSTER_SUPPORT_VERSION)
+// Creates an in-process mock cluster with the test topics pre-created, so
+// tests and benchmarks can run without a KAFKA_TEST_INSTANCE broker
+std::unique_ptr<MockCluster> make_mock_cluster(size_t broker_count = 3);
+#endif
+
 using PollConsumerRunner = BasicConsumerRunner<PollStrategyAdapter>;
 using ConsumerRunner = BasicConsumerRunner<Consumer>;
 
@@ -2,10 +2,12 @@
 #include <catch.hpp>
 #include "cppkafka/topic_partition_list.h"
 #include "cppkafka/topic_partition.h"
+#include "cppkafka/topic_partition_map.h"
 
 using std::ostringstream;
 using std::set;
 using std::string;
+using std::vector;
 
 using namespace cppkafka;
 
@@ -85,3 +87,48 @@ TEST_CASE("find matches by id", "[topic_partition]") {
     const TopicPartitionList subset = find_matches(list, set<int>{2,5,8});
     CHECK(subset == expected);
 }
+
+TEST_CASE("topic partition map", "[topic_partition]") {
+    TopicPartitionMap<int> map;
+    CHECK(map.empty());
+    CHECK(map.get_topic_id("foo") == TopicPartitionMap<int>::npos);
+
+    CHECK(map.emplace({ "foo", 2 }, 20).second == true);
+    CHECK(map.emplace({ "foo", 0 }, 0).second == true);
+    CHECK(map.emplace({ "bar", 1 }, 11).second == true);
+    // Duplicate keys keep the original value
+    CHECK(map.emplace({ "foo", 2 }, 99).second == false);
+    CHECK(map.size() == 3);
+
+    SECTION("lookup") {
+        REQUIRE(map.find({ "foo", 2 }) != map.end());
+        CHECK(map.find({ "foo", 2 })->second == 20);
+        CHECK(map.find({ "foo", 1 }) == map.end());
+        CHECK(map.find({ "missing", 0 }) == map.end());
+
+        const size_t topic_id = map.get_topic_id("foo");
+        REQUIRE(topic_id != TopicPartitionMap<int>::npos);
+        REQUIRE(map.get(topic_id, 2) != nullptr);
+        CHECK(*map.get(topic_id, 2) == 20);
+        CHECK(map.get(topic_id, 5) == nullptr);
+    }
+
+    SECTION("iteration is in partition order per topic") {
+        vector<TopicPartition> visited;
+        for (const auto& entry : map) {
+            visited.push_back(entry.first);
+        }
+        const vector<TopicPartition> expected = { { "foo", 0 }, { "foo", 2 }, { "bar", 1 } };
+        CHECK(visited == expected);
+    }
+
+    SECTION("erase and clear") {
+        CHECK(map.erase({ "foo", 2 }) == 1);
+        CHECK(map.erase({ "foo", 2 }) == 0);
+        CHECK(map.size() == 2);
+        map.clear();
+        CHECK(map.empty());
+        // Topic ids survive a clear
+        CHECK(map.get_topic_id("foo") != TopicPartitionMap<int>::npos);
+    }
+}